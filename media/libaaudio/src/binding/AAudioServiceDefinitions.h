@@ -17,6 +17,7 @@
 #ifndef BINDING_AAUDIOSERVICEDEFINITIONS_H
 #define BINDING_AAUDIOSERVICEDEFINITIONS_H
 
+#include <atomic>
 #include <stdint.h>
 #include <utils/RefBase.h>
 #include <binder/TextOutput.h>
@@ -76,6 +77,77 @@ typedef struct RingBufferDescriptor_s {
     RingbufferFlags flags;
 } RingBufferDescriptor;
 
+/**
+ * When the service expects to next transfer data to or from a shared stream's data queue.
+ *
+ * This is in shared memory. It is written by the service once per burst and read by the client,
+ * which can then wake up just after the transfer instead of at an arbitrary phase of the burst.
+ * A sequence count, which is odd while the service is writing, lets the client read both values
+ * consistently without a lock.
+ *
+ * This does not use afutils::Seqlock, which is private to the audio server and lets readers
+ * spin for as long as a write is in progress: a client must not hang if the service dies
+ * in the middle of a write, so read() gives up after a few attempts. The layout of this struct
+ * is also shared by the 32 and 64 bit processes that map it.
+ */
+struct EndpointSchedule {
+    static_assert(std::atomic<int64_t>::is_always_lock_free);
+
+    // Only call from the one service thread that transfers the data.
+    void write(int64_t nextServiceTime, int64_t servicePeriod) {
+        const uint32_t count = sequence.load(std::memory_order_relaxed);
+        sequence.store(count + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        nextServiceTimeNanos.store(nextServiceTime, std::memory_order_relaxed);
+        servicePeriodNanos.store(servicePeriod, std::memory_order_relaxed);
+        sequence.store(count + 2, std::memory_order_release);
+    }
+
+    /**
+     * @return true if a schedule has been written and was read consistently
+     */
+    bool read(int64_t *nextServiceTime, int64_t *servicePeriod) const {
+        for (int i = 0; i < kMaxReadAttempts; i++) {
+            const uint32_t count = sequence.load(std::memory_order_acquire);
+            if ((count & 1) != 0) {
+                continue; // being written
+            }
+            const int64_t next = nextServiceTimeNanos.load(std::memory_order_relaxed);
+            const int64_t period = servicePeriodNanos.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == count) {
+                *nextServiceTime = next;
+                *servicePeriod = period;
+                return count != 0 && period > 0;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Extrapolate the schedule, before or after nextServiceTime, to find the transfer nearest
+     * to a time. A time half way between two transfers maps to the later one.
+     *
+     * @return time of the nearest transfer
+     */
+    static int64_t nearestServiceTime(int64_t time, int64_t nextServiceTime,
+                                      int64_t servicePeriod) {
+        const int64_t nanosDelta = time - nextServiceTime + (servicePeriod / 2);
+        int64_t periods = nanosDelta / servicePeriod;
+        if (nanosDelta < 0 && (nanosDelta % servicePeriod) != 0) {
+            periods--; // round toward negative infinity
+        }
+        return nextServiceTime + (periods * servicePeriod);
+    }
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<int64_t>  nextServiceTimeNanos{0}; // CLOCK_MONOTONIC
+    std::atomic<int64_t>  servicePeriodNanos{0};
+
+private:
+    static constexpr int kMaxReadAttempts = 4;
+};
+
 // This is not passed through Binder.
 // Client side code will convert Binder data and fill this descriptor.
 typedef struct EndpointDescriptor_s {
@@ -83,6 +155,7 @@ typedef struct EndpointDescriptor_s {
     RingBufferDescriptor upMessageQueueDescriptor;   // server to client
     RingBufferDescriptor downMessageQueueDescriptor; // client to server
     RingBufferDescriptor dataQueueDescriptor;    // playback or capture
+    EndpointSchedule    *endpointSchedule;       // null unless the stream is shared
 } EndpointDescriptor;
 
 static constexpr int32_t AAUDIO_SERVICE_LIFETIME_ID_INVALID = -1;
@@ -38,7 +38,8 @@ AudioEndpointParcelable::AudioEndpointParcelable(Endpoint&& parcelable)
         : mUpMessageQueueParcelable(parcelable.upMessageQueueParcelable),
           mDownMessageQueueParcelable(parcelable.downMessageQueueParcelable),
           mUpDataQueueParcelable(parcelable.upDataQueueParcelable),
-          mDownDataQueueParcelable(parcelable.downDataQueueParcelable) {
+          mDownDataQueueParcelable(parcelable.downDataQueueParcelable),
+          mEndpointScheduleParcelable(parcelable.endpointScheduleParcelable) {
     for (size_t i = 0; i < parcelable.sharedMemories.size() && i < MAX_SHARED_MEMORIES; ++i) {
         // Re-construct.
         mSharedMemories[i].~SharedMemoryParcelable();
@@ -71,6 +72,7 @@ void updateSharedMemoryIndex(Endpoint* endpoint, int oldIndex, int newIndex) {
     updateSharedMemoryIndex(&endpoint->downMessageQueueParcelable, oldIndex, newIndex);
     updateSharedMemoryIndex(&endpoint->upDataQueueParcelable, oldIndex, newIndex);
     updateSharedMemoryIndex(&endpoint->downDataQueueParcelable, oldIndex, newIndex);
+    updateSharedMemoryIndex(&endpoint->endpointScheduleParcelable, oldIndex, newIndex);
 }
 
 } // namespace
@@ -81,6 +83,7 @@ Endpoint AudioEndpointParcelable::parcelable()&& {
     result.downMessageQueueParcelable = mDownMessageQueueParcelable.parcelable();
     result.upDataQueueParcelable = mUpDataQueueParcelable.parcelable();
     result.downDataQueueParcelable = mDownDataQueueParcelable.parcelable();
+    result.endpointScheduleParcelable = mEndpointScheduleParcelable.parcelable();
     // To transfer through binder, only valid/in-use shared memory is allowed. By design, the
     // shared memories that are currently in-use may not be placed continuously from position 0.
     // However, when marshalling the shared memories into Endpoint, the shared memories will be
@@ -160,6 +163,11 @@ aaudio_result_t AudioEndpointParcelable::resolve(EndpointDescriptor *descriptor)
 
     result = mDownDataQueueParcelable.resolve(mSharedMemories,
                                               &descriptor->dataQueueDescriptor);
+    if (result != AAUDIO_OK) return result;
+
+    void *scheduleAddress = nullptr;
+    result = mEndpointScheduleParcelable.resolve(mSharedMemories, &scheduleAddress);
+    descriptor->endpointSchedule = static_cast<EndpointSchedule *>(scheduleAddress);
     return result;
 }
 
@@ -201,6 +209,8 @@ void AudioEndpointParcelable::dump() {
     mUpDataQueueParcelable.dump();
     ALOGD("mDownDataQueueParcelable ==========");
     mDownDataQueueParcelable.dump();
+    ALOGD("mEndpointScheduleParcelable =======");
+    mEndpointScheduleParcelable.dump();
     ALOGD("======================================= END");
 }
 
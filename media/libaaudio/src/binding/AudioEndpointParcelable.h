@@ -25,6 +25,7 @@
 
 #include "binding/AAudioServiceDefinitions.h"
 #include "binding/RingBufferParcelable.h"
+#include "binding/SharedRegionParcelable.h"
 
 using android::status_t;
 
@@ -84,6 +85,8 @@ public: // TODO add getters
     RingBufferParcelable    mDownMessageQueueParcelable; // to server
     RingBufferParcelable    mUpDataQueueParcelable;      // eg. record, could share same queue
     RingBufferParcelable    mDownDataQueueParcelable;    // eg. playback
+    // Set sizeInBytes to zero if the service does not publish an EndpointSchedule.
+    SharedRegionParcelable  mEndpointScheduleParcelable;
 
 private:
     // Return the first available shared memory position. Return -1 if all shared memories are
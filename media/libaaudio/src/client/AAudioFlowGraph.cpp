@@ -20,6 +20,7 @@
 
 #include "AAudioFlowGraph.h"
 
+#include <audio_utils/primitives.h>
 #include <flowgraph/Limiter.h>
 #include <flowgraph/ManyToMultiConverter.h>
 #include <flowgraph/MonoBlend.h>
@@ -39,6 +40,53 @@
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
+// These match the conversions of the Source and Sink nodes.
+static void convertToFloat(audio_format_t format, float *destination, const void *source,
+                           size_t numSamples) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            memcpy(destination, source, numSamples * sizeof(float));
+            break;
+        case AUDIO_FORMAT_PCM_16_BIT:
+            memcpy_to_float_from_i16(destination, (const int16_t *) source, numSamples);
+            break;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            memcpy_to_float_from_p24(destination, (const uint8_t *) source, numSamples);
+            break;
+        case AUDIO_FORMAT_PCM_32_BIT:
+            memcpy_to_float_from_i32(destination, (const int32_t *) source, numSamples);
+            break;
+        case AUDIO_FORMAT_PCM_8_24_BIT:
+            memcpy_to_float_from_q8_23(destination, (const int32_t *) source, numSamples);
+            break;
+        default:
+            break; // rejected by configure()
+    }
+}
+
+static void convertFromFloat(audio_format_t format, void *destination, const float *source,
+                             size_t numSamples) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            memcpy(destination, source, numSamples * sizeof(float));
+            break;
+        case AUDIO_FORMAT_PCM_16_BIT:
+            memcpy_to_i16_from_float((int16_t *) destination, source, numSamples);
+            break;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            memcpy_to_p24_from_float((uint8_t *) destination, source, numSamples);
+            break;
+        case AUDIO_FORMAT_PCM_32_BIT:
+            memcpy_to_i32_from_float((int32_t *) destination, source, numSamples);
+            break;
+        case AUDIO_FORMAT_PCM_8_24_BIT:
+            memcpy_to_q8_23_from_float_with_clamp((int32_t *) destination, source, numSamples);
+            break;
+        default:
+            break; // rejected by configure()
+    }
+}
+
 aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
                           int32_t sourceChannelCount,
                           int32_t sourceSampleRate,
@@ -153,19 +201,136 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    // Without a sample rate converter, the chain produces one output frame per input frame,
+    // so it can be run in one pass per block, in place in a single buffer.
+    // The nodes stay connected, as they hold the state used by the fused pass.
+    mFused = mFusedAllowed && mRateConverter == nullptr;
+    if (mFused) {
+        mSourceFormat = sourceFormat;
+        mSinkFormat = sinkFormat;
+        mSourceChannelCount = sourceChannelCount;
+        mSinkChannelCount = sinkChannelCount;
+        mFusedBuffer.resize(kFusedFramesPerBlock * sinkChannelCount);
+        mFusedLevels.resize(kFusedFramesPerBlock * mVolumeRamps.size());
+    }
+    ALOGV("%s() fused = %d", __func__, mFused);
+
     return AAUDIO_OK;
 }
 
 int32_t AAudioFlowGraph::pull(void *destination, int32_t targetFramesToRead) {
+    if (mFused) {
+        return pullFused(destination, targetFramesToRead);
+    }
     return mSink->read(destination, targetFramesToRead);
 }
 
 int32_t AAudioFlowGraph::process(const void *source, int32_t numFramesToWrite, void *destination,
                     int32_t targetFramesToRead) {
+    if (mFused) {
+        mFusedSource = static_cast<const uint8_t *>(source);
+        mFusedSourceFrames = numFramesToWrite;
+        mFusedSourceIndex = 0;
+        return pullFused(destination, targetFramesToRead);
+    }
     mSource->setData(source, numFramesToWrite);
     return mSink->read(destination, targetFramesToRead);
 }
 
+int32_t AAudioFlowGraph::pullFused(void *destination, int32_t targetFramesToRead) {
+    const int32_t framesToRead = std::min(targetFramesToRead,
+                                          mFusedSourceFrames - mFusedSourceIndex);
+    const size_t sourceFrameSize = audio_bytes_per_frame(mSourceChannelCount, mSourceFormat);
+    const size_t sinkFrameSize = audio_bytes_per_frame(mSinkChannelCount, mSinkFormat);
+    uint8_t *sinkData = static_cast<uint8_t *>(destination);
+    float *buffer = mFusedBuffer.data();
+
+    int32_t framesLeft = framesToRead;
+    while (framesLeft > 0) {
+        const int32_t numFrames = std::min(framesLeft, kFusedFramesPerBlock);
+        convertToFloat(mSourceFormat, buffer,
+                       mFusedSource + mFusedSourceIndex * sourceFrameSize,
+                       numFrames * mSourceChannelCount);
+        if (mMonoBlend) {
+            mMonoBlend->processBuffer(buffer, buffer, numFrames);
+        }
+        if (mLimiter) {
+            mLimiter->processBuffer(buffer, buffer, numFrames * mSourceChannelCount);
+        }
+        if (mChannelConverter) {
+            // Expand in place, from the end so that no mono sample is overwritten before use.
+            for (int32_t i = numFrames - 1; i >= 0; i--) {
+                const float sample = buffer[i];
+                for (int32_t channel = 0; channel < mSinkChannelCount; channel++) {
+                    buffer[i * mSinkChannelCount + channel] = sample;
+                }
+            }
+        }
+        if (!mVolumeRamps.empty()) {
+            applyVolumeRampsFused(buffer, numFrames);
+        }
+        convertFromFloat(mSinkFormat, sinkData, buffer, numFrames * mSinkChannelCount);
+
+        sinkData += numFrames * sinkFrameSize;
+        mFusedSourceIndex += numFrames;
+        framesLeft -= numFrames;
+    }
+    return framesToRead;
+}
+
+void AAudioFlowGraph::applyVolumeRampsFused(float *buffer, int32_t numFrames) {
+    const int32_t channelCount = mSinkChannelCount;
+    float *levels = mFusedLevels.data();
+
+    // Frames at the start of the block where the level of at least one channel changes.
+    int32_t rampFrames = 0;
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        RampLinear *ramp = mVolumeRamps[channel].get();
+        float *channelLevels = &levels[channel * kFusedFramesPerBlock];
+        // Latch the target once per port buffer, as the per-node graph does, so that a
+        // volume change is not delayed until the next block.
+        float previousLevel = ramp->getLevel();
+        for (int32_t frame = 0; frame < numFrames; frame += kDefaultBufferSize) {
+            const int32_t chunkFrames = std::min(numFrames - frame, kDefaultBufferSize);
+            const int32_t chunkRampFrames = ramp->advance(&channelLevels[frame], chunkFrames);
+            const float level = ramp->getLevel();
+            for (int32_t i = chunkRampFrames; i < chunkFrames; i++) {
+                channelLevels[frame + i] = level;
+            }
+            if (chunkRampFrames > 0 || level != previousLevel) {
+                rampFrames = std::max(rampFrames, frame + chunkFrames);
+            }
+            previousLevel = level;
+        }
+    }
+
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        const float *channelLevels = &levels[channel * kFusedFramesPerBlock];
+        for (int32_t i = 0; i < rampFrames; i++) {
+            buffer[i * channelCount + channel] *= channelLevels[i];
+        }
+    }
+
+    // The rest of the block has a constant gain per channel, which vectorizes well.
+    float *steady = &buffer[rampFrames * channelCount];
+    const int32_t steadyFrames = numFrames - rampFrames;
+    if (channelCount == 2) {
+        const float left = mVolumeRamps[0]->getLevel();
+        const float right = mVolumeRamps[1]->getLevel();
+        for (int32_t i = 0; i < steadyFrames; i++) {
+            steady[2 * i] *= left;
+            steady[2 * i + 1] *= right;
+        }
+    } else {
+        for (int32_t channel = 0; channel < channelCount; channel++) {
+            const float level = mVolumeRamps[channel]->getLevel();
+            for (int32_t i = 0; i < steadyFrames; i++) {
+                steady[i * channelCount + channel] *= level;
+            }
+        }
+    }
+}
+
 /**
  * @param volume between 0.0 and 1.0
  */
@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <stdint.h>
+#include <vector>
 #include <sys/types.h>
 #include <system/audio.h>
 
@@ -112,7 +113,28 @@ public:
      */
     void setRampLengthInFrames(int32_t numFrames);
 
+    /**
+     * Allow configure() to select fused execution, where the whole chain is run in one
+     * pass per block of frames instead of node by node. This is only possible without
+     * sample rate conversion. The output is the same. Allowed by default.
+     *
+     * @param allowed
+     */
+    void setFusedExecutionAllowed(bool allowed) {
+        mFusedAllowed = allowed;
+    }
+
+    bool isFused() const {
+        return mFused;
+    }
+
 private:
+    // Frames processed per pass in fused execution.
+    static constexpr int32_t kFusedFramesPerBlock = 256;
+
+    int32_t pullFused(void *destination, int32_t targetFramesToRead);
+    void applyVolumeRampsFused(float *buffer, int32_t numFrames);
+
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FlowGraphSourceBuffered> mSource;
     std::unique_ptr<RESAMPLER_OUTER_NAMESPACE::resampler::MultiChannelResampler> mResampler;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::SampleRateConverter> mRateConverter;
@@ -128,6 +150,19 @@ private:
     float mTargetVolume = 1.0f;
     android::audio_utils::Balance mBalance;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FlowGraphSink> mSink;
+
+    // Fused execution uses the state of the nodes above, but not their ports.
+    bool mFusedAllowed = true;
+    bool mFused = false;
+    audio_format_t mSourceFormat = AUDIO_FORMAT_DEFAULT;
+    audio_format_t mSinkFormat = AUDIO_FORMAT_DEFAULT;
+    int32_t mSourceChannelCount = 0;
+    int32_t mSinkChannelCount = 0;
+    const uint8_t *mFusedSource = nullptr;
+    int32_t mFusedSourceFrames = 0;
+    int32_t mFusedSourceIndex = 0;
+    std::vector<float> mFusedBuffer;
+    std::vector<float> mFusedLevels;
 };
 
 
@@ -138,6 +138,8 @@ aaudio_result_t AudioEndpoint::configure(const EndpointDescriptor *pEndpointDesc
             descriptor->dataAddress
     );
 
+    mEndpointSchedule = pEndpointDescriptor->endpointSchedule;
+
     // ============================ data queue =============================
     result = configureDataQueue(pEndpointDescriptor->dataQueueDescriptor, direction);
 
@@ -109,11 +109,23 @@ public:
 
     void freeDataQueue() { mDataQueue.reset(); }
 
+    /**
+     * Get the time of the next transfer to or from the data queue by the service.
+     * This is only published for shared streams.
+     *
+     * @return true if the service has published a schedule
+     */
+    bool getServiceSchedule(int64_t *nextServiceTime, int64_t *servicePeriod) const {
+        return mEndpointSchedule != nullptr
+                && mEndpointSchedule->read(nextServiceTime, servicePeriod);
+    }
+
     void dump() const;
 
 private:
     std::unique_ptr<android::FifoBufferIndirect> mUpCommandQueue;
     std::unique_ptr<android::FifoBufferIndirect> mDataQueue;
+    const EndpointSchedule *mEndpointSchedule = nullptr; // in shared memory, may be null
     bool                    mFreeRunning{false};
     android::fifo_counter_t mDataReadCounter{0}; // only used if free-running
     android::fifo_counter_t mDataWriteCounter{0}; // only used if free-running
@@ -67,6 +67,9 @@ using namespace aaudio;
 // Minimum number of bursts to use when sample rate conversion is used.
 #define MIN_SAMPLE_RATE_CONVERSION_NUM_BURSTS    3
 
+// Time allowed for the service to finish a transfer that started at its scheduled time.
+static constexpr int64_t kServiceTransferMarginNanos = 200 * AAUDIO_NANOS_PER_MICROSECOND;
+
 AudioStreamInternal::AudioStreamInternal(AAudioServiceInterface  &serviceInterface, bool inService)
         : AudioStream()
         , mClockModel()
@@ -536,6 +539,25 @@ int64_t AudioStreamInternal::calculateReasonableTimeout() {
     return calculateReasonableTimeout(getFramesPerBurst());
 }
 
+int64_t AudioStreamInternal::predictPositionTime(int64_t framePosition) const {
+    return mClockModel.isRunning()
+            ? mClockModel.convertPositionToTime(framePosition - mFramesOffsetFromService)
+            : 0;
+}
+
+int64_t AudioStreamInternal::alignWakeTimeToService(int64_t wakeTime) const {
+    int64_t nextServiceTime = 0;
+    int64_t servicePeriod = 0;
+    if (!mAudioEndpoint->getServiceSchedule(&nextServiceTime, &servicePeriod)) {
+        return wakeTime;
+    }
+    // The clock model is built from the service transfer times so it should be within
+    // a fraction of a burst. Pick the nearest transfer, which also extrapolates the schedule
+    // if the service published it a few bursts ago.
+    return EndpointSchedule::nearestServiceTime(wakeTime, nextServiceTime, servicePeriod)
+            + kServiceTransferMarginNanos;
+}
+
 // This must be called under mStreamLock.
 aaudio_result_t AudioStreamInternal::stopCallback_l()
 {
@@ -81,6 +81,15 @@ public:
     // Calculate timeout based on framesPerBurst
     int64_t calculateReasonableTimeout();
 
+    /**
+     * Predict when the DSP will reach a frame position, using the timing model.
+     * The position is counted like getFramesWritten() or getFramesRead().
+     * Only call this from the thread that reads or writes the stream.
+     *
+     * @return time in nanoseconds or 0 if the timing model is not running yet
+     */
+    int64_t predictPositionTime(int64_t framePosition) const;
+
     aaudio_result_t startClient(const android::AudioClient& client,
                                 const audio_attributes_t *attr,
                                 audio_port_handle_t *clientHandle);
@@ -151,6 +160,13 @@ protected:
      */
     bool isClockModelInControl() const;
 
+    /**
+     * Shared streams are serviced once per burst by the AAudio service.
+     * Move a wake time predicted by the timing model to just after the service transfer
+     * that it corresponds to, if the service has published its schedule.
+     */
+    int64_t alignWakeTimeToService(int64_t wakeTime) const;
+
     IsochronousClockModel    mClockModel;      // timing model for chasing the HAL
 
     std::unique_ptr<AudioEndpoint> mAudioEndpoint;   // source for reads or sink for writes
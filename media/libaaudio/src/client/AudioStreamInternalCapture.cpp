@@ -172,7 +172,8 @@ aaudio_result_t AudioStreamInternalCapture::processDataNow(void *buffer, int32_t
                 // causing us to sleep until a later burst.
                 const int64_t nextPosition = mAudioEndpoint->getDataReadCounter() +
                         getDeviceFramesPerBurst();
-                wakeTime = mClockModel.convertPositionToLatestTime(nextPosition);
+                wakeTime = alignWakeTimeToService(
+                        mClockModel.convertPositionToLatestTime(nextPosition));
             }
                 break;
             default:
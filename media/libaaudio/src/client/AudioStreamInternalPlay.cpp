@@ -221,7 +221,8 @@ aaudio_result_t AudioStreamInternalPlay::processDataNow(void *buffer, int32_t nu
                         - getDeviceFramesPerBurst();
                 const int64_t bestBufferSize = std::min(appBufferSize, endBufferSize);
                 int64_t targetReadPosition = mAudioEndpoint->getDataWriteCounter() - bestBufferSize;
-                wakeTime = mClockModel.convertPositionToTime(targetReadPosition);
+                wakeTime = alignWakeTimeToService(
+                        mClockModel.convertPositionToTime(targetReadPosition));
             }
                 break;
             default:
@@ -27,10 +27,26 @@ Limiter::Limiter(int32_t channelCount)
 }
 
 int32_t Limiter::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    processBuffer(input.getBuffer(), output.getBuffer(),
+            numFrames * output.getSamplesPerFrame());
+    return numFrames;
+}
 
-    int32_t numSamples = numFrames * output.getSamplesPerFrame();
+void Limiter::processBuffer(const float *inputBuffer, float *outputBuffer, int32_t numSamples) {
+    if (numSamples <= 0) {
+        return;
+    }
+    bool hasNan = false;
+    for (int32_t i = 0; i < numSamples; i++) {
+        hasNan |= isnan(inputBuffer[i]);
+    }
+    if (!hasNan) {
+        for (int32_t i = 0; i < numSamples; i++) {
+            outputBuffer[i] = processFloatBranchless(inputBuffer[i]);
+        }
+        mLastValidOutput = outputBuffer[numSamples - 1];
+        return;
+    }
 
     // Cache the last valid output to reduce memory read/write
     float lastValidOutput = mLastValidOutput;
@@ -44,8 +60,6 @@ int32_t Limiter::onProcess(int32_t numFrames) {
         *outputBuffer++ = lastValidOutput;
     }
     mLastValidOutput = lastValidOutput;
-
-    return numFrames;
 }
 
 float Limiter::processFloat(float in)
@@ -18,6 +18,7 @@
 #define FLOWGRAPH_LIMITER_H
 
 #include <atomic>
+#include <math.h>
 #include <unistd.h>
 #include <sys/types.h>
 
@@ -31,6 +32,13 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    /**
+     * Limit numSamples samples without going through the ports.
+     * This is used when a graph is executed in a single pass.
+     * The input and output may be the same buffer.
+     */
+    void processBuffer(const float *inputBuffer, float *outputBuffer, int32_t numSamples);
+
     const char *getName() override {
         return "Limiter";
     }
@@ -55,6 +63,18 @@ private:
      */
     float processFloat(float in);
 
+    /**
+     * Same as processFloat() without branches, so that loops calling it can be vectorized.
+     */
+    static inline float processFloatBranchless(float in) {
+        const float in_abs = fabsf(in);
+        const float spline =
+                (kPolynomialSplineA * in_abs + kPolynomialSplineB) * in_abs + kPolynomialSplineC;
+        float out = in_abs < kXWhenYis3Decibels ? spline : (float) M_SQRT2;
+        out = in_abs <= 1 ? in_abs : out;
+        return copysignf(out, in);
+    }
+
     // Use the previous valid output for NaN inputs
     float mLastValidOutput = 0.0f;
 };
@@ -27,9 +27,22 @@ MonoBlend::MonoBlend(int32_t channelCount)
 }
 
 int32_t MonoBlend::onProcess(int32_t numFrames) {
-    int32_t channelCount = output.getSamplesPerFrame();
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    processBuffer(input.getBuffer(), output.getBuffer(), numFrames);
+    return numFrames;
+}
+
+void MonoBlend::processBuffer(const float *inputBuffer, float *outputBuffer, int32_t numFrames) {
+    const int32_t channelCount = output.getSamplesPerFrame();
+
+    if (channelCount == 2) {
+        // Common case, written so that the compiler can vectorize it.
+        for (int32_t i = 0; i < numFrames; ++i) {
+            const float accum = (inputBuffer[2 * i] + inputBuffer[2 * i + 1]) * mInvChannelCount;
+            outputBuffer[2 * i] = accum;
+            outputBuffer[2 * i + 1] = accum;
+        }
+        return;
+    }
 
     for (size_t i = 0; i < numFrames; ++i) {
         float accum = 0;
@@ -41,6 +54,4 @@ int32_t MonoBlend::onProcess(int32_t numFrames) {
             *outputBuffer++ = accum;
         }
     }
-
-    return numFrames;
 }
@@ -36,6 +36,13 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    /**
+     * Blend numFrames interleaved frames without going through the ports.
+     * This is used when a graph is executed in a single pass.
+     * The input and output may be the same buffer.
+     */
+    void processBuffer(const float *inputBuffer, float *outputBuffer, int32_t numFrames);
+
     const char *getName() override {
         return "MonoBlend";
     }
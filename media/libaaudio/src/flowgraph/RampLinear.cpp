@@ -42,11 +42,7 @@ float RampLinear::interpolateCurrent() {
     return mLevelTo - (mRemaining * mScaler);
 }
 
-int32_t RampLinear::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-    int32_t channelCount = output.getSamplesPerFrame();
-
+void RampLinear::updateRamp() {
     float target = getTarget();
     if (target != mLevelTo) {
         // Start new ramp. Continue from previous level.
@@ -55,6 +51,29 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
         mRemaining = mLengthInFrames;
         mScaler = (mLevelTo - mLevelFrom) / mLengthInFrames; // for interpolation
     }
+}
+
+int32_t RampLinear::advance(float *levels, int32_t numFrames) {
+    // Count this as a call, so that setTarget() ramps from now on, as after onProcess().
+    if (mLastCallCount == kInitialCallCount) {
+        mLastCallCount = kInitialCallCount + 1;
+    }
+    updateRamp();
+
+    const int32_t framesToRamp = std::min(numFrames, mRemaining);
+    for (int32_t i = 0; i < framesToRamp; i++) {
+        levels[i] = interpolateCurrent();
+        mRemaining--;
+    }
+    return framesToRamp;
+}
+
+int32_t RampLinear::onProcess(int32_t numFrames) {
+    const float *inputBuffer = input.getBuffer();
+    float *outputBuffer = output.getBuffer();
+    int32_t channelCount = output.getSamplesPerFrame();
+
+    updateRamp();
 
     int32_t framesLeft = numFrames;
 
@@ -74,6 +74,26 @@ public:
         mLevelTo = level;
     }
 
+    /**
+     * Advance the ramp by numFrames frames without going through the ports.
+     * This is used when a graph is executed in a single pass.
+     *
+     * The levels of the frames which are still ramping are written to levels,
+     * the following frames are at getLevel().
+     *
+     * @param levels buffer for at least numFrames levels
+     * @param numFrames
+     * @return number of frames written to levels
+     */
+    int32_t advance(float *levels, int32_t numFrames);
+
+    /**
+     * @return the level at the end of the current ramp
+     */
+    float getLevel() const {
+        return mLevelTo;
+    }
+
     const char *getName() override {
         return "RampLinear";
     }
@@ -82,6 +102,9 @@ private:
 
     float interpolateCurrent();
 
+    // Start a new ramp if the target changed.
+    void updateRamp();
+
     std::atomic<float>  mTarget;
 
     int32_t             mLengthInFrames  = 48000.0f / 100.0f ; // 10 msec at 48000 Hz;
@@ -21,6 +21,7 @@
 #include "MultiChannelResampler.h"
 #include "PolyphaseResampler.h"
 #include "PolyphaseResamplerMono.h"
+#include "PolyphaseResamplerMulti.h"
 #include "PolyphaseResamplerStereo.h"
 #include "SincResampler.h"
 #include "SincResamplerStereo.h"
@@ -47,11 +48,13 @@ MultiChannelResampler::MultiChannelResampler(const MultiChannelResampler::Builde
 MultiChannelResampler *MultiChannelResampler::make(int32_t channelCount,
                                                    int32_t inputRate,
                                                    int32_t outputRate,
-                                                   Quality quality) {
+                                                   Quality quality,
+                                                   CoefficientPrecision precision) {
     Builder builder;
     builder.setInputRate(inputRate);
     builder.setOutputRate(outputRate);
     builder.setChannelCount(channelCount);
+    builder.setCoefficientPrecision(precision);
 
     switch (quality) {
         case Quality::Fastest:
@@ -88,12 +91,14 @@ MultiChannelResampler *MultiChannelResampler::Builder::build() {
     ratio.reduce();
     bool usePolyphase = (getNumTaps() * ratio.getDenominator()) <= kMaxCoefficients;
     if (usePolyphase) {
-        if (getChannelCount() == 1) {
+        // The mono and stereo resamplers only support float coefficients.
+        const bool useFloat = getCoefficientPrecision() == CoefficientPrecision::Float;
+        if (useFloat && getChannelCount() == 1) {
             return new PolyphaseResamplerMono(*this);
-        } else if (getChannelCount() == 2) {
+        } else if (useFloat && getChannelCount() == 2) {
             return new PolyphaseResamplerStereo(*this);
         } else {
-            return new PolyphaseResampler(*this);
+            return new PolyphaseResamplerMulti(*this);
         }
     } else {
         // Use less optimized resampler that uses a float phaseIncrement.
@@ -50,6 +50,16 @@ public:
         Best,
     };
 
+    /**
+     * Storage of the polyphase filter coefficients.
+     * Int16 halves the size of the coefficient table, which keeps large tables in the cache,
+     * at the cost of a noise floor around -90 dB.
+     */
+    enum class CoefficientPrecision : int32_t {
+        Float,
+        Int16,
+    };
+
     class Builder {
     public:
         /**
@@ -142,12 +152,29 @@ public:
             return mNormalizedCutoff;
         }
 
+        /**
+         * Only used by the polyphase resamplers, which are selected when the
+         * coefficient table is small enough. Default is Float.
+         *
+         * @param precision storage of the filter coefficients
+         * @return address of this builder for chaining calls
+         */
+        Builder *setCoefficientPrecision(CoefficientPrecision precision) {
+            mCoefficientPrecision = precision;
+            return this;
+        }
+
+        CoefficientPrecision getCoefficientPrecision() const {
+            return mCoefficientPrecision;
+        }
+
     protected:
         int32_t mChannelCount = 1;
         int32_t mNumTaps = 16;
         int32_t mInputRate = 48000;
         int32_t mOutputRate = 48000;
         float   mNormalizedCutoff = kDefaultNormalizedCutoff;
+        CoefficientPrecision mCoefficientPrecision = CoefficientPrecision::Float;
     };
 
     virtual ~MultiChannelResampler() = default;
@@ -159,12 +186,15 @@ public:
      * @param inputRate sample rate of the input stream
      * @param outputRate  sample rate of the output stream
      * @param quality higher quality sounds better but uses more CPU
+     * @param precision storage of the filter coefficients
      * @return an optimal resampler
      */
     static MultiChannelResampler *make(int32_t channelCount,
                                        int32_t inputRate,
                                        int32_t outputRate,
-                                       Quality quality);
+                                       Quality quality,
+                                       CoefficientPrecision precision =
+                                               CoefficientPrecision::Float);
 
     bool isWriteNeeded() const {
         return mIntegerPhase >= mDenominator;
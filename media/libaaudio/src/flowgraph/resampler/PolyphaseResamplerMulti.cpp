@@ -0,0 +1,106 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <math.h>
+#include "PolyphaseResamplerMulti.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+PolyphaseResamplerMulti::PolyphaseResamplerMulti(const MultiChannelResampler::Builder &builder)
+        : PolyphaseResampler(builder) {
+    if (builder.getCoefficientPrecision() == CoefficientPrecision::Int16) {
+        mCoefficients16.resize(mCoefficients.size());
+        for (size_t i = 0; i < mCoefficients.size(); i++) {
+            const float scaled = roundf(mCoefficients[i] * (1 << kInt16FractionBits));
+            mCoefficients16[i] = static_cast<int16_t>(std::clamp(scaled,
+                    static_cast<float>(INT16_MIN), static_cast<float>(INT16_MAX)));
+        }
+        // Only the Int16 table is used from now on.
+        std::vector<float>().swap(mCoefficients);
+    }
+}
+
+/**
+ * Run the FIR for NUM_CHANNELS adjacent channels of an interleaved frame.
+ * The accumulators stay in registers, and the loop over channels can be vectorized.
+ *
+ * For float coefficients, scale is 1.0 and the result matches PolyphaseResampler::readFrame().
+ */
+template <int NUM_CHANNELS, typename T>
+static inline void dotChannels(const float *xFrame, const T *coefficients,
+                               int32_t numTaps, int32_t channelCount, float scale,
+                               float *frame) {
+    float sums[NUM_CHANNELS] = {};
+    for (int32_t tap = 0; tap < numTaps; tap++) {
+        const float coefficient = static_cast<float>(coefficients[tap]);
+        for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+            sums[channel] += xFrame[channel] * coefficient;
+        }
+        xFrame += channelCount;
+    }
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+        frame[channel] = sums[channel] * scale;
+    }
+}
+
+template <typename T>
+void PolyphaseResamplerMulti::readChannels(const float *xFrame, const T *coefficients,
+                                           float scale, float *frame) {
+    const int32_t channelCount = getChannelCount();
+    int32_t channel = 0;
+    for (; channel + 8 <= channelCount; channel += 8) {
+        dotChannels<8>(&xFrame[channel], coefficients, mNumTaps, channelCount, scale,
+                       &frame[channel]);
+    }
+    if (channel + 4 <= channelCount) {
+        dotChannels<4>(&xFrame[channel], coefficients, mNumTaps, channelCount, scale,
+                       &frame[channel]);
+        channel += 4;
+    }
+    switch (channelCount - channel) {
+        case 3:
+            dotChannels<3>(&xFrame[channel], coefficients, mNumTaps, channelCount, scale,
+                           &frame[channel]);
+            break;
+        case 2:
+            dotChannels<2>(&xFrame[channel], coefficients, mNumTaps, channelCount, scale,
+                           &frame[channel]);
+            break;
+        case 1:
+            dotChannels<1>(&xFrame[channel], coefficients, mNumTaps, channelCount, scale,
+                           &frame[channel]);
+            break;
+        default:
+            break;
+    }
+}
+
+void PolyphaseResamplerMulti::readFrame(float *frame) {
+    const float *xFrame = &mX[static_cast<size_t>(mCursor)
+            * static_cast<size_t>(getChannelCount())];
+    size_t coefficientCount;
+    if (mCoefficients16.empty()) {
+        readChannels(xFrame, &mCoefficients[mCoefficientCursor], 1.0f, frame);
+        coefficientCount = mCoefficients.size();
+    } else {
+        readChannels(xFrame, &mCoefficients16[mCoefficientCursor], kInt16Scale, frame);
+        coefficientCount = mCoefficients16.size();
+    }
+
+    // Advance and wrap through coefficients.
+    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % coefficientCount;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_POLYPHASE_RESAMPLER_MULTI_H
+#define RESAMPLER_POLYPHASE_RESAMPLER_MULTI_H
+
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "PolyphaseResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * Polyphase resampler for any number of channels.
+ *
+ * The FIR is computed for a block of interleaved channels at a time, with one accumulator
+ * per channel, so that the inner loop is a vector multiply-add of the block by one coefficient.
+ * Blocks are 8 and 4 channels wide, with a narrower block for the remaining channels.
+ *
+ * This also supports CoefficientPrecision::Int16, which replaces the float coefficient
+ * table by one half its size.
+ */
+class PolyphaseResamplerMulti : public PolyphaseResampler {
+public:
+    explicit PolyphaseResamplerMulti(const MultiChannelResampler::Builder &builder);
+
+    virtual ~PolyphaseResamplerMulti() = default;
+
+    void readFrame(float *frame) override;
+
+private:
+    template <typename T>
+    void readChannels(const float *xFrame, const T *coefficients, float scale, float *frame);
+
+    // Coefficients are stored as Q2.14 for CoefficientPrecision::Int16, with room for
+    // the main tap which can be slightly above 1.0.
+    static constexpr int   kInt16FractionBits = 14;
+    static constexpr float kInt16Scale = 1.0f / (1 << kInt16FractionBits);
+
+    std::vector<int16_t>   mCoefficients16; // empty unless CoefficientPrecision::Int16
+};
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_POLYPHASE_RESAMPLER_MULTI_H
@@ -166,6 +166,16 @@ int32_t AAudioProperty_getInputMMapOffsetMicros();
 int32_t AAudioProperty_getOutputMMapOffsetMicros();
 #define AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC   "aaudio.out_mmap_offset_usec"
 
+/**
+ * Read a system property that enables just-in-time scheduling of the mixer for
+ * shared MMAP output streams. When enabled the mixer wakes up shortly before the DSP needs
+ * the next burst, as predicted by the timing model, instead of as soon as there is room.
+ *
+ * @return true if the mixer should be scheduled just-in-time, the default
+ */
+bool AAudioProperty_isJustInTimeMixerEnabled();
+#define AAUDIO_PROP_JIT_MIXER   "aaudio.jit_mixer"
+
 // These are powers of two that can be combined as a bit mask.
 // AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM must be enabled before the stream is opened.
 #define AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM   1
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the per-node and fused execution of AAudioFlowGraph for the conversions
+// done by AudioStreamInternalPlay, at 48 kHz with 4 ms bursts.
+//
+// Each benchmark takes (fused, scenario flags). An item is one frame.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "client/AAudioFlowGraph.h"
+
+using namespace aaudio::resampler;
+
+static constexpr int32_t kSampleRate = 48000;
+static constexpr int32_t kFramesPerBurst = 192;
+
+enum : int64_t {
+    kMonoSource   = 1 << 0,   // mono application data expanded to stereo
+    kFloatSource  = 1 << 1,   // float application data, which adds the limiter
+    kMonoBlend    = 1 << 2,   // accessibility mono blend
+    kVolumeRamps  = 1 << 3,   // volume ramps for balance and stream volume
+    kI16Sink      = 1 << 4,   // 16 bit device instead of float
+    kRamping      = 1 << 5,   // a volume change on every burst
+};
+
+static void BM_FlowGraph(benchmark::State& state) {
+    const bool fused = state.range(0) != 0;
+    const int64_t flags = state.range(1);
+    const int32_t sourceChannelCount = (flags & kMonoSource) ? 1 : 2;
+    const int32_t sinkChannelCount = 2;
+    const audio_format_t sourceFormat = (flags & kFloatSource)
+            ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const audio_format_t sinkFormat = (flags & kI16Sink)
+            ? AUDIO_FORMAT_PCM_16_BIT : AUDIO_FORMAT_PCM_FLOAT;
+
+    AAudioFlowGraph flowGraph;
+    flowGraph.setFusedExecutionAllowed(fused);
+    if (flowGraph.configure(sourceFormat, sourceChannelCount, kSampleRate,
+            sinkFormat, sinkChannelCount, kSampleRate,
+            (flags & kMonoBlend) != 0, (flags & kVolumeRamps) != 0,
+            0.2f /* audioBalance */, MultiChannelResampler::Quality::Medium) != AAUDIO_OK) {
+        state.SkipWithError("configure failed");
+        return;
+    }
+    if (flowGraph.isFused() != fused) {
+        state.SkipWithError("unexpected execution mode");
+        return;
+    }
+    flowGraph.setRampLengthInFrames(kFramesPerBurst / 2);
+
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    const size_t numSamples = kFramesPerBurst * sourceChannelCount;
+    std::vector<float> floatSource(numSamples);
+    std::generate(floatSource.begin(), floatSource.end(), [&] { return dis(gen); });
+    std::vector<int16_t> i16Source(numSamples);
+    std::transform(floatSource.begin(), floatSource.end(), i16Source.begin(),
+            [](float f) { return (int16_t)(f * INT16_MAX); });
+    const void *source = (flags & kFloatSource)
+            ? (const void *) floatSource.data() : (const void *) i16Source.data();
+    // large enough for float samples
+    std::vector<float> sink(kFramesPerBurst * sinkChannelCount);
+
+    float volume = 1.0f;
+    for (auto _ : state) {
+        if (flags & kRamping) {
+            volume = volume == 1.0f ? 0.5f : 1.0f;
+            flowGraph.setTargetVolume(volume);
+        }
+        benchmark::DoNotOptimize(
+                flowGraph.process(source, kFramesPerBurst, sink.data(), kFramesPerBurst));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+static void FlowGraphArgs(benchmark::internal::Benchmark *b) {
+    for (int64_t fused : {0, 1}) {
+        // I16 to float with stream volume, the typical shared MMAP playback path.
+        b->Args({fused, kVolumeRamps});
+        b->Args({fused, kVolumeRamps | kRamping});
+        b->Args({fused, kMonoSource | kVolumeRamps});
+        b->Args({fused, kMonoBlend | kVolumeRamps});
+        b->Args({fused, kI16Sink | kVolumeRamps});
+        // Float to float, with the limiter.
+        b->Args({fused, kFloatSource | kVolumeRamps});
+        // Format conversion only.
+        b->Args({fused, 0});
+    }
+}
+
+BENCHMARK(BM_FlowGraph)->Apply(FlowGraphArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the cost of the AAudio polyphase resamplers for 44.1 kHz to 48 kHz,
+// across channel counts and Quality levels.
+//
+// Each benchmark takes (channelCount, quality, implementation), where implementation is
+// 0 for the generic scalar PolyphaseResampler, 1 for the resampler selected by
+// MultiChannelResampler::make() and 2 for the same with Int16 coefficients.
+// An item is one output frame.
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/PolyphaseResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+static constexpr int32_t kInputRate = 44100;
+static constexpr int32_t kOutputRate = 48000;
+static constexpr int32_t kFramesPerBurst = 192;
+
+// Number of taps used by make() for each Quality.
+static int32_t numTapsForQuality(MultiChannelResampler::Quality quality) {
+    switch (quality) {
+        case MultiChannelResampler::Quality::Low: return 4;
+        case MultiChannelResampler::Quality::Medium: return 8;
+        case MultiChannelResampler::Quality::High: return 16;
+        case MultiChannelResampler::Quality::Best: return 32;
+        default: return 8;
+    }
+}
+
+static void BM_Resampler(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    const auto quality = static_cast<MultiChannelResampler::Quality>(state.range(1));
+    const int64_t implementation = state.range(2);
+
+    std::unique_ptr<MultiChannelResampler> resampler;
+    if (implementation == 0) {
+        MultiChannelResampler::Builder builder;
+        builder.setChannelCount(channelCount)
+                ->setNumTaps(numTapsForQuality(quality))
+                ->setInputRate(kInputRate)
+                ->setOutputRate(kOutputRate);
+        resampler = std::make_unique<PolyphaseResampler>(builder);
+    } else {
+        resampler.reset(MultiChannelResampler::make(channelCount, kInputRate, kOutputRate,
+                quality, implementation == 2
+                        ? MultiChannelResampler::CoefficientPrecision::Int16
+                        : MultiChannelResampler::CoefficientPrecision::Float));
+    }
+
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFramesPerBurst * channelCount);
+    std::generate(input.begin(), input.end(), [&] { return dis(gen); });
+    std::vector<float> output(kFramesPerBurst * channelCount);
+
+    // Produce one burst of output per iteration, wrapping through the input.
+    int32_t inputIndex = 0;
+    for (auto _ : state) {
+        float *frame = output.data();
+        for (int32_t i = 0; i < kFramesPerBurst; ) {
+            if (resampler->isWriteNeeded()) {
+                resampler->writeNextFrame(&input[inputIndex * channelCount]);
+                inputIndex = (inputIndex + 1) % kFramesPerBurst;
+            } else {
+                resampler->readNextFrame(frame);
+                frame += channelCount;
+                i++;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+static void ResamplerArgs(benchmark::internal::Benchmark *b) {
+    for (int64_t channelCount : {1, 2, 4, 6, 8, 12, 16}) {
+        for (auto quality : {MultiChannelResampler::Quality::Low,
+                MultiChannelResampler::Quality::Medium,
+                MultiChannelResampler::Quality::High,
+                MultiChannelResampler::Quality::Best}) {
+            for (int64_t implementation : {0, 1, 2}) {
+                b->Args({channelCount, static_cast<int64_t>(quality), implementation});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Resampler)->Apply(ResamplerArgs);
+
+BENCHMARK_MAIN();
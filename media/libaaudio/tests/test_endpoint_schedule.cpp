@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit tests for the EndpointSchedule shared by the AAudio service with shared streams.
+
+#include <gtest/gtest.h>
+
+#include <binding/AAudioServiceDefinitions.h>
+
+using namespace aaudio;
+
+static constexpr int64_t kNextServiceTime = 1'000'000'000;
+static constexpr int64_t kServicePeriod = 2'000'000;
+
+static int64_t nearest(int64_t time) {
+    return EndpointSchedule::nearestServiceTime(time, kNextServiceTime, kServicePeriod);
+}
+
+TEST(test_endpoint_schedule, read_before_write) {
+    EndpointSchedule schedule;
+    int64_t next = -1;
+    int64_t period = -1;
+    EXPECT_FALSE(schedule.read(&next, &period));
+}
+
+TEST(test_endpoint_schedule, read_after_write) {
+    EndpointSchedule schedule;
+    schedule.write(kNextServiceTime, kServicePeriod);
+    int64_t next = 0;
+    int64_t period = 0;
+    ASSERT_TRUE(schedule.read(&next, &period));
+    EXPECT_EQ(kNextServiceTime, next);
+    EXPECT_EQ(kServicePeriod, period);
+    EXPECT_EQ(2u, schedule.sequence.load());
+
+    schedule.write(kNextServiceTime + kServicePeriod, kServicePeriod);
+    ASSERT_TRUE(schedule.read(&next, &period));
+    EXPECT_EQ(kNextServiceTime + kServicePeriod, next);
+}
+
+TEST(test_endpoint_schedule, read_during_write) {
+    EndpointSchedule schedule;
+    schedule.write(kNextServiceTime, kServicePeriod);
+    // As left by a service that died while writing.
+    schedule.sequence.store(schedule.sequence.load() + 1);
+    int64_t next = 0;
+    int64_t period = 0;
+    EXPECT_FALSE(schedule.read(&next, &period));
+}
+
+TEST(test_endpoint_schedule, read_zero_period) {
+    EndpointSchedule schedule;
+    schedule.write(kNextServiceTime, 0);
+    int64_t next = 0;
+    int64_t period = 0;
+    EXPECT_FALSE(schedule.read(&next, &period));
+}
+
+TEST(test_endpoint_schedule, nearest_after_next) {
+    EXPECT_EQ(kNextServiceTime, nearest(kNextServiceTime));
+    EXPECT_EQ(kNextServiceTime, nearest(kNextServiceTime + 1));
+    EXPECT_EQ(kNextServiceTime, nearest(kNextServiceTime + kServicePeriod / 2 - 1));
+    EXPECT_EQ(kNextServiceTime + kServicePeriod,
+              nearest(kNextServiceTime + kServicePeriod / 2));
+    EXPECT_EQ(kNextServiceTime + 3 * kServicePeriod,
+              nearest(kNextServiceTime + 3 * kServicePeriod - 1));
+}
+
+// The division must round toward negative infinity when the time is before the schedule.
+TEST(test_endpoint_schedule, nearest_before_next) {
+    EXPECT_EQ(kNextServiceTime, nearest(kNextServiceTime - 1));
+    EXPECT_EQ(kNextServiceTime, nearest(kNextServiceTime - kServicePeriod / 2));
+    EXPECT_EQ(kNextServiceTime - kServicePeriod,
+              nearest(kNextServiceTime - kServicePeriod / 2 - 1));
+    EXPECT_EQ(kNextServiceTime - kServicePeriod, nearest(kNextServiceTime - kServicePeriod));
+    EXPECT_EQ(kNextServiceTime - kServicePeriod,
+              nearest(kNextServiceTime - kServicePeriod - 1));
+    EXPECT_EQ(kNextServiceTime - 3 * kServicePeriod,
+              nearest(kNextServiceTime - 3 * kServicePeriod + kServicePeriod / 4));
+    EXPECT_EQ(kNextServiceTime - 4 * kServicePeriod,
+              nearest(kNextServiceTime - 3 * kServicePeriod - kServicePeriod / 2 - 1));
+}
+
+TEST(test_endpoint_schedule, nearest_odd_period) {
+    constexpr int64_t kOddPeriod = 1001;
+    EXPECT_EQ(kNextServiceTime - kOddPeriod,
+              EndpointSchedule::nearestServiceTime(kNextServiceTime - 501, kNextServiceTime,
+                                                   kOddPeriod));
+    EXPECT_EQ(kNextServiceTime,
+              EndpointSchedule::nearestServiceTime(kNextServiceTime - 500, kNextServiceTime,
+                                                   kOddPeriod));
+    EXPECT_EQ(kNextServiceTime + kOddPeriod,
+              EndpointSchedule::nearestServiceTime(kNextServiceTime + 501, kNextServiceTime,
+                                                   kOddPeriod));
+}
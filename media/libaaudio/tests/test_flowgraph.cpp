@@ -509,6 +509,117 @@ TEST(test_flowgraph, module_sourceI8_24) {
     }
 }
 
+// Run the same data through a fused and a per-node flowgraph and compare the float outputs.
+void checkFusedMatchesNodes(audio_format_t sourceFormat, int32_t sourceChannelCount,
+                            int32_t sinkChannelCount, bool useMonoBlend, bool useVolumeRamps) {
+    AAudioFlowGraph flowgraphs[2];
+    for (int i = 0; i < 2; i++) {
+        flowgraphs[i].setFusedExecutionAllowed(i == 1);
+        ASSERT_EQ(AAUDIO_OK, flowgraphs[i].configure(sourceFormat,
+                sourceChannelCount,
+                48000 /* sourceSampleRate */,
+                AUDIO_FORMAT_PCM_FLOAT /* sinkFormat */,
+                sinkChannelCount,
+                48000 /* sinkSampleRate */,
+                useMonoBlend,
+                useVolumeRamps,
+                0.3f /* audioBalance */,
+                MultiChannelResampler::Quality::Medium));
+        flowgraphs[i].setRampLengthInFrames(100);
+    }
+    ASSERT_FALSE(flowgraphs[0].isFused());
+    ASSERT_TRUE(flowgraphs[1].isFused());
+
+    constexpr int kMaxFrames = 600;
+    float inputFloat[kMaxFrames * 2];
+    int16_t inputI16[kMaxFrames * 2];
+    for (int i = 0; i < kMaxFrames * 2; i++) {
+        // Include values beyond full scale to exercise the limiter.
+        inputFloat[i] = 1.5f * sinf(i * 0.01f) * ((i & 1) ? 1.0f : -0.7f);
+        inputI16[i] = (int16_t) (inputFloat[i] * 16384);
+    }
+    const void *input = (sourceFormat == AUDIO_FORMAT_PCM_FLOAT)
+            ? (const void *) inputFloat : (const void *) inputI16;
+
+    float outputs[2][kMaxFrames * 2];
+    const float volumes[] = {1.0f, 0.5f, 0.5f, 0.25f, 1.0f};
+    int numFrames = 37;
+    for (float volume : volumes) {
+        for (int i = 0; i < 2; i++) {
+            flowgraphs[i].setTargetVolume(volume);
+            ASSERT_EQ(numFrames, flowgraphs[i].process(input, numFrames,
+                    outputs[i], numFrames));
+        }
+        for (int i = 0; i < numFrames * sinkChannelCount; i++) {
+            EXPECT_EQ(outputs[0][i], outputs[1][i]) << ", i = " << i;
+        }
+        numFrames = std::min(numFrames * 2 + 3, kMaxFrames);
+    }
+}
+
+TEST(test_flowgraph, flowgraph_fused_matches_nodes) {
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_16_BIT, 2, 2, false, true);
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_16_BIT, 1, 2, false, true);
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_16_BIT, 2, 2, true, true);
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_FLOAT, 2, 2, false, true);
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_FLOAT, 1, 2, true, false);
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_FLOAT, 2, 2, false, false);
+}
+
+// Change the volume after part of a burst was read. The ramp must start at the next read,
+// also within a fused block, and the fused output must still match the per-node output.
+TEST(test_flowgraph, flowgraph_fused_volume_mid_burst) {
+    constexpr int32_t kNumFrames = 600;
+    constexpr int32_t kRampFrames = 20;
+    constexpr float kInput = 0.5f;
+    constexpr float kOldVolume = 1.0f;
+    constexpr float kNewVolume = 0.25f;
+    float input[kNumFrames];
+    std::fill(std::begin(input), std::end(input), kInput);
+
+    for (int32_t split : {1, 8, 13, 100, 255, 256, 257, 500}) {
+        SCOPED_TRACE(testing::Message() << "split " << split);
+        AAudioFlowGraph flowgraphs[2];
+        float outputs[2][kNumFrames * 2];
+        for (int i = 0; i < 2; i++) {
+            flowgraphs[i].setFusedExecutionAllowed(i == 1);
+            ASSERT_EQ(AAUDIO_OK, flowgraphs[i].configure(AUDIO_FORMAT_PCM_FLOAT,
+                    1 /* sourceChannelCount */,
+                    48000 /* sourceSampleRate */,
+                    AUDIO_FORMAT_PCM_FLOAT /* sinkFormat */,
+                    2 /* sinkChannelCount */,
+                    48000 /* sinkSampleRate */,
+                    false /* useMonoBlend */,
+                    true /* useVolumeRamps */,
+                    0.0f /* audioBalance */,
+                    MultiChannelResampler::Quality::Medium));
+            flowgraphs[i].setRampLengthInFrames(kRampFrames);
+            flowgraphs[i].setTargetVolume(kOldVolume);
+            ASSERT_EQ(split, flowgraphs[i].process(input, kNumFrames, outputs[i], split));
+            flowgraphs[i].setTargetVolume(kNewVolume);
+            ASSERT_EQ(kNumFrames - split,
+                      flowgraphs[i].pull(&outputs[i][split * 2], kNumFrames - split));
+        }
+        ASSERT_TRUE(flowgraphs[1].isFused());
+
+        for (int i = 0; i < kNumFrames * 2; i++) {
+            EXPECT_EQ(outputs[0][i], outputs[1][i]) << "i = " << i;
+        }
+        const float *output = outputs[1];
+        // The first frame of the ramp is at the old level.
+        for (int32_t frame = 0; frame <= split; frame++) {
+            ASSERT_FLOAT_EQ(kInput * kOldVolume, output[frame * 2]) << "frame " << frame;
+        }
+        for (int32_t frame = split + 1; frame < split + kRampFrames; frame++) {
+            ASSERT_LT(output[frame * 2], output[frame * 2 - 2]) << "frame " << frame;
+        }
+        for (int32_t frame = split + kRampFrames; frame < kNumFrames; frame++) {
+            ASSERT_FLOAT_EQ(kInput * kNewVolume, output[frame * 2]) << "frame " << frame;
+            ASSERT_EQ(output[frame * 2], output[frame * 2 + 1]) << "frame " << frame;
+        }
+    }
+}
+
 void checkSampleRateConversionVariedSizes(int32_t sourceSampleRate,
                     int32_t sinkSampleRate,
                     MultiChannelResampler::Quality resamplerQuality) {
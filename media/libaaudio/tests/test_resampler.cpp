@@ -22,10 +22,12 @@
  */
 
 #include <iostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/PolyphaseResampler.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
@@ -223,3 +225,62 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+// Run the same multichannel input through two resamplers and compare the outputs.
+static void checkMultiChannelMatches(int32_t channelCount, int32_t numTaps,
+        MultiChannelResampler::CoefficientPrecision precision, float tolerance) {
+    MultiChannelResampler::Builder builder;
+    builder.setChannelCount(channelCount)
+            ->setNumTaps(numTaps)
+            ->setInputRate(44100)
+            ->setOutputRate(48000);
+    // The generic scalar implementation, which is the reference.
+    std::unique_ptr<MultiChannelResampler> reference =
+            std::make_unique<PolyphaseResampler>(builder);
+    builder.setCoefficientPrecision(precision);
+    std::unique_ptr<MultiChannelResampler> resampler(builder.build());
+
+    std::vector<float> input(channelCount);
+    std::vector<float> expected(channelCount);
+    std::vector<float> output(channelCount);
+    int inputIndex = 0;
+    for (int i = 0; i < 2000; i++) {
+        ASSERT_EQ(reference->isWriteNeeded(), resampler->isWriteNeeded());
+        if (resampler->isWriteNeeded()) {
+            for (int channel = 0; channel < channelCount; channel++) {
+                input[channel] = sinf((inputIndex + 1) * 0.01f * (channel + 1));
+            }
+            inputIndex++;
+            reference->writeNextFrame(input.data());
+            resampler->writeNextFrame(input.data());
+        } else {
+            reference->readNextFrame(expected.data());
+            resampler->readNextFrame(output.data());
+            for (int channel = 0; channel < channelCount; channel++) {
+                ASSERT_NEAR(expected[channel], output[channel], tolerance)
+                        << "channelCount = " << channelCount << ", numTaps = " << numTaps
+                        << ", channel = " << channel;
+            }
+        }
+    }
+}
+
+TEST(test_resampler, resampler_multichannel_matches_generic) {
+    for (int32_t numTaps : {4, 8, 16, 32}) {
+        for (int32_t channelCount = 3; channelCount <= 16; channelCount++) {
+            checkMultiChannelMatches(channelCount, numTaps,
+                    MultiChannelResampler::CoefficientPrecision::Float, 1.0e-6f);
+        }
+    }
+}
+
+TEST(test_resampler, resampler_int16_coefficients) {
+    for (int32_t numTaps : {4, 8, 16, 32}) {
+        for (int32_t channelCount : {1, 2, 6, 8, 12}) {
+            // Each coefficient is off by at most half of 2^-14.
+            checkMultiChannelMatches(channelCount, numTaps,
+                    MultiChannelResampler::CoefficientPrecision::Int16,
+                    numTaps * 0.5f / (1 << 14));
+        }
+    }
+}
@@ -558,6 +558,36 @@ status_t AudioEffect::getConfigs(
     return status;
 }
 
+status_t AudioEffect::getAnalysisRegion(sp<IMemory> *memory)
+{
+    if (mProbe) {
+        return INVALID_OPERATION;
+    }
+    if (mStatus != NO_ERROR && mStatus != ALREADY_EXISTS) {
+        return mStatus;
+    }
+    if (memory == NULL) {
+        return BAD_VALUE;
+    }
+    status_t status;
+    media::SharedFileRegion region;
+    Status bs = mIEffect->getAnalysisRegion(&region, &status);
+    if (!bs.isOk()) {
+        status = statusTFromBinderStatus(bs);
+        ALOGW("%s received status %d from binder transaction", __func__, status);
+        return status;
+    }
+    if (status != NO_ERROR) {
+        ALOGW("%s received status %d from the effect", __func__, status);
+        return status;
+    }
+    if (!convertSharedFileRegionToIMemory(region, memory) || *memory == nullptr) {
+        ALOGE("%s could not map the analysis region", __func__);
+        return NO_MEMORY;
+    }
+    return NO_ERROR;
+}
+
 // -------------------------------------------------------------------------
 
 void AudioEffect::binderDied()
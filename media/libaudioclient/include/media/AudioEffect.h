@@ -598,6 +598,24 @@ public:
      virtual status_t   getConfigs(audio_config_base_t *inputCfg,
                                    audio_config_base_t *outputCfg);
 
+    /* Returns the read only shared memory in which the audio server publishes the analysis of
+     * the input of a Visualizer effect, see audio_effects/effect_visualizer_analysis.h.
+     * The analysis runs while the effect is enabled and at least one AudioEffect holding the
+     * memory exists. Does not require control of the effect.
+     *
+     * Parameters:
+     *      memory: receives the memory, to be read with visualizer_analysis_read_latest().
+     *
+     * Returned status (from utils/Errors.h) can be:
+     *  - NO_ERROR: successful operation.
+     *  - INVALID_OPERATION: the AudioEffect was not successfully initialized, or the effect is
+     *          not a Visualizer.
+     *  - BAD_VALUE: null memory pointer
+     *  - NO_MEMORY: the memory could not be allocated or shared.
+     *  - DEAD_OBJECT: the effect engine has been deleted.
+     */
+     virtual status_t   getAnalysisRegion(sp<IMemory> *memory);
+
      /*
       * Utility functions.
       */
@@ -147,6 +147,7 @@ void AudioMixer::Track::unprepareForDownmix() {
     }
 
     mDownmixRequiresFormat = AUDIO_FORMAT_INVALID;
+    mDownmixIsChannelMix = false;
     if (mDownmixerBufferProvider.get() != nullptr) {
         // this track had previously been configured with a downmixer, delete it
         mDownmixerBufferProvider.reset(nullptr);
@@ -201,6 +202,7 @@ status_t AudioMixer::Track::prepareForDownmix()
         if (static_cast<ChannelMixBufferProvider *>(mDownmixerBufferProvider.get())
                 ->isValid()) {
             mDownmixRequiresFormat = mMixerInFormat;
+            mDownmixIsChannelMix = true;
             reconfigureBufferProviders();
             ALOGD("%s: Fallback using ChannelMix", __func__);
             return NO_ERROR;
@@ -242,7 +244,21 @@ status_t AudioMixer::Track::prepareForReformat()
     const audio_format_t targetFormat = mDownmixRequiresFormat != AUDIO_FORMAT_INVALID
             ? mDownmixRequiresFormat : mMixerInFormat;
     bool requiresReconfigure = false;
-    if (mFormat != targetFormat) {
+    // The ChannelMix downmixer converts integer input itself, a block at a time,
+    // which saves a pass over the data and the ReformatBufferProvider buffer.
+    bool reformatInDownmix = false;
+    if (mDownmixIsChannelMix) {
+        reformatInDownmix = ChannelMixBufferProvider::isInputFormatSupported(mFormat);
+        const audio_format_t downmixInputFormat = reformatInDownmix ? mFormat : targetFormat;
+        if (static_cast<ChannelMixBufferProvider *>(mDownmixerBufferProvider.get())
+                ->getInputFormat() != downmixInputFormat) {
+            mDownmixerBufferProvider.reset(new ChannelMixBufferProvider(channelMask,
+                    mMixerChannelMask, targetFormat, kCopyBufferFrameCount,
+                    downmixInputFormat));
+            requiresReconfigure = true;
+        }
+    }
+    if (mFormat != targetFormat && !reformatInDownmix) {
         mReformatBufferProvider.reset(new ReformatBufferProvider(
                 audio_channel_count_from_out_mask(channelMask),
                 mFormat,
@@ -582,6 +598,7 @@ status_t AudioMixer::postCreateTrack(TrackBase *track)
     t->channelMask = channelMask;
     t->mInputBufferProvider = NULL;
     t->mDownmixRequiresFormat = AUDIO_FORMAT_INVALID; // no format required
+    t->mDownmixIsChannelMix = false;
     t->mPlaybackRate = AUDIO_PLAYBACK_RATE_DEFAULT;
     // haptic
     t->mHapticPlaybackEnabled = false;
@@ -19,6 +19,7 @@
 //#define LOG_NDEBUG 0
 
 #include <array>
+#include <atomic>
 #include <sstream>
 #include <string.h>
 
@@ -26,8 +27,10 @@
 #include <cutils/compiler.h>
 #include <media/AudioMixerBase.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include "AudioMixerOps.h"
+#include "AudioMixerOpsSimd.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -54,8 +57,36 @@ static constexpr int BLOCKSIZE = 16;
 
 namespace android {
 
+static_assert(BLOCKSIZE >= kMixerSimdMinFrames,
+        "the default no-resampling path must reach the SIMD volume kernels");
+
 // ----------------------------------------------------------------------------
 
+// Kernels set by setMixerKernelsForTest(), or nullptr for the kernels chosen for this CPU.
+static std::atomic<const MixerSimdKernels *> sMixerKernelsForTest{nullptr};
+
+static inline const MixerSimdKernels& mixerKernels()
+{
+    const MixerSimdKernels *kernels = sMixerKernelsForTest.load(std::memory_order_relaxed);
+    return kernels != nullptr ? *kernels : mixerSimdKernels();
+}
+
+/* static */
+void AudioMixerBase::selectMixerKernels()
+{
+    // The kernels are chosen once per process; this just makes sure it happens here
+    // rather than on the first call from the mixer thread.
+    const MixerSimdKernels& kernels = mixerSimdKernels();
+    ALOGV("%s: using %s mixer kernels", __func__, kernels.name);
+    (void)kernels;
+}
+
+/* static */
+void AudioMixerBase::setMixerKernelsForTest(const MixerSimdKernels *kernels)
+{
+    sMixerKernelsForTest.store(kernels, std::memory_order_relaxed);
+}
+
 bool AudioMixerBase::isValidFormat(audio_format_t format) const
 {
     switch (format) {
@@ -617,6 +648,66 @@ std::string AudioMixerBase::trackNames() const
     return ss.str();
 }
 
+void AudioMixerBase::setTileFrameCount(size_t tileFrameCount)
+{
+    tileFrameCount = std::min(tileFrameCount, mFrameCount);
+    if (tileFrameCount != 0 && mOutputTemp.get() == nullptr) {
+        mOutputTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+    }
+    mTileFrameCount = tileFrameCount;
+    mTileCount = 0;
+    mTileFrames = 0;
+    mTileTotalNs = 0;
+    mTileMaxNs = 0;
+    invalidate();
+}
+
+void AudioMixerBase::setWorkerPool(const std::shared_ptr<AudioMixerWorkerPool>& workerPool)
+{
+    mWorkerPool = workerPool;
+    mWorkerTracks.clear();
+    if (mWorkerPool == nullptr) {
+        for (const auto &pair : mTracks) {
+            pair.second->mWorkerOut.reset();
+            pair.second->mWorkerTemp.reset();
+        }
+    }
+    invalidate();
+}
+
+/* static */
+size_t AudioMixerBase::tileFrameCountForCache(uint32_t channelCount, size_t cacheBytes)
+{
+    if (channelCount == 0) return BLOCKSIZE;
+    // the accumulator is int32_t, also when it holds float samples, and the current
+    // track input is at most 4 bytes per sample.
+    const size_t bytesPerFrame = 2 * channelCount * sizeof(int32_t);
+    const size_t frames = cacheBytes / bytesPerFrame / BLOCKSIZE * BLOCKSIZE;
+    return std::max(frames, (size_t)BLOCKSIZE);
+}
+
+AudioMixerBase::TileStats AudioMixerBase::getTileStats() const
+{
+    TileStats stats;
+    stats.tiles = mTileCount.load(std::memory_order_relaxed);
+    stats.frames = mTileFrames.load(std::memory_order_relaxed);
+    stats.totalNs = mTileTotalNs.load(std::memory_order_relaxed);
+    stats.maxNs = mTileMaxNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string AudioMixerBase::TileStats::toString() const
+{
+    std::stringstream ss;
+    ss << "tiles:" << tiles;
+    if (tiles > 0) {
+        ss << " frames/tile:" << frames / tiles
+                << " avg ns/tile:" << totalNs / tiles
+                << " max ns/tile:" << maxNs;
+    }
+    return ss.str();
+}
+
 void AudioMixerBase::process__validate()
 {
     // TODO: fix all16BitsStereNoResample logic to
@@ -713,6 +804,16 @@ void AudioMixerBase::process__validate()
             if (mResampleTemp.get() == nullptr) {
                 mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
             }
+            if (mWorkerPool != nullptr) {
+                for (const int name : mEnabled) {
+                    const std::shared_ptr<TrackBase> &t = mTracks[name];
+                    if (usesWorkerPool(*t) && t->mWorkerOut.get() == nullptr) {
+                        t->mWorkerOut.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+                        t->mWorkerTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+                    }
+                }
+                mWorkerTracks.reserve(mEnabled.size());
+            }
             mHook = &AudioMixerBase::process__genericResampling;
         } else {
             // we keep temp arrays around.
@@ -1094,27 +1195,43 @@ void AudioMixerBase::process__nop()
 void AudioMixerBase::process__genericNoResampling()
 {
     ALOGVV("process__genericNoResampling\n");
+    if (mTileFrameCount != 0) {
+        // tiled mixing, see setTileFrameCount().
+        processNoResampling(mOutputTemp.get() /* naked ptr */, mTileFrameCount,
+                true /* recordTiles */);
+        return;
+    }
     int32_t outTemp[BLOCKSIZE * MAX_NUM_CHANNELS] __attribute__((aligned(32)));
+    processNoResampling(outTemp, BLOCKSIZE, false /* recordTiles */);
+}
 
+// mixes all tracks of each group blockFrameCount frames at a time into outTemp,
+// which holds at least blockFrameCount * MAX_NUM_CHANNELS samples.
+void AudioMixerBase::processNoResampling(
+        int32_t *outTemp, size_t blockFrameCount, bool recordTiles)
+{
     for (const auto &pair : mGroups) {
         // process by group of tracks with same output main buffer to
         // avoid multiple memset() on same buffer
         const auto &group = pair.second;
 
         // acquire buffer
+        uint32_t accumChannelCount = 0;
         for (const int name : group) {
             const std::shared_ptr<TrackBase> &t = mTracks[name];
             t->buffer.frameCount = mFrameCount;
             t->bufferProvider->getNextBuffer(&t->buffer);
             t->frameCount = t->buffer.frameCount;
             t->mIn = t->buffer.raw;
+            accumChannelCount = std::max(accumChannelCount, t->getMixerChannelCount());
         }
 
         int32_t *out = (int *)pair.first;
         size_t numFrames = 0;
         do {
-            const size_t frameCount = std::min((size_t)BLOCKSIZE, mFrameCount - numFrames);
-            memset(outTemp, 0, sizeof(outTemp));
+            const nsecs_t blockStartNs = recordTiles ? systemTime() : 0;
+            const size_t frameCount = std::min(blockFrameCount, mFrameCount - numFrames);
+            memset(outTemp, 0, frameCount * accumChannelCount * sizeof(*outTemp));
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
                 int32_t *aux = NULL;
@@ -1160,6 +1277,19 @@ void AudioMixerBase::process__genericNoResampling()
                     + frameCount * t1->mMixerChannelCount
                     * audio_bytes_per_sample(t1->mMixerFormat));
             numFrames += frameCount;
+            if (recordTiles) {
+                // only the mixer thread writes the tile statistics.
+                const int64_t tileNs = systemTime() - blockStartNs;
+                mTileCount.store(mTileCount.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+                mTileFrames.store(mTileFrames.load(std::memory_order_relaxed) + frameCount,
+                        std::memory_order_relaxed);
+                mTileTotalNs.store(mTileTotalNs.load(std::memory_order_relaxed) + tileNs,
+                        std::memory_order_relaxed);
+                if (tileNs > mTileMaxNs.load(std::memory_order_relaxed)) {
+                    mTileMaxNs.store(tileNs, std::memory_order_relaxed);
+                }
+            }
         } while (numFrames < mFrameCount);
 
         // release each track's buffer
@@ -1181,10 +1311,30 @@ void AudioMixerBase::process__genericResampling()
         const auto &group = pair.second;
         const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
 
+        // hand the independent resampling tracks to the worker pool, if there is enough
+        // work to share; they are processed while this thread mixes the other tracks.
+        mWorkerTracks.clear();
+        if (mWorkerPool != nullptr) {
+            for (const int name : group) {
+                const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (usesWorkerPool(*t)) {
+                    mWorkerTracks.push_back(t.get());
+                }
+            }
+            if (mWorkerTracks.size() < 2) {
+                mWorkerTracks.clear();
+            } else {
+                mWorkerPool->start(&AudioMixerBase::workerProcessTrack, this,
+                        mWorkerTracks.size());
+            }
+        }
+        const bool useWorkers = !mWorkerTracks.empty();
+
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
             const std::shared_ptr<TrackBase> &t = mTracks[name];
+            if (useWorkers && usesWorkerPool(*t)) continue;
             int32_t *aux = NULL;
             if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                 aux = t->auxBuffer;
@@ -1217,11 +1367,42 @@ void AudioMixerBase::process__genericResampling()
                 }
             }
         }
+
+        if (useWorkers) {
+            mWorkerPool->join();
+            const size_t sampleCount = numFrames * t1->mMixerChannelCount;
+            for (const TrackBase *t : mWorkerTracks) {
+                if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                    float * const accum = reinterpret_cast<float *>(outTemp);
+                    const float * const in = reinterpret_cast<const float *>(t->mWorkerOut.get());
+                    for (size_t i = 0; i < sampleCount; ++i) {
+                        accum[i] += in[i];
+                    }
+                } else {
+                    const int32_t * const in = t->mWorkerOut.get();
+                    for (size_t i = 0; i < sampleCount; ++i) {
+                        outTemp[i] += in[i];
+                    }
+                }
+            }
+        }
         convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
                 outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
     }
 }
 
+// Runs on a worker pool thread (or the mixer thread when it joins): resamples and
+// volume adjusts one track into its private buffer for process__genericResampling().
+/* static */
+void AudioMixerBase::workerProcessTrack(void *arg, size_t index)
+{
+    AudioMixerBase * const mixer = static_cast<AudioMixerBase *>(arg);
+    TrackBase * const t = mixer->mWorkerTracks[index];
+    const size_t numFrames = mixer->mFrameCount;
+    memset(t->mWorkerOut.get(), 0, sizeof(int32_t) * t->mMixerChannelCount * numFrames);
+    (t->*t->hook)(t->mWorkerOut.get(), numFrames, t->mWorkerTemp.get(), nullptr /* aux */);
+}
+
 // one track, 16 bits stereo without resampling is the most common case
 void AudioMixerBase::process__oneTrack16BitsStereoNoResampling()
 {
@@ -1350,6 +1531,13 @@ static void volumeRampMulti(uint32_t channels, TO* out, size_t frameCount,
 {
     static constexpr auto volumeRampMultiArray =
             makeVRMArray<MIXTYPE, TO, TI, TV, TA, TAV>(std::make_index_sequence<FCC_LIMIT>());
+    if constexpr (std::is_same_v<TO, float> && std::is_same_v<TI, float>
+            && std::is_same_v<TV, float>) {
+        if (aux == nullptr && volumeRampMultiSimd<MIXTYPE>(mixerKernels(),
+                channels, out, frameCount, in, vol, volinc)) {
+            return;
+        }
+    }
     if (channels > 0 && channels <= volumeRampMultiArray.size()) {
         volumeRampMultiArray[channels - 1](out, frameCount, in, aux, vol, volinc, vola, volainc);
     } else {
@@ -1380,6 +1568,13 @@ static void volumeMulti(uint32_t channels, TO* out, size_t frameCount,
 {
     static constexpr auto volumeMultiArray =
             makeVMArray<MIXTYPE, TO, TI, TV, TA, TAV>(std::make_index_sequence<FCC_LIMIT>());
+    if constexpr (std::is_same_v<TO, float> && std::is_same_v<TI, float>
+            && std::is_same_v<TV, float>) {
+        if (aux == nullptr && volumeMultiSimd<MIXTYPE>(mixerKernels(),
+                channels, out, frameCount, in, vol)) {
+            return;
+        }
+    }
     if (channels > 0 && channels <= volumeMultiArray.size()) {
         volumeMultiArray[channels - 1](out, frameCount, in, aux, vol, vola);
     } else {
@@ -0,0 +1,476 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_OPS_SIMD_H
+#define ANDROID_AUDIO_MIXER_OPS_SIMD_H
+
+#include <algorithm>
+#include <numeric>
+
+// depends on AudioMixerOps.h
+
+// Define USE_MIXER_SIMD to false to disable the explicit SIMD kernels, for benchmarking.
+#ifndef USE_MIXER_SIMD
+#define USE_MIXER_SIMD (true)
+#endif
+
+#if USE_MIXER_SIMD && (defined(__aarch64__) || defined(__ARM_NEON__))
+#define MIXER_SIMD_NEON (true)
+#include <arm_neon.h>
+#else
+#define MIXER_SIMD_NEON (false)
+#endif
+
+#if USE_MIXER_SIMD && (defined(__i386__) || defined(__x86_64__)) && defined(__SSE2__)
+#define MIXER_SIMD_X86 (true)
+#include <immintrin.h>
+#else
+#define MIXER_SIMD_X86 (false)
+#endif
+
+namespace android {
+
+/*
+ * Explicit SIMD kernels for the float (TO, TI, TV) = (float, float, float) mixer path
+ * without aux send, which is the common case for AudioMixer with float volumes.
+ *
+ * The MULTI, MONOVOL and STEREOVOL mixtypes apply a fixed volume per output channel
+ * position, so for an interleaved buffer of NCHAN channels the per-sample gain repeats
+ * with a period of NCHAN samples.  We expand this into a gain pattern whose length is
+ * lcm(NCHAN, kMixerSimdAlign), which is then a whole number of SIMD vectors for every
+ * supported instruction set.  A volume ramp advances the gain pattern by the frames
+ * contained in one pattern length after each pass.
+ *
+ * The kernels are selected once at runtime by mixerSimdKernels() (the x86 AVX2 and
+ * AVX-512 variants are compiled with target attributes and checked against the CPU).
+ */
+
+enum mixer_simd_isa_t {
+    MIXER_SIMD_ISA_SCALAR,
+    MIXER_SIMD_ISA_NEON,
+    MIXER_SIMD_ISA_SSE,
+    MIXER_SIMD_ISA_AVX2,
+    MIXER_SIMD_ISA_AVX512,
+    MIXER_SIMD_ISA_COUNT,
+};
+
+// Gain pattern alignment in samples, must be a multiple of the widest vector (AVX-512).
+static constexpr size_t kMixerSimdAlign = 16;
+
+// Largest gain pattern, lcm(channels, kMixerSimdAlign) <= channels * kMixerSimdAlign.
+static constexpr size_t kMixerSimdMaxPattern = FCC_LIMIT * kMixerSimdAlign;
+
+// Below this frame count, building the gain pattern costs more than it saves.
+// AudioMixerBase mixes without resampling in blocks of 16 frames, which must reach this.
+static constexpr size_t kMixerSimdMinFrames = 16;
+
+/* Multiplies sampleCount interleaved samples of in by the repeating gain pattern and
+ * stores (or accumulates) into out.  If gainInc is not null, gain is advanced by gainInc
+ * after each full pattern length.
+ */
+using mixer_simd_kernel_t = void (*)(float* out, const float* in, size_t sampleCount,
+        float* gain, const float* gainInc, size_t patternLen);
+
+struct MixerSimdKernels {
+    mixer_simd_isa_t isa;
+    const char* name;
+    mixer_simd_kernel_t mix[2 /* RAMP */][2 /* ACCUMULATE */];
+};
+
+template <bool RAMP, bool ACCUMULATE>
+static inline void mixPatternScalar(float* out, const float* in, size_t sampleCount,
+        float* gain, const float* gainInc, size_t patternLen)
+{
+    while (sampleCount > 0) {
+        const size_t n = std::min(sampleCount, patternLen);
+        for (size_t i = 0; i < n; ++i) {
+            if constexpr (ACCUMULATE) {
+                out[i] += in[i] * gain[i];
+            } else {
+                out[i] = in[i] * gain[i];
+            }
+        }
+        if constexpr (RAMP) {
+            for (size_t i = 0; i < patternLen; ++i) {
+                gain[i] += gainInc[i];
+            }
+        }
+        in += n;
+        out += n;
+        sampleCount -= n;
+    }
+}
+
+#if MIXER_SIMD_NEON
+
+template <bool RAMP, bool ACCUMULATE>
+static inline void mixPatternNeon(float* out, const float* in, size_t sampleCount,
+        float* gain, const float* gainInc, size_t patternLen)
+{
+    while (sampleCount > 0) {
+        const size_t n = std::min(sampleCount, patternLen);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t g = vld1q_f32(gain + i);
+            const float32x4_t x = vld1q_f32(in + i);
+            if constexpr (ACCUMULATE) {
+                vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), x, g));
+            } else {
+                vst1q_f32(out + i, vmulq_f32(x, g));
+            }
+        }
+        for (; i < n; ++i) {
+            if constexpr (ACCUMULATE) {
+                out[i] += in[i] * gain[i];
+            } else {
+                out[i] = in[i] * gain[i];
+            }
+        }
+        if constexpr (RAMP) {
+            for (i = 0; i < patternLen; i += 4) {
+                vst1q_f32(gain + i, vaddq_f32(vld1q_f32(gain + i), vld1q_f32(gainInc + i)));
+            }
+        }
+        in += n;
+        out += n;
+        sampleCount -= n;
+    }
+}
+
+#endif // MIXER_SIMD_NEON
+
+#if MIXER_SIMD_X86
+
+template <bool RAMP, bool ACCUMULATE>
+static inline void mixPatternSse(float* out, const float* in, size_t sampleCount,
+        float* gain, const float* gainInc, size_t patternLen)
+{
+    while (sampleCount > 0) {
+        const size_t n = std::min(sampleCount, patternLen);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m128 g = _mm_loadu_ps(gain + i);
+            const __m128 x = _mm_mul_ps(_mm_loadu_ps(in + i), g);
+            if constexpr (ACCUMULATE) {
+                _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), x));
+            } else {
+                _mm_storeu_ps(out + i, x);
+            }
+        }
+        for (; i < n; ++i) {
+            if constexpr (ACCUMULATE) {
+                out[i] += in[i] * gain[i];
+            } else {
+                out[i] = in[i] * gain[i];
+            }
+        }
+        if constexpr (RAMP) {
+            for (i = 0; i < patternLen; i += 4) {
+                _mm_storeu_ps(gain + i,
+                        _mm_add_ps(_mm_loadu_ps(gain + i), _mm_loadu_ps(gainInc + i)));
+            }
+        }
+        in += n;
+        out += n;
+        sampleCount -= n;
+    }
+}
+
+template <bool RAMP, bool ACCUMULATE>
+__attribute__((target("avx2,fma")))
+static void mixPatternAvx2(float* out, const float* in, size_t sampleCount,
+        float* gain, const float* gainInc, size_t patternLen)
+{
+    while (sampleCount > 0) {
+        const size_t n = std::min(sampleCount, patternLen);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256 g = _mm256_loadu_ps(gain + i);
+            const __m256 x = _mm256_loadu_ps(in + i);
+            if constexpr (ACCUMULATE) {
+                _mm256_storeu_ps(out + i, _mm256_fmadd_ps(x, g, _mm256_loadu_ps(out + i)));
+            } else {
+                _mm256_storeu_ps(out + i, _mm256_mul_ps(x, g));
+            }
+        }
+        for (; i < n; ++i) {
+            if constexpr (ACCUMULATE) {
+                out[i] += in[i] * gain[i];
+            } else {
+                out[i] = in[i] * gain[i];
+            }
+        }
+        if constexpr (RAMP) {
+            for (i = 0; i < patternLen; i += 8) {
+                _mm256_storeu_ps(gain + i,
+                        _mm256_add_ps(_mm256_loadu_ps(gain + i), _mm256_loadu_ps(gainInc + i)));
+            }
+        }
+        in += n;
+        out += n;
+        sampleCount -= n;
+    }
+}
+
+template <bool RAMP, bool ACCUMULATE>
+__attribute__((target("avx512f")))
+static void mixPatternAvx512(float* out, const float* in, size_t sampleCount,
+        float* gain, const float* gainInc, size_t patternLen)
+{
+    while (sampleCount > 0) {
+        const size_t n = std::min(sampleCount, patternLen);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m512 g = _mm512_loadu_ps(gain + i);
+            const __m512 x = _mm512_loadu_ps(in + i);
+            if constexpr (ACCUMULATE) {
+                _mm512_storeu_ps(out + i, _mm512_fmadd_ps(x, g, _mm512_loadu_ps(out + i)));
+            } else {
+                _mm512_storeu_ps(out + i, _mm512_mul_ps(x, g));
+            }
+        }
+        if (i < n) {
+            // remainder of a partial pattern, handled with a lane mask.
+            const __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+            const __m512 g = _mm512_maskz_loadu_ps(mask, gain + i);
+            const __m512 x = _mm512_maskz_loadu_ps(mask, in + i);
+            if constexpr (ACCUMULATE) {
+                _mm512_mask_storeu_ps(out + i, mask,
+                        _mm512_fmadd_ps(x, g, _mm512_maskz_loadu_ps(mask, out + i)));
+            } else {
+                _mm512_mask_storeu_ps(out + i, mask, _mm512_mul_ps(x, g));
+            }
+        }
+        if constexpr (RAMP) {
+            for (i = 0; i < patternLen; i += 16) {
+                _mm512_storeu_ps(gain + i,
+                        _mm512_add_ps(_mm512_loadu_ps(gain + i), _mm512_loadu_ps(gainInc + i)));
+            }
+        }
+        in += n;
+        out += n;
+        sampleCount -= n;
+    }
+}
+
+#endif // MIXER_SIMD_X86
+
+#define MIXER_SIMD_KERNELS(ISA, NAME, FUNC) \
+    MixerSimdKernels{ ISA, NAME, { \
+            { &FUNC<false, false>, &FUNC<false, true> }, \
+            { &FUNC<true, false>, &FUNC<true, true> }, \
+    } }
+
+// Returns the kernels for a specific instruction set, or nullptr if not supported
+// by this build or this CPU.  Used by the benchmarks and tests.
+inline const MixerSimdKernels* mixerSimdKernelsForIsa(mixer_simd_isa_t isa) {
+    static const MixerSimdKernels scalar =
+            MIXER_SIMD_KERNELS(MIXER_SIMD_ISA_SCALAR, "scalar", mixPatternScalar);
+    switch (isa) {
+    case MIXER_SIMD_ISA_SCALAR:
+        return &scalar;
+#if MIXER_SIMD_NEON
+    case MIXER_SIMD_ISA_NEON: {
+        static const MixerSimdKernels neon =
+                MIXER_SIMD_KERNELS(MIXER_SIMD_ISA_NEON, "neon", mixPatternNeon);
+        return &neon;
+    }
+#endif
+#if MIXER_SIMD_X86
+    case MIXER_SIMD_ISA_SSE: {
+        static const MixerSimdKernels sse =
+                MIXER_SIMD_KERNELS(MIXER_SIMD_ISA_SSE, "sse", mixPatternSse);
+        return &sse;
+    }
+    case MIXER_SIMD_ISA_AVX2: {
+        static const MixerSimdKernels avx2 =
+                MIXER_SIMD_KERNELS(MIXER_SIMD_ISA_AVX2, "avx2", mixPatternAvx2);
+        if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) return nullptr;
+        return &avx2;
+    }
+    case MIXER_SIMD_ISA_AVX512: {
+        static const MixerSimdKernels avx512 =
+                MIXER_SIMD_KERNELS(MIXER_SIMD_ISA_AVX512, "avx512", mixPatternAvx512);
+        if (!__builtin_cpu_supports("avx512f")) return nullptr;
+        return &avx512;
+    }
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+#undef MIXER_SIMD_KERNELS
+
+// Returns the best kernels for this CPU.  The selection is made on first call,
+// which AudioMixerBase does at construction so that the mixer thread never pays for it.
+inline const MixerSimdKernels& mixerSimdKernels() {
+    static const MixerSimdKernels* const kernels = [] {
+        for (int isa = MIXER_SIMD_ISA_COUNT - 1; isa > MIXER_SIMD_ISA_SCALAR; --isa) {
+            const MixerSimdKernels* k = mixerSimdKernelsForIsa((mixer_simd_isa_t)isa);
+            if (k != nullptr) return k;
+        }
+        return mixerSimdKernelsForIsa(MIXER_SIMD_ISA_SCALAR);
+    }();
+    return *kernels;
+}
+
+// True if the volumeRampMulti / volumeMulti MIXTYPE has a SIMD implementation.
+constexpr inline bool mixerSimdSupportsMixType(int mixtype) {
+    return mixtype == MIXTYPE_MULTI
+            || mixtype == MIXTYPE_MULTI_SAVEONLY
+            || mixtype == MIXTYPE_MULTI_MONOVOL
+            || mixtype == MIXTYPE_MULTI_SAVEONLY_MONOVOL
+            || mixtype == MIXTYPE_MULTI_STEREOVOL
+            || mixtype == MIXTYPE_MULTI_SAVEONLY_STEREOVOL;
+}
+
+constexpr inline bool mixerSimdAccumulates(int mixtype) {
+    return mixtype == MIXTYPE_MULTI
+            || mixtype == MIXTYPE_MULTI_MONOVOL
+            || mixtype == MIXTYPE_MULTI_STEREOVOL;
+}
+
+/* Fills gain (and gainInc, if not null) with the per-sample gain pattern
+ * matching the volume assignment of volumeRampMulti<MIXTYPE, channels>.
+ *
+ * Returns the pattern length in samples, or 0 if the channel count is not supported.
+ */
+template <int MIXTYPE>
+inline size_t makeMixerGainPattern(uint32_t channels, const float* vol, const float* volinc,
+        float* gain, float* gainInc)
+{
+    static_assert(mixerSimdSupportsMixType(MIXTYPE));
+    if (channels == 0 || channels > FCC_LIMIT) return 0;
+
+    float chanVol[FCC_LIMIT];
+    float chanInc[FCC_LIMIT];
+    if constexpr (MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        using namespace audio_utils::channels;
+        // Same channel side assignment as stereoVolumeHelperWithChannelMask().
+        const audio_channel_mask_t mask = canonicalChannelMaskFromCount(channels);
+        if (mask == AUDIO_CHANNEL_NONE) return 0;
+        constexpr unsigned LFE_LFE2 =
+                AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2;
+        const bool has_LFE_LFE2 = (mask & LFE_LFE2) == LFE_LFE2;
+        const float center = (vol[0] + vol[1]) * 0.5f;
+        const float centerInc = volinc != nullptr ? (volinc[0] + volinc[1]) * 0.5f : 0.f;
+        size_t c = 0;
+        for (unsigned bits = mask; bits != 0; bits &= bits - 1) {
+            const int index = __builtin_ctz(bits);
+            const auto side = kSideFromChannelIdx[index];
+            int which;
+            if (side == AUDIO_GEOMETRY_SIDE_LEFT
+                    || (has_LFE_LFE2 && (1u << index) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY)) {
+                which = 0;
+            } else if (side == AUDIO_GEOMETRY_SIDE_RIGHT
+                    || (has_LFE_LFE2 && (1u << index) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2)) {
+                which = 1;
+            } else {
+                which = -1;
+            }
+            chanVol[c] = which < 0 ? center : vol[which];
+            chanInc[c] = which < 0 ? centerInc : volinc != nullptr ? volinc[which] : 0.f;
+            ++c;
+        }
+    } else {
+        // MULTI and MULTI_SAVEONLY are only per-channel volume for up to 2 channels,
+        // otherwise they are treated as MONOVOL (see MIXTYPE_MONOVOL in AudioMixerBase.cpp).
+        const bool perChannel = (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY)
+                && channels <= FCC_2;
+        for (size_t c = 0; c < channels; ++c) {
+            const size_t which = perChannel ? c : 0;
+            chanVol[c] = vol[which];
+            chanInc[c] = volinc != nullptr ? volinc[which] : 0.f;
+        }
+    }
+
+    const size_t patternLen = std::lcm((size_t)channels, kMixerSimdAlign);
+    const size_t patternFrames = patternLen / channels;
+    for (size_t s = 0; s < patternLen; ++s) {
+        const size_t c = s % channels;
+        const size_t frame = s / channels;
+        gain[s] = chanVol[c] + frame * chanInc[c];
+        if (gainInc != nullptr) {
+            gainInc[s] = patternFrames * chanInc[c];
+        }
+    }
+    return patternLen;
+}
+
+/* SIMD versions of volumeRampMulti and volumeMulti for float data without aux.
+ *
+ * These return false if the MIXTYPE, channel count or frame count is not handled,
+ * in which case the caller must use the templated scalar version.
+ */
+template <int MIXTYPE>
+inline bool volumeRampMultiSimd(const MixerSimdKernels& kernels, uint32_t channels,
+        float* out, size_t frameCount, const float* in, float* vol, const float* volinc)
+{
+    if constexpr (!mixerSimdSupportsMixType(MIXTYPE)) {
+        return false;
+    } else {
+        if (frameCount < kMixerSimdMinFrames) return false;
+        float gain[kMixerSimdMaxPattern];
+        float gainInc[kMixerSimdMaxPattern];
+        const size_t patternLen =
+                makeMixerGainPattern<MIXTYPE>(channels, vol, volinc, gain, gainInc);
+        if (patternLen == 0) return false;
+        kernels.mix[true][mixerSimdAccumulates(MIXTYPE)](
+                out, in, frameCount * channels, gain, gainInc, patternLen);
+
+        // advance the volumes the same way volumeRampMulti() does.
+        if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+                || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+            vol[0] += frameCount * volinc[0];
+        } else if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+            if (channels <= FCC_2) {
+                for (size_t i = 0; i < channels; ++i) {
+                    vol[i] += frameCount * volinc[i];
+                }
+            } else {
+                vol[0] += frameCount * volinc[0];
+            }
+        } else {
+            vol[0] += frameCount * volinc[0];
+            vol[1] += frameCount * volinc[1];
+        }
+        return true;
+    }
+}
+
+template <int MIXTYPE>
+inline bool volumeMultiSimd(const MixerSimdKernels& kernels, uint32_t channels,
+        float* out, size_t frameCount, const float* in, const float* vol)
+{
+    if constexpr (!mixerSimdSupportsMixType(MIXTYPE)) {
+        return false;
+    } else {
+        if (frameCount < kMixerSimdMinFrames) return false;
+        float gain[kMixerSimdMaxPattern];
+        const size_t patternLen =
+                makeMixerGainPattern<MIXTYPE>(channels, vol, nullptr, gain, nullptr);
+        if (patternLen == 0) return false;
+        kernels.mix[false][mixerSimdAccumulates(MIXTYPE)](
+                out, in, frameCount * channels, gain, nullptr, patternLen);
+        return true;
+    }
+}
+
+} // namespace android
+
+#endif /* ANDROID_AUDIO_MIXER_OPS_SIMD_H */
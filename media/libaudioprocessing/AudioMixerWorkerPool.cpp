@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioMixerWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <media/AudioMixerWorkerPool.h>
+#include <utils/Log.h>
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+static inline void futexWait(std::atomic<uint32_t> *addr, uint32_t value)
+{
+    (void) syscall(__NR_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_PRIVATE, value,
+            nullptr);
+}
+
+static inline void futexWake(std::atomic<uint32_t> *addr, int count)
+{
+    (void) syscall(__NR_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE_PRIVATE, count);
+}
+
+// A ticket is (generation << 32) | (count << 16) | next unclaimed index.
+static inline uint64_t makeTicket(uint32_t gen, uint32_t count)
+{
+    return (uint64_t)gen << 32 | (uint64_t)(count & 0xffff) << 16;
+}
+
+AudioMixerWorkerPool::AudioMixerWorkerPool(size_t workerCount)
+    : mTids(workerCount, -1)
+{
+    std::atomic<size_t> started{0};
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        mWorkers.emplace_back([this, i, &started] {
+            char name[16];
+            snprintf(name, sizeof(name), "AudioMixerW%zu", i);
+            pthread_setname_np(pthread_self(), name);
+            mTids[i] = gettid();
+            started.fetch_add(1, std::memory_order_release);
+            threadLoop(i);
+        });
+    }
+    // not on the mixer thread, so we can afford to wait for the tids.
+    while (started.load(std::memory_order_acquire) < workerCount) {
+        std::this_thread::yield();
+    }
+    ALOGV("%s: %zu workers", __func__, workerCount);
+}
+
+AudioMixerWorkerPool::~AudioMixerWorkerPool()
+{
+    mExit.store(true, std::memory_order_release);
+    mGeneration.fetch_add(1, std::memory_order_acq_rel);
+    futexWake(&mGeneration, INT_MAX);
+    for (auto &worker : mWorkers) {
+        worker.join();
+    }
+}
+
+void AudioMixerWorkerPool::start(job_t job, void *arg, size_t count)
+{
+    LOG_ALWAYS_FATAL_IF(count > kMaxJobs, "%s: %zu jobs exceeds %zu", __func__, count, kMaxJobs);
+    mJob = job;
+    mArg = arg;
+    mCount = count;
+    mDone.store(0, std::memory_order_relaxed);
+    const uint32_t gen = mGeneration.load(std::memory_order_relaxed) + 1;
+    mTicket.store(makeTicket(gen, count), std::memory_order_release);
+    mGeneration.store(gen, std::memory_order_release);
+    if (count > 0) {
+        futexWake(&mGeneration, std::min(count, mWorkers.size()));
+    }
+}
+
+void AudioMixerWorkerPool::join()
+{
+    runJobs(mGeneration.load(std::memory_order_relaxed));
+    uint32_t done;
+    while ((done = mDone.load(std::memory_order_acquire)) < mCount) {
+        futexWait(&mDone, done);
+    }
+}
+
+void AudioMixerWorkerPool::runJobs(uint32_t gen)
+{
+    uint64_t ticket = mTicket.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t index = ticket & 0xffff;
+        const uint32_t count = (ticket >> 16) & 0xffff;
+        if ((uint32_t)(ticket >> 32) != gen || index >= count) {
+            return;
+        }
+        if (!mTicket.compare_exchange_weak(ticket, ticket + 1,
+                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            continue; // ticket was reloaded
+        }
+        // The job parameters are stable: the caller cannot start another generation
+        // until this job is counted in mDone.
+        mJob(mArg, index);
+        if (mDone.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            futexWake(&mDone, 1);
+        }
+        ticket = mTicket.load(std::memory_order_acquire);
+    }
+}
+
+void AudioMixerWorkerPool::threadLoop(size_t index __unused)
+{
+    uint32_t seen = 0;
+    for (;;) {
+        uint32_t gen;
+        while ((gen = mGeneration.load(std::memory_order_acquire)) == seen) {
+            futexWait(&mGeneration, seen);
+        }
+        if (mExit.load(std::memory_order_acquire)) {
+            return;
+        }
+        seen = gen;
+        runJobs(gen);
+    }
+}
+
+// ----------------------------------------------------------------------------
+} // namespace android
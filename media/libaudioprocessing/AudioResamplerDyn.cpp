@@ -23,6 +23,17 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#if defined(__i386__) || defined(__x86_64__)
+// AudioResamplerFirOps.h includes the SSE intrinsics inside namespace android;
+// include all x86 intrinsics in the global namespace first for the AVX2 kernels.
+#include <immintrin.h>
+#endif
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -32,6 +43,7 @@
 #include "AudioResamplerFirProcess.h"
 #include "AudioResamplerFirProcessNeon.h"
 #include "AudioResamplerFirProcessSSE.h"
+#include "AudioResamplerFirProcessAVX2.h" // USE_AVX2_DISPATCH defined here
 #include "AudioResamplerFirGen.h" // requires math.h
 #include "AudioResamplerDyn.h"
 
@@ -182,7 +194,7 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
       mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mUseAVX2(isFirAVX2Type<TC, TI, TO>() && firAVX2Available())
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +219,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -238,6 +249,99 @@ template<typename T> T max(T a, T b) {return a > b ? a : b;}
 
 template<typename T> T absdiff(T a, T b) {return a > b ? a - b : b - a;}
 
+/*
+ * FirCache is a process wide cache of the immutable polyphase filter banks.
+ *
+ * Resamplers with the same filter design, e.g. tracks with the same sample rate
+ * ratio and quality, share one filter bank instead of designing and storing their own.
+ * The cache holds the filter banks weakly: a filter bank is freed when the last
+ * resampler using it changes filter or is destroyed.
+ *
+ * The key is the design (not the sample rates or quality) as this also covers
+ * the property based designs and the isClose() reuse of a filter for nearby rates.
+ */
+template<typename TC>
+class FirCache {
+public:
+    struct Key {
+        int phases;
+        int halfLength;
+        double stopBandAtten;
+        double fcr;
+
+        bool operator<(const Key& other) const {
+            return std::tie(phases, halfLength, stopBandAtten, fcr)
+                    < std::tie(other.phases, other.halfLength, other.stopBandAtten, other.fcr);
+        }
+    };
+
+    // Returns the filter bank for key, calling design(coefs) to compute it if not cached.
+    //
+    // setSampleRate() runs on the mixer thread, so the cache lock is only tried, never
+    // waited for. If another thread holds it, the filter is designed as if not cached,
+    // and not published; sharing is an optimization, not needed for correctness.
+    template<typename DESIGN>
+    static std::shared_ptr<const TC> get(const Key& key, DESIGN design) {
+        std::map<Key, std::weak_ptr<const TC>>& cache = getCache();
+        {
+            std::unique_lock<std::mutex> lock(getLock(), std::try_to_lock);
+            if (lock.owns_lock()) {
+                auto it = cache.find(key);
+                if (it != cache.end()) {
+                    std::shared_ptr<const TC> coefs = it->second.lock();
+                    if (coefs) {
+                        return coefs;
+                    }
+                }
+            }
+        }
+
+        // Design outside of the lock; this may take several milliseconds
+        // and should not delay resamplers looking up a different filter.
+        TC *coefs = nullptr;
+        int ret = posix_memalign(
+                reinterpret_cast<void **>(&coefs),
+                CACHE_LINE_SIZE /* alignment */,
+                (key.phases + 1) * key.halfLength * sizeof(TC));
+        LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+        design(coefs);
+        std::shared_ptr<const TC> entry(coefs, [](const TC *p) { free((void *)p); });
+
+        std::unique_lock<std::mutex> lock(getLock(), std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return entry; // not shared.
+        }
+        std::weak_ptr<const TC>& cached = cache[key];
+        std::shared_ptr<const TC> existing = cached.lock();
+        if (existing) {
+            return existing; // designed concurrently, ours is freed on return.
+        }
+        cached = entry;
+        for (auto it = cache.begin(); it != cache.end(); ) {
+            if (it->second.expired()) {
+                it = cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        ALOGV("%s: phases:%d halfLength:%d stopBandAtten:%lf fcr:%lf, %zu cached",
+                __func__, key.phases, key.halfLength, key.stopBandAtten, key.fcr, cache.size());
+        return entry;
+    }
+
+private:
+    // function statics avoid static initialization order issues.
+    static std::mutex& getLock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::map<Key, std::weak_ptr<const TC>>& getCache() {
+        static std::map<Key, std::weak_ptr<const TC>> cache;
+        return cache;
+    }
+};
+
 template<typename TC, typename TI, typename TO>
 void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
         double stopBandAtten, int inSampleRate, int outSampleRate, double tbwCheat)
@@ -263,24 +367,17 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or share an identical one designed by another resampler.
+    mCoefs = FirCache<TC>::get({phases, halfLength, stopBandAtten, fcr},
+            [&](TC *coefs) {
+                firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+            });
+    c.mFirCoefs = mCoefs.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +403,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
@@ -555,6 +652,13 @@ void AudioResamplerDyn<TC, TI, TO>::setSampleRate(int32_t inSampleRate)
 #undef AUDIORESAMPLERDYN_CASE
 #define AUDIORESAMPLERDYN_CASE(CHANNEL, LOCKED) \
     case CHANNEL: if constexpr (CHANNEL <= FCC_LIMIT) {\
+        if constexpr (CHANNEL <= 2 && isFirAVX2Type<TC, TI, TO>()) { \
+            if (mUseAVX2) { \
+                mResampleFunc = &AudioResamplerDyn<TC, TI, TO>::resample<CHANNEL, LOCKED, 16, \
+                        true /* AVX2 */>; \
+                break; \
+            } \
+        } \
         mResampleFunc = &AudioResamplerDyn<TC, TI, TO>::resample<CHANNEL, LOCKED, 16>; \
     } break
 
@@ -630,7 +734,7 @@ size_t AudioResamplerDyn<TC, TI, TO>::resample(int32_t* out, size_t outFrameCoun
 }
 
 template<typename TC, typename TI, typename TO>
-template<int CHANNELS, bool LOCKED, int STRIDE>
+template<int CHANNELS, bool LOCKED, int STRIDE, bool AVX2>
 size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
         AudioBufferProvider* provider)
 {
@@ -719,11 +823,19 @@ size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
             //        "  phaseFraction:%u  phaseWrapLimit:%u",
             //        inFrameCount, outputIndex, outFrameCount, phaseFraction, phaseWrapLimit);
             ALOG_ASSERT(phaseFraction < phaseWrapLimit);
-            fir<CHANNELS, LOCKED, STRIDE>(
-                    &out[outputIndex],
-                    phaseFraction, phaseWrapLimit,
-                    coefShift, halfNumCoefs, coefs,
-                    impulse, volumeSimd);
+            if constexpr (AVX2) {
+                firAVX2<CHANNELS, LOCKED>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            } else {
+                fir<CHANNELS, LOCKED, STRIDE>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            }
 
             outputIndex += OUTPUT_CHANNELS;
 
@@ -17,6 +17,8 @@
 #ifndef ANDROID_AUDIO_RESAMPLER_DYN_H
 #define ANDROID_AUDIO_RESAMPLER_DYN_H
 
+#include <memory>
+
 #include <stdint.h>
 #include <sys/types.h>
 #include <android/log.h>
@@ -152,7 +154,8 @@ private:
 
     void createKaiserFir(Constants &c, double stopBandAtten, double fcr);
 
-    template<int CHANNELS, bool LOCKED, int STRIDE>
+    // AVX2 selects the runtime dispatched firAVX2() instead of fir(), see mUseAVX2.
+    template<int CHANNELS, bool LOCKED, int STRIDE, bool AVX2 = false>
     size_t resample(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
 
     // define a pointer to member function type for resample
@@ -166,7 +169,8 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const TC> mCoefs;  // filter bank shared with other resamplers, or null
+         const bool mUseAVX2;          // AVX2/FMA kernels for 1 and 2 channels, set on creation
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
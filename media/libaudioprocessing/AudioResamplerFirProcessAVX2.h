@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H
+
+#if defined(__i386__) || defined(__x86_64__)
+#define USE_AVX2_DISPATCH (true)  // AVX2/FMA kernels selected at runtime
+#include <immintrin.h>
+#else
+#define USE_AVX2_DISPATCH (false)
+#endif
+
+namespace android {
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+
+//
+// AVX2/FMA variants of ProcessL() and Process() for 1 and 2 channels.
+//
+// Unlike the NEON and SSE specializations these are not chosen at compile time:
+// the kernels are compiled with a function level target attribute and
+// AudioResamplerDyn uses them through firAVX2() when firAVX2Available() is true.
+//
+// The float kernels accumulate with FMA, so results differ from the scalar path
+// within rounding. The int16 coefficient kernels are bit-exact with ProcessBase().
+//
+
+// Types for which firAVX2() is implemented (TC, TI, TO).
+template <typename TC, typename TI, typename TO>
+constexpr bool isFirAVX2Type() {
+    return (is_same<TC, float>::value && is_same<TI, float>::value
+                    && is_same<TO, float>::value)
+            || (is_same<TC, int16_t>::value && is_same<TI, int16_t>::value
+                    && is_same<TO, int32_t>::value);
+}
+
+#if USE_AVX2_DISPATCH
+
+static inline bool firAVX2Available()
+{
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+__attribute__((target("avx2,fma")))
+static inline float hsumAVX2(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+    return _mm_cvtss_f32(sum);
+}
+
+// Eight taps per loop iteration.
+// The samples are loaded in memory order (and deinterleaved for stereo);
+// the coefficients are permuted to match, which is cheaper than reversing the samples.
+template <int CHANNELS, bool FIXED>
+__attribute__((target("avx2,fma")))
+static void ProcessAVX2(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* coefsP1,
+        const float* coefsN1,
+        const float* sP,
+        const float* sN,
+        float lerpP,
+        const float* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    // Frame order of the loaded samples, relative to the coefficient index.
+    // mono: frames -7 .. 0 of sP, frames 1 .. 8 of sN.
+    // stereo: _mm256_shuffle_ps() deinterleaves as -7 -6 -3 -2 -5 -4 -1 0 and 1 2 5 6 3 4 7 8.
+    const __m256i posOrder = CHANNELS == 1
+            ? _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)
+            : _mm256_setr_epi32(7, 6, 3, 2, 5, 4, 1, 0);
+    const __m256i negOrder = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    __m256 interp;
+    if (!FIXED) {
+        interp = _mm256_set1_ps(lerpP);
+    }
+    __m256 accL = _mm256_setzero_ps();
+    __m256 accR = _mm256_setzero_ps();
+
+    do {
+        __m256 posCoef = _mm256_loadu_ps(coefsP);
+        __m256 negCoef = _mm256_loadu_ps(coefsN);
+        coefsP += 8;
+        coefsN += 8;
+
+        if (!FIXED) { // interpolate
+            const __m256 posCoef1 = _mm256_loadu_ps(coefsP1);
+            const __m256 negCoef1 = _mm256_loadu_ps(coefsN1);
+            coefsP1 += 8;
+            coefsN1 += 8;
+
+            // posCoef = interp * (posCoef1 - posCoef) + posCoef
+            // negCoef = interp * (negCoef - negCoef1) + negCoef1
+            posCoef = _mm256_fmadd_ps(_mm256_sub_ps(posCoef1, posCoef), interp, posCoef);
+            negCoef = _mm256_fmadd_ps(_mm256_sub_ps(negCoef, negCoef1), interp, negCoef1);
+        }
+        posCoef = _mm256_permutevar8x32_ps(posCoef, posOrder);
+
+        if (CHANNELS == 1) {
+            accL = _mm256_fmadd_ps(_mm256_loadu_ps(sP), posCoef, accL);
+            accL = _mm256_fmadd_ps(_mm256_loadu_ps(sN), negCoef, accL);
+        } else {
+            negCoef = _mm256_permutevar8x32_ps(negCoef, negOrder);
+
+            __m256 s0 = _mm256_loadu_ps(sP);
+            __m256 s1 = _mm256_loadu_ps(sP + 8);
+            accL = _mm256_fmadd_ps(_mm256_shuffle_ps(s0, s1, 0x88), posCoef, accL);
+            accR = _mm256_fmadd_ps(_mm256_shuffle_ps(s0, s1, 0xdd), posCoef, accR);
+
+            s0 = _mm256_loadu_ps(sN);
+            s1 = _mm256_loadu_ps(sN + 8);
+            accL = _mm256_fmadd_ps(_mm256_shuffle_ps(s0, s1, 0x88), negCoef, accL);
+            accR = _mm256_fmadd_ps(_mm256_shuffle_ps(s0, s1, 0xdd), negCoef, accR);
+        }
+        sP -= CHANNELS*8;
+        sN += CHANNELS*8;
+        count -= 8;
+    } while (count > 0);
+
+    const float l = hsumAVX2(accL);
+    out[0] += l * volumeLR[0];
+    out[1] += (CHANNELS == 1 ? l : hsumAVX2(accR)) * volumeLR[1];
+}
+
+// Returns eight coefficients interpolate<int16_t, uint32_t>(c0[i], c1[i], lerp)
+// widened to 32 bits. The product is computed in 32 bits and truncated back to
+// 16 bits, as in the scalar version.
+__attribute__((target("avx2,fma")))
+static inline __m256i interpolateAVX2(const int16_t* c0, const int16_t* c1, __m256i interp)
+{
+    const __m128i coef0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c0));
+    const __m128i diff = _mm_sub_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(c1)), coef0);
+    __m256i coef = _mm256_srai_epi32(
+            _mm256_mullo_epi32(_mm256_cvtepi16_epi32(diff), interp), 15);
+    coef = _mm256_add_epi32(coef, _mm256_cvtepi16_epi32(coef0));
+    return _mm256_srai_epi32(_mm256_slli_epi32(coef, 16), 16);
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256i loadCoefsAVX2(const int16_t* c)
+{
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c)));
+}
+
+// int16 samples and coefficients are widened to 32 bits, so the products and the
+// (wrapping) sums are identical to mulAdd() and mulAddRL() in any order.
+template <int CHANNELS, bool FIXED>
+__attribute__((target("avx2,fma")))
+static void ProcessAVX2(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    __m256i interp;
+    if (!FIXED) {
+        interp = _mm256_set1_epi32(lerpP);  // lerpP < 1 << 15
+    }
+    __m256i acc = _mm256_setzero_si256();   // stereo: L in even, R in odd lanes
+
+    do {
+        __m256i posCoef, negCoef;
+        if (FIXED) {
+            posCoef = loadCoefsAVX2(coefsP);
+            negCoef = loadCoefsAVX2(coefsN);
+        } else {
+            posCoef = interpolateAVX2(coefsP, coefsP1, interp);
+            negCoef = interpolateAVX2(coefsN1, coefsN, interp);
+            coefsP1 += 8;
+            coefsN1 += 8;
+        }
+        coefsP += 8;
+        coefsN += 8;
+
+        if (CHANNELS == 1) {
+            posCoef = _mm256_permutevar8x32_epi32(posCoef,
+                    _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(posCoef,
+                    _mm256_cvtepi16_epi32(_mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(sP)))));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(negCoef,
+                    _mm256_cvtepi16_epi32(_mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(sN)))));
+        } else {
+            // frames -7 .. -4 and -3 .. 0 of the positive side.
+            const __m256i pos = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sP));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(
+                    _mm256_permutevar8x32_epi32(posCoef,
+                            _mm256_setr_epi32(7, 7, 6, 6, 5, 5, 4, 4)),
+                    _mm256_cvtepi16_epi32(_mm256_castsi256_si128(pos))));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(
+                    _mm256_permutevar8x32_epi32(posCoef,
+                            _mm256_setr_epi32(3, 3, 2, 2, 1, 1, 0, 0)),
+                    _mm256_cvtepi16_epi32(_mm256_extracti128_si256(pos, 1))));
+
+            // frames 1 .. 4 and 5 .. 8 of the negative side.
+            const __m256i neg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sN));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(
+                    _mm256_permutevar8x32_epi32(negCoef,
+                            _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3)),
+                    _mm256_cvtepi16_epi32(_mm256_castsi256_si128(neg))));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(
+                    _mm256_permutevar8x32_epi32(negCoef,
+                            _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7)),
+                    _mm256_cvtepi16_epi32(_mm256_extracti128_si256(neg, 1))));
+        }
+        sP -= CHANNELS*8;
+        sN += CHANNELS*8;
+        count -= 8;
+    } while (count > 0);
+
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));   // L R x x
+    if (CHANNELS == 1) {
+        const int32_t l = _mm_cvtsi128_si32(sum) + _mm_extract_epi32(sum, 1);
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(l, volumeLR[1]);
+    } else {
+        out[0] += volumeAdjust(_mm_cvtsi128_si32(sum), volumeLR[0]);
+        out[1] += volumeAdjust(_mm_extract_epi32(sum, 1), volumeLR[1]);
+    }
+}
+
+/*
+ * Calculates a single output frame from input sample pointer with the AVX2/FMA kernels.
+ * Same as fir() for CHANNELS 1 and 2, and types for which isFirAVX2Type() is true.
+ * Must only be called if firAVX2Available().
+ */
+template<int CHANNELS, bool LOCKED, typename TC, typename TI, typename TO>
+static inline
+void firAVX2(TO* const out,
+        const uint32_t phase, const uint32_t phaseWrapLimit,
+        const int coefShift, const int halfNumCoefs, const TC* const coefs,
+        const TI* const samples, const TO* const volumeLR)
+{
+    static_assert(isFirAVX2Type<TC, TI, TO>(), "unsupported types");
+
+    if (LOCKED) {
+        const uint32_t indexP = phase >> coefShift;
+        const uint32_t indexN = (phaseWrapLimit - phase) >> coefShift;
+        const TC* coefsP = coefs + indexP*halfNumCoefs;
+        const TC* coefsN = coefs + indexN*halfNumCoefs;
+
+        ProcessAVX2<CHANNELS, true>(out, halfNumCoefs, coefsP, coefsN,
+                nullptr /* coefsP1 */, nullptr /* coefsN1 */,
+                samples, samples + CHANNELS, 0 /* lerpP */, volumeLR);
+    } else {
+        const uint32_t indexP = phase >> coefShift;
+        const uint32_t indexN = (phaseWrapLimit - phase - 1) >> coefShift; // one's complement.
+        const TC* coefsP = coefs + indexP*halfNumCoefs;
+        const TC* coefsN = coefs + indexN*halfNumCoefs;
+
+        // see fir() for the derivation of lerpP.
+        if constexpr (is_same<TC, float>::value) {
+            static const TC scale = 1. / (65536. * 65536.); // scale phase bits to [0.0, 1.0)
+            const TC lerpP = TC(phase << (sizeof(phase)*8 - coefShift)) * scale;
+
+            ProcessAVX2<CHANNELS, false>(out, halfNumCoefs, coefsP, coefsN,
+                    coefsP + halfNumCoefs, coefsN + halfNumCoefs,
+                    samples, samples + CHANNELS, lerpP, volumeLR);
+        } else {
+            const uint32_t lerpP = phase << (sizeof(phase)*8 - coefShift)
+                    >> ((sizeof(phase)-sizeof(*coefs))*8 + 1);
+
+            ProcessAVX2<CHANNELS, false>(out, halfNumCoefs, coefsP, coefsN,
+                    coefsP + halfNumCoefs, coefsN + halfNumCoefs,
+                    samples, samples + CHANNELS, lerpP, volumeLR);
+        }
+    }
+}
+
+#else // !USE_AVX2_DISPATCH
+
+static inline bool firAVX2Available()
+{
+    return false;
+}
+
+// Never selected, present so that callers need not be conditionally compiled.
+template<int CHANNELS, bool LOCKED, typename TC, typename TI, typename TO>
+static inline
+void firAVX2(TO* const out,
+        const uint32_t phase, const uint32_t phaseWrapLimit,
+        const int coefShift, const int halfNumCoefs, const TC* const coefs,
+        const TI* const samples, const TO* const volumeLR)
+{
+    fir<CHANNELS, LOCKED, 16>(out, phase, phaseWrapLimit, coefShift, halfNumCoefs, coefs,
+            samples, volumeLR);
+}
+
+#endif // USE_AVX2_DISPATCH
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H*/
@@ -368,29 +368,68 @@ void RemixBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
 
 ChannelMixBufferProvider::ChannelMixBufferProvider(audio_channel_mask_t inputChannelMask,
         audio_channel_mask_t outputChannelMask, audio_format_t format,
-        size_t bufferFrameCount) :
+        size_t bufferFrameCount, audio_format_t inputFormat) :
         CopyBufferProvider(
-                audio_bytes_per_sample(format)
+                audio_bytes_per_sample(inputFormat == AUDIO_FORMAT_DEFAULT ? format : inputFormat)
                     * audio_channel_count_from_out_mask(inputChannelMask),
                 audio_bytes_per_sample(format)
                     * audio_channel_count_from_out_mask(outputChannelMask),
                 bufferFrameCount)
+        , mInputFormat(inputFormat == AUDIO_FORMAT_DEFAULT ? format : inputFormat)
+        , mInputChannelCount(audio_channel_count_from_out_mask(inputChannelMask))
+        , mOutputChannelCount(audio_channel_count_from_out_mask(outputChannelMask))
         , mChannelMix{format == AUDIO_FORMAT_PCM_FLOAT
+                        && (mInputFormat == format || isInputFormatSupported(mInputFormat))
                 ? audio_utils::channels::IChannelMix::create(outputChannelMask) : nullptr}
         , mIsValid{mChannelMix && mChannelMix->setInputChannelMask(inputChannelMask)}
 {
-    ALOGV("ChannelMixBufferProvider(%p)(%#x, %#x, %#x)",
-            this, format, inputChannelMask, outputChannelMask);
+    ALOGV("ChannelMixBufferProvider(%p)(%#x, %#x, %#x, %#x)",
+            this, format, inputChannelMask, outputChannelMask, mInputFormat);
+}
+
+// static
+bool ChannelMixBufferProvider::isInputFormatSupported(audio_format_t inputFormat)
+{
+    switch (inputFormat) {
+    case AUDIO_FORMAT_PCM_16_BIT:
+    case AUDIO_FORMAT_PCM_8_BIT:
+    case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+    case AUDIO_FORMAT_PCM_8_24_BIT:
+    case AUDIO_FORMAT_PCM_32_BIT:
+    case AUDIO_FORMAT_PCM_FLOAT:
+        return true;
+    default:
+        return false;
+    }
 }
 
 void ChannelMixBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
 {
-    if (mIsValid) {
-        mChannelMix->process(static_cast<const float *>(src), static_cast<float *>(dst),
-                frames, false /* accumulate */);
-    } else {
+    if (!mIsValid) {
         // Should fall back to a different BufferProvider if not valid.
         ALOGE("%s: Use without being valid!", __func__);
+        return;
+    }
+    if (mInputFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        mChannelMix->process(static_cast<const float *>(src), static_cast<float *>(dst),
+                frames, false /* accumulate */);
+        return;
+    }
+    // Convert to float a block at a time and mix it while it is still in the L1 cache,
+    // rather than converting the whole buffer in a ReformatBufferProvider first.
+    constexpr size_t kBlockSamples = 1024;
+    float block[kBlockSamples];
+    const size_t blockFrames = kBlockSamples / mInputChannelCount;
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    float *out = static_cast<float *>(dst);
+    while (frames > 0) {
+        const size_t count = std::min(frames, blockFrames);
+        memcpy_by_audio_format(block, AUDIO_FORMAT_PCM_FLOAT, in, mInputFormat,
+                count * mInputChannelCount);
+        mChannelMix->process(block, out, count, false /* accumulate */);
+        in += count * mInputFrameSize;
+        out += count * mOutputChannelCount;
+        frames -= count;
     }
 }
 
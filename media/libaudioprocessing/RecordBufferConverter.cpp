@@ -37,6 +37,104 @@ static inline T max(const T& a, const T& b)
 
 namespace android {
 
+// Conversion of one sample to float, matching memcpy_by_audio_format().
+template <typename T, float (*CONVERT)(T)>
+struct FloatFrom {
+    static constexpr size_t kSize = sizeof(T);
+    static float get(const uint8_t *p) {
+        T value;
+        memcpy(&value, p, sizeof(value));
+        return CONVERT(value);
+    }
+};
+
+struct FloatFromP24 {
+    static constexpr size_t kSize = 3;
+    static float get(const uint8_t *p) { return float_from_p24(p); }
+};
+
+// Selects channels of src by idxAry and converts them to float in a single pass.
+// A negative index fills the channel with a zero sample of the source format, as
+// memcpy_by_index_array() does, so 8 bit sources fill with -1.f and not silence.
+// DST_CHANNELS is 0 if not known at compile time.
+template <typename SAMPLE, size_t DST_CHANNELS>
+static void selectToFloat(float *dst, size_t dstChannels,
+        const uint8_t *src, size_t srcChannels, const int8_t *idxAry, size_t frames)
+{
+    static constexpr uint8_t kZeroSample[sizeof(int32_t)] = {};
+    const float zero = SAMPLE::get(kZeroSample);
+    const size_t channels = DST_CHANNELS != 0 ? DST_CHANNELS : dstChannels;
+    const size_t srcFrameSize = srcChannels * SAMPLE::kSize;
+    for (; frames > 0; --frames) {
+        for (size_t i = 0; i < channels; ++i) {
+            const int idx = idxAry[i];
+            *dst++ = idx < 0 ? zero : SAMPLE::get(src + idx * SAMPLE::kSize);
+        }
+        src += srcFrameSize;
+    }
+}
+
+template <typename SAMPLE>
+static void selectToFloat(float *dst, size_t dstChannels,
+        const uint8_t *src, size_t srcChannels, const int8_t *idxAry, size_t frames)
+{
+    switch (dstChannels) {
+    case 1:
+        selectToFloat<SAMPLE, 1>(dst, dstChannels, src, srcChannels, idxAry, frames);
+        break;
+    case 2:
+        selectToFloat<SAMPLE, 2>(dst, dstChannels, src, srcChannels, idxAry, frames);
+        break;
+    default:
+        selectToFloat<SAMPLE, 0>(dst, dstChannels, src, srcChannels, idxAry, frames);
+        break;
+    }
+}
+
+static bool isSelectToFloatSupported(audio_format_t format)
+{
+    switch (format) {
+    case AUDIO_FORMAT_PCM_8_BIT:
+    case AUDIO_FORMAT_PCM_16_BIT:
+    case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+    case AUDIO_FORMAT_PCM_8_24_BIT:
+    case AUDIO_FORMAT_PCM_32_BIT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void selectToFloat(float *dst, size_t dstChannels,
+        const void *src, audio_format_t srcFormat, size_t srcChannels,
+        const int8_t *idxAry, size_t frames)
+{
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    switch (srcFormat) {
+    case AUDIO_FORMAT_PCM_8_BIT:
+        selectToFloat<FloatFrom<uint8_t, float_from_u8>>(
+                dst, dstChannels, in, srcChannels, idxAry, frames);
+        break;
+    case AUDIO_FORMAT_PCM_16_BIT:
+        selectToFloat<FloatFrom<int16_t, float_from_i16>>(
+                dst, dstChannels, in, srcChannels, idxAry, frames);
+        break;
+    case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+        selectToFloat<FloatFromP24>(dst, dstChannels, in, srcChannels, idxAry, frames);
+        break;
+    case AUDIO_FORMAT_PCM_8_24_BIT:
+        selectToFloat<FloatFrom<int32_t, float_from_q8_23>>(
+                dst, dstChannels, in, srcChannels, idxAry, frames);
+        break;
+    case AUDIO_FORMAT_PCM_32_BIT:
+        selectToFloat<FloatFrom<int32_t, float_from_i32>>(
+                dst, dstChannels, in, srcChannels, idxAry, frames);
+        break;
+    default:
+        LOG_ALWAYS_FATAL("%s: unsupported format %#x", __func__, srcFormat);
+    }
+}
+
 RecordBufferConverter::RecordBufferConverter(
         audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
         uint32_t srcSampleRate,
@@ -56,6 +154,7 @@ RecordBufferConverter::RecordBufferConverter(
             mIsLegacyDownmix(false),
             mIsLegacyUpmix(false),
             mRequiresFloat(false),
+            mSelectToFloat(false),
             mInputConverterProvider(NULL)
 {
     (void)updateParameters(srcChannelMask, srcFormat, srcSampleRate,
@@ -188,6 +287,11 @@ status_t RecordBufferConverter::updateParameters(
     // do we need to process in float?
     mRequiresFloat = mResampler != NULL || mIsLegacyDownmix || mIsLegacyUpmix;
 
+    // can we select channels and convert to float in one pass, without a staging buffer?
+    mSelectToFloat = mResampler == NULL && !mIsLegacyUpmix && !mIsLegacyDownmix
+            && mSrcChannelMask != mDstChannelMask
+            && mDstFormat == AUDIO_FORMAT_PCM_FLOAT && isSelectToFloatSupported(mSrcFormat);
+
     // do we need a staging buffer to convert for destination (we can still optimize this)?
     // we use mBufFrameSize > 0 to indicate both frame size as well as buffer necessity
     if (mResampler != NULL) {
@@ -195,7 +299,8 @@ status_t RecordBufferConverter::updateParameters(
                 * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
     } else if (mIsLegacyUpmix || mIsLegacyDownmix) { // legacy modes always float
         mBufFrameSize = mDstChannelCount * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
-    } else if (mSrcChannelMask != mDstChannelMask && mDstFormat != mSrcFormat) {
+    } else if (mSrcChannelMask != mDstChannelMask && mDstFormat != mSrcFormat
+            && !mSelectToFloat) {
         mBufFrameSize = mDstChannelCount * audio_bytes_per_sample(mSrcFormat);
     } else {
         mBufFrameSize = 0;
@@ -247,6 +352,11 @@ void RecordBufferConverter::convertNoResampler(
         return;
     }
     // do we need to do channel mask conversion?
+    if (mSelectToFloat) {
+        selectToFloat((float *)dst, mDstChannelCount,
+                src, mSrcFormat, mSrcChannelCount, mIdxAry, frames);
+        return;
+    }
     if (mSrcChannelMask != mDstChannelMask) {
         void *dstBuf = mBuf != NULL ? mBuf : dst;
         memcpy_by_index_array(dstBuf, mDstChannelCount,
@@ -119,6 +119,7 @@ private:
          *    match either mMixerInFormat or mDownmixRequiresFormat, if the downmixer
          *    requires reformat. For example, it may convert floating point input to
          *    PCM_16_bit if that's required by the downmixer.
+         *    Not used when the ChannelMix downmixer converts the input format itself.
          * 5) mDownmixerBufferProvider: If not NULL, performs the channel remixing to match
          *    the number of channels required by the mixer sink.
          * 6) mPostDownmixReformatBufferProvider: If not NULL, performs reformatting from
@@ -136,6 +137,8 @@ private:
         audio_format_t mDownmixRequiresFormat;  // required downmixer format
                                                 // AUDIO_FORMAT_PCM_16_BIT if 16 bit necessary
                                                 // AUDIO_FORMAT_INVALID if no required format
+        bool           mDownmixIsChannelMix;    // mDownmixerBufferProvider is a
+                                                // ChannelMixBufferProvider
 
         AudioPlaybackRate    mPlaybackRate;
 
@@ -18,6 +18,7 @@
 #ifndef ANDROID_AUDIO_MIXER_BASE_H
 #define ANDROID_AUDIO_MIXER_BASE_H
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -25,6 +26,7 @@
 #include <vector>
 
 #include <media/AudioBufferProvider.h>
+#include <media/AudioMixerWorkerPool.h>
 #include <media/AudioResampler.h>
 #include <media/AudioResamplerPublic.h>
 #include <system/audio.h>
@@ -36,6 +38,8 @@
 
 namespace android {
 
+struct MixerSimdKernels;
+
 // ----------------------------------------------------------------------------
 
 // AudioMixerBase is functional on its own if only mixing and resampling
@@ -94,6 +98,7 @@ public:
     AudioMixerBase(size_t frameCount, uint32_t sampleRate)
         : mSampleRate(sampleRate)
         , mFrameCount(frameCount) {
+        selectMixerKernels();
     }
 
     virtual ~AudioMixerBase() {}
@@ -139,6 +144,40 @@ public:
 
     std::string trackNames() const;
 
+    // Tiled mixing: when no track resamples, the output is mixed in tiles of
+    // tileFrameCount frames, each tile accumulating all tracks before moving on,
+    // so that the accumulator stays resident in the data cache.
+    // A tileFrameCount of 0 restores the default small fixed block.
+    // Must not be called concurrently with process().
+    void        setTileFrameCount(size_t tileFrameCount);
+    size_t      getTileFrameCount() const { return mTileFrameCount; }
+
+    // Returns the largest tile frame count (a multiple of the default block) for which
+    // the int32_t accumulator and one track's input, of channelCount samples per frame
+    // and at most 4 bytes per sample, fit within cacheBytes.
+    static size_t tileFrameCountForCache(uint32_t channelCount, size_t cacheBytes);
+
+    // Replaces the SIMD volume kernels chosen for this CPU (see AudioMixerOpsSimd.h),
+    // or restores them if kernels is nullptr. For tests; must not be called during process().
+    static void setMixerKernelsForTest(const MixerSimdKernels *kernels);
+
+    // Parallel track preprocessing: when set, tracks that resample and have no aux send
+    // are resampled and volume adjusted on the pool's helper threads into per-track
+    // buffers, which are then accumulated by the calling thread.
+    // nullptr restores serial processing. Must not be called concurrently with process().
+    void        setWorkerPool(const std::shared_ptr<AudioMixerWorkerPool>& workerPool);
+
+    // Timing of the tiles mixed since setTileFrameCount(), may be read from another thread.
+    struct TileStats {
+        int64_t tiles = 0;
+        int64_t frames = 0;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+
+        std::string toString() const;
+    };
+    TileStats   getTileStats() const;
+
   protected:
     // Set kUseNewMixer to true to use the new mixer engine always. Otherwise the
     // original code will be used for stereo sinks, the new mixer for everything else.
@@ -297,6 +336,10 @@ public:
 
         int32_t        mTeeBufferFrameCount;
 
+        // output and temp buffers used when processed by the worker pool, see setWorkerPool().
+        std::unique_ptr<int32_t[]> mWorkerOut;
+        std::unique_ptr<int32_t[]> mWorkerTemp;
+
         uint32_t       mInputFrameSize; // The track input frame size, used for tee buffer
 
         // consider volume muted only if all channel volume (floating point) is 0.f
@@ -351,6 +394,7 @@ public:
     void process__genericNoResampling();
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
+    void processNoResampling(int32_t *outTemp, size_t blockFrameCount, bool recordTiles);
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
@@ -362,6 +406,15 @@ public:
     static void convertMixerFormat(void *out, audio_format_t mixerOutFormat,
             void *in, audio_format_t mixerInFormat, size_t sampleCount);
 
+    // True if the track is processed by the worker pool in process__genericResampling().
+    bool usesWorkerPool(const TrackBase& t) const {
+        return mWorkerPool != nullptr && (t.needs & (NEEDS_RESAMPLE | NEEDS_AUX)) == NEEDS_RESAMPLE;
+    }
+    static void workerProcessTrack(void *arg, size_t index);
+
+    // Selects the SIMD volume kernels (see AudioMixerOpsSimd.h) for this CPU, once.
+    static void selectMixerKernels();
+
     // initialization constants
     const uint32_t mSampleRate;
     const size_t mFrameCount;
@@ -373,6 +426,17 @@ public:
     std::unique_ptr<int32_t[]> mOutputTemp;
     std::unique_ptr<int32_t[]> mResampleTemp;
 
+    // parallel track preprocessing, see setWorkerPool().
+    std::shared_ptr<AudioMixerWorkerPool> mWorkerPool;
+    std::vector<TrackBase *> mWorkerTracks; // tracks of the current group given to the pool
+
+    // tiled mixing, see setTileFrameCount(). Uses mOutputTemp as the tile accumulator.
+    size_t mTileFrameCount = 0;
+    std::atomic<int64_t> mTileCount = 0;
+    std::atomic<int64_t> mTileFrames = 0;
+    std::atomic<int64_t> mTileTotalNs = 0;
+    std::atomic<int64_t> mTileMaxNs = 0;
+
     // track names grouped by main buffer, in no particular order of main buffer.
     // however names for a particular main buffer are in order (by construction).
     std::unordered_map<void * /* mainBuffer */, std::vector<int /* name */>> mGroups;
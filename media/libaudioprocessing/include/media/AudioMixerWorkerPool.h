@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_WORKER_POOL_H
+#define ANDROID_AUDIO_MIXER_WORKER_POOL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+// AudioMixerWorkerPool runs independent per-track jobs of one mixer cycle on a small set
+// of helper threads. The owner of the mixer thread is responsible for giving the helpers
+// an appropriate scheduling policy, see getTids().
+//
+// Jobs are claimed and completed with atomics only; the helpers and the caller sleep on
+// futexes, so start() and join() never block on a mutex held by another thread.
+// start() and join() must be called from a single thread, and alternate.
+
+class AudioMixerWorkerPool
+{
+public:
+    using job_t = void (*)(void *arg, size_t index);
+
+    static constexpr size_t kMaxJobs = 0xffff;
+
+    explicit AudioMixerWorkerPool(size_t workerCount);
+    ~AudioMixerWorkerPool();
+
+    AudioMixerWorkerPool(const AudioMixerWorkerPool&) = delete;
+    AudioMixerWorkerPool& operator=(const AudioMixerWorkerPool&) = delete;
+
+    size_t  getWorkerCount() const { return mWorkers.size(); }
+
+    // Returns the kernel thread ids of the helpers, valid after construction.
+    std::vector<pid_t> getTids() const { return mTids; }
+
+    // Makes job(arg, index) for index in [0, count) available to the helpers.
+    // The caller may do other work before calling join().
+    void    start(job_t job, void *arg, size_t count);
+
+    // Runs any jobs not yet claimed by a helper on the calling thread, then waits
+    // until all jobs of the last start() have completed.
+    void    join();
+
+private:
+    void    threadLoop(size_t index);
+
+    // Claims and runs jobs of generation gen until none are left.
+    void    runJobs(uint32_t gen);
+
+    std::vector<std::thread> mWorkers;
+    std::vector<pid_t>       mTids;
+
+    // Parameters of the current generation, written by start() before mTicket
+    // is released and not modified until join() has returned.
+    job_t                    mJob = nullptr;
+    void                    *mArg = nullptr;
+    uint32_t                 mCount = 0;       // only accessed by the caller
+
+    // (generation << 32) | (count << 16) | next unclaimed index. A helper only claims
+    // an index if the generation still matches, so it can never run a stale job.
+    std::atomic<uint64_t>    mTicket{0};
+    std::atomic<uint32_t>    mGeneration{0};   // futex, helpers wait for a new generation
+    std::atomic<uint32_t>    mDone{0};         // futex, caller waits for mCount completions
+    std::atomic<bool>        mExit{false};
+};
+
+// ----------------------------------------------------------------------------
+} // namespace android
+
+#endif // ANDROID_AUDIO_MIXER_WORKER_POOL_H
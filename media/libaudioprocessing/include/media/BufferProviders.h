@@ -132,22 +132,31 @@ protected:
 
 // ChannelMixBufferProvider derives from CopyBufferProvider to perform an
 // downmix to the proper channel count and mask.
+// If inputFormat differs from format, the input is converted to format as part of the
+// downmix, in place of a separate ReformatBufferProvider.
 class ChannelMixBufferProvider : public CopyBufferProvider {
 public:
     ChannelMixBufferProvider(audio_channel_mask_t inputChannelMask,
             audio_channel_mask_t outputChannelMask, audio_format_t format,
-            size_t bufferFrameCount);
+            size_t bufferFrameCount, audio_format_t inputFormat = AUDIO_FORMAT_DEFAULT);
 
     void copyFrames(void *dst, const void *src, size_t frames) override;
 
     bool isValid() const { return mIsValid; }
+    audio_format_t getInputFormat() const { return mInputFormat; }
 
     static bool isOutputChannelMaskSupported(audio_channel_mask_t outputChannelMask) {
         return audio_utils::channels::IChannelMix::isOutputChannelMaskSupported(
                 outputChannelMask);
     }
 
+    // Returns true if inputFormat may be passed to the constructor with a float format.
+    static bool isInputFormatSupported(audio_format_t inputFormat);
+
 protected:
+    const audio_format_t mInputFormat;
+    const size_t         mInputChannelCount;
+    const size_t         mOutputChannelCount;
     const std::shared_ptr<audio_utils::channels::IChannelMix> mChannelMix;
     const bool mIsValid;
 };
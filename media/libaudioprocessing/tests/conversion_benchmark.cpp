@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <audio_utils/format.h>
+#include <audio_utils/primitives.h>
+#include <benchmark/benchmark.h>
+#include <media/BufferProviders.h>
+#include <media/RecordBufferConverter.h>
+
+using namespace android;
+
+// Measures the track conversion chain at 8 channels to stereo, 24 bit packed to float,
+// both for playback (AudioMixer buffer providers) and capture (RecordBufferConverter).
+
+static constexpr size_t kFrameCount = 960;   // 20 ms at 48 kHz
+static constexpr audio_format_t kSrcFormat = AUDIO_FORMAT_PCM_24_BIT_PACKED;
+static constexpr size_t kSrcChannels = 8;
+static constexpr size_t kDstChannels = 2;
+
+// Provides the same buffer of random data forever.
+class LoopBufferProvider : public AudioBufferProvider {
+public:
+    LoopBufferProvider(size_t frameSize, size_t frameCount)
+        : mFrameSize(frameSize), mFrameCount(frameCount), mData(frameSize * frameCount) {
+        std::minstd_rand gen(42);
+        for (auto &b : mData) b = gen();
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mFrameCount - mOffset);
+        buffer->raw = mData.data() + mOffset * mFrameSize;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        mOffset = (mOffset + buffer->frameCount) % mFrameCount;
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    const size_t mFrameSize;
+    const size_t mFrameCount;
+    std::vector<uint8_t> mData;
+    size_t mOffset = 0;
+};
+
+static void pull(benchmark::State& state, AudioBufferProvider *provider) {
+    std::vector<float> out(kFrameCount * kDstChannels);
+    while (state.KeepRunning()) {
+        size_t frames = 0;
+        while (frames < kFrameCount) {
+            AudioBufferProvider::Buffer buffer;
+            buffer.frameCount = kFrameCount - frames;
+            if (provider->getNextBuffer(&buffer) != NO_ERROR || buffer.frameCount == 0) {
+                state.SkipWithError("getNextBuffer failed");
+                return;
+            }
+            memcpy(&out[frames * kDstChannels], buffer.raw,
+                    buffer.frameCount * kDstChannels * sizeof(float));
+            frames += buffer.frameCount;
+            provider->releaseBuffer(&buffer);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+// ReformatBufferProvider followed by a float ChannelMixBufferProvider,
+// as AudioMixer configured the track before the conversion was fused.
+static void BM_ChannelMix_Chained(benchmark::State& state) {
+    LoopBufferProvider source(kSrcChannels * audio_bytes_per_sample(kSrcFormat), kFrameCount);
+    ReformatBufferProvider reformat(kSrcChannels, kSrcFormat, AUDIO_FORMAT_PCM_FLOAT, 256);
+    ChannelMixBufferProvider channelMix(AUDIO_CHANNEL_OUT_7POINT1, AUDIO_CHANNEL_OUT_STEREO,
+            AUDIO_FORMAT_PCM_FLOAT, 256);
+    reformat.setBufferProvider(&source);
+    channelMix.setBufferProvider(&reformat);
+    pull(state, &channelMix);
+}
+
+// ChannelMixBufferProvider converting the input format itself.
+static void BM_ChannelMix_Fused(benchmark::State& state) {
+    LoopBufferProvider source(kSrcChannels * audio_bytes_per_sample(kSrcFormat), kFrameCount);
+    ChannelMixBufferProvider channelMix(AUDIO_CHANNEL_OUT_7POINT1, AUDIO_CHANNEL_OUT_STEREO,
+            AUDIO_FORMAT_PCM_FLOAT, 256, kSrcFormat);
+    channelMix.setBufferProvider(&source);
+    pull(state, &channelMix);
+}
+
+// Index array selection into a staging buffer, then format conversion,
+// as RecordBufferConverter did before the conversion was fused.
+static void BM_RecordConvert_Staged(benchmark::State& state) {
+    const size_t srcSampleSize = audio_bytes_per_sample(kSrcFormat);
+    LoopBufferProvider source(kSrcChannels * srcSampleSize, kFrameCount);
+    int8_t idxAry[sizeof(uint32_t) * 8];
+    (void) memcpy_by_index_array_initialization_from_channel_mask(idxAry, std::size(idxAry),
+            audio_channel_mask_for_index_assignment_from_count(kDstChannels),
+            audio_channel_mask_for_index_assignment_from_count(kSrcChannels));
+    std::vector<uint8_t> staging(kFrameCount * kDstChannels * srcSampleSize);
+    std::vector<float> out(kFrameCount * kDstChannels);
+    while (state.KeepRunning()) {
+        AudioBufferProvider::Buffer buffer;
+        buffer.frameCount = kFrameCount;
+        source.getNextBuffer(&buffer);
+        memcpy_by_index_array(staging.data(), kDstChannels, buffer.raw, kSrcChannels,
+                idxAry, srcSampleSize, kFrameCount);
+        memcpy_by_audio_format(out.data(), AUDIO_FORMAT_PCM_FLOAT, staging.data(), kSrcFormat,
+                kFrameCount * kDstChannels);
+        source.releaseBuffer(&buffer);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void BM_RecordConvert_Fused(benchmark::State& state) {
+    LoopBufferProvider source(kSrcChannels * audio_bytes_per_sample(kSrcFormat), kFrameCount);
+    RecordBufferConverter converter(
+            audio_channel_mask_for_index_assignment_from_count(kSrcChannels), kSrcFormat, 48000,
+            audio_channel_mask_for_index_assignment_from_count(kDstChannels),
+            AUDIO_FORMAT_PCM_FLOAT, 48000);
+    if (converter.initCheck() != NO_ERROR) {
+        state.SkipWithError("RecordBufferConverter initCheck failed");
+        return;
+    }
+    std::vector<float> out(kFrameCount * kDstChannels);
+    while (state.KeepRunning()) {
+        converter.convert(out.data(), &source, kFrameCount);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+BENCHMARK(BM_ChannelMix_Chained);
+BENCHMARK(BM_ChannelMix_Fused);
+BENCHMARK(BM_RecordConvert_Staged);
+BENCHMARK(BM_RecordConvert_Fused);
+
+BENCHMARK_MAIN();
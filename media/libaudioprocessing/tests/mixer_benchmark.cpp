@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Drives AudioMixer::process() end-to-end, so that changes to the process__*()
+// hooks, the track buffer providers and the mixer kernels are measured together.
+//
+// Each benchmark takes (track count, scenario flags). An item is one output frame,
+// with all tracks mixed.
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioMixer.h>
+#include <media/AudioMixerWorkerPool.h>
+
+using namespace android;
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr size_t kMixerFrameCount = 960;   // 20 ms, a typical normal mixer period
+static constexpr audio_channel_mask_t kMixerChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+
+enum : int64_t {
+    kFloat        = 1 << 0,   // float tracks instead of 16 bit
+    kMultichannel = 1 << 1,   // 5.1 tracks, downmixed to stereo
+    kMono         = 1 << 2,   // mono tracks
+    kResample     = 1 << 3,   // tracks at 44.1 kHz
+    kRamp         = 1 << 4,   // volume ramps every period
+    kAux          = 1 << 5,   // aux effect send on every track
+    kTiled        = 1 << 6,   // tiled mixing sized for a 32 KiB L1 cache
+    kWorkerPool   = 1 << 7,   // parallel track preprocessing on 2 helper threads
+};
+
+// Provides the same buffer of random data forever.
+class LoopBufferProvider : public AudioBufferProvider {
+public:
+    LoopBufferProvider(audio_format_t format, uint32_t channelCount, size_t frameCount)
+        : mFrameSize(audio_bytes_per_sample(format) * channelCount)
+        , mFrameCount(frameCount)
+        , mData(mFrameSize * frameCount) {
+        std::minstd_rand gen(42);
+        std::uniform_real_distribution<float> dis(-0.5f, 0.5f);
+        if (format == AUDIO_FORMAT_PCM_FLOAT) {
+            float *data = reinterpret_cast<float *>(mData.data());
+            std::generate(data, data + frameCount * channelCount, [&] { return dis(gen); });
+        } else {
+            int16_t *data = reinterpret_cast<int16_t *>(mData.data());
+            std::generate(data, data + frameCount * channelCount,
+                    [&] { return (int16_t)(dis(gen) * INT16_MAX); });
+        }
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mFrameCount - mOffset);
+        buffer->raw = mData.data() + mOffset * mFrameSize;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        mOffset = (mOffset + buffer->frameCount) % mFrameCount;
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    const size_t mFrameSize;
+    const size_t mFrameCount;
+    std::vector<uint8_t> mData;
+    size_t mOffset = 0;
+};
+
+static void BM_AudioMixerProcess(benchmark::State& state) {
+    const int trackCount = state.range(0);
+    const int64_t flags = state.range(1);
+    const audio_format_t format = flags & kFloat
+            ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const audio_channel_mask_t channelMask = flags & kMultichannel ? AUDIO_CHANNEL_OUT_5POINT1
+            : flags & kMono ? AUDIO_CHANNEL_OUT_MONO : AUDIO_CHANNEL_OUT_STEREO;
+    const uint32_t trackSampleRate = flags & kResample ? 44100 : kSampleRate;
+
+    std::vector<float> mainBuffer(kMixerFrameCount * FCC_2);
+    std::vector<float> auxBuffer(kMixerFrameCount);
+    std::vector<std::unique_ptr<LoopBufferProvider>> providers;
+    AudioMixer mixer(kMixerFrameCount, kSampleRate);
+    std::shared_ptr<AudioMixerWorkerPool> workerPool;
+    if (flags & kWorkerPool) {
+        workerPool = std::make_shared<AudioMixerWorkerPool>(2 /* workerCount */);
+        mixer.setWorkerPool(workerPool);
+    }
+    if (flags & kTiled) {
+        mixer.setTileFrameCount(AudioMixer::tileFrameCountForCache(FCC_2, 32 * 1024));
+    }
+
+    float volume = AudioMixer::UNITY_GAIN_FLOAT / trackCount;
+    for (int name = 0; name < trackCount; ++name) {
+        if (mixer.create(name, channelMask, format, AUDIO_SESSION_OUTPUT_MIX) != OK) {
+            state.SkipWithError("AudioMixer::create failed");
+            return;
+        }
+        providers.emplace_back(std::make_unique<LoopBufferProvider>(
+                format, audio_channel_count_from_out_mask(channelMask), kMixerFrameCount * 4));
+        mixer.setBufferProvider(name, providers.back().get());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, mainBuffer.data());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                (void *)(uintptr_t)kMixerChannelMask);
+        mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                (void *)(uintptr_t)trackSampleRate);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &volume);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &volume);
+        if (flags & kAux) {
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::AUX_BUFFER,
+                    auxBuffer.data());
+            mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::AUXLEVEL, &volume);
+        }
+        mixer.enable(name);
+    }
+
+    // Alternate between two volumes so that every period ramps.
+    float rampVolumes[2] = { volume, volume * 0.5f };
+    size_t period = 0;
+    for (auto _ : state) {
+        if (flags & kRamp) {
+            float *v = &rampVolumes[++period & 1];
+            for (int name = 0; name < trackCount; ++name) {
+                mixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0, v);
+                mixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1, v);
+                if (flags & kAux) {
+                    mixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::AUXLEVEL,
+                            v);
+                }
+            }
+        }
+        mixer.process();
+        benchmark::DoNotOptimize(mainBuffer.data());
+        benchmark::DoNotOptimize(auxBuffer.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kMixerFrameCount);
+
+    for (int name = 0; name < trackCount; ++name) {
+        mixer.destroy(name);
+    }
+}
+
+static void MixerArgs(benchmark::internal::Benchmark* b) {
+    static constexpr int64_t kScenarios[] = {
+        0,                          // 16 bit stereo, the common case
+        kFloat,
+        kMono,
+        kFloat | kMultichannel,
+        kResample,
+        kFloat | kResample,
+        kRamp,
+        kFloat | kRamp,
+        kAux,
+        kFloat | kRamp | kAux,
+        kFloat | kTiled,
+        kFloat | kResample | kWorkerPool,
+    };
+    for (int64_t flags : kScenarios) {
+        for (int tracks : { 1, 2, 4, 8, 16 }) {
+            b->Args({tracks, flags});
+        }
+    }
+    b->ArgNames({"tracks", "flags"});
+}
+
+// Real time, as the worker pool scenario runs on several threads.
+BENCHMARK(BM_AudioMixerProcess)->Apply(MixerArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -19,6 +19,7 @@
 #define LOG_ALWAYS_FATAL(...)
 
 #include <../AudioMixerOps.h>
+#include <../AudioMixerOpsSimd.h>
 #include <benchmark/benchmark.h>
 
 using namespace android;
@@ -101,4 +102,93 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+// SIMD kernels (see AudioMixerOpsSimd.h) compared with the templated scalar versions above.
+// The argument is the mixer_simd_isa_t; instruction sets not supported by the CPU are skipped.
+template <int MIXTYPE, int NCHAN>
+static void BM_VolumeRampMultiSimd(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    const MixerSimdKernels* kernels = mixerSimdKernelsForIsa((mixer_simd_isa_t)state.range(0));
+    if (kernels == nullptr) {
+        state.SkipWithError("instruction set not supported");
+        return;
+    }
+    state.SetLabel(kernels->name);
+
+    // data inialized to 0.
+    float out[SAMPLE_COUNT]{};
+    float in[SAMPLE_COUNT]{};
+
+    // volume initialized to 0
+    float vol[2] = {0.f, 0.f};
+
+    // some volume increment
+    float volinc[2] = {0.01f, 0.01f};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        volumeRampMultiSimd<MIXTYPE>(*kernels, NCHAN, out, FRAME_COUNT, in, vol, volinc);
+        benchmark::ClobberMemory();
+    }
+}
+
+template <int MIXTYPE, int NCHAN>
+static void BM_VolumeMultiSimd(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    const MixerSimdKernels* kernels = mixerSimdKernelsForIsa((mixer_simd_isa_t)state.range(0));
+    if (kernels == nullptr) {
+        state.SkipWithError("instruction set not supported");
+        return;
+    }
+    state.SetLabel(kernels->name);
+
+    // data inialized to 0.
+    float out[SAMPLE_COUNT]{};
+    float in[SAMPLE_COUNT]{};
+
+    // volume initialized to 0
+    float vol[2] = {0.f, 0.f};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        volumeMultiSimd<MIXTYPE>(*kernels, NCHAN, out, FRAME_COUNT, in, vol);
+        benchmark::ClobberMemory();
+    }
+}
+
+static void SimdIsaArgs(benchmark::internal::Benchmark* b) {
+    for (int isa = MIXER_SIMD_ISA_SCALAR; isa < MIXER_SIMD_ISA_COUNT; ++isa) {
+        b->Arg(isa);
+    }
+}
+
+// Channel counts with a canonical channel mask (required for the STEREOVOL mixtypes).
+#define BENCHMARK_SIMD_CHANNELS(NCHAN) \
+    BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_STEREOVOL, NCHAN); \
+    BENCHMARK_TEMPLATE(BM_VolumeRampMultiSimd, MIXTYPE_MULTI_STEREOVOL, NCHAN) \
+            ->Apply(SimdIsaArgs); \
+    BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, NCHAN); \
+    BENCHMARK_TEMPLATE(BM_VolumeMultiSimd, MIXTYPE_MULTI_STEREOVOL, NCHAN) \
+            ->Apply(SimdIsaArgs); \
+    BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN); \
+    BENCHMARK_TEMPLATE(BM_VolumeMultiSimd, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN) \
+            ->Apply(SimdIsaArgs)
+
+BENCHMARK_SIMD_CHANNELS(1);
+BENCHMARK_SIMD_CHANNELS(2);
+BENCHMARK_SIMD_CHANNELS(3);
+BENCHMARK_SIMD_CHANNELS(4);
+BENCHMARK_SIMD_CHANNELS(5);
+BENCHMARK_SIMD_CHANNELS(6);
+BENCHMARK_SIMD_CHANNELS(7);
+BENCHMARK_SIMD_CHANNELS(8);
+BENCHMARK_SIMD_CHANNELS(12);
+BENCHMARK_SIMD_CHANNELS(16);
+BENCHMARK_SIMD_CHANNELS(24);
+
 BENCHMARK_MAIN();
@@ -18,11 +18,15 @@
 #define LOG_TAG "mixerop_tests"
 #include <log/log.h>
 
+#include <atomic>
 #include <inttypes.h>
 #include <type_traits>
+#include <vector>
 
 #include <../AudioMixerOps.h>
+#include <../AudioMixerOpsSimd.h>
 #include <gtest/gtest.h>
+#include <media/AudioMixer.h>
 
 using namespace android;
 
@@ -173,3 +177,160 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+// The SIMD kernels must match the templated scalar versions within rounding
+// (FMA variants do not round the intermediate product, and the scalar volume ramp
+// accumulates the increment per frame whereas the SIMD ramp advances per gain pattern).
+template <int MIXTYPE, int NCHAN>
+static void testSimdEquivalence(bool ramp) {
+    constexpr size_t FRAME_COUNT = 999; // not a multiple of the gain pattern.
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    const float kTolerance = ramp ? 1e-4f : 1e-6f;
+
+    float in[SAMPLE_COUNT];
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        in[i] = (float)((i * 7919) % 2001) / 1000.f - 1.f;
+    }
+    const float volinc[2] = {0.0004f, -0.0003f};
+
+    float expected[SAMPLE_COUNT];
+    std::fill(std::begin(expected), std::end(expected), 0.25f);
+    float expectedVol[2] = {0.125f, 0.75f};
+    float vola = 0.f;
+    if (ramp) {
+        volumeRampMulti<MIXTYPE, NCHAN>(expected, FRAME_COUNT, in, (float *)nullptr,
+                expectedVol, volinc, &vola, 0.f);
+    } else {
+        volumeMulti<MIXTYPE, NCHAN>(expected, FRAME_COUNT, in, (float *)nullptr,
+                expectedVol, vola);
+    }
+
+    for (int isa = MIXER_SIMD_ISA_SCALAR; isa < MIXER_SIMD_ISA_COUNT; ++isa) {
+        const MixerSimdKernels* kernels = mixerSimdKernelsForIsa((mixer_simd_isa_t)isa);
+        if (kernels == nullptr) continue;
+        SCOPED_TRACE(kernels->name);
+
+        float out[SAMPLE_COUNT];
+        std::fill(std::begin(out), std::end(out), 0.25f);
+        float vol[2] = {0.125f, 0.75f};
+        const bool handled = ramp
+                ? volumeRampMultiSimd<MIXTYPE>(*kernels, NCHAN, out, FRAME_COUNT, in, vol, volinc)
+                : volumeMultiSimd<MIXTYPE>(*kernels, NCHAN, out, FRAME_COUNT, in, vol);
+        ASSERT_TRUE(handled);
+        for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+            ASSERT_NEAR(expected[i], out[i], kTolerance) << "sample " << i;
+        }
+        EXPECT_NEAR(expectedVol[0], vol[0], kTolerance);
+        EXPECT_NEAR(expectedVol[1], vol[1], kTolerance);
+    }
+}
+
+template <int NCHAN>
+static void testSimdEquivalenceAllTypes() {
+    for (bool ramp : {false, true}) {
+        SCOPED_TRACE(ramp ? "ramp" : "no ramp");
+        testSimdEquivalence<MIXTYPE_MULTI_MONOVOL, NCHAN>(ramp);
+        testSimdEquivalence<MIXTYPE_MULTI_SAVEONLY_MONOVOL, NCHAN>(ramp);
+        testSimdEquivalence<MIXTYPE_MULTI_STEREOVOL, NCHAN>(ramp);
+        testSimdEquivalence<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN>(ramp);
+        if constexpr (NCHAN <= FCC_2) {
+            testSimdEquivalence<MIXTYPE_MULTI, NCHAN>(ramp);
+            testSimdEquivalence<MIXTYPE_MULTI_SAVEONLY, NCHAN>(ramp);
+        }
+    }
+}
+
+TEST(mixerops, simd_equivalence) {
+    testSimdEquivalenceAllTypes<1>();
+    testSimdEquivalenceAllTypes<2>();
+    testSimdEquivalenceAllTypes<3>();
+    testSimdEquivalenceAllTypes<4>();
+    testSimdEquivalenceAllTypes<5>();
+    testSimdEquivalenceAllTypes<6>();
+    testSimdEquivalenceAllTypes<7>();
+    testSimdEquivalenceAllTypes<8>();
+    if constexpr (FCC_LIMIT >= 12) {
+        testSimdEquivalenceAllTypes<12>();
+    }
+    if constexpr (FCC_LIMIT >= 24) {
+        testSimdEquivalenceAllTypes<24>();
+    }
+}
+
+// Counts the calls to the SIMD kernels chosen for this CPU.
+static std::atomic<size_t> sSimdKernelCalls;
+
+template <bool RAMP, bool ACCUMULATE>
+static void countingKernel(float* out, const float* in, size_t sampleCount,
+        float* gain, const float* gainInc, size_t patternLen) {
+    ++sSimdKernelCalls;
+    mixerSimdKernels().mix[RAMP][ACCUMULATE](out, in, sampleCount, gain, gainInc, patternLen);
+}
+
+// Provides a constant float stereo signal.
+class ConstantBufferProvider : public AudioBufferProvider {
+public:
+    ConstantBufferProvider(float value, size_t frameCount)
+        : mData(frameCount * FCC_2, value) {}
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mData.size() / FCC_2);
+        buffer->raw = mData.data();
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    std::vector<float> mData;
+};
+
+// AudioMixer::process() mixes float tracks that do not resample with the SIMD kernels,
+// in the default blocks as well as in tiles.
+TEST(mixerops, audiomixer_uses_simd_kernels) {
+    constexpr size_t kFrameCount = 960;
+    constexpr int kTrackCount = 2;
+    const MixerSimdKernels counting = {
+        MIXER_SIMD_ISA_SCALAR, "counting",
+        {{countingKernel<false, false>, countingKernel<false, true>},
+         {countingKernel<true, false>, countingKernel<true, true>}},
+    };
+    AudioMixer::setMixerKernelsForTest(&counting);
+
+    AudioMixer mixer(kFrameCount, 48000 /* sampleRate */);
+    std::vector<float> mainBuffer(kFrameCount * FCC_2);
+    ConstantBufferProvider provider(0.5f, kFrameCount);
+    float volumes[kTrackCount] = {0.25f, 0.5f};
+    for (int name = 0; name < kTrackCount; ++name) {
+        ASSERT_EQ(OK, mixer.create(name, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+                AUDIO_SESSION_OUTPUT_MIX));
+        mixer.setBufferProvider(name, &provider);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, mainBuffer.data());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &volumes[name]);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &volumes[name]);
+        mixer.enable(name);
+    }
+
+    for (size_t tileFrameCount : {(size_t)0, kFrameCount / 4}) {
+        SCOPED_TRACE("tileFrameCount " + std::to_string(tileFrameCount));
+        mixer.setTileFrameCount(tileFrameCount);
+        sSimdKernelCalls = 0;
+        mixer.process();
+        // each track is mixed by one kernel call per block or tile.
+        const size_t blockFrameCount = tileFrameCount != 0 ? tileFrameCount : 16 /* BLOCKSIZE */;
+        EXPECT_EQ(kTrackCount * kFrameCount / blockFrameCount, sSimdKernelCalls.load());
+        for (size_t i = 0; i < mainBuffer.size(); ++i) {
+            ASSERT_FLOAT_EQ(0.5f * (volumes[0] + volumes[1]), mainBuffer[i]) << "sample " << i;
+        }
+    }
+
+    for (int name = 0; name < kTrackCount; ++name) {
+        mixer.destroy(name);
+    }
+    AudioMixer::setMixerKernelsForTest(nullptr);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "recordbufferconverter_tests"
+#include <log/log.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <audio_utils/format.h>
+#include <audio_utils/primitives.h>
+#include <gtest/gtest.h>
+#include <media/RecordBufferConverter.h>
+
+#include "test_utils.h"
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kFrameCount = 1000;
+constexpr uint32_t kSampleRate = 48000;
+
+// The channel selection to float is done in one pass for these source formats.
+constexpr audio_format_t kSrcFormats[] = {
+    AUDIO_FORMAT_PCM_8_BIT,
+    AUDIO_FORMAT_PCM_16_BIT,
+    AUDIO_FORMAT_PCM_24_BIT_PACKED,
+    AUDIO_FORMAT_PCM_8_24_BIT,
+    AUDIO_FORMAT_PCM_32_BIT,
+};
+
+// Channel mask changes that are not the legacy mono <-> stereo conversions.
+// They cover the mono and stereo specializations and the generic channel count.
+constexpr std::pair<audio_channel_mask_t, audio_channel_mask_t> kChannelMasks[] = {
+    {AUDIO_CHANNEL_INDEX_MASK_4, AUDIO_CHANNEL_INDEX_MASK_1},
+    {AUDIO_CHANNEL_INDEX_MASK_4, AUDIO_CHANNEL_INDEX_MASK_2},
+    {AUDIO_CHANNEL_INDEX_MASK_8, AUDIO_CHANNEL_INDEX_MASK_6},
+    {AUDIO_CHANNEL_INDEX_MASK_2, AUDIO_CHANNEL_INDEX_MASK_4},  // zero filled channels
+    {AUDIO_CHANNEL_IN_2POINT0POINT2, AUDIO_CHANNEL_IN_STEREO},
+    {AUDIO_CHANNEL_IN_STEREO, AUDIO_CHANNEL_IN_FRONT_BACK},
+};
+
+// The conversion that RecordBufferConverter did before the one pass selection:
+// select the channels in the source format, then convert to the destination format.
+std::vector<float> referenceConvert(const std::vector<uint8_t>& src,
+        audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
+        audio_channel_mask_t dstChannelMask, size_t frames) {
+    const uint32_t srcChannelCount = audio_channel_count_from_in_mask(srcChannelMask);
+    const uint32_t dstChannelCount = audio_channel_count_from_in_mask(dstChannelMask);
+    int8_t idxAry[sizeof(uint32_t) * 8];
+    (void)memcpy_by_index_array_initialization_from_channel_mask(
+            idxAry, std::size(idxAry), dstChannelMask, srcChannelMask);
+    std::vector<uint8_t> selected(frames * dstChannelCount * audio_bytes_per_sample(srcFormat));
+    memcpy_by_index_array(selected.data(), dstChannelCount, src.data(), srcChannelCount,
+            idxAry, audio_bytes_per_sample(srcFormat), frames);
+    std::vector<float> dst(frames * dstChannelCount);
+    memcpy_by_audio_format(dst.data(), AUDIO_FORMAT_PCM_FLOAT, selected.data(), srcFormat,
+            frames * dstChannelCount);
+    return dst;
+}
+
+class RecordBufferConverterTest : public ::testing::TestWithParam<
+        std::tuple<audio_format_t, std::pair<audio_channel_mask_t, audio_channel_mask_t>>> {};
+
+TEST_P(RecordBufferConverterTest, selectToFloatMatchesReference) {
+    const audio_format_t srcFormat = std::get<0>(GetParam());
+    const auto [srcChannelMask, dstChannelMask] = std::get<1>(GetParam());
+    const uint32_t srcChannelCount = audio_channel_count_from_in_mask(srcChannelMask);
+    const uint32_t dstChannelCount = audio_channel_count_from_in_mask(dstChannelMask);
+    const size_t srcFrameSize = srcChannelCount * audio_bytes_per_sample(srcFormat);
+
+    // Random bytes reach every sample value, including full scale of each format.
+    std::vector<uint8_t> src(kFrameCount * srcFrameSize);
+    std::minstd_rand gen(srcFormat ^ srcChannelMask);
+    std::uniform_int_distribution<int> dis(0, UINT8_MAX);
+    for (auto& byte : src) {
+        byte = dis(gen);
+    }
+
+    RecordBufferConverter converter(srcChannelMask, srcFormat, kSampleRate,
+            dstChannelMask, AUDIO_FORMAT_PCM_FLOAT, kSampleRate);
+    ASSERT_EQ(NO_ERROR, converter.initCheck());
+    // Odd buffer sizes, so that conversions start at any frame.
+    TestProvider provider(src.data(), kFrameCount, srcFrameSize, {7, 64, 1, 333});
+    std::vector<float> dst(kFrameCount * dstChannelCount, -2.f);
+    ASSERT_EQ(kFrameCount, converter.convert(dst.data(), &provider, kFrameCount));
+
+    const std::vector<float> expected = referenceConvert(
+            src, srcChannelMask, srcFormat, dstChannelMask, kFrameCount);
+    for (size_t i = 0; i < dst.size(); ++i) {
+        // bit-exact
+        ASSERT_EQ(expected[i], dst[i]) << "frame " << i / dstChannelCount
+                << " channel " << i % dstChannelCount;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Conversions, RecordBufferConverterTest,
+        ::testing::Combine(::testing::ValuesIn(kSrcFormats),
+                ::testing::ValuesIn(kChannelMasks)));
+
+} // namespace
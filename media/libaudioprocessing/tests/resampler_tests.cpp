@@ -28,8 +28,11 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <random>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -38,6 +41,14 @@
 #include <media/AudioBufferProvider.h>
 
 #include <media/AudioResampler.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>  // before the FIR kernels, see AudioResamplerDyn.cpp
+#endif
+#include "../AudioResamplerFirOps.h"
+#include "../AudioResamplerFirProcess.h"
+#include "../AudioResamplerFirProcessNeon.h"
+#include "../AudioResamplerFirProcessSSE.h"
+#include "../AudioResamplerFirProcessAVX2.h"
 #include "../AudioResamplerDyn.h"
 #include "../AudioResamplerFirGen.h"
 #include "test_utils.h"
@@ -601,3 +612,117 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Runs fir() and firAVX2() on the same random filter bank and samples, for every phase
+// of a locked (integer ratio) resampler and for random phases of an interpolated one.
+template <int CHANNELS, bool LOCKED, typename TC, typename TI, typename TO>
+static void testFirAVX2(int halfNumCoefs, const TO (&volumeLR)[2], TO tolerance)
+{
+    constexpr int kPhases = 128;
+    constexpr int kCoefShift = android::AudioResampler::kNumPhaseBits - 7;  // kPhases - 1 bits
+    constexpr uint32_t kPhaseWrapLimit = kPhases << kCoefShift;
+
+    std::minstd_rand gen(halfNumCoefs * CHANNELS);
+    auto random = [&gen](auto max) {
+        using T = decltype(max);
+        if constexpr (std::is_floating_point_v<T>) {
+            return std::uniform_real_distribution<T>(-max, max)(gen);
+        } else {
+            return (T)std::uniform_int_distribution<int32_t>(-max, max)(gen);
+        }
+    };
+
+    // the interpolated phases read one more polyphase filter.
+    std::vector<TC> coefs((kPhases + 1) * halfNumCoefs);
+    for (auto &coef : coefs) {
+        coef = random(std::is_floating_point_v<TC> ? TC(1. / halfNumCoefs) : TC(INT16_MAX));
+    }
+    // halfNumCoefs frames on each side of the impulse.
+    std::vector<TI> samples(2 * halfNumCoefs * CHANNELS);
+    for (auto &sample : samples) {
+        sample = random(std::is_floating_point_v<TI> ? TI(1.) : TI(INT16_MAX));
+    }
+    const TI *impulse = samples.data() + (halfNumCoefs - 1) * CHANNELS;
+
+    std::vector<uint32_t> phases;
+    for (uint32_t i = 0; i < kPhases; i++) {
+        phases.push_back(i << kCoefShift);
+        if (!LOCKED) {
+            phases.push_back(std::uniform_int_distribution<uint32_t>(0, kPhaseWrapLimit - 1)(gen));
+        }
+    }
+    for (const uint32_t phase : phases) {
+        TO expected[2] = { 1, -1 };  // both accumulate to the output
+        TO actual[2] = { 1, -1 };
+        android::fir<CHANNELS, LOCKED, 16>(expected, phase, kPhaseWrapLimit, kCoefShift,
+                halfNumCoefs, coefs.data(), impulse, volumeLR);
+        android::firAVX2<CHANNELS, LOCKED>(actual, phase, kPhaseWrapLimit, kCoefShift,
+                halfNumCoefs, coefs.data(), impulse, volumeLR);
+        for (int i = 0; i < 2; i++) {
+            if constexpr (std::is_floating_point_v<TO>) {
+                ASSERT_NEAR(expected[i], actual[i], tolerance) << "phase " << phase;
+            } else {
+                ASSERT_EQ(expected[i], actual[i]) << "phase " << phase;
+            }
+        }
+    }
+}
+
+// The AVX2/FMA kernels match fir() for the channel counts, coefficient types and phase modes
+// they are selected for: within rounding for float, and bit-exact for int16.
+TEST(audioflinger_resampler, firavx2) {
+    if (!android::firAVX2Available()) {
+        GTEST_SKIP() << "AVX2/FMA not supported";
+    }
+    const float floatVolume[2] = { 1.f, 0.5f };
+    const int32_t intVolume[2] = { 1 << 28, (1 << 27) + 12345 };  // U4_28
+
+    for (const int halfNumCoefs : { 16, 32, 64 }) {
+        SCOPED_TRACE(testing::Message() << "halfNumCoefs " << halfNumCoefs);
+        // the float sums are reassociated and fused, allow a few ulps per tap.
+        const float tolerance = halfNumCoefs * 1e-7f;
+        testFirAVX2<1, true, float, float>(halfNumCoefs, floatVolume, tolerance);
+        testFirAVX2<1, false, float, float>(halfNumCoefs, floatVolume, tolerance);
+        testFirAVX2<2, true, float, float>(halfNumCoefs, floatVolume, tolerance);
+        testFirAVX2<2, false, float, float>(halfNumCoefs, floatVolume, tolerance);
+
+        testFirAVX2<1, true, int16_t, int16_t>(halfNumCoefs, intVolume, 0);
+        testFirAVX2<1, false, int16_t, int16_t>(halfNumCoefs, intVolume, 0);
+        testFirAVX2<2, true, int16_t, int16_t>(halfNumCoefs, intVolume, 0);
+        testFirAVX2<2, false, int16_t, int16_t>(halfNumCoefs, intVolume, 0);
+    }
+}
+
+// Resamplers with the same filter design share one filter bank.
+TEST(audioflinger_resampler, sharedfilter) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto create = [](unsigned inputFreq, unsigned outputFreq,
+            android::AudioResampler::src_quality quality) {
+        std::unique_ptr<ResamplerType> rdyn(static_cast<ResamplerType *>(
+                android::AudioResampler::create(
+                        AUDIO_FORMAT_PCM_FLOAT, 2 /* channels */, outputFreq, quality)));
+        rdyn->setSampleRate(inputFreq);
+        return rdyn;
+    };
+
+    std::vector<std::unique_ptr<ResamplerType>> resamplers;
+    for (int i = 0; i < 30; ++i) {
+        resamplers.push_back(create(44100, 48000, android::AudioResampler::DYN_HIGH_QUALITY));
+        EXPECT_EQ(resamplers[0]->getFilterCoefs(), resamplers[i]->getFilterCoefs());
+    }
+
+    // a different design has its own filter bank.
+    auto other = create(32000, 48000, android::AudioResampler::DYN_HIGH_QUALITY);
+    EXPECT_NE(resamplers[0]->getFilterCoefs(), other->getFilterCoefs());
+    auto high = create(48000, 44100, android::AudioResampler::DYN_HIGH_QUALITY);
+    auto med = create(48000, 44100, android::AudioResampler::DYN_MED_QUALITY);
+    EXPECT_NE(high->getFilterCoefs(), med->getFilterCoefs());
+
+    // the shared filter bank remains valid as the resamplers go away.
+    const int phases = resamplers.back()->getPhases();
+    const int halfLength = resamplers.back()->getHalfLength();
+    const std::vector<float> expected(resamplers.back()->getFilterCoefs(),
+            resamplers.back()->getFilterCoefs() + (phases + 1) * halfLength);
+    resamplers.resize(1);
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), resamplers[0]->getFilterCoefs()));
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include <audio_utils/primitives.h>
+
+#include "DownmixMatrix.h"
+
+namespace android {
+
+namespace {
+
+// Gains for the front left/right of center channels, which are panned between
+// front center and front left/right.
+constexpr float COEF_25 = 0.2508909536f;
+constexpr float COEF_61 = 0.6057043428f;
+// Gains for the top center channels, which are spread over a wider image.
+constexpr float COEF_35 = 0.3543928915f;
+constexpr float COEF_36 = 0.3552343859f;
+
+constexpr float MINUS_3_DB = M_SQRT1_2;
+constexpr float MINUS_6_DB = 0.5f;
+
+// Gain of each channel position, indexed by the bit of the position in the mask.
+constexpr float kLeftFromChannelIdx[FCC_26] = {
+    1.f,         // AUDIO_CHANNEL_OUT_FRONT_LEFT
+    0.f,         // AUDIO_CHANNEL_OUT_FRONT_RIGHT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_FRONT_CENTER
+    MINUS_6_DB,  // AUDIO_CHANNEL_OUT_LOW_FREQUENCY
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_BACK_LEFT
+    0.f,         // AUDIO_CHANNEL_OUT_BACK_RIGHT
+    COEF_61,     // AUDIO_CHANNEL_OUT_FRONT_LEFT_OF_CENTER
+    COEF_25,     // AUDIO_CHANNEL_OUT_FRONT_RIGHT_OF_CENTER
+    MINUS_6_DB,  // AUDIO_CHANNEL_OUT_BACK_CENTER
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_SIDE_LEFT
+    0.f,         // AUDIO_CHANNEL_OUT_SIDE_RIGHT
+    COEF_36,     // AUDIO_CHANNEL_OUT_TOP_CENTER
+    1.f,         // AUDIO_CHANNEL_OUT_TOP_FRONT_LEFT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_TOP_FRONT_CENTER
+    0.f,         // AUDIO_CHANNEL_OUT_TOP_FRONT_RIGHT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_TOP_BACK_LEFT
+    COEF_35,     // AUDIO_CHANNEL_OUT_TOP_BACK_CENTER
+    0.f,         // AUDIO_CHANNEL_OUT_TOP_BACK_RIGHT
+    COEF_61,     // AUDIO_CHANNEL_OUT_TOP_SIDE_LEFT
+    0.f,         // AUDIO_CHANNEL_OUT_TOP_SIDE_RIGHT
+    1.f,         // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_LEFT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_CENTER
+    0.f,         // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_RIGHT
+    0.f,         // AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_FRONT_WIDE_LEFT
+    0.f,         // AUDIO_CHANNEL_OUT_FRONT_WIDE_RIGHT
+};
+
+constexpr float kRightFromChannelIdx[FCC_26] = {
+    0.f,         // AUDIO_CHANNEL_OUT_FRONT_LEFT
+    1.f,         // AUDIO_CHANNEL_OUT_FRONT_RIGHT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_FRONT_CENTER
+    MINUS_6_DB,  // AUDIO_CHANNEL_OUT_LOW_FREQUENCY
+    0.f,         // AUDIO_CHANNEL_OUT_BACK_LEFT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_BACK_RIGHT
+    COEF_25,     // AUDIO_CHANNEL_OUT_FRONT_LEFT_OF_CENTER
+    COEF_61,     // AUDIO_CHANNEL_OUT_FRONT_RIGHT_OF_CENTER
+    MINUS_6_DB,  // AUDIO_CHANNEL_OUT_BACK_CENTER
+    0.f,         // AUDIO_CHANNEL_OUT_SIDE_LEFT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_SIDE_RIGHT
+    COEF_36,     // AUDIO_CHANNEL_OUT_TOP_CENTER
+    0.f,         // AUDIO_CHANNEL_OUT_TOP_FRONT_LEFT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_TOP_FRONT_CENTER
+    1.f,         // AUDIO_CHANNEL_OUT_TOP_FRONT_RIGHT
+    0.f,         // AUDIO_CHANNEL_OUT_TOP_BACK_LEFT
+    COEF_35,     // AUDIO_CHANNEL_OUT_TOP_BACK_CENTER
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_TOP_BACK_RIGHT
+    0.f,         // AUDIO_CHANNEL_OUT_TOP_SIDE_LEFT
+    COEF_61,     // AUDIO_CHANNEL_OUT_TOP_SIDE_RIGHT
+    0.f,         // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_LEFT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_CENTER
+    1.f,         // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_RIGHT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2
+    0.f,         // AUDIO_CHANNEL_OUT_FRONT_WIDE_LEFT
+    MINUS_3_DB,  // AUDIO_CHANNEL_OUT_FRONT_WIDE_RIGHT
+};
+
+constexpr int kLowFrequencyIdx = __builtin_ctz(AUDIO_CHANNEL_OUT_LOW_FREQUENCY);
+
+}  // namespace
+
+bool DownmixMatrix::setInputChannelMask(audio_channel_mask_t inputChannelMask) {
+    if (inputChannelMask == AUDIO_CHANNEL_NONE || (inputChannelMask & ~kMaximumChannelMask)) {
+        return false;
+    }
+    const bool hasLowFrequency2 = (inputChannelMask & AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2) != 0;
+
+    size_t inputChannel = 0;
+    for (uint32_t channels = inputChannelMask; channels != 0; ++inputChannel) {
+        const int index = __builtin_ctz(channels);
+        channels &= ~(1u << index);
+        if (index == kLowFrequencyIdx && hasLowFrequency2) {
+            // The second low frequency channel takes the right side, so this takes the left.
+            mLeft[inputChannel] = MINUS_3_DB;
+            mRight[inputChannel] = 0.f;
+        } else {
+            mLeft[inputChannel] = kLeftFromChannelIdx[index];
+            mRight[inputChannel] = kRightFromChannelIdx[index];
+        }
+    }
+    for (size_t i = inputChannel; i < FCC_26; ++i) {
+        mLeft[i] = 0.f;
+        mRight[i] = 0.f;
+    }
+
+    static constexpr auto kProcessFuncs =
+            makeProcessFuncs<false>(std::make_index_sequence<FCC_26>{});
+    static constexpr auto kProcessAccumulateFuncs =
+            makeProcessFuncs<true>(std::make_index_sequence<FCC_26>{});
+    mInputChannelMask = inputChannelMask;
+    mInputChannelCount = inputChannel;
+    mProcess = kProcessFuncs[inputChannel - 1];
+    mProcessAccumulate = kProcessAccumulateFuncs[inputChannel - 1];
+    return true;
+}
+
+bool DownmixMatrix::process(const float* src, float* dst, size_t frameCount,
+                            bool accumulate) const {
+    if (mProcess == nullptr) {
+        return false;
+    }
+    (accumulate ? mProcessAccumulate : mProcess)(*this, src, dst, frameCount);
+    return true;
+}
+
+// The channel count is a constant, so the loops over the channels are unrolled and the
+// gains stay in registers for the whole buffer.
+template <size_t CHANNELS, bool ACCUMULATE>
+void DownmixMatrix::processChannels(const DownmixMatrix& matrix, const float* src, float* dst,
+                                    size_t frameCount) {
+    float left[CHANNELS];
+    float right[CHANNELS];
+    for (size_t c = 0; c < CHANNELS; ++c) {
+        left[c] = matrix.mLeft[c];
+        right[c] = matrix.mRight[c];
+    }
+
+    for (size_t i = 0; i < frameCount; ++i) {
+        float l = 0.f;
+        float r = 0.f;
+        for (size_t c = 0; c < CHANNELS; ++c) {
+            l += src[c] * left[c];
+            r += src[c] * right[c];
+        }
+        if constexpr (ACCUMULATE) {
+            l += dst[0];
+            r += dst[1];
+        }
+        dst[0] = clamp_float(l);
+        dst[1] = clamp_float(r);
+        src += CHANNELS;
+        dst += FCC_2;
+    }
+}
+
+}  // namespace android
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_DOWNMIX_MATRIX_H_
+#define ANDROID_DOWNMIX_MATRIX_H_
+
+#include <array>
+#include <stddef.h>
+#include <utility>
+
+#include <system/audio.h>
+
+namespace android {
+
+/**
+ * Folds a positional channel mask down to stereo with a precomputed mix matrix.
+ *
+ * The matrix is built once by setInputChannelMask(), when the effect is configured,
+ * so process() does no per-call work on the channel layout. process() runs a kernel
+ * specialized for the input channel count, so the per-frame matrix-vector product is
+ * fully unrolled and vectorized by the compiler.
+ *
+ * Each input channel is mixed into the left and right outputs according to its position,
+ * e.g. front center at -3 dB into both, side left into left only. The low frequency channel
+ * goes to both outputs at -6 dB, unless there is a second low frequency channel, in which
+ * case they go to the left and right outputs at -3 dB.
+ */
+class DownmixMatrix {
+public:
+    // Largest supported mask, up to FCC_26.
+    static constexpr uint32_t kMaximumChannelMask = AUDIO_CHANNEL_OUT_22POINT2
+            | AUDIO_CHANNEL_OUT_FRONT_WIDE_LEFT | AUDIO_CHANNEL_OUT_FRONT_WIDE_RIGHT;
+
+    /**
+     * Builds the mix matrix for an input channel mask.
+     *
+     * \return false if the mask is empty or has channels outside kMaximumChannelMask,
+     *         in which case the previous matrix is kept.
+     */
+    bool setInputChannelMask(audio_channel_mask_t inputChannelMask);
+
+    audio_channel_mask_t getInputChannelMask() const { return mInputChannelMask; }
+    size_t getInputChannelCount() const { return mInputChannelCount; }
+
+    /**
+     * Returns the gain of an input channel, in mask order, into the left (0) or right (1) output.
+     */
+    float getCoefficient(size_t inputChannel, size_t outputChannel) const {
+        return outputChannel == 0 ? mLeft[inputChannel] : mRight[inputChannel];
+    }
+
+    /**
+     * Downmixes interleaved input frames to interleaved stereo.
+     * The output is clamped to [-1, 1].
+     *
+     * \param accumulate true to add to the output instead of replacing it.
+     * \return false if no input channel mask has been set.
+     */
+    bool process(const float* src, float* dst, size_t frameCount, bool accumulate) const;
+
+private:
+    using ProcessFunc = void (*)(const DownmixMatrix& matrix, const float* src, float* dst,
+                                 size_t frameCount);
+
+    template <size_t CHANNELS, bool ACCUMULATE>
+    static void processChannels(const DownmixMatrix& matrix, const float* src, float* dst,
+                                size_t frameCount);
+
+    // Returns the kernels for 1 to sizeof...(INDICES) channels, indexed by channel count - 1.
+    template <bool ACCUMULATE, size_t... INDICES>
+    static constexpr std::array<ProcessFunc, sizeof...(INDICES)> makeProcessFuncs(
+            std::index_sequence<INDICES...>) {
+        return {&processChannels<INDICES + 1, ACCUMULATE>...};
+    }
+
+    audio_channel_mask_t mInputChannelMask = AUDIO_CHANNEL_NONE;
+    size_t mInputChannelCount = 0;
+    // Gains of each input channel, in mask order, into the left and right outputs.
+    std::array<float, FCC_26> mLeft{};
+    std::array<float, FCC_26> mRight{};
+    ProcessFunc mProcess = nullptr;
+    ProcessFunc mProcessAccumulate = nullptr;
+};
+
+}  // namespace android
+
+#endif  // ANDROID_DOWNMIX_MATRIX_H_
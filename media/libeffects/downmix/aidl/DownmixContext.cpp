@@ -144,8 +144,7 @@ IEffect::Status DownmixContext::downmixProcess(float* in, float* out, int sample
             frames--;
         }
     } else {
-        int chMask = mChMask.get<AudioChannelLayout::layoutMask>();
-        if (!mChannelMix.process(in, out, frames, accumulate, (audio_channel_mask_t)chMask)) {
+        if (!mMatrix.process(in, out, frames, accumulate)) {
             LOG(ERROR) << "Multichannel configuration " << mChMask.toString()
                        << " is not supported";
             return status;
@@ -167,6 +166,8 @@ void DownmixContext::init_params(const Parameter::Common& common) {
     } else {
         mType = Downmix::Type::FOLD;
         mChMask = channelMask;
+        mMatrix.setInputChannelMask(
+                (audio_channel_mask_t)channelMask.get<AudioChannelLayout::layoutMask>());
         mState = DOWNMIX_STATE_INITIALIZED;
     }
 }
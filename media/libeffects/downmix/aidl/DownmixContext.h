@@ -18,7 +18,7 @@
 
 #include "effect-impl/EffectContext.h"
 
-#include <audio_utils/ChannelMix.h>
+#include "DownmixMatrix.h"
 
 namespace aidl::android::hardware::audio::effect {
 
@@ -58,7 +58,7 @@ class DownmixContext final : public EffectContext {
     DownmixState mState;
     Downmix::Type mType;
     ::aidl::android::media::audio::common::AudioChannelLayout mChMask;
-    ::android::audio_utils::channels::ChannelMix<AUDIO_CHANNEL_OUT_STEREO> mChannelMix;
+    ::android::DownmixMatrix mMatrix;  // built by init_params() for mChMask
 
     // Common Params
     void init_params(const Parameter::Common& common);
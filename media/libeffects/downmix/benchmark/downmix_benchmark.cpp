@@ -25,6 +25,7 @@
 #include <log/log.h>
 #include <system/audio.h>
 
+#include "DownmixMatrix.h"
 #include "EffectDownmix.h"
 
 extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
@@ -52,6 +53,8 @@ static constexpr audio_channel_mask_t kChannelPositionMasks[] = {
     AUDIO_CHANNEL_OUT_7POINT1POINT4,
     AUDIO_CHANNEL_OUT_13POINT_360RA,
     AUDIO_CHANNEL_OUT_22POINT2,
+    audio_channel_mask_t(AUDIO_CHANNEL_OUT_22POINT2
+            | AUDIO_CHANNEL_OUT_FRONT_WIDE_LEFT | AUDIO_CHANNEL_OUT_FRONT_WIDE_RIGHT),
 };
 
 static constexpr effect_uuid_t downmix_uuid = {
@@ -60,7 +63,7 @@ static constexpr effect_uuid_t downmix_uuid = {
 static constexpr size_t kFrameCount = 1000;
 
 /*
-Pixel 7
+Pixel 7, with audio_utils::ChannelMix before DownmixMatrix, output access mode WRITE.
 $ atest downmix_benchmark
 
 --------------------------------------------------------
@@ -91,8 +94,10 @@ downmix_benchmark:
   #BM_Downmix/21    6332 ns    6301 ns       111134
 */
 
+// Arguments are the index of the channel mask, and whether the output access mode is ACCUMULATE.
 static void BM_Downmix(benchmark::State& state) {
     const audio_channel_mask_t channelMask = kChannelPositionMasks[state.range(0)];
+    const bool accumulate = state.range(1) != 0;
     const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
     const int sampleRate = 48000;
 
@@ -120,7 +125,8 @@ static void BM_Downmix(benchmark::State& state) {
     config.inputCfg.bufferProvider.cookie = nullptr;
     config.inputCfg.mask = EFFECT_CONFIG_ALL;
 
-    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    config.outputCfg.accessMode =
+            accumulate ? EFFECT_BUFFER_ACCESS_ACCUMULATE : EFFECT_BUFFER_ACCESS_WRITE;
     config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
     config.outputCfg.bufferProvider.getBuffer = nullptr;
     config.outputCfg.bufferProvider.releaseBuffer = nullptr;
@@ -171,12 +177,46 @@ static void BM_Downmix(benchmark::State& state) {
     }
 }
 
+// The mix matrix kernel alone, without the effect interface.
+static void BM_DownmixMatrix(benchmark::State& state) {
+    const audio_channel_mask_t channelMask = kChannelPositionMasks[state.range(0)];
+    const bool accumulate = state.range(1) != 0;
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * FCC_2);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    android::DownmixMatrix matrix;
+    if (!matrix.setInputChannelMask(channelMask)) {
+        state.SkipWithError("unsupported channel mask");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+        matrix.process(input.data(), output.data(), kFrameCount, accumulate);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(audio_channel_out_mask_to_string(channelMask));
+}
+
 static void DownmixArgs(benchmark::internal::Benchmark* b) {
-    for (int i = 0; i < (int)std::size(kChannelPositionMasks); i++) {
-        b->Args({i});
+    for (int accumulate = 0; accumulate <= 1; accumulate++) {
+        for (int i = 0; i < (int)std::size(kChannelPositionMasks); i++) {
+            b->Args({i, accumulate});
+        }
     }
 }
 
 BENCHMARK(BM_Downmix)->Apply(DownmixArgs);
 
+BENCHMARK(BM_DownmixMatrix)->Apply(DownmixArgs);
+
 BENCHMARK_MAIN();
@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <random>
 #include <vector>
 
+#include "DownmixMatrix.h"
 #include "EffectDownmix.h"
 
 #include <audio_utils/channels.h>
@@ -355,3 +358,86 @@ INSTANTIATE_TEST_SUITE_P(
                 + "_" + std::to_string(std::get<0>(info.param)) + "_" + std::to_string(index);
             return name;
         });
+
+// Compares the precomputed matrix used by the effect against the gain tables above.
+class DownmixMatrixTest : public ::testing::TestWithParam<int /* channel mask index */> {
+};
+
+TEST_P(DownmixMatrixTest, matchesReference) {
+    const audio_channel_mask_t channelMask = kChannelPositionMasks[GetParam()];
+    const size_t inChannels = audio_channel_count_from_out_mask(channelMask);
+    android::DownmixMatrix matrix;
+    ASSERT_TRUE(matrix.setInputChannelMask(channelMask));
+    ASSERT_EQ(inChannels, matrix.getInputChannelCount());
+
+    // Gains of each input channel, in mask order.
+    std::vector<float> left, right;
+    for (unsigned channel = channelMask; channel != 0; ) {
+        const int index = __builtin_ctz(channel);
+        channel &= ~(1 << index);
+        if (index == __builtin_ctz(AUDIO_CHANNEL_OUT_LOW_FREQUENCY)
+                && (channelMask & AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2)) {
+            left.push_back(M_SQRT1_2);
+            right.push_back(0.f);
+        } else {
+            left.push_back(kScaleFromChannelIdxLeft[index]);
+            right.push_back(kScaleFromChannelIdxRight[index]);
+        }
+    }
+    for (size_t i = 0; i < inChannels; ++i) {
+        EXPECT_EQ(left[i], matrix.getCoefficient(i, 0));
+        EXPECT_EQ(right[i], matrix.getCoefficient(i, 1));
+    }
+
+    // Use an odd frame count and a full scale input so that some outputs are clamped.
+    constexpr size_t frames = 1001;
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<float> dis(-1.f, 1.f);
+    std::vector<float> input(frames * inChannels);
+    for (auto& in : input) in = dis(gen);
+    std::vector<float> previous(frames * FCC_2);
+    for (auto& out : previous) out = dis(gen) * 0.5f;
+
+    for (bool accumulate : {false, true}) {
+        std::vector<float> output = previous;
+        ASSERT_TRUE(matrix.process(input.data(), output.data(), frames, accumulate));
+        for (size_t i = 0; i < frames; ++i) {
+            float l = 0.f, r = 0.f;
+            for (size_t c = 0; c < inChannels; ++c) {
+                l += input[i * inChannels + c] * left[c];
+                r += input[i * inChannels + c] * right[c];
+            }
+            if (accumulate) {
+                l += previous[i * FCC_2];
+                r += previous[i * FCC_2 + 1];
+            }
+            constexpr float kTolerance = 1e-6f;
+            EXPECT_NEAR(std::clamp(l, -1.f, 1.f), output[i * FCC_2], kTolerance);
+            EXPECT_NEAR(std::clamp(r, -1.f, 1.f), output[i * FCC_2 + 1], kTolerance);
+        }
+    }
+}
+
+TEST(DownmixMatrixTestSimple, invalidChannelMask) {
+    android::DownmixMatrix matrix;
+    float in[FCC_26]{}, out[FCC_2]{};
+    EXPECT_FALSE(matrix.process(in, out, 1 /* frameCount */, false /* accumulate */));
+    EXPECT_FALSE(matrix.setInputChannelMask(AUDIO_CHANNEL_NONE));
+    EXPECT_FALSE(matrix.setInputChannelMask(audio_channel_mask_t(1 << 31)));
+    EXPECT_FALSE(matrix.process(in, out, 1 /* frameCount */, false /* accumulate */));
+
+    // A failed update keeps the previous matrix.
+    ASSERT_TRUE(matrix.setInputChannelMask(AUDIO_CHANNEL_OUT_5POINT1));
+    EXPECT_FALSE(matrix.setInputChannelMask(audio_channel_mask_t(1 << 31)));
+    EXPECT_EQ(AUDIO_CHANNEL_OUT_5POINT1, matrix.getInputChannelMask());
+    EXPECT_TRUE(matrix.process(in, out, 1 /* frameCount */, false /* accumulate */));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        DownmixMatrixTestAll, DownmixMatrixTest,
+        ::testing::Range(0, (int)std::size(kChannelPositionMasks)),
+        [](const testing::TestParamInfo<DownmixMatrixTest::ParamType>& info) {
+            const audio_channel_mask_t channelMask = kChannelPositionMasks[info.param];
+            return std::string(audio_channel_out_mask_to_string(channelMask))
+                    + "_" + std::to_string(info.param);
+        });
@@ -213,8 +213,10 @@ int DP_init(DynamicsProcessingContext *pContext)
 void DP_changeVariant(DynamicsProcessingContext *pContext, int newVariant) {
     ALOGV("DP_changeVariant from %d to %d", pContext->mCurrentVariant, newVariant);
     switch(newVariant) {
-    case VARIANT_FAVOR_FREQUENCY_RESOLUTION: {
-        pContext->mCurrentVariant = VARIANT_FAVOR_FREQUENCY_RESOLUTION;
+    case VARIANT_FAVOR_FREQUENCY_RESOLUTION:
+    case VARIANT_FAVOR_TIME_RESOLUTION: {
+        //both use DPFrequency, configured differently.
+        pContext->mCurrentVariant = newVariant;
         delete pContext->mPDynamics;
         pContext->mPDynamics = new dp_fx::DPFrequency();
         break;
@@ -229,7 +231,8 @@ void DP_changeVariant(DynamicsProcessingContext *pContext, int newVariant) {
 void DP_configureVariant(DynamicsProcessingContext *pContext, int newVariant) {
     ALOGV("DP_configureVariant %d", newVariant);
     switch(newVariant) {
-    case VARIANT_FAVOR_FREQUENCY_RESOLUTION: {
+    case VARIANT_FAVOR_FREQUENCY_RESOLUTION:
+    case VARIANT_FAVOR_TIME_RESOLUTION: {
         int32_t minBlockSize = (int32_t)dp_fx::DPFrequency::getMinBockSize();
         int32_t desiredBlock = pContext->mPreferredFrameDuration *
                 pContext->mConfig.inputCfg.samplingRate / 1000.0f;
@@ -243,9 +246,16 @@ void DP_configureVariant(DynamicsProcessingContext *pContext, int newVariant) {
             //find next highest power of 2.
             currentBlock = 1 << (32 - __builtin_clz(desiredBlock));
         }
-        ((dp_fx::DPFrequency*)pContext->mPDynamics)->configure(currentBlock,
-                currentBlock/2,
-                pContext->mConfig.inputCfg.samplingRate);
+        dp_fx::DPFrequency *pDpFrequency = (dp_fx::DPFrequency*)pContext->mPDynamics;
+        if (newVariant == VARIANT_FAVOR_TIME_RESOLUTION) {
+            //low latency: the frame duration is the latency, not the analysis block.
+            pDpFrequency->configurePartitioned(currentBlock,
+                    pContext->mConfig.inputCfg.samplingRate);
+        } else {
+            pDpFrequency->configure(currentBlock,
+                    currentBlock/2,
+                    pContext->mConfig.inputCfg.samplingRate);
+        }
         break;
     }
     default: {
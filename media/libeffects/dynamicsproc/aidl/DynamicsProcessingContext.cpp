@@ -107,20 +107,20 @@ void DynamicsProcessingContext::dpSetFreqDomainVariant_l(
         // find next highest power of 2.
         block = 1 << (32 - __builtin_clz(block));
     }
-    mDpFreq->configure(block, block >> 1, sampleRate);
+    if (engine.resolutionPreference ==
+        DynamicsProcessing::ResolutionPreference::FAVOR_TIME_RESOLUTION) {
+        // low latency: the processing duration is the latency, not the analysis block.
+        mDpFreq->configurePartitioned(block, sampleRate);
+    } else {
+        mDpFreq->configure(block, block >> 1, sampleRate);
+    }
 }
 
 RetCode DynamicsProcessingContext::setEngineArchitecture(
         const DynamicsProcessing::EngineArchitecture& engineArchitecture) {
     std::lock_guard lg(mMutex);
     if (!mEngineInited || mEngineArchitecture != engineArchitecture) {
-        if (engineArchitecture.resolutionPreference ==
-            DynamicsProcessing::ResolutionPreference::FAVOR_FREQUENCY_RESOLUTION) {
-            dpSetFreqDomainVariant_l(engineArchitecture);
-        } else {
-            LOG(WARNING) << __func__ << toString(engineArchitecture.resolutionPreference)
-                         << " not available now";
-        }
+        dpSetFreqDomainVariant_l(engineArchitecture);
         mEngineInited = true;
         mEngineArchitecture = engineArchitecture;
     }
@@ -28,6 +28,9 @@ using Eigen::MatrixXd;
 #define MAX_BLOCKSIZE 16384 //For this implementation
 #define MIN_BLOCKSIZE 8
 
+#define MIN_PARTITIONSIZE 16
+#define PARTITIONS_PER_BLOCK 8
+
 #define CIRCULAR_BUFFER_UPSAMPLE 4  //4 times buffer size
 
 static constexpr float MIN_ENVELOPE = 1e-6f; //-120 dB
@@ -70,6 +73,7 @@ void ChannelBuffer::initBuffers(unsigned int blockSize, unsigned int overlapSize
     //module vectors
     mPreEqFactorVector.resize(halfFftSize, 1.0);
     mPostEqFactorVector.resize(halfFftSize, 1.0);
+    mResponse.resize(halfFftSize, 1.0);
 
     mPreEqBands.resize(dpBase.getPreEqBandCount());
     mMbcBands.resize(dpBase.getMbcBandCount());
@@ -137,6 +141,7 @@ size_t DPFrequency::getMaxBockSize() {
 void DPFrequency::configure(size_t blockSize, size_t overlapSize,
         size_t samplingRate) {
     ALOGV("configure");
+    mPartitionSize = 0;
     mBlockSize = blockSize;
     if (mBlockSize > MAX_BLOCKSIZE) {
         mBlockSize = MAX_BLOCKSIZE;
@@ -180,6 +185,30 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
     mWindowRms = std::max(sqrt(mWindowRms / mVWindow.size()), MIN_ENVELOPE);
 }
 
+void DPFrequency::configurePartitioned(size_t partitionSize, size_t samplingRate) {
+    ALOGV("configurePartitioned");
+    size_t partition = std::clamp(partitionSize, (size_t)MIN_PARTITIONSIZE,
+            (size_t)(MAX_BLOCKSIZE / PARTITIONS_PER_BLOCK));
+    if (!powerof2(partition)) {
+        //find next highest power of 2.
+        partition = 1 << (32 - __builtin_clz(partition));
+    }
+
+    //the analysis hop is half a block, so a whole number of partitions.
+    const size_t blockSize = partition * PARTITIONS_PER_BLOCK;
+    configure(blockSize, blockSize / 2, samplingRate);
+
+    mPartitionSize = partition;
+    mPartitionsPerHop = (mBlockSize - mOverlapSize) / mPartitionSize;
+    //analyze on the first partition, so that the stages apply from the start.
+    mPartitionIndex = mPartitionsPerHop - 1;
+
+    const int channelCount = getChannelCount();
+    mConvolver.configure(channelCount, mBlockSize, mPartitionSize);
+    mPartitionInput.resize(mPartitionSize, channelCount);
+    mPartitionOutput.resize(mPartitionSize, channelCount);
+}
+
 void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
     DPChannel *pChannel = getChannel(channelIndex);
 
@@ -393,7 +422,11 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**process all channelBuffers
-       processChannelBuffers(mChannelBuffers);
+       if (mPartitionSize > 0) {
+           processPartitions(mChannelBuffers);
+       } else {
+           processChannelBuffers(mChannelBuffers);
+       }
 
        //** estimate how much data is available in ALL channels
        size_t available = mChannelBuffers[0].cBOutput.availableToRead();
@@ -474,6 +507,60 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
     }
     return processedSamples;
 }
+
+size_t DPFrequency::processPartitions(CBufferVector &channelBuffers) {
+    const int channelCount = channelBuffers.size();
+    size_t processedSamples = 0;
+    const size_t newestStart = mBlockSize - mPartitionSize;
+
+    size_t available = channelBuffers[0].cBInput.availableToRead();
+    for (int ch = 1; ch < channelCount; ch++) {
+        available = std::min(available, channelBuffers[ch].cBInput.availableToRead());
+    }
+
+    while (available >= mPartitionSize) {
+        for (int ch = 0; ch < channelCount; ch++) {
+            ChannelBuffer * pCb = &channelBuffers[ch];
+            //keep the last block of input for the analysis
+            std::copy(pCb->input.begin() + mPartitionSize,
+                    pCb->input.end(),
+                    pCb->input.begin());
+
+            for (unsigned int k = 0; k < mPartitionSize; k++) {
+                const float value = pCb->cBInput.read();
+                pCb->input[newestStart + k] = value;
+                mPartitionInput(k, ch) = value;
+            }
+        }
+
+        //analysis of the last block, once per hop. It updates the filters, not the audio.
+        if (++mPartitionIndex >= mPartitionsPerHop) {
+            mPartitionIndex = 0;
+            for (int ch = 0; ch < channelCount; ch++) {
+                processedSamples += processFirstStages(channelBuffers[ch]);
+            }
+
+            processLinkedLimiters(channelBuffers);
+
+            for (int ch = 0; ch < channelCount; ch++) {
+                ChannelBuffer * pCb = &channelBuffers[ch];
+                processLastStages(*pCb);
+                mConvolver.setResponse(ch, pCb->mResponse.data());
+            }
+        }
+
+        //all channels at once
+        mConvolver.process(mPartitionInput, mPartitionOutput);
+
+        for (int ch = 0; ch < channelCount; ch++) {
+            for (unsigned int k = 0; k < mPartitionSize; k++) {
+                channelBuffers[ch].cBOutput.write(mPartitionOutput(k, ch));
+            }
+        }
+        available -= mPartitionSize;
+    }
+    return processedSamples;
+}
 size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     //##apply window
@@ -565,6 +652,7 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
             //apply post gain.
             newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
+            pMbcBandParams->newFactor = newFactor;
 
             //apply to this band
             for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
@@ -654,6 +742,12 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
         outputGainFactor *= factor;
     }
 
+    if (mPartitionSize > 0) {
+        //the partitioned convolution applies the gains, not this spectrum.
+        computeResponse(cb, outputGainFactor);
+        return mBlockSize;
+    }
+
     //apply to all if != 1.0
     if (!compareEquality(outputGainFactor, 1.0f)) {
         size_t cSize = cb.complexTemp.size();
@@ -674,4 +768,31 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
     return mBlockSize;
 }
 
+//Gains of all the stages per bin, as they are applied to the spectrum when processing blocks.
+void DPFrequency::computeResponse(ChannelBuffer &cb, float outputGainFactor) {
+    FloatVec &response = cb.mResponse;
+    const size_t maxBin = mHalfFFTSize - 1; //Nyquist has no EQ, as when processing blocks
+
+    for (size_t k = 0; k < maxBin; k++) {
+        response[k] = cb.mPreEqFactorVector[k] * outputGainFactor;
+    }
+    response[maxBin] = 1.0;
+
+    if (cb.mMbcInUse && cb.mMbcEnabled) {
+        for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
+            const ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
+            for (size_t k = pMbcBandParams->binStart;
+                    k <= pMbcBandParams->binStop && k < mHalfFFTSize; k++) {
+                response[k] *= pMbcBandParams->newFactor;
+            }
+        }
+    }
+
+    if (cb.mPostEqInUse && cb.mPostEqEnabled) {
+        for (size_t k = 0; k < maxBin; k++) {
+            response[k] *= cb.mPostEqFactorVector[k];
+        }
+    }
+}
+
 } //namespace dp_fx
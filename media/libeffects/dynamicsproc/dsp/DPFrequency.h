@@ -21,6 +21,7 @@
 #include <Eigen/Dense>
 #include <unsupported/Eigen/FFT>
 
+#include "PartitionedConvolver.h"
 #include "RDsp.h"
 #include "SHCircularBuffer.h"
 
@@ -66,6 +67,7 @@ public:
 
         //Historic values
         float previousEnvelope;
+        float newFactor;
     };
     struct LimiterParams {
         int32_t linkGroup;
@@ -98,6 +100,7 @@ public:
     LimiterParams mLimiterParams;
     FloatVec mPreEqFactorVector; // temp pre-computed vector to shape spectrum at preEQ stage
     FloatVec mPostEqFactorVector; // temp pre-computed vector to shape spectrum at postEQ stage
+    FloatVec mResponse; // gain of all stages per bin, for the partitioned mode
 
     void initBuffers(unsigned int blockSize, unsigned int overlapSize, unsigned int halfFftSize,
             unsigned int samplingRate, DPBase &dpBase);
@@ -125,6 +128,10 @@ public:
     virtual size_t processSamples(const float *in, float *out, size_t samples);
     virtual void reset();
     void configure(size_t blockSize, size_t overlapSize, size_t samplingRate);
+    // Low latency mode. The stages are computed as with configure(), on blocks of
+    // PARTITIONS_PER_BLOCK partitions, and applied to the audio by a partitioned convolution.
+    // The latency is one partition instead of one block.
+    void configurePartitioned(size_t partitionSize, size_t samplingRate);
     static size_t getMinBockSize();
     static size_t getMaxBockSize();
 
@@ -138,6 +145,9 @@ private:
     size_t processLastStages(ChannelBuffer &cb);
     void processLinkedLimiters(CBufferVector &channelBuffers);
 
+    size_t processPartitions(CBufferVector &channelBuffers);
+    void computeResponse(ChannelBuffer &cb, float outputGainFactor);
+
     size_t mBlockSize;
     size_t mHalfFFTSize;
     size_t mOverlapSize;
@@ -153,6 +163,14 @@ private:
     FloatVec mVWindow;  //window class.
     float mWindowRms;
     Eigen::FFT<float> mFftServer;
+
+    //partitioned mode
+    size_t mPartitionSize = 0; // 0 when processing whole blocks
+    size_t mPartitionsPerHop;
+    size_t mPartitionIndex;
+    PartitionedConvolver mConvolver;
+    Eigen::MatrixXf mPartitionInput;
+    Eigen::MatrixXf mPartitionOutput;
 };
 
 } //namespace dp_fx
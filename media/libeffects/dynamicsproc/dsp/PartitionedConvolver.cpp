@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PartitionedConvolver"
+//#define LOG_NDEBUG 0
+
+#include <log/log.h>
+#include "PartitionedConvolver.h"
+#include <algorithm>
+
+namespace dp_fx {
+
+static constexpr float MIN_GAIN = 1e-6f; //-120 dB
+
+void PartitionedConvolver::configure(size_t channelCount, size_t filterLength,
+        size_t partitionSize) {
+    ALOGV("configure channels %zu, filterLength %zu, partitionSize %zu",
+            channelCount, filterLength, partitionSize);
+    mChannelCount = channelCount;
+    mFilterLength = filterLength;
+    mPartitionSize = partitionSize;
+    mPartitionCount = filterLength / partitionSize;
+    mBinCount = partitionSize + 1;
+
+    mPartitionFft = RealFFT::getPlan(2 * partitionSize);
+    mFilterFft = RealFFT::getPlan(filterLength);
+
+    const size_t columns = mPartitionCount * mChannelCount;
+    mInput.resize(2 * partitionSize, channelCount);
+    mSpectra.resize(mBinCount, columns);
+    mFilter.resize(mBinCount, columns);
+    mNextFilter.resize(mBinCount, columns);
+    mAccumulator.resize(mBinCount, channelCount);
+    mTime.resize(2 * partitionSize, channelCount);
+    mFadeOutput.resize(partitionSize, channelCount);
+
+    mFade.resize(partitionSize);
+    for (size_t k = 0; k < partitionSize; k++) {
+        mFade[k] = (k + 0.5f) / partitionSize;
+    }
+
+    mGains.resize(filterLength / 2 + 1, channelCount);
+    mSpectrum.resize(filterLength / 2 + 1);
+    mImpulse.resize(filterLength);
+    mPartition.resize(2 * partitionSize);
+
+    reset();
+}
+
+void PartitionedConvolver::reset() {
+    mInput.setZero();
+    mSpectra.setZero();
+    mNewest = 0;
+
+    //unity filter: an impulse at the start of the first partition.
+    mFilter.setZero();
+    mFilter.leftCols(mChannelCount).setOnes();
+    mFilterChanged = false;
+    mGains.setOnes();
+}
+
+void PartitionedConvolver::setResponse(size_t channel, const float *gains) {
+    if (channel >= mChannelCount) {
+        ALOGE("Error: setResponse invalid channel %zu", channel);
+        return;
+    }
+    //the gains are often steady, e.g. when only EQ is in use.
+    Eigen::Map<const Eigen::VectorXf> eGains(gains, mGains.rows());
+    if (mGains.col(channel) == eGains) {
+        return;
+    }
+    mGains.col(channel) = eGains;
+
+    if (!mFilterChanged) {
+        //start from the current filters, as not every channel may change.
+        mNextFilter = mFilter;
+        mFilterChanged = true;
+    }
+    designFilter(channel, gains, mNextFilter);
+}
+
+// Minimum phase filter from the magnitude response, with the cepstrum: the log magnitude is
+// transformed to the time domain, folded onto positive times, and transformed back.
+void PartitionedConvolver::designFilter(size_t channel, const float *gains,
+        Eigen::MatrixXcf &filter) {
+    const size_t half = mFilterLength / 2;
+    for (size_t k = 0; k <= half; k++) {
+        mSpectrum[k] = std::log(std::max(gains[k], MIN_GAIN));
+    }
+    mFilterFft->inverse(mSpectrum.data(), mImpulse.data());
+
+    for (size_t n = 1; n < half; n++) {
+        mImpulse[n] *= 2;
+    }
+    std::fill(mImpulse.begin() + half + 1, mImpulse.end(), 0.0f);
+
+    mFilterFft->forward(mImpulse.data(), mSpectrum.data());
+    for (size_t k = 0; k <= half; k++) {
+        mSpectrum[k] = std::exp(mSpectrum[k]);
+    }
+    mFilterFft->inverse(mSpectrum.data(), mImpulse.data());
+
+    //split the impulse response into zero padded partitions.
+    std::fill(mPartition.begin() + mPartitionSize, mPartition.end(), 0.0f);
+    for (size_t p = 0; p < mPartitionCount; p++) {
+        std::copy(mImpulse.begin() + p * mPartitionSize,
+                mImpulse.begin() + (p + 1) * mPartitionSize,
+                mPartition.begin());
+        mPartitionFft->forward(mPartition.data(),
+                filter.col(p * mChannelCount + channel).data());
+    }
+}
+
+void PartitionedConvolver::process(const Eigen::MatrixXf &input, Eigen::MatrixXf &output) {
+    //overlap-save: transform the last 2 partitions, keep the last half of the result.
+    mInput.topRows(mPartitionSize) = mInput.bottomRows(mPartitionSize);
+    mInput.bottomRows(mPartitionSize) = input;
+
+    mNewest = (mNewest + 1) % mPartitionCount;
+    for (size_t c = 0; c < mChannelCount; c++) {
+        mPartitionFft->forward(mInput.col(c).data(),
+                mSpectra.col(mNewest * mChannelCount + c).data());
+    }
+
+    if (!mFilterChanged) {
+        accumulate(mFilter);
+        inverse(output);
+        return;
+    }
+
+    accumulate(mFilter);
+    inverse(mFadeOutput);
+    std::swap(mFilter, mNextFilter);
+    mFilterChanged = false;
+    accumulate(mFilter);
+    inverse(output);
+
+    for (size_t c = 0; c < mChannelCount; c++) {
+        for (size_t k = 0; k < mPartitionSize; k++) {
+            output(k, c) = mFadeOutput(k, c) + mFade[k] * (output(k, c) - mFadeOutput(k, c));
+        }
+    }
+}
+
+void PartitionedConvolver::accumulate(const Eigen::MatrixXcf &filter) {
+    mAccumulator.setZero();
+    for (size_t p = 0; p < mPartitionCount; p++) {
+        const size_t slot = (mNewest + mPartitionCount - p) % mPartitionCount;
+        mAccumulator.array() += mSpectra.middleCols(slot * mChannelCount, mChannelCount).array()
+                * filter.middleCols(p * mChannelCount, mChannelCount).array();
+    }
+}
+
+void PartitionedConvolver::inverse(Eigen::MatrixXf &output) {
+    for (size_t c = 0; c < mChannelCount; c++) {
+        mPartitionFft->inverse(mAccumulator.col(c).data(), mTime.col(c).data());
+    }
+    output = mTime.bottomRows(mPartitionSize);
+}
+
+} //namespace dp_fx
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PARTITIONEDCONVOLVER_H_
+#define PARTITIONEDCONVOLVER_H_
+
+#include <Eigen/Dense>
+#include <memory>
+
+#include "RDsp.h"
+#include "RealFFT.h"
+
+namespace dp_fx {
+
+// Multichannel uniformly partitioned convolution, with one filter per channel.
+//
+// A filter of filterLength taps is split in filterLength / partitionSize partitions, which are
+// applied in the frequency domain with FFTs of 2 * partitionSize. The latency is one partition,
+// however long the filter is.
+//
+// The filters are given as magnitude responses and converted to minimum phase, so they add no
+// delay of their own. When a filter changes, the output of the old and new filters is
+// crossfaded over the next partition.
+//
+// All the channels are processed together: the spectra of a partition are stored side by side,
+// so each multiply-accumulate covers every channel in one pass.
+class PartitionedConvolver {
+public:
+    // filterLength and partitionSize are powers of 2, with partitionSize <= filterLength.
+    // Allocates all the memory needed, and resets the filters to unity.
+    void configure(size_t channelCount, size_t filterLength, size_t partitionSize);
+    void reset();
+
+    size_t getPartitionSize() const { return mPartitionSize; }
+
+    // Sets the magnitude response of the filter for a channel, with filterLength / 2 + 1 gains
+    // from DC to Nyquist. Takes effect at the next call to process().
+    // Setting the same response again does nothing.
+    void setResponse(size_t channel, const float *gains);
+
+    // Processes one partition of each channel. Each column of input and output holds
+    // partitionSize frames of one channel.
+    void process(const Eigen::MatrixXf &input, Eigen::MatrixXf &output);
+
+private:
+    void designFilter(size_t channel, const float *gains, Eigen::MatrixXcf &filter);
+    void accumulate(const Eigen::MatrixXcf &filter);
+    void inverse(Eigen::MatrixXf &output);
+
+    size_t mChannelCount = 0;
+    size_t mFilterLength = 0;
+    size_t mPartitionSize = 0;
+    size_t mPartitionCount = 0;
+    size_t mBinCount = 0;            // of a partition spectrum
+
+    std::shared_ptr<const RealFFT> mPartitionFft;  // 2 * partitionSize
+    std::shared_ptr<const RealFFT> mFilterFft;     // filterLength
+
+    Eigen::MatrixXf mInput;          // last 2 partitions of each channel
+    // Spectra of the last mPartitionCount input partitions, newest at mNewest.
+    // Partition p of channel c is column p * mChannelCount + c.
+    Eigen::MatrixXcf mSpectra;
+    size_t mNewest = 0;
+
+    // Spectra of the filter partitions, with the same layout as mSpectra.
+    Eigen::MatrixXcf mFilter;
+    Eigen::MatrixXcf mNextFilter;
+    bool mFilterChanged = false;
+
+    Eigen::MatrixXcf mAccumulator;   // mBinCount x mChannelCount
+    Eigen::MatrixXf mTime;           // 2 * partitionSize x mChannelCount
+    Eigen::MatrixXf mFadeOutput;     // partitionSize x mChannelCount
+    FloatVec mFade;                  // crossfade ramp, partitionSize
+
+    // filter design
+    Eigen::MatrixXf mGains;          // last response set, filterLength / 2 + 1 x mChannelCount
+    ComplexVec mSpectrum;            // filterLength / 2 + 1
+    FloatVec mImpulse;               // filterLength
+    FloatVec mPartition;             // 2 * partitionSize
+};
+
+} //namespace dp_fx
+
+#endif  // PARTITIONEDCONVOLVER_H_
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RealFFT"
+//#define LOG_NDEBUG 0
+
+#include <log/log.h>
+#include "RealFFT.h"
+#include <map>
+#include <math.h>
+#include <mutex>
+#include <sys/param.h>
+
+namespace dp_fx {
+
+using Complex = std::complex<float>;
+
+// std::complex multiplication checks for infinities and NaN, which is not needed here.
+static inline Complex multiply(Complex a, Complex b) {
+    return Complex(a.real() * b.real() - a.imag() * b.imag(),
+            a.real() * b.imag() + a.imag() * b.real());
+}
+
+static inline Complex multiplyConj(Complex a, Complex b) {
+    return Complex(a.real() * b.real() + a.imag() * b.imag(),
+            a.imag() * b.real() - a.real() * b.imag());
+}
+
+std::shared_ptr<const RealFFT> RealFFT::getPlan(size_t size) {
+    static std::mutex sLock;
+    static std::map<size_t, std::weak_ptr<const RealFFT>> sPlans;
+
+    std::lock_guard lock(sLock);
+    std::shared_ptr<const RealFFT> plan = sPlans[size].lock();
+    if (plan == nullptr) {
+        ALOGV("getPlan new plan for size %zu", size);
+        plan = std::make_shared<const RealFFT>(size);
+        sPlans[size] = plan;
+    }
+    return plan;
+}
+
+RealFFT::RealFFT(size_t size) : mSize(size) {
+    LOG_ALWAYS_FATAL_IF(size < 4 || !powerof2(size), "RealFFT invalid size %zu", size);
+    const size_t half = mSize / 2;
+
+    const int bits = __builtin_ctzl(half);
+    mBitReverse.resize(half);
+    for (size_t i = 0; i < half; i++) {
+        size_t reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        mBitReverse[i] = reversed;
+    }
+
+    //stored stage after stage, so that each stage reads them in order.
+    mTwiddles.reserve(half);
+    for (size_t length = 2; length <= half; length <<= 1) {
+        for (size_t k = 0; k < length / 2; k++) {
+            const double phase = -2 * M_PI * k / length;
+            mTwiddles.emplace_back(cos(phase), sin(phase));
+        }
+    }
+
+    mRealTwiddles.resize(half / 2 + 1);
+    for (size_t k = 0; k < mRealTwiddles.size(); k++) {
+        const double phase = -2 * M_PI * k / mSize;
+        mRealTwiddles[k] = Complex(cos(phase), sin(phase));
+    }
+}
+
+// In place radix 2 complex transform of mSize / 2 points, not scaled.
+void RealFFT::transform(Complex *data, bool inverse) const {
+    const size_t n = mSize / 2;
+    for (size_t i = 0; i < n; i++) {
+        const size_t j = mBitReverse[i];
+        if (j > i) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    const Complex *twiddles = mTwiddles.data();
+    for (size_t length = 2; length <= n; length <<= 1) {
+        const size_t halfLength = length / 2;
+        for (size_t start = 0; start < n; start += length) {
+            Complex *a = data + start;
+            Complex *b = a + halfLength;
+            for (size_t k = 0; k < halfLength; k++) {
+                const Complex t = inverse ? multiplyConj(b[k], twiddles[k])
+                        : multiply(b[k], twiddles[k]);
+                b[k] = a[k] - t;
+                a[k] += t;
+            }
+        }
+        twiddles += halfLength;
+    }
+}
+
+// The even and odd samples are transformed together as one complex signal of half the size,
+// then separated using the symmetry of the spectrum of real data.
+void RealFFT::forward(const float *in, Complex *out) const {
+    const size_t half = mSize / 2;
+    for (size_t i = 0; i < half; i++) {
+        out[i] = Complex(in[2 * i], in[2 * i + 1]);
+    }
+    transform(out, false /* inverse */);
+
+    const Complex z0 = out[0];
+    out[0] = Complex(z0.real() + z0.imag(), 0);
+    out[half] = Complex(z0.real() - z0.imag(), 0);
+    for (size_t k = 1; k <= half / 2; k++) {
+        const Complex a = out[k];
+        const Complex b = std::conj(out[half - k]);
+        const Complex even = (a + b) * 0.5f;
+        const Complex diff = (a - b) * 0.5f;
+        const Complex odd(diff.imag(), -diff.real()); // diff / i
+        const Complex t = multiply(odd, mRealTwiddles[k]);
+        out[k] = even + t;
+        out[half - k] = std::conj(even - t);
+    }
+}
+
+void RealFFT::inverse(Complex *in, float *out) const {
+    const size_t half = mSize / 2;
+    const float x0 = in[0].real();
+    const float xHalf = in[half].real();
+    for (size_t k = 1; k <= half / 2; k++) {
+        const Complex x = in[k];
+        const Complex y = std::conj(in[half - k]);
+        const Complex even = (x + y) * 0.5f;
+        const Complex odd = multiplyConj((x - y) * 0.5f, mRealTwiddles[k]);
+        const Complex iOdd(-odd.imag(), odd.real());        // i * odd
+        const Complex iOddConj(odd.imag(), odd.real());     // i * conj(odd)
+        in[k] = even + iOdd;
+        in[half - k] = std::conj(even) + iOddConj;
+    }
+    in[0] = Complex((x0 + xHalf) * 0.5f, (x0 - xHalf) * 0.5f);
+    transform(in, true /* inverse */);
+
+    const float scale = 1.0f / half;
+    for (size_t i = 0; i < half; i++) {
+        out[2 * i] = in[i].real() * scale;
+        out[2 * i + 1] = in[i].imag() * scale;
+    }
+}
+
+} //namespace dp_fx
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REALFFT_H_
+#define REALFFT_H_
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace dp_fx {
+
+// FFT plan for real data of a power of 2 size.
+//
+// A plan is immutable once built and holds no scratch memory, so the same plan is safely used
+// by any number of instances and threads. getPlan() shares one plan per size across the process,
+// and is meant to be called when configuring, not from the audio thread.
+class RealFFT {
+public:
+    static std::shared_ptr<const RealFFT> getPlan(size_t size);
+
+    explicit RealFFT(size_t size);
+
+    size_t getSize() const { return mSize; }
+    size_t getBinCount() const { return mSize / 2 + 1; }
+
+    // Transforms getSize() samples to getBinCount() bins, from DC to Nyquist.
+    void forward(const float *in, std::complex<float> *out) const;
+
+    // Transforms getBinCount() bins to getSize() samples, scaled so that inverse(forward(x)) = x.
+    // The bins are used as work space, and are overwritten.
+    void inverse(std::complex<float> *in, float *out) const;
+
+private:
+    void transform(std::complex<float> *data, bool inverse) const;
+
+    const size_t mSize;
+    std::vector<size_t> mBitReverse;                // for the mSize / 2 complex transform
+    std::vector<std::complex<float>> mTwiddles;     // exp(-2 pi i k / length), for each stage
+    std::vector<std::complex<float>> mRealTwiddles; // exp(-2 pi i k / mSize)
+};
+
+} //namespace dp_fx
+
+#endif  // REALFFT_H_
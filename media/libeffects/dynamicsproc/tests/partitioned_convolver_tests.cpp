@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "PartitionedConvolver.h"
+
+using namespace dp_fx;
+
+namespace {
+
+constexpr size_t kChannelCount = 2;
+constexpr size_t kFilterLength = 1024;
+constexpr size_t kPartitionSize = 64;
+constexpr size_t kGainCount = kFilterLength / 2 + 1;
+
+class PartitionedConvolverTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mConvolver.configure(kChannelCount, kFilterLength, kPartitionSize);
+        mInput.setZero(kPartitionSize, kChannelCount);
+        mOutput.setZero(kPartitionSize, kChannelCount);
+    }
+
+    void setFlatResponse(size_t channel, float gain) {
+        const std::vector<float> gains(kGainCount, gain);
+        mConvolver.setResponse(channel, gains.data());
+    }
+
+    // Processes input[c](n) for partitionCount partitions, and returns the output of each channel.
+    template <typename F>
+    std::vector<std::vector<float>> process(size_t partitionCount, F input) {
+        std::vector<std::vector<float>> output(kChannelCount);
+        for (size_t p = 0; p < partitionCount; p++) {
+            for (size_t c = 0; c < kChannelCount; c++) {
+                for (size_t k = 0; k < kPartitionSize; k++) {
+                    mInput(k, c) = input(c, mPosition + k);
+                }
+            }
+            mConvolver.process(mInput, mOutput);
+            for (size_t c = 0; c < kChannelCount; c++) {
+                for (size_t k = 0; k < kPartitionSize; k++) {
+                    output[c].push_back(mOutput(k, c));
+                }
+            }
+            mPosition += kPartitionSize;
+        }
+        return output;
+    }
+
+    PartitionedConvolver mConvolver;
+    Eigen::MatrixXf mInput;
+    Eigen::MatrixXf mOutput;
+    size_t mPosition = 0;
+};
+
+// The output of a partition is returned by the process() call of that partition: an impulse is
+// delayed by the partition being collected only, and the minimum phase filters add no delay.
+TEST_F(PartitionedConvolverTest, impulseLatencyIsOnePartition) {
+    std::vector<float> gains(kGainCount);
+    for (size_t k = 0; k < kGainCount; k++) {
+        gains[k] = 1.0f / (1.0f + 16.0f * k / kGainCount);  // low pass
+    }
+    mConvolver.setResponse(0, gains.data());
+    setFlatResponse(1, 0.5f);
+
+    constexpr size_t kImpulse = 3 * kPartitionSize + 5;
+    const auto output = process(kFilterLength / kPartitionSize + 4,
+            [](size_t, size_t n) { return n == kImpulse ? 1.0f : 0.0f; });
+
+    for (size_t n = 0; n < kImpulse; n++) {
+        ASSERT_NEAR(0.0f, output[0][n], 1e-6f) << "frame " << n;
+        ASSERT_NEAR(0.0f, output[1][n], 1e-6f) << "frame " << n;
+    }
+    EXPECT_NEAR(0.5f, output[1][kImpulse], 1e-6f);
+    for (size_t n = kImpulse + 1; n < output[1].size(); n++) {
+        EXPECT_NEAR(0.0f, output[1][n], 1e-6f) << "frame " << n;
+    }
+
+    // The low pass response peaks in its first taps, and holds all its energy in the filter.
+    size_t peak = kImpulse;
+    for (size_t n = kImpulse; n < output[0].size(); n++) {
+        if (fabsf(output[0][n]) > fabsf(output[0][peak])) {
+            peak = n;
+        }
+    }
+    EXPECT_LT(peak - kImpulse, 4u);
+    double energy = 0;
+    double tail = 0;
+    for (size_t n = kImpulse; n < output[0].size(); n++) {
+        energy += output[0][n] * output[0][n];
+        if (n >= kImpulse + kFilterLength) {
+            tail += output[0][n] * output[0][n];
+        }
+    }
+    EXPECT_LT(tail, 1e-9 * energy);
+}
+
+// In steady state, a sine is scaled by the gain set at its frequency.
+TEST_F(PartitionedConvolverTest, steadyStateMagnitude) {
+    std::vector<float> gains[kChannelCount];
+    for (size_t c = 0; c < kChannelCount; c++) {
+        gains[c].resize(kGainCount);
+        for (size_t k = 0; k < kGainCount; k++) {
+            // smooth responses, a cut and a boost, different for each channel.
+            const double x = (double)k / (kGainCount - 1);
+            gains[c][k] = c == 0 ? 0.1 + 0.9 * pow(cos(M_PI * x / 2), 2)
+                    : 1.0 + sin(M_PI * x);
+        }
+        mConvolver.setResponse(c, gains[c].data());
+    }
+
+    for (const size_t bin : {8, 64, 128, 256, 384, 480}) {
+        SCOPED_TRACE(testing::Message() << "bin " << bin);
+        mConvolver.reset();
+        for (size_t c = 0; c < kChannelCount; c++) {
+            mConvolver.setResponse(c, gains[c].data());
+        }
+        mPosition = 0;
+        const double frequency = (double)bin / kFilterLength;
+        // the filter fills up in kFilterLength, then measure over a whole number of periods.
+        const size_t settlePartitions = kFilterLength / kPartitionSize;
+        const auto output = process(settlePartitions + kFilterLength / kPartitionSize,
+                [frequency](size_t, size_t n) { return sin(2 * M_PI * frequency * n); });
+        for (size_t c = 0; c < kChannelCount; c++) {
+            double sumSquares = 0;
+            for (size_t n = kFilterLength; n < output[c].size(); n++) {
+                sumSquares += output[c][n] * output[c][n];
+            }
+            const double amplitude = sqrt(2 * sumSquares / kFilterLength);
+            EXPECT_NEAR(20 * log10(gains[c][bin]), 20 * log10(amplitude), 0.1)
+                    << "channel " << c;
+        }
+    }
+}
+
+// When a filter changes, the output of the old and new filters is crossfaded over a partition.
+TEST_F(PartitionedConvolverTest, crossfadeOnFilterChange) {
+    constexpr float kOldGain = 0.5f;
+    constexpr float kNewGain = 2.0f;
+    const auto dc = [](size_t, size_t) { return 1.0f; };
+    setFlatResponse(0, kOldGain);
+    setFlatResponse(1, kOldGain);
+    auto output = process(2, dc);
+    for (size_t c = 0; c < kChannelCount; c++) {
+        EXPECT_NEAR(kOldGain, output[c].back(), 1e-5f);
+    }
+
+    // Setting the same response again does nothing.
+    setFlatResponse(0, kOldGain);
+    output = process(1, dc);
+    for (size_t k = 0; k < kPartitionSize; k++) {
+        EXPECT_NEAR(kOldGain, output[0][k], 1e-5f) << "frame " << k;
+    }
+
+    // Only channel 0 changes.
+    setFlatResponse(0, kNewGain);
+    output = process(2, dc);
+    for (size_t k = 0; k < kPartitionSize; k++) {
+        const float fade = (k + 0.5f) / kPartitionSize;
+        EXPECT_NEAR(kOldGain + fade * (kNewGain - kOldGain), output[0][k], 1e-5f)
+                << "frame " << k;
+        EXPECT_NEAR(kOldGain, output[1][k], 1e-5f) << "frame " << k;
+    }
+    for (size_t k = kPartitionSize; k < 2 * kPartitionSize; k++) {
+        EXPECT_NEAR(kNewGain, output[0][k], 1e-5f) << "frame " << k;
+        EXPECT_NEAR(kOldGain, output[1][k], 1e-5f) << "frame " << k;
+    }
+}
+
+TEST_F(PartitionedConvolverTest, resetToUnity) {
+    setFlatResponse(0, 0.25f);
+    setFlatResponse(1, 4.0f);
+    process(2, [](size_t, size_t) { return 1.0f; });
+
+    mConvolver.reset();
+    mPosition = 0;
+    const auto output = process(2, [](size_t c, size_t n) { return c + 1.0f + n; });
+    for (size_t c = 0; c < kChannelCount; c++) {
+        for (size_t n = 0; n < output[c].size(); n++) {
+            EXPECT_NEAR(c + 1.0f + n, output[c][n], 1e-4f) << "channel " << c << " frame " << n;
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <complex>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unsupported/Eigen/FFT>
+
+#include "RealFFT.h"
+
+using namespace dp_fx;
+
+namespace {
+
+std::vector<float> randomSignal(size_t size) {
+    std::minstd_rand gen(size);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    std::vector<float> signal(size);
+    for (auto &sample : signal) {
+        sample = dis(gen);
+    }
+    return signal;
+}
+
+class RealFFTTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(RealFFTTest, inverseOfForward) {
+    const size_t size = GetParam();
+    const RealFFT fft(size);
+    ASSERT_EQ(size / 2 + 1, fft.getBinCount());
+
+    const std::vector<float> signal = randomSignal(size);
+    std::vector<std::complex<float>> spectrum(fft.getBinCount());
+    std::vector<float> output(size);
+    fft.forward(signal.data(), spectrum.data());
+    fft.inverse(spectrum.data(), output.data());
+    for (size_t i = 0; i < size; i++) {
+        EXPECT_NEAR(signal[i], output[i], 1e-5f) << "sample " << i;
+    }
+}
+
+TEST_P(RealFFTTest, matchesEigenFFT) {
+    const size_t size = GetParam();
+    const RealFFT fft(size);
+
+    const std::vector<float> signal = randomSignal(size);
+    std::vector<std::complex<float>> spectrum(fft.getBinCount());
+    fft.forward(signal.data(), spectrum.data());
+
+    Eigen::FFT<float> eigenFft;
+    eigenFft.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+    std::vector<std::complex<float>> expected;
+    eigenFft.fwd(expected, signal);
+    ASSERT_EQ(expected.size(), spectrum.size());
+
+    // the rounding errors grow with the magnitude of the bins.
+    const float tolerance = 1e-5f * size;
+    for (size_t k = 0; k < spectrum.size(); k++) {
+        EXPECT_NEAR(expected[k].real(), spectrum[k].real(), tolerance) << "bin " << k;
+        EXPECT_NEAR(expected[k].imag(), spectrum[k].imag(), tolerance) << "bin " << k;
+    }
+
+    // and the inverse agrees too.
+    std::vector<float> output(size);
+    std::vector<float> expectedOutput;
+    eigenFft.inv(expectedOutput, expected);
+    fft.inverse(spectrum.data(), output.data());
+    for (size_t i = 0; i < size; i++) {
+        EXPECT_NEAR(expectedOutput[i], output[i], 1e-5f) << "sample " << i;
+    }
+}
+
+TEST_P(RealFFTTest, sineIsOneBin) {
+    const size_t size = GetParam();
+    const RealFFT fft(size);
+    const size_t bin = size / 4;
+
+    std::vector<float> signal(size);
+    for (size_t i = 0; i < size; i++) {
+        signal[i] = cos(2 * M_PI * bin * i / size);
+    }
+    std::vector<std::complex<float>> spectrum(fft.getBinCount());
+    fft.forward(signal.data(), spectrum.data());
+    for (size_t k = 0; k < spectrum.size(); k++) {
+        EXPECT_NEAR(k == bin ? size / 2.0f : 0.0f, std::abs(spectrum[k]), 1e-5f * size)
+                << "bin " << k;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, RealFFTTest,
+        ::testing::Values(4, 8, 16, 32, 64, 256, 1024, 4096));
+
+TEST(RealFFTPlanTest, sharedPerSize) {
+    const auto plan = RealFFT::getPlan(64);
+    EXPECT_EQ(64u, plan->getSize());
+    EXPECT_EQ(plan, RealFFT::getPlan(64));
+    EXPECT_NE(plan, RealFFT::getPlan(128));
+}
+
+} // namespace
@@ -16,13 +16,19 @@
 
 #include <array>
 #include <climits>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <random>
 #include <vector>
 #include <log/log.h>
+#include <audio_utils/BiquadFilter.h>
 #include <benchmark/benchmark.h>
 #include <hardware/audio_effect.h>
 #include <system/audio.h>
+#include <system/audio_effects/effect_equalizer.h>
+
+#include "BiquadCascade.h"
 
 extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
 constexpr effect_uuid_t kEffectUuids[] = {
@@ -235,4 +241,175 @@ static void LVMArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_LVM)->Apply(LVMArgs);
 
+constexpr size_t kEqualizerUuidIndex = 2;
+constexpr int kEqualizerChannelCounts[] = {FCC_2, 6, FCC_8};
+// Indices in the bundle preset list. Normal has 2 active bands, Rock has all 5 active.
+constexpr int kEqualizerPresetNormal = 0;
+constexpr int kEqualizerPresetRock = 9;
+
+/*******************************************************************
+ * Equalizer only, for the channel counts used by stereo and surround content.
+ * The first parameter indicates the number of channels.
+ * The second parameter indicates the preset.
+ *******************************************************************/
+static void BM_LVM_Equalizer(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const audio_channel_mask_t chMask = kChMasks[channelCount - 1];
+    const uint16_t preset = state.range(1);
+    const effect_uuid_t uuid = kEffectUuids[kEqualizerUuidIndex];
+
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&uuid, 1, 1, &effectHandle);
+        status != 0) {
+        ALOGE("create_effect returned an error = %d\n", status);
+        return;
+    }
+
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = chMask;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+                             ->command(effectHandle, EFFECT_CMD_SET_CONFIG, sizeof(effect_config_t),
+                                       &config, &replySize, &reply);
+        status != 0) {
+        ALOGE("command returned an error = %d\n", status);
+        return;
+    }
+
+    const uint32_t key = EQ_PARAM_CUR_PRESET;
+    uint8_t paramData[sizeof(effect_param_t) + sizeof(key) + sizeof(preset)];
+    auto effectParam = (effect_param_t*)paramData;
+    memcpy(&effectParam->data[0], &key, sizeof(key));
+    memcpy(&effectParam->data[sizeof(key)], &preset, sizeof(preset));
+    effectParam->psize = sizeof(key);
+    effectParam->vsize = sizeof(preset);
+    if (int status = (*effectHandle)
+                             ->command(effectHandle, EFFECT_CMD_SET_PARAM, sizeof(paramData),
+                                       effectParam, &replySize, &reply);
+        status != 0) {
+        ALOGE("set_param returned an error = %d\n", status);
+        return;
+    }
+
+    if (int status =
+                (*effectHandle)
+                        ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
+        status != 0) {
+        ALOGE("Command enable call returned error %d\n", reply);
+        return;
+    }
+
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
+        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
+        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+        ALOGE("release_effect returned an error = %d\n", status);
+        return;
+    }
+}
+
+static void EqualizerArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : kEqualizerChannelCounts) {
+        for (int preset : {kEqualizerPresetNormal, kEqualizerPresetRock}) {
+            b->Args({channelCount, preset});
+        }
+    }
+}
+
+BENCHMARK(BM_LVM_Equalizer)->Apply(EqualizerArgs);
+
+constexpr size_t kEqualizerBandCount = 5;
+
+/*******************************************************************
+ * The 5 band equalizer filters on their own.
+ * The first parameter indicates the number of channels.
+ * The second parameter indicates the implementation.
+ * 0: one BiquadFilter per band, as the equalizer used before the cascade
+ * 1: BiquadCascade
+ *******************************************************************/
+static void BM_BiquadCascade(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const bool useCascade = state.range(1) != 0;
+    const size_t sampleCount = kFrameCount * channelCount;
+
+    std::minstd_rand gen(channelCount);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(sampleCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    // Peaking bands in the form used by the equalizer
+    std::vector<BiquadCascade::Coefs> coefs;
+    std::vector<float> gains;
+    for (size_t i = 0; i < kEqualizerBandCount; i++) {
+        const float r = 0.9f + 0.02f * i;
+        const float a0 = (1.0f - r) / 2;
+        coefs.push_back({a0, 0.0f, -a0, -2 * r * cosf(0.05f * (1 << i)), r * r});
+        gains.push_back(0.5f);
+    }
+
+    std::vector<android::audio_utils::BiquadFilter<float>> filters;
+    BiquadCascade cascade(channelCount);
+    for (size_t i = 0; i < kEqualizerBandCount; i++) {
+        filters.emplace_back(channelCount, coefs[i]);
+        cascade.addStage(coefs[i], 1.0f, gains[i]);
+    }
+
+    std::vector<float> output(sampleCount);
+    std::vector<float> temp(sampleCount);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        if (useCascade) {
+            cascade.process(output.data(), input.data(), kFrameCount);
+        } else {
+            memcpy(output.data(), input.data(), sampleCount * sizeof(float));
+            for (size_t i = 0; i < kEqualizerBandCount; i++) {
+                filters[i].process(temp.data(), output.data(), kFrameCount);
+                for (size_t j = 0; j < sampleCount; j++) {
+                    output[j] += gains[i] * temp[j];
+                }
+            }
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void BiquadCascadeArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : kEqualizerChannelCounts) {
+        for (int useCascade : {0, 1}) {
+            b->Args({channelCount, useCascade});
+        }
+    }
+}
+
+BENCHMARK(BM_BiquadCascade)->Apply(BiquadCascadeArgs);
+
 BENCHMARK_MAIN();
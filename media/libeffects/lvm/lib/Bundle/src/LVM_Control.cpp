@@ -277,13 +277,14 @@ void LVM_SetTrebleBoost(LVM_Instance_t* pInstance, LVM_ControlParams_t* pParams)
             Offset = (LVM_INT16)(EffectLevel - 1 +
                                  TrebleBoostSteps * (pParams->SampleRate - TrebleBoostMinRate));
             /*
-             * Create biquad instance
+             * Set up the biquad instance
              */
-            std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs> coefs = {
+            const BiquadCascade::Coefs coefs = {
                     LVM_TrebleBoostCoefs[Offset].A0, LVM_TrebleBoostCoefs[Offset].A1, 0.0,
                     -(LVM_TrebleBoostCoefs[Offset].B1), 0.0};
-            pInstance->pTEBiquad.reset(
-                    new android::audio_utils::BiquadFilter<LVM_FLOAT>(pParams->NrChannels, coefs));
+            pInstance->TEBiquad.setChannelCount(pParams->NrChannels);
+            pInstance->TEBiquad.removeAllStages();
+            pInstance->TEBiquad.addStage(coefs);
         }
     } else {
         /*
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIQUAD_CASCADE_H_
+#define _BIQUAD_CASCADE_H_
+
+#include <array>
+#include <stddef.h>
+#include <vector>
+
+#include "LVM_Types.h"
+
+/**********************************************************************************
+   BIQUAD CASCADE
+***********************************************************************************/
+
+/*
+ * A cascade of biquad stages applied to interleaved multichannel data in one pass.
+ *
+ * Each stage computes
+ *
+ *     y = dry * x + wet * H(x)
+ *
+ * where H has the coefficients {b0, b1, b2, a1, a2} used by audio_utils::BiquadFilter, so
+ * a plain filter has dry = 0 and wet = 1, and a peaking EQ band has dry = 1 and wet = gain.
+ *
+ * The data is read and written once for all stages, and the work is spread over SIMD lanes
+ * in one of two layouts:
+ *
+ *  Layout::kChannels  Each lane is a channel. All stages run on a frame before moving to
+ *                     the next frame. Best for 4 or more channels.
+ *  Layout::kStages    Each lane is a (stage, channel) pair. The stages are pipelined so that
+ *                     stage k works on frame n - k while stage 0 works on frame n. This fills
+ *                     the lanes for mono and stereo, where there are not enough channels.
+ *                     The pipeline is drained at the end of each call so there is no latency.
+ *
+ * Both layouts give the same result and keep the same state, so they may be switched freely.
+ */
+class BiquadCascade {
+  public:
+    static constexpr size_t kMaxStages = 16;
+    static constexpr size_t kNumCoefs = 5;  // b0, b1, b2, a1, a2
+    using Coefs = std::array<LVM_FLOAT, kNumCoefs>;
+
+    enum class Layout {
+        kAuto,  // pick the faster layout for the channel and stage count
+        kChannels,
+        kStages,
+    };
+
+    explicit BiquadCascade(size_t channelCount = FCC_1);
+
+    /* Changing the channel count keeps the stages and clears the history. */
+    void setChannelCount(size_t channelCount);
+    size_t getChannelCount() const { return mChannelCount; }
+
+    /*
+     * Append a stage to the cascade.
+     * Returns false if the cascade already has kMaxStages stages.
+     */
+    bool addStage(const Coefs& coefs, LVM_FLOAT dry = 0.0f, LVM_FLOAT wet = 1.0f);
+    void removeAllStages();
+    size_t getStageCount() const { return mStageCount; }
+
+    /* Clear the filter history. */
+    void clear();
+
+    void setLayout(Layout layout) { mLayout = layout; }
+
+    /*
+     * Process interleaved frames. The input and output may be the same buffer.
+     */
+    void process(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount);
+
+  private:
+    struct Stage {
+        LVM_FLOAT b0, b1, b2, a1, a2;
+        LVM_FLOAT dry, wet;
+    };
+
+    Layout selectLayout() const;
+
+    template <size_t CHANNELS>
+    void processChannels(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount,
+                         size_t firstChannel);
+
+    template <size_t CHANNELS, size_t LANES>
+    void processStages(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount);
+
+    size_t mChannelCount;
+    size_t mStageCount = 0;
+    Layout mLayout = Layout::kAuto;
+    std::array<Stage, kMaxStages> mStages{};
+    // History for stage k and channel c is at [k * mChannelCount + c], for both layouts.
+    std::vector<LVM_FLOAT> mState1;
+    std::vector<LVM_FLOAT> mState2;
+};
+
+#endif /* _BIQUAD_CASCADE_H_ */
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+#include "BiquadCascade.h"
+
+/* The most lanes used by Layout::kStages */
+static constexpr size_t kMaxStageLanes = 16;
+
+BiquadCascade::BiquadCascade(size_t channelCount) {
+    setChannelCount(channelCount);
+}
+
+void BiquadCascade::setChannelCount(size_t channelCount) {
+    mChannelCount = channelCount;
+    mState1.assign(kMaxStages * channelCount, 0.0f);
+    mState2.assign(kMaxStages * channelCount, 0.0f);
+}
+
+bool BiquadCascade::addStage(const Coefs& coefs, LVM_FLOAT dry, LVM_FLOAT wet) {
+    if (mStageCount >= kMaxStages) {
+        return false;
+    }
+    mStages[mStageCount++] = {coefs[0], coefs[1], coefs[2], coefs[3], coefs[4], dry, wet};
+    return true;
+}
+
+void BiquadCascade::removeAllStages() {
+    mStageCount = 0;
+    clear();
+}
+
+void BiquadCascade::clear() {
+    std::fill(mState1.begin(), mState1.end(), 0.0f);
+    std::fill(mState2.begin(), mState2.end(), 0.0f);
+}
+
+BiquadCascade::Layout BiquadCascade::selectLayout() const {
+    const bool stagesFit = mChannelCount <= FCC_2 && mStageCount * mChannelCount <= kMaxStageLanes;
+    switch (mLayout) {
+        case Layout::kStages:
+            return stagesFit ? Layout::kStages : Layout::kChannels;
+        case Layout::kChannels:
+            return Layout::kChannels;
+        case Layout::kAuto:
+        default:
+            return (stagesFit && mStageCount > 1) ? Layout::kStages : Layout::kChannels;
+    }
+}
+
+void BiquadCascade::process(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount) {
+    if (mStageCount == 0) {
+        if (out != in) {
+            memcpy(out, in, frameCount * mChannelCount * sizeof(LVM_FLOAT));
+        }
+        return;
+    }
+
+    if (selectLayout() == Layout::kStages) {
+        const size_t lanes = mStageCount * mChannelCount;
+        if (mChannelCount == FCC_1) {
+            if (lanes <= 4) {
+                processStages<FCC_1, 4>(out, in, frameCount);
+            } else if (lanes <= 8) {
+                processStages<FCC_1, 8>(out, in, frameCount);
+            } else {
+                processStages<FCC_1, 16>(out, in, frameCount);
+            }
+        } else {
+            if (lanes <= 4) {
+                processStages<FCC_2, 4>(out, in, frameCount);
+            } else if (lanes <= 8) {
+                processStages<FCC_2, 8>(out, in, frameCount);
+            } else {
+                processStages<FCC_2, 16>(out, in, frameCount);
+            }
+        }
+        return;
+    }
+
+    /* Process blocks of adjacent channels, as wide as possible. */
+    size_t channel = 0;
+    for (; channel + 8 <= mChannelCount; channel += 8) {
+        processChannels<8>(out, in, frameCount, channel);
+    }
+    if (channel + 4 <= mChannelCount) {
+        processChannels<4>(out, in, frameCount, channel);
+        channel += 4;
+    }
+    if (channel + 2 <= mChannelCount) {
+        processChannels<2>(out, in, frameCount, channel);
+        channel += 2;
+    }
+    if (channel < mChannelCount) {
+        processChannels<1>(out, in, frameCount, channel);
+    }
+}
+
+/*
+ * Run all the stages on CHANNELS adjacent channels, one frame at a time.
+ * The loops over the channels can be vectorized and the history stays in registers.
+ */
+template <size_t CHANNELS>
+void BiquadCascade::processChannels(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount,
+                                    size_t firstChannel) {
+    const size_t channelCount = mChannelCount;
+    const size_t stageCount = mStageCount;
+    LVM_FLOAT s1[kMaxStages][CHANNELS];
+    LVM_FLOAT s2[kMaxStages][CHANNELS];
+    for (size_t k = 0; k < stageCount; k++) {
+        for (size_t c = 0; c < CHANNELS; c++) {
+            s1[k][c] = mState1[k * channelCount + firstChannel + c];
+            s2[k][c] = mState2[k * channelCount + firstChannel + c];
+        }
+    }
+
+    in += firstChannel;
+    out += firstChannel;
+    for (size_t frame = 0; frame < frameCount; frame++) {
+        LVM_FLOAT x[CHANNELS];
+        for (size_t c = 0; c < CHANNELS; c++) {
+            x[c] = in[c];
+        }
+        for (size_t k = 0; k < stageCount; k++) {
+            const Stage& stage = mStages[k];
+            for (size_t c = 0; c < CHANNELS; c++) {
+                const LVM_FLOAT y = stage.b0 * x[c] + s1[k][c];
+                s1[k][c] = stage.b1 * x[c] - stage.a1 * y + s2[k][c];
+                s2[k][c] = stage.b2 * x[c] - stage.a2 * y;
+                x[c] = stage.dry * x[c] + stage.wet * y;
+            }
+        }
+        for (size_t c = 0; c < CHANNELS; c++) {
+            out[c] = x[c];
+        }
+        in += channelCount;
+        out += channelCount;
+    }
+
+    for (size_t k = 0; k < stageCount; k++) {
+        for (size_t c = 0; c < CHANNELS; c++) {
+            mState1[k * channelCount + firstChannel + c] = s1[k][c];
+            mState2[k * channelCount + firstChannel + c] = s2[k][c];
+        }
+    }
+}
+
+/*
+ * Run all the stages at once, with lane (k * CHANNELS + c) for stage k and channel c.
+ * At step t, stage k processes frame t - k, using the output of stage k - 1 from step t - 1.
+ * Lanes beyond the last stage have zero coefficients, so their output is never used.
+ */
+template <size_t CHANNELS, size_t LANES>
+void BiquadCascade::processStages(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount) {
+    static_assert(LANES % CHANNELS == 0 && LANES <= kMaxStageLanes);
+    const size_t stageCount = mStageCount;
+    const size_t lanes = stageCount * CHANNELS;
+    const size_t lastLane = (stageCount - 1) * CHANNELS;
+
+    LVM_FLOAT b0[LANES] = {}, b1[LANES] = {}, b2[LANES] = {}, a1[LANES] = {}, a2[LANES] = {};
+    LVM_FLOAT dry[LANES] = {}, wet[LANES] = {};
+    LVM_FLOAT s1[LANES] = {}, s2[LANES] = {};
+    size_t firstStep[LANES];
+    for (size_t lane = 0; lane < LANES; lane++) {
+        if (lane < lanes) {
+            const Stage& stage = mStages[lane / CHANNELS];
+            b0[lane] = stage.b0;
+            b1[lane] = stage.b1;
+            b2[lane] = stage.b2;
+            a1[lane] = stage.a1;
+            a2[lane] = stage.a2;
+            dry[lane] = stage.dry;
+            wet[lane] = stage.wet;
+            s1[lane] = mState1[lane];
+            s2[lane] = mState2[lane];
+            firstStep[lane] = lane / CHANNELS;
+        } else {
+            firstStep[lane] = SIZE_MAX;  // never active
+        }
+    }
+
+    LVM_FLOAT y[LANES] = {};  // output of each lane from the previous step
+    const size_t stepCount = frameCount + stageCount - 1;
+    for (size_t step = 0; step < stepCount; step++) {
+        LVM_FLOAT x[LANES];
+        for (size_t c = 0; c < CHANNELS; c++) {
+            x[c] = (step < frameCount) ? in[step * CHANNELS + c] : 0.0f;
+        }
+        for (size_t lane = CHANNELS; lane < LANES; lane++) {
+            x[lane] = y[lane - CHANNELS];
+        }
+
+        if (step + 1 >= stageCount && step < frameCount) {
+            /* Every stage has a frame to process. */
+            for (size_t lane = 0; lane < LANES; lane++) {
+                const LVM_FLOAT filtered = b0[lane] * x[lane] + s1[lane];
+                s1[lane] = b1[lane] * x[lane] - a1[lane] * filtered + s2[lane];
+                s2[lane] = b2[lane] * x[lane] - a2[lane] * filtered;
+                y[lane] = dry[lane] * x[lane] + wet[lane] * filtered;
+            }
+        } else {
+            /* Filling or draining the pipeline, so only update the stages that are active. */
+            for (size_t lane = 0; lane < LANES; lane++) {
+                const bool active = step >= firstStep[lane] && step - firstStep[lane] < frameCount;
+                const LVM_FLOAT filtered = b0[lane] * x[lane] + s1[lane];
+                const LVM_FLOAT next1 = b1[lane] * x[lane] - a1[lane] * filtered + s2[lane];
+                const LVM_FLOAT next2 = b2[lane] * x[lane] - a2[lane] * filtered;
+                s1[lane] = active ? next1 : s1[lane];
+                s2[lane] = active ? next2 : s2[lane];
+                y[lane] = dry[lane] * x[lane] + wet[lane] * filtered;
+            }
+        }
+
+        if (step + 1 >= stageCount) {
+            LVM_FLOAT* frame = &out[(step + 1 - stageCount) * CHANNELS];
+            for (size_t c = 0; c < CHANNELS; c++) {
+                frame[c] = y[lastLane + c];
+            }
+        }
+    }
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        mState1[lane] = s1[lane];
+        mState2[lane] = s2[lane];
+    }
+}
@@ -178,9 +178,10 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
     LVM_UINT16 i;                    /* Filter band index */
     LVEQNB_BiquadType_en BiquadType; /* Filter biquad type */
 
-    pInstance->gain.resize(pInstance->Params.NBands);
+    pInstance->eqCascade.removeAllStages();
     /*
-     * Set the coefficients for each band by the init function
+     * Set the coefficients for each band by the init function. Bands with 0dB gain are
+     * skipped, so the cascade only contains the bands that need processing.
      */
     for (i = 0; i < pInstance->Params.NBands; i++) {
         /*
@@ -189,6 +190,9 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
         BiquadType = pInstance->pBiquadType[i];
         switch (BiquadType) {
             case LVEQNB_SinglePrecision_Float: {
+                if (pInstance->pBandDefinitions[i].Gain == 0) {
+                    break;
+                }
                 PK_FLOAT_Coefs_t Coefficients;
                 /*
                  * Calculate the single precision coefficients
@@ -196,16 +200,12 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
                 LVEQNB_SinglePrecCoefs((LVM_UINT16)pInstance->Params.SampleRate,
                                        &pInstance->pBandDefinitions[i], &Coefficients);
                 /*
-                 * Set the coefficients
+                 * Set the coefficients. The band adds its filtered output, scaled by the gain,
+                 * to its input.
                  */
-                pInstance->gain[i] = Coefficients.G;
-                std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs> coefs = {
-                        Coefficients.A0, 0.0, -(Coefficients.A0), -(Coefficients.B1),
-                        -(Coefficients.B2)};
-                pInstance->eqBiquad[i]
-                        .setCoefficients<
-                                std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs>>(
-                                coefs);
+                const BiquadCascade::Coefs coefs = {Coefficients.A0, 0.0, -(Coefficients.A0),
+                                                    -(Coefficients.B1), -(Coefficients.B2)};
+                pInstance->eqCascade.addStage(coefs, 1.0f /* dry */, Coefficients.G /* wet */);
                 break;
             }
             default:
@@ -226,9 +226,7 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
 /*                                                                                  */
 /************************************************************************************/
 void LVEQNB_ClearFilterHistory(LVEQNB_Instance_t* pInstance) {
-    for (size_t i = 0; i < pInstance->eqBiquad.size(); i++) {
-        pInstance->eqBiquad[i].clear();
-    }
+    pInstance->eqCascade.clear();
 }
 /****************************************************************************************/
 /*                                                                                      */
@@ -307,12 +305,10 @@ LVEQNB_ReturnStatus_en LVEQNB_Control(LVEQNB_Handle_t hInstance, LVEQNB_Params_t
              LVC_Mixer_GetTarget(&pInstance->BypassMixer.MixerStream[0]) == 0);
 
     /*
-     * Create biquad instance
+     * Resize the biquad cascade
      */
     if (pParams->NrChannels != pInstance->Params.NrChannels) {
-        pInstance->eqBiquad.clear();
-        pInstance->eqBiquad.resize(pParams->NBands,
-                           android::audio_utils::BiquadFilter<LVM_FLOAT>(pParams->NrChannels));
+        pInstance->eqCascade.setChannelCount(pParams->NrChannels);
     }
     if (bChange || modeChange) {
         LVEQNB_ClearFilterHistory(pInstance);
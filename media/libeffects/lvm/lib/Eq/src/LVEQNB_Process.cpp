@@ -86,40 +86,10 @@ LVEQNB_ReturnStatus_en LVEQNB_Process(
 
     if (pInstance->Params.OperatingMode == LVEQNB_ON) {
         /*
-         * Copy input data in to scratch buffer
+         * Run all the bands with a non-zero dB gain in a single pass, from the input
+         * in to the scratch buffer
          */
-        Copy_Float(pInData,  /* Source */
-                   pScratch, /* Destination */
-                   (LVM_INT16)NrSamples);
-
-        /*
-         * For each section execte the filter unless the gain is 0dB
-         */
-        if (pInstance->NBands != 0) {
-            for (LVM_UINT16 i = 0; i < pInstance->NBands; i++) {
-                /*
-                 * Check if band is non-zero dB gain
-                 */
-                if (pInstance->pBandDefinitions[i].Gain != 0) {
-                    /*
-                     * Select single or double precision as required
-                     */
-                    switch (pInstance->pBiquadType[i]) {
-                        case LVEQNB_SinglePrecision_Float: {
-                            LVM_FLOAT* pTemp = pScratch + NrSamples;
-                            pInstance->eqBiquad[i].process(pTemp, pScratch, NrFrames);
-                            const auto gain = pInstance->gain[i];
-                            for (unsigned j = 0; j < NrSamples; ++j) {
-                                pScratch[j] += pTemp[j] * gain;
-                            }
-                            break;
-                        }
-                        default:
-                            break;
-                    }
-                }
-            }
-        }
+        pInstance->eqCascade.process(pScratch, pInData, NrFrames);
 
         if (pInstance->bInOperatingModeTransition == LVM_TRUE) {
             LVC_MixSoft_2Mc_D16C31_SAT(&pInstance->BypassMixer, pScratch, pInData, pScratch,
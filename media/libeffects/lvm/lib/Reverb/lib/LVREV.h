@@ -72,6 +72,14 @@ typedef enum {
     LVREV_DELAYLINES_DUMMY = LVM_MAXENUM
 } LVREV_NumDelayLines_en;
 
+/* Reverb delay line processing */
+typedef enum {
+    LVREV_KERNEL_DELAYLINES = 0, /* Process each delay line in turn */
+    LVREV_KERNEL_FDN = 1,        /* Process four delay lines together as a feedback delay
+                                    network, falls back to LVREV_KERNEL_DELAYLINES for fewer */
+    LVREV_KERNEL_DUMMY = LVM_MAXENUM
+} LVREV_Kernel_en;
+
 /****************************************************************************************/
 /*                                                                                      */
 /*  Structures                                                                          */
@@ -95,6 +103,9 @@ typedef struct {
     LVM_UINT16 Damping;  /* Damping */
     LVM_UINT16 RoomSize; /* Simulated room size, 1 to 100 for minimum to maximum size */
 
+    LVREV_Kernel_en Kernel; /* Delay line processing, both give the same output within
+                               floating point rounding */
+
 } LVREV_ControlParams_st;
 
 /* Instance Parameter structure */
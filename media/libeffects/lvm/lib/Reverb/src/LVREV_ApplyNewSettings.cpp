@@ -233,6 +233,11 @@ LVREV_ReturnStatus_en LVREV_ApplyNewSettings(LVREV_Instance_st* pPrivate) {
                     Coeffs.A0, Coeffs.A1, 0.0, -(Coeffs.B1), 0.0};
             pPrivate->revLPFBiquad[i].reset(
                     new android::audio_utils::BiquadFilter<LVM_FLOAT>(FCC_1, coefs));
+            /* The same filter for the feedback delay network, which also restarts */
+            pPrivate->Fdn.LPF_B0[i] = Coeffs.A0;
+            pPrivate->Fdn.LPF_B1[i] = Coeffs.A1;
+            pPrivate->Fdn.LPF_A1[i] = -(Coeffs.B1);
+            pPrivate->Fdn.LPF_State[i] = 0;
         }
     }
 
@@ -481,6 +486,14 @@ LVREV_ReturnStatus_en LVREV_ApplyNewSettings(LVREV_Instance_st* pPrivate) {
         pPrivate->BypassMixer.Current2 = pPrivate->BypassMixer.Target2;
     }
 
+    /*
+     * Select the delay line processing
+     */
+    LVREV_FdnSetActive(pPrivate, ((pPrivate->NewParams.Kernel == LVREV_KERNEL_FDN) &&
+                                  (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_4))
+                                         ? LVM_TRUE
+                                         : LVM_FALSE);
+
     /*
      * Copy the new parameters
      */
@@ -63,6 +63,9 @@ LVREV_ReturnStatus_en LVREV_ClearAudioBuffers(LVREV_Handle_t hInstance) {
         memset(pLVREV_Private->pDelay_T[i], 0, LVREV_MAX_T_DELAY[i] *
                 sizeof(pLVREV_Private->pDelay_T[i][0]));
     }
+    for (size_t i = 0; i < LVREV_DELAYLINES_4; i++) {
+        pLVREV_Private->Fdn.LPF_State[i] = 0;
+    }
     return LVREV_SUCCESS;
 }
 
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/****************************************************************************************/
+/*                                                                                      */
+/* Includes                                                                             */
+/*                                                                                      */
+/****************************************************************************************/
+#include <algorithm>
+#include <string.h>
+
+#include "LVREV_Private.h"
+
+/****************************************************************************************/
+/*                                                                                      */
+/* Defines                                                                              */
+/*                                                                                      */
+/****************************************************************************************/
+
+/* One lane per delay line */
+static constexpr LVM_INT32 kLanes = LVREV_DELAYLINES_4;
+
+/* Interleaved workspace arrays, each of kLanes * MaxBlockSize samples */
+enum {
+    FDN_TAP_A,            /* Delayed samples at the A all-pass tap */
+    FDN_TAP_B,            /* Delayed samples at the B all-pass tap */
+    FDN_ALLPASS,          /* All-pass filter state, read and written back */
+    FDN_GAIN_TAP_A,       /* Mixer gains for each sample */
+    FDN_GAIN_TAP_B,
+    FDN_GAIN_FEEDBACK,
+    FDN_GAIN_FEEDFORWARD,
+    FDN_GAIN_DELAYLINE,
+    FDN_OUTPUT,           /* Delay line outputs, the stereo output is in the first two lanes */
+    FDN_DELAYLINE_INPUT,  /* Rotation matrix output, written to the delay lines */
+    FDN_NUM_ARRAYS
+};
+
+/* Planar workspace arrays, each of MaxBlockSize samples, after the interleaved arrays */
+enum {
+    FDN_ONES,  /* Unity input used to read the gains from the mixers */
+    FDN_GAINS_1,
+    FDN_GAINS_2,
+    FDN_NUM_PLANAR_ARRAYS
+};
+
+/****************************************************************************************/
+/*                                                                                      */
+/* Local functions                                                                      */
+/*                                                                                      */
+/****************************************************************************************/
+
+/*
+ * Same as LVM_Clamp for all values except NaN, but it compiles to vector min and max
+ * instructions instead of calls to fmin and fmax.
+ */
+static inline LVM_FLOAT Saturate(LVM_FLOAT val) {
+    return std::min(std::max(val, -1.0f), 1.0f);
+}
+
+/* Position in a circular delay line of the sample Age samples before the write index */
+static inline LVM_INT32 DelayPosition(LVM_INT32 WriteIndex, LVM_INT32 Age, LVM_INT32 Size) {
+    const LVM_INT32 Position = WriteIndex - Age;
+    return (Position < 0) ? Position + Size : Position;
+}
+
+/* Copy n samples from a circular delay line into one lane of an interleaved array */
+static void ReadDelayLine(const LVM_FLOAT* pDelay, LVM_INT32 Size, LVM_INT32 Position,
+                          LVM_FLOAT* pDst, LVM_INT32 n) {
+    const LVM_INT32 First = std::min(n, Size - Position);
+    for (LVM_INT32 i = 0; i < First; i++) {
+        pDst[i * kLanes] = pDelay[Position + i];
+    }
+    for (LVM_INT32 i = First; i < n; i++) {
+        pDst[i * kLanes] = pDelay[i - First];
+    }
+}
+
+/* Copy n samples from one lane of an interleaved array into a circular delay line */
+static void WriteDelayLine(const LVM_FLOAT* pSrc, LVM_FLOAT* pDelay, LVM_INT32 Size,
+                           LVM_INT32 Position, LVM_INT32 n) {
+    const LVM_INT32 First = std::min(n, Size - Position);
+    for (LVM_INT32 i = 0; i < First; i++) {
+        pDelay[Position + i] = pSrc[i * kLanes];
+    }
+    for (LVM_INT32 i = First; i < n; i++) {
+        pDelay[i - First] = pSrc[i * kLanes];
+    }
+}
+
+/* Copy a planar array into one lane of an interleaved array */
+static void ToLane(const LVM_FLOAT* pSrc, LVM_FLOAT* pDst, LVM_INT32 n) {
+    for (LVM_INT32 i = 0; i < n; i++) {
+        pDst[i * kLanes] = pSrc[i];
+    }
+}
+
+/*
+ * Get the gains the mixers apply to each sample, by mixing a unity input.
+ * This runs the mixers exactly as MixSoft_1St_D32C31_WRA and MixSoft_2St_D32C31_SAT would
+ * in ReverbBlock, so the smoothing and the callbacks are the same for both kernels.
+ */
+static void GetMixerGains(Mix_1St_Cll_FLOAT_t* pMixer, const LVM_FLOAT* pOnes, LVM_FLOAT* pGains,
+                          LVM_INT16 n) {
+    MixSoft_1St_D32C31_WRA(pMixer, pOnes, pGains, n);
+}
+
+static void GetTapMixerGains(Mix_2St_Cll_FLOAT_t* pMixer, const LVM_FLOAT* pOnes,
+                             LVM_FLOAT* pGains1, LVM_FLOAT* pGains2, LVM_INT16 n) {
+    if ((pMixer->Current1 != pMixer->Target1) || (pMixer->Current2 != pMixer->Target2)) {
+        MixSoft_1St_D32C31_WRA((Mix_1St_Cll_FLOAT_t*)pMixer, pOnes, pGains1, n);
+        memset(pGains2, 0, n * sizeof(*pGains2));
+        MixInSoft_D32C31_SAT((Mix_1St_Cll_FLOAT_t*)&pMixer->Alpha2, pOnes, pGains2, n);
+    } else {
+        std::fill(pGains1, pGains1 + n, pMixer->Current1);
+        std::fill(pGains2, pGains2 + n, pMixer->Current2);
+    }
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                LVREV_FdnInit                                               */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Allocates the feedback delay network workspace.                                     */
+/*                                                                                      */
+/* PARAMETERS:                                                                          */
+/*  pPrivate                Pointer to the instance                                     */
+/*  MaxBlockSize            Largest number of samples passed to LVREV_FdnProcess        */
+/*                                                                                      */
+/****************************************************************************************/
+void LVREV_FdnInit(LVREV_Instance_st* pPrivate, LVM_INT32 MaxBlockSize) {
+    LVREV_Fdn_st* pFdn = &pPrivate->Fdn;
+
+    pFdn->MaxBlockSize = MaxBlockSize;
+    pFdn->Workspace.assign((FDN_NUM_ARRAYS * kLanes + FDN_NUM_PLANAR_ARRAYS) * MaxBlockSize, 0);
+    LVM_FLOAT* pOnes = &pFdn->Workspace[(FDN_NUM_ARRAYS * kLanes + FDN_ONES) * MaxBlockSize];
+    std::fill(pOnes, pOnes + MaxBlockSize, 1.0f);
+    for (LVM_INT32 j = 0; j < kLanes; j++) {
+        pFdn->WriteIndex[j] = 0;
+        pFdn->LPF_State[j] = 0;
+    }
+    pPrivate->bFdnActive = LVM_FALSE;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                LVREV_FdnSetActive                                          */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Switches the delay line processing between ReverbBlock and LVREV_FdnProcess.       */
+/*                                                                                      */
+/* PARAMETERS:                                                                          */
+/*  pPrivate                Pointer to the instance                                     */
+/*  bActive                 LVM_TRUE to use LVREV_FdnProcess                            */
+/*                                                                                      */
+/* NOTES:                                                                               */
+/*  1. ReverbBlock keeps the oldest sample of each delay line first, which is a         */
+/*     circular buffer with its write index at 0. The delay lines are rotated back to   */
+/*     that layout when switching to ReverbBlock, so the reverb tail is kept.           */
+/*  2. The damping filters are not shared, so they restart from silence.                */
+/*                                                                                      */
+/****************************************************************************************/
+void LVREV_FdnSetActive(LVREV_Instance_st* pPrivate, LVM_INT16 bActive) {
+    LVREV_Fdn_st* pFdn = &pPrivate->Fdn;
+
+    if (bActive == pPrivate->bFdnActive) {
+        return;
+    }
+
+    for (LVM_INT32 j = 0; j < kLanes; j++) {
+        if (bActive == LVM_FALSE) {
+            std::rotate(pPrivate->pDelay_T[j], pPrivate->pDelay_T[j] + pFdn->WriteIndex[j],
+                        pPrivate->pDelay_T[j] + pPrivate->T[j]);
+            if (pPrivate->revLPFBiquad[j] != nullptr) {
+                pPrivate->revLPFBiquad[j]->clear();
+            }
+        }
+        pFdn->WriteIndex[j] = 0;
+        pFdn->LPF_State[j] = 0;
+    }
+    pPrivate->bFdnActive = bActive;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                LVREV_FdnProcess                                            */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Processes the four delay lines together and creates the stereo output. This gives   */
+/*  the same result as the delay line part of ReverbBlock, except for rounding.         */
+/*                                                                                      */
+/*  The delay lines are circular buffers, so the taps are read as blocks instead of     */
+/*  moving the whole delay line on every call. The all-pass filters, feedback gains,    */
+/*  damping filters and rotation matrix then run in a single pass over the block, with  */
+/*  one SIMD lane per delay line.                                                       */
+/*                                                                                      */
+/* PARAMETERS:                                                                          */
+/*  pInput                  Pointer to the filtered mono input                          */
+/*  pOutput                 Pointer to the stereo output, may be the same as pInput     */
+/*  pPrivate                Pointer to the instance                                     */
+/*  NumSamples              Number of samples, at most the smallest all-pass delay      */
+/*                                                                                      */
+/****************************************************************************************/
+void LVREV_FdnProcess(const LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPrivate,
+                      LVM_UINT16 NumSamples) {
+    LVREV_Fdn_st* pFdn = &pPrivate->Fdn;
+    const LVM_INT32 n = NumSamples;
+    const LVM_INT32 Stride = kLanes * pFdn->MaxBlockSize;
+    LVM_FLOAT* pArrays = pFdn->Workspace.data();
+    LVM_FLOAT* pTapA = &pArrays[FDN_TAP_A * Stride];
+    LVM_FLOAT* pTapB = &pArrays[FDN_TAP_B * Stride];
+    LVM_FLOAT* pAllPass = &pArrays[FDN_ALLPASS * Stride];
+    LVM_FLOAT* pGainTapA = &pArrays[FDN_GAIN_TAP_A * Stride];
+    LVM_FLOAT* pGainTapB = &pArrays[FDN_GAIN_TAP_B * Stride];
+    LVM_FLOAT* pGainFeedback = &pArrays[FDN_GAIN_FEEDBACK * Stride];
+    LVM_FLOAT* pGainFeedforward = &pArrays[FDN_GAIN_FEEDFORWARD * Stride];
+    LVM_FLOAT* pGainDelayLine = &pArrays[FDN_GAIN_DELAYLINE * Stride];
+    LVM_FLOAT* pOut = &pArrays[FDN_OUTPUT * Stride];
+    LVM_FLOAT* pDelayLineInput = &pArrays[FDN_DELAYLINE_INPUT * Stride];
+    LVM_FLOAT* pPlanar = &pArrays[FDN_NUM_ARRAYS * Stride];
+    const LVM_FLOAT* pOnes = &pPlanar[FDN_ONES * pFdn->MaxBlockSize];
+    LVM_FLOAT* pGains1 = &pPlanar[FDN_GAINS_1 * pFdn->MaxBlockSize];
+    LVM_FLOAT* pGains2 = &pPlanar[FDN_GAINS_2 * pFdn->MaxBlockSize];
+
+    /*
+     * Read the delayed blocks and the mixer gains for each delay line
+     */
+    for (LVM_INT32 j = 0; j < kLanes; j++) {
+        const LVM_FLOAT* pDelay = pPrivate->pDelay_T[j];
+        const LVM_INT32 Size = pPrivate->T[j];
+        const LVM_INT32 WriteIndex = pFdn->WriteIndex[j];
+
+        /* ReverbBlock reads the taps at a fixed offset from the end of its delay lines */
+        ReadDelayLine(pDelay, Size,
+                      DelayPosition(WriteIndex, Size - (LVM_INT32)(pPrivate->pOffsetA[j] - pDelay),
+                                    Size),
+                      &pTapA[j], n);
+        ReadDelayLine(pDelay, Size,
+                      DelayPosition(WriteIndex, Size - (LVM_INT32)(pPrivate->pOffsetB[j] - pDelay),
+                                    Size),
+                      &pTapB[j], n);
+        ReadDelayLine(pDelay, Size,
+                      DelayPosition(WriteIndex, Size - pPrivate->Delay_AP[j], Size), &pAllPass[j],
+                      n);
+
+        GetTapMixerGains(&pPrivate->Mixer_APTaps[j], pOnes, pGains1, pGains2, (LVM_INT16)n);
+        ToLane(pGains1, &pGainTapA[j], n);
+        ToLane(pGains2, &pGainTapB[j], n);
+        GetMixerGains(&pPrivate->Mixer_SGFeedback[j], pOnes, pGains1, (LVM_INT16)n);
+        ToLane(pGains1, &pGainFeedback[j], n);
+        GetMixerGains(&pPrivate->Mixer_SGFeedforward[j], pOnes, pGains1, (LVM_INT16)n);
+        ToLane(pGains1, &pGainFeedforward[j], n);
+        GetMixerGains(&pPrivate->FeedbackMixer[j], pOnes, pGains1, (LVM_INT16)n);
+        ToLane(pGains1, &pGainDelayLine[j], n);
+    }
+
+    /*
+     * Process all the delay lines, one sample at a time
+     */
+    LVM_FLOAT B0[kLanes], B1[kLanes], A1[kLanes], State[kLanes];
+    for (LVM_INT32 j = 0; j < kLanes; j++) {
+        B0[j] = pFdn->LPF_B0[j];
+        B1[j] = pFdn->LPF_B1[j];
+        A1[j] = pFdn->LPF_A1[j];
+        State[j] = pFdn->LPF_State[j];
+    }
+    for (LVM_INT32 i = 0; i < n; i++) {
+        const LVM_INT32 Base = i * kLanes;
+        LVM_FLOAT Out[kLanes];
+
+        for (LVM_INT32 j = 0; j < kLanes; j++) {
+            /* All-pass filter with pop and click suppression */
+            const LVM_FLOAT Tap = Saturate(pTapA[Base + j] * pGainTapA[Base + j] +
+                                            pTapB[Base + j] * pGainTapB[Base + j]);
+            const LVM_FLOAT AllPass =
+                    Saturate(pAllPass[Base + j] - Tap * pGainFeedback[Base + j]);
+            pAllPass[Base + j] = AllPass;
+            const LVM_FLOAT Delayed =
+                    Saturate(AllPass * pGainFeedforward[Base + j] + Tap) * pGainDelayLine[Base + j];
+
+            /* Damping low pass filter */
+            const LVM_FLOAT Damped = B0[j] * Delayed + State[j];
+            State[j] = B1[j] * Delayed - A1[j] * Damped;
+            Out[j] = Damped;
+        }
+
+        /* Rotation matrix */
+        const LVM_FLOAT In = pInput[i];
+        pDelayLineInput[Base + 0] = Saturate(Out[2] + Saturate(In - Out[1]));
+        pDelayLineInput[Base + 1] = Saturate(Out[3] + Saturate(In - Out[0]));
+        pDelayLineInput[Base + 2] = Saturate(Saturate(In - Out[0]) - Out[3]);
+        pDelayLineInput[Base + 3] = Saturate(Saturate(In - Out[1]) - Out[2]);
+
+        /* Stereo output */
+        pOut[Base + 0] = Saturate(Out[3] + Out[0]);
+        pOut[Base + 1] = Saturate(Out[2] + Out[1]);
+    }
+    for (LVM_INT32 j = 0; j < kLanes; j++) {
+        pFdn->LPF_State[j] = State[j];
+    }
+
+    /*
+     * Write back the all-pass state and the new input, and advance the delay lines
+     */
+    for (LVM_INT32 j = 0; j < kLanes; j++) {
+        LVM_FLOAT* pDelay = pPrivate->pDelay_T[j];
+        const LVM_INT32 Size = pPrivate->T[j];
+        const LVM_INT32 WriteIndex = pFdn->WriteIndex[j];
+
+        WriteDelayLine(&pAllPass[j], pDelay, Size,
+                       DelayPosition(WriteIndex, Size - pPrivate->Delay_AP[j], Size), n);
+        WriteDelayLine(&pDelayLineInput[j], pDelay, Size, WriteIndex, n);
+        pFdn->WriteIndex[j] = (WriteIndex + n) % Size;
+    }
+
+    /*
+     * The input has been consumed, so the output may overwrite it
+     */
+    for (LVM_INT32 i = 0; i < n; i++) {
+        pOutput[2 * i] = pOut[i * kLanes];
+        pOutput[2 * i + 1] = pOut[i * kLanes + 1];
+    }
+}
+
+/* End of file */
@@ -109,6 +109,8 @@ LVREV_ReturnStatus_en LVREV_GetInstanceHandle(LVREV_Handle_t* phInstance,
     pLVREV_Private->pScratch = (LVM_FLOAT*)calloc(MaxBlockSize, sizeof(LVM_FLOAT));
     /* Mono->stereo input save for end mix */
     pLVREV_Private->pInputSave = (LVM_FLOAT*)calloc(FCC_2 * MaxBlockSize, sizeof(LVM_FLOAT));
+    /* Feedback delay network workspace */
+    LVREV_FdnInit(pLVREV_Private, MaxBlockSize);
 
     /*
      * Save the instance parameters in the instance structure
@@ -24,6 +24,7 @@
 /*                                                                                      */
 /****************************************************************************************/
 
+#include <vector>
 #include <audio_utils/BiquadFilter.h>
 #include "LVREV.h"
 #include "LVREV_Tables.h"
@@ -103,6 +104,18 @@
 /*                                                                                      */
 /****************************************************************************************/
 
+/* Feedback delay network state, used when the LVREV_KERNEL_FDN kernel is active */
+typedef struct {
+    LVM_INT32 MaxBlockSize;                      /* Largest block the workspace can hold */
+    LVM_INT32 WriteIndex[LVREV_DELAYLINES_4];    /* Where the next block is written in each \
+                                                    delay line, used as a circular buffer */
+    LVM_FLOAT LPF_B0[LVREV_DELAYLINES_4];        /* Damping low pass filter coefficients */
+    LVM_FLOAT LPF_B1[LVREV_DELAYLINES_4];
+    LVM_FLOAT LPF_A1[LVREV_DELAYLINES_4];
+    LVM_FLOAT LPF_State[LVREV_DELAYLINES_4];     /* Damping low pass filter history */
+    std::vector<LVM_FLOAT> Workspace;            /* Block data, one lane per delay line */
+} LVREV_Fdn_st;
+
 typedef struct {
     /* General */
     LVREV_InstanceParams_st InstanceParams; /* Initialisation time instance parameters */
@@ -155,6 +168,10 @@ typedef struct {
                                         average signal power */
     Mix_1St_Cll_FLOAT_t GainMixer;   /* Gain smoothing */
 
+    /* Feedback delay network */
+    LVM_INT16 bFdnActive; /* Delay lines are processed by LVREV_FdnProcess */
+    LVREV_Fdn_st Fdn;
+
 } LVREV_Instance_st;
 
 /****************************************************************************************/
@@ -168,6 +185,10 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
                  LVM_UINT16 NumSamples);
 LVM_INT32 BypassMixer_Callback(void* pCallbackData, void* pGeneralPurpose,
                                LVM_INT16 GeneralPurpose);
+void LVREV_FdnInit(LVREV_Instance_st* pPrivate, LVM_INT32 MaxBlockSize);
+void LVREV_FdnSetActive(LVREV_Instance_st* pPrivate, LVM_INT16 bActive);
+void LVREV_FdnProcess(const LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPrivate,
+                      LVM_UINT16 NumSamples);
 
 #endif /** __LVREV_PRIVATE_H__ **/
 
@@ -23,6 +23,9 @@
 #include "LVREV_Private.h"
 #include "VectorArithmetic.h"
 
+static void ProcessDelayLines(LVM_FLOAT* pTemp, LVREV_Instance_st* pPrivate,
+                              LVM_UINT16 NumSamples);
+
 /****************************************************************************************/
 /*                                                                                      */
 /* FUNCTION:                LVREV_Process                                               */
@@ -157,13 +160,9 @@ LVREV_ReturnStatus_en LVREV_Process(LVREV_Handle_t hInstance, const LVM_FLOAT* p
 /****************************************************************************************/
 void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPrivate,
                  LVM_UINT16 NumSamples) {
-    LVM_INT16 j, size;
-    LVM_FLOAT* pDelayLine;
-    LVM_FLOAT* pDelayLineInput = pPrivate->pScratch;
-    LVM_FLOAT* pScratch = pPrivate->pScratch;
+    LVM_INT16 size;
     LVM_FLOAT* pIn;
     LVM_FLOAT* pTemp = pPrivate->pInputSave;
-    LVM_INT32 NumberOfDelayLines;
 
     /******************************************************************************
      * All calculations will go into the buffer pointed to by pTemp, this will    *
@@ -180,14 +179,6 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
      * and the final output is converted to STEREO after the mixer                *
      ******************************************************************************/
 
-    if (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_4) {
-        NumberOfDelayLines = 4;
-    } else if (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_2) {
-        NumberOfDelayLines = 2;
-    } else {
-        NumberOfDelayLines = 1;
-    }
-
     if (pPrivate->CurrentParams.SourceFormat == LVM_MONO) {
         pIn = pInput;
     } else {
@@ -211,6 +202,61 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
      */
     pPrivate->pRevLPFBiquad->process(pTemp, pTemp, NumSamples);
 
+    /*
+     *  Process all delay lines and create the stereo output
+     */
+    if (pPrivate->bFdnActive == LVM_TRUE) {
+        LVREV_FdnProcess(pTemp, pTemp, pPrivate, NumSamples);
+    } else {
+        ProcessDelayLines(pTemp, pPrivate, NumSamples);
+    }
+
+    /*
+     *  Dry/wet mixer
+     */
+
+    size = (LVM_INT16)(NumSamples << 1);
+    MixSoft_2St_D32C31_SAT(&pPrivate->BypassMixer, pTemp, pTemp, pOutput, size);
+
+    /* Apply Gain*/
+
+    Shift_Sat_Float(LVREV_OUTPUTGAIN_SHIFT, pOutput, pOutput, size);
+
+    MixSoft_1St_D32C31_WRA(&pPrivate->GainMixer, pOutput, pOutput, size);
+
+    return;
+}
+
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                ProcessDelayLines                                           */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Processes each delay line in turn and creates the stereo output.                    */
+/*                                                                                      */
+/* PARAMETERS:                                                                          */
+/*  pTemp                   Pointer to the filtered mono input, replaced by the stereo  */
+/*                          output                                                      */
+/*  pPrivate                Pointer to the instance                                     */
+/*  NumSamples              Number of samples in the input buffer                       */
+/*                                                                                      */
+/****************************************************************************************/
+static void ProcessDelayLines(LVM_FLOAT* pTemp, LVREV_Instance_st* pPrivate,
+                              LVM_UINT16 NumSamples) {
+    LVM_INT16 j;
+    LVM_FLOAT* pDelayLine;
+    LVM_FLOAT* pDelayLineInput = pPrivate->pScratch;
+    LVM_FLOAT* pScratch = pPrivate->pScratch;
+    LVM_INT32 NumberOfDelayLines;
+
+    if (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_4) {
+        NumberOfDelayLines = 4;
+    } else if (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_2) {
+        NumberOfDelayLines = 2;
+    } else {
+        NumberOfDelayLines = 1;
+    }
+
     /*
      *  Process all delay lines
      */
@@ -378,20 +424,5 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
         default:
             break;
     }
-
-    /*
-     *  Dry/wet mixer
-     */
-
-    size = (LVM_INT16)(NumSamples << 1);
-    MixSoft_2St_D32C31_SAT(&pPrivate->BypassMixer, pTemp, pTemp, pOutput, size);
-
-    /* Apply Gain*/
-
-    Shift_Sat_Float(LVREV_OUTPUTGAIN_SHIFT, pOutput, pOutput, size);
-
-    MixSoft_1St_D32C31_WRA(&pPrivate->GainMixer, pOutput, pOutput, size);
-
-    return;
 }
 /* End of file */
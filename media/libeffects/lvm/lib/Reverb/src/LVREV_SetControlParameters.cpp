@@ -99,6 +99,11 @@ LVREV_ReturnStatus_en LVREV_SetControlParameters(LVREV_Handle_t hInstance,
         return LVREV_OUTOFRANGE;
     }
 
+    if ((pNewParams->Kernel != LVREV_KERNEL_DELAYLINES) &&
+        (pNewParams->Kernel != LVREV_KERNEL_FDN)) {
+        return LVREV_OUTOFRANGE;
+    }
+
     /*
      * Copy the new parameters and set the flag to indicate they are available
      */
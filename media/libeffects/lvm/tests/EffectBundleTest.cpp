@@ -14,9 +14,13 @@
  * limitations under the License.
  */
 
+#include <cmath>
+
+#include <audio_utils/BiquadFilter.h>
 #include <system/audio_effects/effect_bassboost.h>
 #include <system/audio_effects/effect_equalizer.h>
 #include <system/audio_effects/effect_virtualizer.h>
+#include "BiquadCascade.h"
 #include "EffectTestHelper.h"
 
 using namespace android;
@@ -334,6 +338,89 @@ INSTANTIATE_TEST_SUITE_P(
                            ::testing::Range(0, (int)EffectTestHelper::kNumFrameCounts),
                            ::testing::Range(0, (int)kNumEffectUuids)));
 
+constexpr size_t kBiquadCascadeChannelCounts[] = {FCC_1, FCC_2, 3, 6, FCC_8};
+constexpr size_t kBiquadCascadeStageCounts[] = {1, 2, 5, 8};
+constexpr size_t kBiquadCascadeFrameCounts[] = {1, 37, 256};
+
+using BiquadCascadeTestParam = std::tuple<int, int>;
+class BiquadCascadeTest : public ::testing::TestWithParam<BiquadCascadeTestParam> {
+  public:
+    BiquadCascadeTest()
+        : mChannelCount(kBiquadCascadeChannelCounts[std::get<0>(GetParam())]),
+          mStageCount(kBiquadCascadeStageCounts[std::get<1>(GetParam())]) {
+        // Stable peaking bands in the form used by the equalizer
+        std::minstd_rand gen(mChannelCount * 100 + mStageCount);
+        std::uniform_real_distribution<> radius(0.9, 0.99);
+        std::uniform_real_distribution<> angle(0.01, 3.0);
+        std::uniform_real_distribution<> gain(-0.7, 2.0);
+        for (size_t i = 0; i < mStageCount; ++i) {
+            const float r = radius(gen);
+            const float a0 = (1.0f - r) / 2;
+            mCoefs.push_back({a0, 0.0f, -a0, -2 * r * cosf(angle(gen)), r * r});
+            mGains.push_back(gain(gen));
+        }
+    }
+
+    const size_t mChannelCount;
+    const size_t mStageCount;
+    std::vector<BiquadCascade::Coefs> mCoefs;
+    std::vector<float> mGains;
+};
+
+// Tests that both layouts of the cascade give the same output as a chain of BiquadFilters
+TEST_P(BiquadCascadeTest, MatchesBiquadFilterChain) {
+    SCOPED_TRACE(testing::Message()
+                 << "channelCount: " << mChannelCount << " stageCount: " << mStageCount);
+
+    BiquadCascade channelsCascade(mChannelCount);
+    BiquadCascade stagesCascade(mChannelCount);
+    channelsCascade.setLayout(BiquadCascade::Layout::kChannels);
+    stagesCascade.setLayout(BiquadCascade::Layout::kStages);
+    std::vector<audio_utils::BiquadFilter<float>> filters;
+    for (size_t i = 0; i < mStageCount; ++i) {
+        ASSERT_TRUE(channelsCascade.addStage(mCoefs[i], 1.0f, mGains[i]));
+        ASSERT_TRUE(stagesCascade.addStage(mCoefs[i], 1.0f, mGains[i]));
+        filters.emplace_back(mChannelCount, mCoefs[i]);
+    }
+
+    std::minstd_rand gen(mChannelCount);
+    std::uniform_real_distribution<> dis(kMinAmplitude, kMaxAmplitude);
+    // Use several block sizes to check that the history is carried between calls
+    for (size_t frameCount : kBiquadCascadeFrameCounts) {
+        const size_t sampleCount = frameCount * mChannelCount;
+        std::vector<float> input(sampleCount);
+        for (auto& in : input) {
+            in = dis(gen);
+        }
+
+        std::vector<float> refOutput(input);
+        std::vector<float> temp(sampleCount);
+        for (size_t i = 0; i < mStageCount; ++i) {
+            filters[i].process(temp.data(), refOutput.data(), frameCount);
+            for (size_t j = 0; j < sampleCount; ++j) {
+                refOutput[j] += mGains[i] * temp[j];
+            }
+        }
+
+        std::vector<float> channelsOutput(sampleCount);
+        channelsCascade.process(channelsOutput.data(), input.data(), frameCount);
+        // Process the stages layout in place
+        std::vector<float> stagesOutput(input);
+        stagesCascade.process(stagesOutput.data(), stagesOutput.data(), frameCount);
+
+        ASSERT_TRUE(areNearlySame(channelsOutput.data(), stagesOutput.data(), sampleCount))
+                << "Layouts do not match";
+        for (size_t j = 0; j < sampleCount; ++j) {
+            ASSERT_NEAR(refOutput[j], channelsOutput[j], 1e-4f) << "at sample " << j;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        EffectBundleTestAll, BiquadCascadeTest,
+        ::testing::Combine(::testing::Range(0, (int)std::size(kBiquadCascadeChannelCounts)),
+                           ::testing::Range(0, (int)std::size(kBiquadCascadeStageCounts))));
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     int status = RUN_ALL_TESTS();
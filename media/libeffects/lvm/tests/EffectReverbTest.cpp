@@ -15,6 +15,7 @@
  */
 
 #include <audio_effects/effect_presetreverb.h>
+#include <LVREV.h>
 #include <VectorArithmetic.h>
 
 #include "EffectTestHelper.h"
@@ -252,6 +253,100 @@ INSTANTIATE_TEST_SUITE_P(
                            ::testing::Range(0, (int)kNumEffectUuids),
                            ::testing::Range(0, (int)kNumPresets)));
 
+static constexpr LVM_Fs_en kLvmSampleRates[] = {LVM_FS_8000, LVM_FS_44100, LVM_FS_48000,
+                                                LVM_FS_192000};
+
+static constexpr LVM_UINT16 kKernelFrameCounts[] = {1, 37, 256, 1000};
+
+class ReverbKernelTest : public ::testing::TestWithParam<std::tuple<int, int>> {
+  public:
+    ReverbKernelTest()
+        : mSampleRate(kLvmSampleRates[std::get<0>(GetParam())]),
+          mFrameCount(kKernelFrameCounts[std::get<1>(GetParam())]) {
+        mParams.OperatingMode = LVM_MODE_ON;
+        mParams.SampleRate = mSampleRate;
+        mParams.SourceFormat = LVM_STEREO;
+        mParams.Level = 100;
+        mParams.LPF = 23999;
+        mParams.HPF = 50;
+        mParams.T60 = 1490;
+        mParams.Density = 100;
+        mParams.Damping = 21;
+        mParams.RoomSize = 100;
+    }
+
+    void createInstance(LVREV_Handle_t* handle, LVREV_Kernel_en kernel) {
+        LVREV_InstanceParams_st instanceParams = {
+                .MaxBlockSize = 512,
+                .SourceFormat = LVM_STEREO,
+                .NumDelays = LVREV_DELAYLINES_4,
+        };
+        ASSERT_EQ(LVREV_SUCCESS, LVREV_GetInstanceHandle(handle, &instanceParams));
+        setParams(*handle, kernel);
+    }
+
+    void setParams(LVREV_Handle_t handle, LVREV_Kernel_en kernel) {
+        mParams.Kernel = kernel;
+        ASSERT_EQ(LVREV_SUCCESS, LVREV_SetControlParameters(handle, &mParams));
+    }
+
+    const LVM_Fs_en mSampleRate;
+    const LVM_UINT16 mFrameCount;
+    LVREV_ControlParams_st mParams{};
+};
+
+// Tests that the feedback delay network kernel gives the same output as the delay line kernel,
+// while the room is changed and the reverb tail decays
+TEST_P(ReverbKernelTest, FdnMatchesDelayLines) {
+    SCOPED_TRACE(testing::Message()
+                 << "sampleRate: " << mSampleRate << " frameCount: " << mFrameCount);
+
+    LVREV_Handle_t delayLines = nullptr;
+    LVREV_Handle_t fdn = nullptr;
+    ASSERT_NO_FATAL_FAILURE(createInstance(&delayLines, LVREV_KERNEL_DELAYLINES));
+    ASSERT_NO_FATAL_FAILURE(createInstance(&fdn, LVREV_KERNEL_FDN));
+
+    constexpr size_t kTotalFrameCount = 48000;
+    const size_t loopCount = kTotalFrameCount / mFrameCount;
+    std::minstd_rand gen(mFrameCount);
+    std::uniform_real_distribution<> dis(-0.5f, 0.5f);
+    std::vector<float> input(mFrameCount * FCC_2);
+    std::vector<float> delayLinesOutput(mFrameCount * FCC_2);
+    std::vector<float> fdnOutput(mFrameCount * FCC_2);
+    for (size_t loop = 0; loop < loopCount; ++loop) {
+        if (loop == loopCount / 4 || loop == loopCount / 2) {
+            mParams.RoomSize = mParams.RoomSize / 2;
+            mParams.T60 = mParams.T60 * 2;
+            mParams.Density = mParams.Density - 30;
+            mParams.Damping = mParams.Damping + 20;
+            ASSERT_NO_FATAL_FAILURE(setParams(delayLines, LVREV_KERNEL_DELAYLINES));
+            ASSERT_NO_FATAL_FAILURE(setParams(fdn, LVREV_KERNEL_FDN));
+        }
+        // Stop the input for the last quarter to check the tail
+        for (auto& in : input) {
+            in = (loop < loopCount * 3 / 4) ? dis(gen) : 0.0f;
+        }
+        ASSERT_EQ(LVREV_SUCCESS, LVREV_Process(delayLines, input.data(), delayLinesOutput.data(),
+                                               mFrameCount));
+        // Process the feedback delay network in place
+        std::copy(input.begin(), input.end(), fdnOutput.begin());
+        ASSERT_EQ(LVREV_SUCCESS,
+                  LVREV_Process(fdn, fdnOutput.data(), fdnOutput.data(), mFrameCount));
+        for (size_t i = 0; i < fdnOutput.size(); ++i) {
+            ASSERT_NEAR(delayLinesOutput[i], fdnOutput[i], 1e-5f)
+                    << "at loop " << loop << " sample " << i;
+        }
+    }
+
+    ASSERT_EQ(LVREV_SUCCESS, LVREV_FreeInstance(delayLines));
+    ASSERT_EQ(LVREV_SUCCESS, LVREV_FreeInstance(fdn));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        EffectReverbTestAll, ReverbKernelTest,
+        ::testing::Combine(::testing::Range(0, (int)std::size(kLvmSampleRates)),
+                           ::testing::Range(0, (int)std::size(kKernelFrameCounts))));
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     int status = RUN_ALL_TESTS();
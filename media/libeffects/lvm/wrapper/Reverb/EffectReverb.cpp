@@ -698,6 +698,7 @@ int Reverb_init(ReverbContext* pContext) {
     params.Density = 100;
     params.Damping = 21;
     params.RoomSize = 100;
+    params.Kernel = LVREV_KERNEL_FDN;
 
     pContext->SamplesToExitCount = (params.T60 * pContext->config.inputCfg.samplingRate) / 1000;
 
@@ -320,6 +320,7 @@ void ReverbContext::initControlParameter(LVREV_ControlParams_st& params) {
     params.Density = kDefaultDensity;
     params.Damping = kDefaultDamping;
     params.RoomSize = kDefaultRoomSize;
+    params.Kernel = LVREV_KERNEL_FDN;
 }
 
 /*
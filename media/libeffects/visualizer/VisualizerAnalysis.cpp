@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "VisualizerAnalysis"
+//#define LOG_NDEBUG 0
+
+#include "VisualizerAnalysis.h"
+
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+
+namespace android {
+
+static constexpr float kMinPower = 2.5118864e-10f; // VISUALIZER_ANALYSIS_MIN_DB
+
+static inline float powerToDb(float power) {
+    return power > kMinPower ? 10.f * log10f(power) : VISUALIZER_ANALYSIS_MIN_DB;
+}
+
+VisualizerAnalysis::VisualizerAnalysis() {
+    mMix.resize(kFftSize);
+    mWindowed.resize(kFftSize);
+    mSpectrum.resize(kFftSize);
+    mFft.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+
+    // periodic Hann window
+    mWindow.resize(kFftSize);
+    float windowSum = 0.f;
+    for (size_t n = 0; n < kFftSize; n++) {
+        mWindow[n] = 0.5f - 0.5f * cosf(2 * M_PI * n / kFftSize);
+        windowSum += mWindow[n];
+    }
+    mMagnitudeScale = 2.f / windowSum;
+
+    // plan the transform now, it allocates on first use.
+    mFft.fwd(mSpectrum, mWindowed);
+    configure(44100, AUDIO_CHANNEL_OUT_STEREO);
+}
+
+void VisualizerAnalysis::setRing(visualizer_analysis_ring_t* ring, bool initialize) {
+    mRing = ring;
+    if (mRing == nullptr || !initialize) {
+        return;
+    }
+    *mRing = {};
+    mRing->magic = VISUALIZER_ANALYSIS_MAGIC;
+    mRing->version = VISUALIZER_ANALYSIS_VERSION;
+    mRing->recordCount = VISUALIZER_ANALYSIS_RECORD_COUNT;
+    mRing->binCount = kBinCount;
+    mRing->fftSize = kFftSize;
+    mRing->hopSize = kHopSize;
+}
+
+// ITU-R BS.1770 K-weighting: a high shelf modeling the head, then a high pass, designed for
+// the sample rate from their analog prototypes.
+void VisualizerAnalysis::configure(uint32_t sampleRate, audio_channel_mask_t channelMask) {
+    mSampleRate = sampleRate;
+    mChannelCount = audio_channel_count_from_out_mask(channelMask);
+    mMixScale = mChannelCount > 0 ? 1.f / mChannelCount : 0.f;
+
+    double k = tan(M_PI * 1681.974450955533 / sampleRate);
+    double q = 0.7071752369554196;
+    const double vh = pow(10., 3.999843853973347 / 20.);
+    const double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1. + k / q + k * k;
+    mKWeighting[0] = {
+            .b0 = (vh + vb * k / q + k * k) / a0,
+            .b1 = 2. * (k * k - vh) / a0,
+            .b2 = (vh - vb * k / q + k * k) / a0,
+            .a1 = 2. * (k * k - 1.) / a0,
+            .a2 = (1. - k / q + k * k) / a0,
+    };
+    k = tan(M_PI * 38.13547087602444 / sampleRate);
+    q = 0.5003270373238773;
+    a0 = 1. + k / q + k * k;
+    mKWeighting[1] = {
+            .b0 = 1.,
+            .b1 = -2.,
+            .b2 = 1.,
+            .a1 = 2. * (k * k - 1.) / a0,
+            .a2 = (1. - k / q + k * k) / a0,
+    };
+
+    // the surround channels are weighted 1.41 and the LFE is ignored, as in BS.1770.
+    mChannelWeights.assign(mChannelCount, 1.f);
+    if (audio_channel_mask_get_representation(channelMask)
+            == AUDIO_CHANNEL_REPRESENTATION_POSITION) {
+        uint32_t bits = audio_channel_mask_get_bits(channelMask);
+        for (size_t c = 0; c < mChannelCount; c++) {
+            const uint32_t channel = bits & -bits;
+            bits &= ~channel;
+            switch (channel) {
+            case AUDIO_CHANNEL_OUT_LOW_FREQUENCY:
+            case AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2:
+                mChannelWeights[c] = 0.f;
+                break;
+            case AUDIO_CHANNEL_OUT_BACK_LEFT:
+            case AUDIO_CHANNEL_OUT_BACK_RIGHT:
+            case AUDIO_CHANNEL_OUT_SIDE_LEFT:
+            case AUDIO_CHANNEL_OUT_SIDE_RIGHT:
+                mChannelWeights[c] = 1.41f;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    mKWeightingStates.resize(mChannelCount);
+    mLoudnessBlockFrames = std::max(sampleRate / kLoudnessBlocksPerSecond, size_t(1));
+
+    reset();
+}
+
+void VisualizerAnalysis::reset() {
+    mPosition = 0;
+    std::fill(mMix.begin(), mMix.end(), 0.f);
+    mMixFrames = kFftSize - kHopSize;
+    mPeak = 0.f;
+    mSumSquares = 0.f;
+
+    for (auto& states : mKWeightingStates) {
+        states.fill({0., 0.});
+    }
+    mLoudnessFrames = 0;
+    mLoudnessSum = 0.;
+    mLoudnessBlocks.fill(0.f);
+    mLoudnessBlockIndex = 0;
+    mLoudnessBlockCount = 0;
+}
+
+void VisualizerAnalysis::process(const float* in, size_t frameCount) {
+    if (mRing == nullptr || mChannelCount == 0) {
+        return;
+    }
+    int64_t timestampNs = -1;
+    for (size_t i = 0; i < frameCount; i++) {
+        float mix = 0.f;
+        for (size_t c = 0; c < mChannelCount; c++) {
+            const float sample = *in++;
+            mix += sample;
+            mPeak = std::max(mPeak, fabsf(sample));
+            mSumSquares += sample * sample;
+
+            double x = sample;
+            for (size_t s = 0; s < mKWeighting.size(); s++) {
+                const Biquad& f = mKWeighting[s];
+                BiquadState& z = mKWeightingStates[c][s];
+                const double y = f.b0 * x + z.z1;
+                z.z1 = f.b1 * x - f.a1 * y + z.z2;
+                z.z2 = f.b2 * x - f.a2 * y;
+                x = y;
+            }
+            mLoudnessSum += mChannelWeights[c] * x * x;
+        }
+        mMix[mMixFrames++] = mix * mMixScale;
+        mPosition++;
+
+        if (++mLoudnessFrames == mLoudnessBlockFrames) {
+            mLoudnessBlocks[mLoudnessBlockIndex] = mLoudnessSum / mLoudnessBlockFrames;
+            mLoudnessBlockIndex = (mLoudnessBlockIndex + 1) % kShortTermBlocks;
+            mLoudnessBlockCount = std::min(mLoudnessBlockCount + 1, kShortTermBlocks);
+            mLoudnessFrames = 0;
+            mLoudnessSum = 0.;
+        }
+
+        if (mMixFrames == kFftSize) {
+            if (timestampNs < 0) {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                timestampNs = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+            }
+            analyzeHop(timestampNs);
+            std::copy(mMix.begin() + kHopSize, mMix.end(), mMix.begin());
+            mMixFrames = kFftSize - kHopSize;
+        }
+    }
+}
+
+// The record is written in place in the ring, under its sequence number: readers retry when
+// the sequence is odd or changed while they copied the record.
+void VisualizerAnalysis::analyzeHop(int64_t timestampNs) {
+    for (size_t n = 0; n < kFftSize; n++) {
+        mWindowed[n] = mMix[n] * mWindow[n];
+    }
+    mFft.fwd(mSpectrum, mWindowed);
+
+    const uint32_t writeCount = mRing->writeCount;
+    visualizer_analysis_record_t& record =
+            mRing->records[writeCount % VISUALIZER_ANALYSIS_RECORD_COUNT];
+    const uint32_t sequence = record.sequence;
+    __atomic_store_n(&record.sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    record.sampleRate = mSampleRate;
+    record.timestampNs = timestampNs;
+    record.position = mPosition;
+    record.peakDb = powerToDb(mPeak * mPeak);
+    record.rmsDb = powerToDb(mSumSquares / (kHopSize * mChannelCount));
+    record.momentaryLufs = loudness(kMomentaryBlocks);
+    record.shortTermLufs = loudness(kShortTermBlocks);
+    const float scale = mMagnitudeScale * mMagnitudeScale;
+    for (size_t k = 0; k < kBinCount; k++) {
+        record.magnitudeDb[k] = powerToDb(std::norm(mSpectrum[k]) * scale);
+    }
+
+    __atomic_store_n(&record.sequence, sequence + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&mRing->writeCount, writeCount + 1, __ATOMIC_RELEASE);
+
+    mPeak = 0.f;
+    mSumSquares = 0.f;
+}
+
+float VisualizerAnalysis::loudness(size_t blockCount) const {
+    blockCount = std::min(blockCount, mLoudnessBlockCount);
+    if (blockCount == 0) {
+        return VISUALIZER_ANALYSIS_MIN_DB;
+    }
+    float sum = 0.f;
+    for (size_t b = 1; b <= blockCount; b++) {
+        sum += mLoudnessBlocks[(mLoudnessBlockIndex + kShortTermBlocks - b) % kShortTermBlocks];
+    }
+    return std::max(-0.691f + powerToDb(sum / blockCount), VISUALIZER_ANALYSIS_MIN_DB);
+}
+
+int VisualizerAnalysis::readLatest(visualizer_analysis_record_t* record) const {
+    if (mRing == nullptr) {
+        return -ENODATA;
+    }
+    return visualizer_analysis_read_latest(mRing, record);
+}
+
+}  // namespace android
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <vector>
+
+#include <audio_effects/effect_visualizer_analysis.h>
+#include <system/audio.h>
+#include <unsupported/Eigen/FFT>
+
+namespace android {
+
+// Computes the spectrum, levels and loudness of the Visualizer input, and publishes them in a
+// visualizer_analysis_ring_t provided by the caller, usually in shared memory.
+//
+// configure() allocates, and is called from the command path. process() does not allocate or
+// block, and is called from the audio thread; the caller serializes them.
+class VisualizerAnalysis {
+  public:
+    static constexpr size_t kFftSize = VISUALIZER_ANALYSIS_FFT_SIZE;
+    static constexpr size_t kHopSize = VISUALIZER_ANALYSIS_HOP_SIZE;
+    static constexpr size_t kBinCount = VISUALIZER_ANALYSIS_BIN_COUNT;
+
+    VisualizerAnalysis();
+    VisualizerAnalysis(const VisualizerAnalysis&) = delete;
+    VisualizerAnalysis& operator=(const VisualizerAnalysis&) = delete;
+
+    // Initializes the ring and publishes the next records to it. The ring is owned by the
+    // caller, and must stay valid until another ring is set or the analysis is destroyed.
+    // Nothing is published while the ring is null.
+    // With initialize false, the ring must already be initialized, for example by an analysis
+    // this one replaces, and its records are kept.
+    void setRing(visualizer_analysis_ring_t* ring, bool initialize = true);
+
+    void configure(uint32_t sampleRate, audio_channel_mask_t channelMask);
+    // Forgets the past input. The records already published are kept.
+    void reset();
+
+    // Analyzes frameCount interleaved frames, publishing a record every kHopSize frames.
+    void process(const float* in, size_t frameCount);
+
+    // Copies the latest record, see visualizer_analysis_read_latest().
+    int readLatest(visualizer_analysis_record_t* record) const;
+
+  private:
+    // second order section of the K-weighting filter, transposed direct form II
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+    struct BiquadState {
+        double z1, z2;
+    };
+
+    // loudness is measured in blocks of 100 ms, and averaged over 4 or 30 of them
+    static constexpr size_t kLoudnessBlocksPerSecond = 10;
+    static constexpr size_t kMomentaryBlocks = 4;
+    static constexpr size_t kShortTermBlocks = 30;
+
+    void analyzeHop(int64_t timestampNs);
+    float loudness(size_t blockCount) const;
+
+    visualizer_analysis_ring_t* mRing = nullptr;
+
+    uint32_t mSampleRate = 0;
+    size_t mChannelCount = 0;
+    uint64_t mPosition = 0;
+
+    // the mix of all the channels, the last kFftSize frames, the newest kHopSize pending
+    std::vector<float> mMix;
+    size_t mMixFrames = 0;
+    float mMixScale = 0.f;
+    std::vector<float> mWindow;
+    float mMagnitudeScale = 0.f;    // so that a full scale sine reads 1
+    std::vector<float> mWindowed;
+    std::vector<std::complex<float>> mSpectrum;
+    Eigen::FFT<float> mFft;
+
+    // levels of the current hop
+    float mPeak = 0.f;
+    float mSumSquares = 0.f;
+
+    // K-weighting
+    std::array<Biquad, 2> mKWeighting;
+    std::vector<std::array<BiquadState, 2>> mKWeightingStates;    // per channel
+    std::vector<float> mChannelWeights;
+    size_t mLoudnessBlockFrames = 0;
+    size_t mLoudnessFrames = 0;
+    double mLoudnessSum = 0.;
+    std::array<float, kShortTermBlocks> mLoudnessBlocks;          // weighted mean squares
+    size_t mLoudnessBlockIndex = 0;                               // next block to write
+    size_t mLoudnessBlockCount = 0;
+};
+
+}  // namespace android
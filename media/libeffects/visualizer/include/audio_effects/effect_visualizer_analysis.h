@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_EFFECT_VISUALIZER_ANALYSIS_H_
+#define ANDROID_EFFECT_VISUALIZER_ANALYSIS_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#if __cplusplus
+extern "C" {
+#endif
+
+// Server side analysis of the Visualizer.
+//
+// When a client of a Visualizer effect asks for the analysis region (IEffect::getAnalysisRegion,
+// see AudioEffect::getAnalysisRegion()), the audio server analyzes the input of the effect once
+// every VISUALIZER_ANALYSIS_HOP_SIZE frames while it is enabled, and publishes the result as a
+// visualizer_analysis_record_t in a ring held in that region. All the clients get the same
+// region, map it read only, and read the latest record with visualizer_analysis_read_latest(),
+// without calling into the server for each frame they display.
+
+#define VISUALIZER_ANALYSIS_MAGIC 0x56495341 // "VISA"
+#define VISUALIZER_ANALYSIS_VERSION 1
+#define VISUALIZER_ANALYSIS_FFT_SIZE 1024
+#define VISUALIZER_ANALYSIS_HOP_SIZE (VISUALIZER_ANALYSIS_FFT_SIZE / 2)
+#define VISUALIZER_ANALYSIS_BIN_COUNT (VISUALIZER_ANALYSIS_FFT_SIZE / 2 + 1)
+#define VISUALIZER_ANALYSIS_RECORD_COUNT 16
+// level reported for silence, in dB
+#define VISUALIZER_ANALYSIS_MIN_DB (-96.0f)
+
+typedef struct visualizer_analysis_record_s {
+    // odd while the record is being written, incremented by 2 at each write
+    uint32_t sequence;
+    uint32_t sampleRate;
+    // CLOCK_MONOTONIC time at which the record was published
+    int64_t timestampNs;
+    // number of frames analyzed since the effect was configured, up to the end of this hop
+    uint64_t position;
+    // of all the channels over the hop, in dBFS
+    float peakDb;
+    float rmsDb;
+    // ITU-R BS.1770 loudness over the last 400 ms and the last 3 s, in LUFS
+    float momentaryLufs;
+    float shortTermLufs;
+    uint32_t reserved;
+    // magnitude of the Hann windowed spectrum of the mix of all the channels, from DC to
+    // Nyquist, in dBFS: a full scale sine reads 0 dB at its frequency.
+    float magnitudeDb[VISUALIZER_ANALYSIS_BIN_COUNT];
+} visualizer_analysis_record_t;
+
+typedef struct visualizer_analysis_ring_s {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t binCount;
+    uint32_t fftSize;
+    uint32_t hopSize;
+    // number of records published, the latest is at (writeCount - 1) % recordCount
+    uint32_t writeCount;
+    uint32_t reserved;
+    visualizer_analysis_record_t records[VISUALIZER_ANALYSIS_RECORD_COUNT];
+} visualizer_analysis_ring_t;
+
+// Copies the latest record of the ring.
+// Returns 0 on success, -ENODATA if no record was published yet, or -EAGAIN if the writer kept
+// overwriting the record being read, in which case the caller may try again.
+static inline int visualizer_analysis_read_latest(const visualizer_analysis_ring_t *ring,
+        visualizer_analysis_record_t *record) {
+    if (ring->magic != VISUALIZER_ANALYSIS_MAGIC
+            || ring->version != VISUALIZER_ANALYSIS_VERSION) {
+        return -EINVAL;
+    }
+    for (int tries = 0; tries < 4; tries++) {
+        const uint32_t writeCount = __atomic_load_n(&ring->writeCount, __ATOMIC_ACQUIRE);
+        if (writeCount == 0) {
+            return -ENODATA;
+        }
+        const visualizer_analysis_record_t *latest =
+                &ring->records[(writeCount - 1) % VISUALIZER_ANALYSIS_RECORD_COUNT];
+        const uint32_t sequence = __atomic_load_n(&latest->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) {
+            continue;
+        }
+        memcpy(record, latest, sizeof(*record));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&latest->sequence, __ATOMIC_RELAXED) == sequence) {
+            return 0;
+        }
+    }
+    return -EAGAIN;
+}
+
+#if __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // ANDROID_EFFECT_VISUALIZER_ANALYSIS_H_
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <memory>
+#include <vector>
+
+#include <VisualizerAnalysis.h>
+#include <gtest/gtest.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+
+class VisualizerAnalysisTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mRing = std::make_unique<visualizer_analysis_ring_t>();
+        mAnalysis.setRing(mRing.get());
+    }
+
+    // Processes seconds of a sine of amplitude gains[c] in each channel c, in bursts of 480
+    // frames, and returns the latest record.
+    visualizer_analysis_record_t processSine(audio_channel_mask_t channelMask, double frequency,
+            const std::vector<float>& gains, double seconds) {
+        const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+        EXPECT_EQ(channelCount, gains.size());
+        mAnalysis.configure(kSampleRate, channelMask);
+
+        constexpr size_t kBurstFrames = 480;
+        std::vector<float> buffer(kBurstFrames * channelCount);
+        const size_t frameCount = seconds * kSampleRate;
+        for (size_t frame = 0; frame < frameCount; frame += kBurstFrames) {
+            for (size_t i = 0; i < kBurstFrames; i++) {
+                const float sine = sin(2 * M_PI * frequency * (frame + i) / kSampleRate);
+                for (size_t c = 0; c < channelCount; c++) {
+                    buffer[i * channelCount + c] = gains[c] * sine;
+                }
+            }
+            mAnalysis.process(buffer.data(), kBurstFrames);
+        }
+
+        visualizer_analysis_record_t record{};
+        EXPECT_EQ(0, visualizer_analysis_read_latest(mRing.get(), &record));
+        return record;
+    }
+
+    std::unique_ptr<visualizer_analysis_ring_t> mRing;
+    VisualizerAnalysis mAnalysis;
+};
+
+TEST_F(VisualizerAnalysisTest, ringHeader) {
+    EXPECT_EQ(VISUALIZER_ANALYSIS_MAGIC, mRing->magic);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_VERSION, mRing->version);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_RECORD_COUNT, mRing->recordCount);
+    EXPECT_EQ(VisualizerAnalysis::kBinCount, mRing->binCount);
+    EXPECT_EQ(VisualizerAnalysis::kFftSize, mRing->fftSize);
+    EXPECT_EQ(VisualizerAnalysis::kHopSize, mRing->hopSize);
+
+    visualizer_analysis_record_t record;
+    EXPECT_EQ(-ENODATA, visualizer_analysis_read_latest(mRing.get(), &record));
+}
+
+TEST_F(VisualizerAnalysisTest, publishesOneRecordPerHop) {
+    mAnalysis.configure(kSampleRate, AUDIO_CHANNEL_OUT_STEREO);
+    const std::vector<float> silence(VisualizerAnalysis::kHopSize * 2 * FCC_2);
+
+    mAnalysis.process(silence.data(), VisualizerAnalysis::kHopSize - 1);
+    EXPECT_EQ(0u, mRing->writeCount);
+    mAnalysis.process(silence.data(), 1);
+    EXPECT_EQ(1u, mRing->writeCount);
+    mAnalysis.process(silence.data(), 2 * VisualizerAnalysis::kHopSize);
+    EXPECT_EQ(3u, mRing->writeCount);
+
+    visualizer_analysis_record_t record;
+    ASSERT_EQ(0, visualizer_analysis_read_latest(mRing.get(), &record));
+    EXPECT_EQ(0u, record.sequence & 1);
+    EXPECT_EQ(kSampleRate, record.sampleRate);
+    EXPECT_EQ(3 * VisualizerAnalysis::kHopSize, record.position);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_MIN_DB, record.peakDb);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_MIN_DB, record.rmsDb);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_MIN_DB, record.momentaryLufs);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_MIN_DB, record.shortTermLufs);
+    for (size_t k = 0; k < VisualizerAnalysis::kBinCount; k++) {
+        EXPECT_EQ(VISUALIZER_ANALYSIS_MIN_DB, record.magnitudeDb[k]) << "bin " << k;
+    }
+
+    // nothing is published without a ring.
+    mAnalysis.setRing(nullptr);
+    mAnalysis.process(silence.data(), 2 * VisualizerAnalysis::kHopSize);
+    EXPECT_EQ(3u, mRing->writeCount);
+}
+
+// A replacing analysis continues the records of the ring it takes over.
+TEST_F(VisualizerAnalysisTest, continuesInitializedRing) {
+    const std::vector<float> silence(VisualizerAnalysis::kHopSize * FCC_2);
+    mAnalysis.process(silence.data(), VisualizerAnalysis::kHopSize);
+    ASSERT_EQ(1u, mRing->writeCount);
+
+    VisualizerAnalysis replacement;
+    replacement.configure(kSampleRate, AUDIO_CHANNEL_OUT_MONO);
+    replacement.setRing(mRing.get(), false /* initialize */);
+    EXPECT_EQ(1u, mRing->writeCount);
+    visualizer_analysis_record_t record;
+    EXPECT_EQ(0, visualizer_analysis_read_latest(mRing.get(), &record));
+
+    replacement.process(silence.data(), VisualizerAnalysis::kHopSize);
+    EXPECT_EQ(2u, mRing->writeCount);
+    ASSERT_EQ(0, visualizer_analysis_read_latest(mRing.get(), &record));
+    EXPECT_EQ(kSampleRate, record.sampleRate);
+    EXPECT_EQ(VisualizerAnalysis::kHopSize, record.position);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_MAGIC, mRing->magic);
+}
+
+// A full scale sine centered on a bin reads 0 dB in that bin.
+TEST_F(VisualizerAnalysisTest, fullScaleSineMagnitude) {
+    constexpr size_t kBin = 64;
+    const double frequency = double(kBin) * kSampleRate / VisualizerAnalysis::kFftSize;
+    const auto record = processSine(AUDIO_CHANNEL_OUT_STEREO, frequency, {1.f, 1.f}, 0.5);
+
+    EXPECT_NEAR(0., record.magnitudeDb[kBin], 0.01);
+    // the Hann window leaks to the adjacent bins only, at half the amplitude.
+    EXPECT_NEAR(-6.02, record.magnitudeDb[kBin - 1], 0.01);
+    EXPECT_NEAR(-6.02, record.magnitudeDb[kBin + 1], 0.01);
+    for (size_t k = 0; k < VisualizerAnalysis::kBinCount; k++) {
+        if (k + 1 < kBin || k > kBin + 1) {
+            EXPECT_LT(record.magnitudeDb[k], -60.f) << "bin " << k;
+        }
+    }
+    EXPECT_NEAR(0., record.peakDb, 0.01);
+    EXPECT_NEAR(-3.01, record.rmsDb, 0.01);
+}
+
+// ITU-R BS.1770: a 0 dBFS 997 Hz sine in the left, center or right channel reads -3.01 LUFS.
+TEST_F(VisualizerAnalysisTest, loudnessOfSineInOneChannel) {
+    const auto record = processSine(AUDIO_CHANNEL_OUT_MONO, 997., {0.1f}, 4.);
+    EXPECT_NEAR(-23.01, record.momentaryLufs, 0.05);
+    EXPECT_NEAR(-23.01, record.shortTermLufs, 0.05);
+}
+
+TEST_F(VisualizerAnalysisTest, loudnessOfSineInStereo) {
+    const auto record = processSine(AUDIO_CHANNEL_OUT_STEREO, 997., {0.1f, 0.1f}, 4.);
+    EXPECT_NEAR(-20., record.momentaryLufs, 0.05);
+    EXPECT_NEAR(-20., record.shortTermLufs, 0.05);
+    EXPECT_NEAR(-20., record.peakDb, 0.01);
+}
+
+TEST_F(VisualizerAnalysisTest, loudnessAtOtherSampleRates) {
+    for (const uint32_t sampleRate : {44100u, 96000u}) {
+        mAnalysis.configure(sampleRate, AUDIO_CHANNEL_OUT_MONO);
+        std::vector<float> buffer(sampleRate);
+        for (size_t i = 0; i < buffer.size(); i++) {
+            buffer[i] = 0.1f * sin(2 * M_PI * 997. * i / sampleRate);
+        }
+        mAnalysis.process(buffer.data(), buffer.size());
+        visualizer_analysis_record_t record;
+        ASSERT_EQ(0, visualizer_analysis_read_latest(mRing.get(), &record));
+        EXPECT_NEAR(-23.01, record.momentaryLufs, 0.05) << "sample rate " << sampleRate;
+    }
+}
+
+// The surround channels weigh 1.41 (+1.5 dB), and the LFE is not measured.
+TEST_F(VisualizerAnalysisTest, loudnessChannelWeights) {
+    // 5.1: front left, front right, center, LFE, back left, back right
+    const auto front = processSine(AUDIO_CHANNEL_OUT_5POINT1, 997., {0.1f, 0, 0, 0, 0, 0}, 1.);
+    const auto back = processSine(AUDIO_CHANNEL_OUT_5POINT1, 997., {0, 0, 0, 0, 0.1f, 0}, 1.);
+    const auto lfe = processSine(AUDIO_CHANNEL_OUT_5POINT1, 997., {0, 0, 0, 0.1f, 0, 0}, 1.);
+    EXPECT_NEAR(-23.01, front.momentaryLufs, 0.05);
+    EXPECT_NEAR(10 * log10(1.41), back.momentaryLufs - front.momentaryLufs, 0.01);
+    EXPECT_EQ(VISUALIZER_ANALYSIS_MIN_DB, lfe.momentaryLufs);
+    EXPECT_NEAR(-20., lfe.peakDb, 0.01);
+}
+
+}  // namespace
@@ -152,6 +152,13 @@
 
 #define AMEDIAMETRICS_PROP_EVENT          "event#"         // string value (often func name)
 #define AMEDIAMETRICS_PROP_EXECUTIONTIMENS "executionTimeNs"  // time to execute the event
+#define AMEDIAMETRICS_PROP_FASTCPUHISTOGRAM "fastCpuHistogram" // string |, FastThreadCycleStats
+#define AMEDIAMETRICS_PROP_FASTCYCLES     "fastCycles"     // int64_t fast thread cycles
+#define AMEDIAMETRICS_PROP_FASTCYCLESLOST "fastCyclesLost" // int64_t cycles not drained in time
+#define AMEDIAMETRICS_PROP_FASTJITTERHISTOGRAM "fastJitterHistogram" // string |, cycle jitter
+#define AMEDIAMETRICS_PROP_FASTMAXCPUNS   "fastMaxCpuNs"   // int32 max cpu time of a cycle
+#define AMEDIAMETRICS_PROP_FASTMAXWALLNS  "fastMaxWallNs"  // int32 max wall time of a cycle
+#define AMEDIAMETRICS_PROP_FASTUNDERRUNS  "fastUnderruns"  // int64_t late fast thread cycles
 
 // TODO: fix inconsistency in flags: AudioRecord / AudioTrack int32,  AudioThread string
 #define AMEDIAMETRICS_PROP_FLAGS          "flags"
@@ -186,6 +193,8 @@
 #define AMEDIAMETRICS_PROP_SAMPLERATE     "sampleRate"     // int32
 #define AMEDIAMETRICS_PROP_SAMPLERATECLIENT "sampleRateClient" // int32
 #define AMEDIAMETRICS_PROP_SAMPLERATEHARDWARE "sampleRateHardware" // int32
+#define AMEDIAMETRICS_PROP_SCHEDULEMARGINMS "scheduleMarginMs" // double avg adaptive write margin
+#define AMEDIAMETRICS_PROP_SCHEDULEMISSES "scheduleMisses" // int64_t late adaptive wakeups
 #define AMEDIAMETRICS_PROP_SELECTEDDEVICEID "selectedDeviceId" // int32
 #define AMEDIAMETRICS_PROP_SELECTEDMICDIRECTION "selectedMicDirection" // int32
 #define AMEDIAMETRICS_PROP_SELECTEDMICFIELDDIRECTION "selectedMicFieldDimension" // double
@@ -227,7 +236,9 @@
 #define AMEDIAMETRICS_PROP_VOICEVOLUME    "voiceVolume"    // double (audio.flinger)
 #define AMEDIAMETRICS_PROP_VOLUME_LEFT    "volume.left"    // double (AudioTrack)
 #define AMEDIAMETRICS_PROP_VOLUME_RIGHT   "volume.right"   // double (AudioTrack)
+#define AMEDIAMETRICS_PROP_WAKEUPS        "wakeups"        // int64_t thread wakeups to write
 #define AMEDIAMETRICS_PROP_WHERE          "where"          // string value
+#define AMEDIAMETRICS_PROP_WRITES         "writes"         // int64_t HAL writes from Thread
 // EncodingClient is the encoding format requested by the client
 #define AMEDIAMETRICS_PROP_ENCODINGCLIENT "encodingClient" // string
 // PerformanceModeActual is the actual selected performance mode, could be "none', "lowLatency" or
@@ -253,6 +264,7 @@
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_DTOR       "dtor"
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAAUDIOSTREAM "endAAudioStream" // AAudioStream
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP "endAudioIntervalGroup"
+#define AMEDIAMETRICS_PROP_EVENT_VALUE_FASTMIXERTELEMETRY "fastMixerTelemetry" // MixerThread
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_FLUSH      "flush"  // AudioTrack
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_INVALIDATE "invalidate" // server track, record
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_OPEN       "open"
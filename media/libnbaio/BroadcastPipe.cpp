@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BroadcastPipe"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/BroadcastPipe.h>
+#include <audio_utils/roundup.h>
+
+namespace android {
+
+BroadcastPipe::BroadcastPipe(size_t maxFrames, const NBAIO_Format& format, void *buffer) :
+        NBAIO_Sink(format),
+        mMaxFrames(roundup(maxFrames)),
+        mFrameSize(Format_frameSize(format)),
+        mBuffer(buffer == NULL ? malloc(mMaxFrames * mFrameSize) : buffer),
+        mFreeBufferInDestructor(buffer == NULL)
+{
+}
+
+BroadcastPipe::~BroadcastPipe()
+{
+    ALOG_ASSERT(readers() == 0);
+    if (mFreeBufferInDestructor) {
+        free(mBuffer);
+    }
+}
+
+size_t BroadcastPipe::readers() const
+{
+    return std::count_if(std::begin(mReaders), std::end(mReaders),
+            [](const ReaderSlot& slot) { return slot.mClaimed.load(std::memory_order_relaxed); });
+}
+
+BroadcastPipe::ReaderSlot *BroadcastPipe::attach(bool throttlesWriter, uint32_t *front)
+{
+    for (ReaderSlot& slot : mReaders) {
+        bool claimed = false;
+        if (slot.mClaimed.compare_exchange_strong(claimed, true, std::memory_order_acq_rel)) {
+            // A writer which has not seen mThrottles yet cannot overwrite frames at or after
+            // the rear it has published, so it is safe to start reading there.
+            *front = mRear.load(std::memory_order_acquire);
+            slot.mFront.store(*front, std::memory_order_relaxed);
+            slot.mThrottles.store(throttlesWriter, std::memory_order_release);
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void BroadcastPipe::detach(ReaderSlot *slot)
+{
+    slot->mThrottles.store(false, std::memory_order_release);
+    slot->mClaimed.store(false, std::memory_order_release);
+}
+
+size_t BroadcastPipe::framesFree(uint32_t rear) const
+{
+    size_t frames = mMaxFrames;
+    for (const ReaderSlot& slot : mReaders) {
+        if (slot.mThrottles.load(std::memory_order_acquire)) {
+            const uint32_t filled = rear - slot.mFront.load(std::memory_order_acquire);
+            frames = std::min(frames, mMaxFrames - std::min((size_t) filled, mMaxFrames));
+        }
+    }
+    return frames;
+}
+
+ssize_t BroadcastPipe::availableToWrite()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    return framesFree(mRear.load(std::memory_order_relaxed));
+}
+
+ssize_t BroadcastPipe::write(const void *buffer, size_t count)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const uint32_t rear = mRear.load(std::memory_order_relaxed);
+    count = std::min(count, framesFree(rear));
+    if (count == 0) {
+        return 0;
+    }
+    mRearNext.store(rear + (uint32_t) count, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const size_t index = rear & (mMaxFrames - 1);
+    const size_t part1 = std::min(count, mMaxFrames - index);
+    memcpy((uint8_t *) mBuffer + index * mFrameSize, buffer, part1 * mFrameSize);
+    if (part1 < count) {
+        memcpy(mBuffer, (const uint8_t *) buffer + part1 * mFrameSize,
+                (count - part1) * mFrameSize);
+    }
+
+    mRear.store(rear + (uint32_t) count, std::memory_order_release);
+    mFramesWritten += count;
+    return count;
+}
+
+}   // namespace android
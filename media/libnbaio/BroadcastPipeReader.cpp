@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BroadcastPipeReader"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/BroadcastPipeReader.h>
+
+namespace android {
+
+BroadcastPipeReader::BroadcastPipeReader(BroadcastPipe& pipe, bool throttlesWriter) :
+        NBAIO_Source(pipe.mFormat),
+        mPipe(pipe),
+        mThrottlesWriter(throttlesWriter),
+        mSlot(pipe.attach(throttlesWriter, &mFront))
+{
+    ALOGE_IF(mSlot == nullptr, "%s: already %zu readers attached",
+            __func__, BroadcastPipe::kMaxReaders);
+}
+
+BroadcastPipeReader::~BroadcastPipeReader()
+{
+    if (mSlot != nullptr) {
+        mPipe.detach(mSlot);
+    }
+}
+
+ssize_t BroadcastPipeReader::available(uint32_t rear)
+{
+    const uint32_t filled = rear - mFront;
+    if (filled > mPipe.mMaxFrames) {
+        // only a non-throttling reader can be overrun: skip to the oldest frame in the pipe.
+        const uint32_t lost = filled - mPipe.mMaxFrames;
+        mFront += lost;
+        mFramesOverrun += lost;
+        ++mOverruns;
+        return OVERRUN;
+    }
+    return filled;
+}
+
+ssize_t BroadcastPipeReader::availableToRead()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    if (CC_UNLIKELY(mSlot == nullptr)) {
+        return NO_INIT;
+    }
+    return available(mPipe.mRear.load(std::memory_order_acquire));
+}
+
+ssize_t BroadcastPipeReader::obtain(Span spans[2], size_t count)
+{
+    const ssize_t avail = availableToRead();
+    if (avail < 0) {
+        return avail;
+    }
+    count = std::min(count, (size_t) avail);
+    const size_t index = mFront & (mPipe.mMaxFrames - 1);
+    const size_t part1 = std::min(count, mPipe.mMaxFrames - index);
+    spans[0] = {(const uint8_t *) mPipe.mBuffer + index * mPipe.mFrameSize, part1};
+    spans[1] = {mPipe.mBuffer, count - part1};
+    return count;
+}
+
+ssize_t BroadcastPipeReader::release(size_t count)
+{
+    if (!mThrottlesWriter) {
+        // The frames were accessed before checking that the writer did not start
+        // overwriting them, in the same way as a sequence lock.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint32_t rearNext = mPipe.mRearNext.load(std::memory_order_relaxed);
+        if (rearNext - mFront > mPipe.mMaxFrames) {
+            (void) available(rearNext);     // account for the overrun
+            return OVERRUN;
+        }
+    }
+    mFront += (uint32_t) count;
+    if (mThrottlesWriter) {
+        mSlot->mFront.store(mFront, std::memory_order_release);
+    }
+    mFramesRead += count;
+    return count;
+}
+
+ssize_t BroadcastPipeReader::read(void *buffer, size_t count)
+{
+    Span spans[2];
+    const ssize_t actual = obtain(spans, count);
+    if (actual <= 0) {
+        return actual;
+    }
+    const size_t frameSize = mPipe.mFrameSize;
+    memcpy(buffer, spans[0].mData, spans[0].mFrames * frameSize);
+    memcpy((uint8_t *) buffer + spans[0].mFrames * frameSize, spans[1].mData,
+            spans[1].mFrames * frameSize);
+    return release(actual);
+}
+
+ssize_t BroadcastPipeReader::readVia(readVia_t via, size_t total, void *user,
+                                     size_t /*block*/)
+{
+    Span spans[2];
+    const ssize_t avail = obtain(spans, total);
+    if (avail <= 0) {
+        return avail;
+    }
+    size_t accumulator = 0;
+    ssize_t ret = 0;
+    for (const Span& span : spans) {
+        if (span.mFrames == 0) {
+            break;
+        }
+        ret = via(user, span.mData, span.mFrames);
+        if (ret <= 0) {
+            break;
+        }
+        ALOG_ASSERT((size_t) ret <= span.mFrames);
+        accumulator += ret;
+        if ((size_t) ret < span.mFrames) {
+            break;
+        }
+    }
+    if (accumulator == 0) {
+        return ret;
+    }
+    return release(accumulator);
+}
+
+ssize_t BroadcastPipeReader::flush()
+{
+    const ssize_t avail = availableToRead();
+    if (avail <= 0) {
+        return avail;
+    }
+    mFront += (uint32_t) avail;
+    if (mThrottlesWriter) {
+        mSlot->mFront.store(mFront, std::memory_order_release);
+    }
+    mFramesRead += avail;  // we consider flushed frames as read, but not lost frames
+    return avail;
+}
+
+}   // namespace android
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_BROADCAST_PIPE_H
+#define ANDROID_AUDIO_BROADCAST_PIPE_H
+
+#include <atomic>
+
+#include <media/nbaio/NBAIO.h>
+
+namespace android {
+
+// BroadcastPipe is a single writer, multiple reader ring buffer. Every BroadcastPipeReader
+// has its own read position, and sees every frame written after it was attached, unless
+// it is overrun. Unlike Pipe, a reader can be attached as throttling: the writer then
+// never overwrites frames the reader has not yet read, and availableToWrite() reports
+// the space behind the slowest throttling reader. Non-throttling readers never slow
+// down the writer, and are overrun independently of each other.
+//
+// Writing, attaching, detaching and reading are lock-free. The frame at position p is at
+// index p & (maxFrames - 1) of the buffer, like for Pipe.
+class BroadcastPipe : public NBAIO_Sink {
+
+    friend class BroadcastPipeReader;
+
+public:
+    // Maximum number of readers attached at the same time.
+    static constexpr size_t kMaxReaders = 8;
+
+    // maxFrames will be rounded up to a power of 2, and all slots are available. Must be >= 2.
+    // buffer is an optional parameter specifying the virtual address of the pipe buffer,
+    // which must be of size roundup(maxFrames) * Format_frameSize(format) bytes.
+    BroadcastPipe(size_t maxFrames, const NBAIO_Format& format, void *buffer = NULL);
+
+    // If a buffer was specified in the constructor, it is not automatically freed by destructor.
+    virtual ~BroadcastPipe();
+
+    // NBAIO_Sink interface
+
+    // Returns maxFrames if no throttling reader is attached.
+    virtual ssize_t availableToWrite();
+
+    // Writes up to availableToWrite() frames, returns the number of frames written.
+    virtual ssize_t write(const void *buffer, size_t count);
+
+    // Number of readers currently attached.
+    size_t readers() const;
+
+private:
+    struct ReaderSlot {
+        std::atomic<bool>     mClaimed{false};      // slot is owned by a reader
+        std::atomic<bool>     mThrottles{false};    // mFront limits the writer
+        std::atomic<uint32_t> mFront{0};            // read position of a throttling reader
+    };
+
+    // Returns nullptr if kMaxReaders readers are already attached.
+    ReaderSlot *attach(bool throttlesWriter, uint32_t *front);
+    void detach(ReaderSlot *slot);
+
+    // Frames which can be written at rear without overwriting frames of a throttling reader.
+    size_t framesFree(uint32_t rear) const;
+
+    const size_t    mMaxFrames;     // always a power of 2
+    const size_t    mFrameSize;
+    void * const    mBuffer;
+    // Position of the next frame to write, modulo 2^32. Written by the writer only.
+    std::atomic<uint32_t> mRear{0};
+    // End of the frames being written, set before the buffer is modified, so that
+    // non-throttling readers can detect frames overwritten while they were read.
+    std::atomic<uint32_t> mRearNext{0};
+    ReaderSlot      mReaders[kMaxReaders];
+    const bool      mFreeBufferInDestructor;
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_BROADCAST_PIPE_H
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_BROADCAST_PIPE_READER_H
+#define ANDROID_AUDIO_BROADCAST_PIPE_READER_H
+
+#include "BroadcastPipe.h"
+
+namespace android {
+
+// BroadcastPipeReader is safe for only a single thread.
+class BroadcastPipeReader : public NBAIO_Source {
+
+public:
+    // A contiguous range of frames in the pipe buffer.
+    struct Span {
+        const void *mData;
+        size_t      mFrames;
+    };
+
+    // Attaches to the pipe at its current write position.
+    // A throttling reader is never overrun, see BroadcastPipe.
+    // Check initCheck(), attaching fails if BroadcastPipe::kMaxReaders readers are attached.
+    explicit BroadcastPipeReader(BroadcastPipe& pipe, bool throttlesWriter = false);
+    virtual ~BroadcastPipeReader();
+
+    status_t initCheck() const { return mSlot != nullptr ? NO_ERROR : NO_INIT; }
+
+    // NBAIO_Source interface
+
+    virtual int64_t framesOverrun() { return mFramesOverrun; }
+    virtual int64_t overruns()  { return mOverruns; }
+
+    virtual ssize_t availableToRead();
+
+    virtual ssize_t read(void *buffer, size_t count);
+
+    // Calls via directly on the pipe buffer, without an intermediate copy.
+    // The block hint is ignored, via is called at most twice per call.
+    virtual ssize_t readVia(readVia_t via, size_t total, void *user, size_t block = 0);
+
+    virtual ssize_t flush();
+
+    // NBAIO_Source end
+
+    // Zero-copy read. Fills spans with up to count frames available to read, the second
+    // span is only non-empty if the frames wrap around the end of the buffer.
+    // Returns the number of frames in the spans, or OVERRUN, NEGOTIATE or NO_INIT.
+    // The frames stay available until release() is called.
+    ssize_t obtain(Span spans[2], size_t count);
+
+    // Consumes count frames obtained by the previous call to obtain().
+    // For a non-throttling reader, returns OVERRUN if the writer overwrote any of the
+    // frames since obtain(), in which case the frames must be discarded and the reader
+    // continues with the oldest frames still in the pipe.
+    // Otherwise returns count.
+    ssize_t release(size_t count);
+
+private:
+    // Returns the frames available to read, after accounting for an overrun.
+    ssize_t available(uint32_t rear);
+
+    BroadcastPipe&  mPipe;
+    const bool      mThrottlesWriter;
+    uint32_t        mFront = 0;     // position of the next frame to read, modulo 2^32
+    // Initialized after mFront, as attaching sets it.
+    BroadcastPipe::ReaderSlot * const mSlot;
+    int64_t         mFramesOverrun = 0;
+    int64_t         mOverruns = 0;
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_BROADCAST_PIPE_READER_H
@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "broadcastpipe_tests"
+
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/nbaio/BroadcastPipe.h>
+#include <media/nbaio/BroadcastPipeReader.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kPipeFrames = 16;
+
+// Mono 16 bit frames, so that every frame holds its position in the written sequence.
+const NBAIO_Format kFormat = Format_from_SR_C(48000, 1, AUDIO_FORMAT_PCM_16_BIT);
+
+void negotiate(NBAIO_Port &port) {
+    NBAIO_Format counterOffer;
+    size_t numCounterOffers = 0;
+    ASSERT_EQ(0, port.negotiate(&kFormat, 1, &counterOffer, numCounterOffers));
+}
+
+class BroadcastPipeTest : public testing::Test {
+protected:
+    void SetUp() override {
+        negotiate(mPipe);
+    }
+
+    std::unique_ptr<BroadcastPipeReader> attach(bool throttlesWriter = false) {
+        auto reader = std::make_unique<BroadcastPipeReader>(mPipe, throttlesWriter);
+        EXPECT_EQ(NO_ERROR, reader->initCheck());
+        negotiate(*reader);
+        return reader;
+    }
+
+    // Writes count frames continuing the sequence, returns the number of frames written.
+    ssize_t write(size_t count) {
+        std::vector<int16_t> frames(count);
+        std::iota(frames.begin(), frames.end(), mNext);
+        const ssize_t written = mPipe.write(frames.data(), count);
+        if (written > 0) mNext += written;
+        return written;
+    }
+
+    // Reads up to count frames, and checks that they continue the sequence at first.
+    static ssize_t readAndCheck(BroadcastPipeReader &reader, size_t count, int16_t first) {
+        std::vector<int16_t> frames(count);
+        const ssize_t read = reader.read(frames.data(), count);
+        for (ssize_t i = 0; i < read; i++) {
+            EXPECT_EQ(first + i, frames[i]) << "frame " << i;
+        }
+        return read;
+    }
+
+    BroadcastPipe mPipe{kPipeFrames, kFormat};
+    int16_t mNext = 0;
+};
+
+TEST_F(BroadcastPipeTest, nonThrottlingReaderDoesNotLimitWriter) {
+    auto reader = attach();
+    EXPECT_EQ((ssize_t) kPipeFrames, mPipe.availableToWrite());
+    EXPECT_EQ(10, write(10));
+    EXPECT_EQ((ssize_t) kPipeFrames, mPipe.availableToWrite());
+    EXPECT_EQ(10, reader->availableToRead());
+    EXPECT_EQ(10, readAndCheck(*reader, 10, 0));
+    EXPECT_EQ(0, reader->availableToRead());
+}
+
+TEST_F(BroadcastPipeTest, slowThrottlingReaderBlocksWriter) {
+    auto slow = attach(true /* throttlesWriter */);
+    auto fast = attach();
+
+    EXPECT_EQ(12, write(12));
+    EXPECT_EQ(4, mPipe.availableToWrite());
+    // the writer is limited to the space behind the throttling reader.
+    EXPECT_EQ(4, write(8));
+    EXPECT_EQ(0, mPipe.availableToWrite());
+    EXPECT_EQ(0, write(1));
+
+    // the non-throttling reader does not free any space.
+    EXPECT_EQ(16, readAndCheck(*fast, kPipeFrames, 0));
+    EXPECT_EQ(0, mPipe.availableToWrite());
+
+    EXPECT_EQ(5, readAndCheck(*slow, 5, 0));
+    EXPECT_EQ(5, mPipe.availableToWrite());
+    EXPECT_EQ(5, write(5));
+    EXPECT_EQ(0, mPipe.availableToWrite());
+
+    // the throttling reader is never overrun and sees every frame.
+    EXPECT_EQ(16, readAndCheck(*slow, kPipeFrames, 5));
+    EXPECT_EQ(0, slow->framesOverrun());
+    EXPECT_EQ(0, slow->overruns());
+    EXPECT_EQ(21, slow->framesRead());
+    EXPECT_EQ(5, readAndCheck(*fast, kPipeFrames, 16));
+
+    // detaching the throttling reader releases the writer.
+    slow.reset();
+    EXPECT_EQ((ssize_t) kPipeFrames, mPipe.availableToWrite());
+}
+
+TEST_F(BroadcastPipeTest, overrunIsReportedAndSkipsToOldestFrame) {
+    auto reader = attach();
+    EXPECT_EQ(16, write(16));
+    EXPECT_EQ(6, write(6));
+
+    // the 6 oldest frames were overwritten.
+    EXPECT_EQ(OVERRUN, reader->availableToRead());
+    EXPECT_EQ(6, reader->framesOverrun());
+    EXPECT_EQ(1, reader->overruns());
+
+    // the reader continues with the oldest frame still in the pipe.
+    EXPECT_EQ(16, reader->availableToRead());
+    EXPECT_EQ(16, readAndCheck(*reader, kPipeFrames, 6));
+    EXPECT_EQ(16, reader->framesRead());
+
+    // a later overrun accumulates.
+    EXPECT_EQ(16, write(16));
+    EXPECT_EQ(16, write(16));
+    std::vector<int16_t> frames(kPipeFrames);
+    EXPECT_EQ(OVERRUN, reader->read(frames.data(), kPipeFrames));
+    EXPECT_EQ(22, reader->framesOverrun());
+    EXPECT_EQ(2, reader->overruns());
+    EXPECT_EQ(16, readAndCheck(*reader, kPipeFrames, 38));
+}
+
+TEST_F(BroadcastPipeTest, overrunDuringObtainIsReportedByRelease) {
+    auto reader = attach();
+    EXPECT_EQ(8, write(8));
+
+    BroadcastPipeReader::Span spans[2];
+    ASSERT_EQ(8, reader->obtain(spans, kPipeFrames));
+    // the writer overwrites frames which were obtained but not yet released.
+    EXPECT_EQ(12, write(12));
+    EXPECT_EQ(OVERRUN, reader->release(8));
+    EXPECT_EQ(4, reader->framesOverrun());
+    EXPECT_EQ(1, reader->overruns());
+    EXPECT_EQ(0, reader->framesRead());
+
+    EXPECT_EQ(16, readAndCheck(*reader, kPipeFrames, 4));
+}
+
+TEST_F(BroadcastPipeTest, obtainSplitsSpansAtWrapAround) {
+    auto reader = attach();
+    EXPECT_EQ(12, write(12));
+    EXPECT_EQ(12, readAndCheck(*reader, 12, 0));
+    EXPECT_EQ(10, write(10));
+
+    BroadcastPipeReader::Span spans[2];
+    ASSERT_EQ(10, reader->obtain(spans, kPipeFrames));
+    ASSERT_EQ(4u, spans[0].mFrames);    // up to the end of the buffer
+    ASSERT_EQ(6u, spans[1].mFrames);    // from the start of the buffer
+    const int16_t *part1 = static_cast<const int16_t *>(spans[0].mData);
+    const int16_t *part2 = static_cast<const int16_t *>(spans[1].mData);
+    EXPECT_EQ(part1 + 4, part2 + kPipeFrames);
+    for (int i = 0; i < 4; i++) EXPECT_EQ(12 + i, part1[i]);
+    for (int i = 0; i < 6; i++) EXPECT_EQ(16 + i, part2[i]);
+    EXPECT_EQ(10, reader->release(10));
+
+    // read() copies across the wrap around.
+    EXPECT_EQ(16, write(16));
+    EXPECT_EQ(16, readAndCheck(*reader, kPipeFrames, 22));
+}
+
+TEST_F(BroadcastPipeTest, obtainWithinBufferHasOneSpan) {
+    auto reader = attach();
+    EXPECT_EQ(8, write(8));
+    BroadcastPipeReader::Span spans[2];
+    ASSERT_EQ(5, reader->obtain(spans, 5));
+    EXPECT_EQ(5u, spans[0].mFrames);
+    EXPECT_EQ(0u, spans[1].mFrames);
+    EXPECT_EQ(5, reader->release(5));
+    EXPECT_EQ(3, readAndCheck(*reader, kPipeFrames, 5));
+}
+
+struct ViaCollector {
+    std::vector<int16_t> frames;
+    size_t calls = 0;
+    size_t limit = SIZE_MAX;    // frames accepted per call
+};
+
+ssize_t collect(void *user, const void *buffer, size_t count) {
+    ViaCollector *collector = static_cast<ViaCollector *>(user);
+    ++collector->calls;
+    count = std::min(count, collector->limit);
+    const int16_t *frames = static_cast<const int16_t *>(buffer);
+    collector->frames.insert(collector->frames.end(), frames, frames + count);
+    return count;
+}
+
+TEST_F(BroadcastPipeTest, readViaCallsOncePerSpan) {
+    auto reader = attach();
+    EXPECT_EQ(12, write(12));
+    EXPECT_EQ(12, readAndCheck(*reader, 12, 0));
+    EXPECT_EQ(10, write(10));
+
+    ViaCollector collector;
+    EXPECT_EQ(10, reader->readVia(collect, kPipeFrames, &collector));
+    EXPECT_EQ(2u, collector.calls);     // wraps around
+    ASSERT_EQ(10u, collector.frames.size());
+    for (int i = 0; i < 10; i++) EXPECT_EQ(12 + i, collector.frames[i]);
+    EXPECT_EQ(22, reader->framesRead());
+    EXPECT_EQ(0, reader->availableToRead());
+}
+
+TEST_F(BroadcastPipeTest, readViaReleasesOnlyConsumedFrames) {
+    auto reader = attach();
+    EXPECT_EQ(10, write(10));
+
+    ViaCollector collector;
+    collector.limit = 3;
+    EXPECT_EQ(3, reader->readVia(collect, kPipeFrames, &collector));
+    EXPECT_EQ(1u, collector.calls);     // stops at the partially consumed span
+    EXPECT_EQ(7, reader->availableToRead());
+    EXPECT_EQ(7, readAndCheck(*reader, kPipeFrames, 3));
+
+    // nothing to read does not call via.
+    collector.calls = 0;
+    EXPECT_EQ(0, reader->readVia(collect, kPipeFrames, &collector));
+    EXPECT_EQ(0u, collector.calls);
+}
+
+TEST_F(BroadcastPipeTest, readersAtDifferentOffsets) {
+    auto first = attach();
+    EXPECT_EQ(4, write(4));
+    // a reader sees the frames written after it was attached.
+    auto second = attach();
+    EXPECT_EQ(6, write(6));
+    auto third = attach(true /* throttlesWriter */);
+    EXPECT_EQ(2, write(2));
+    EXPECT_EQ(3u, mPipe.readers());
+
+    EXPECT_EQ(12, first->availableToRead());
+    EXPECT_EQ(8, second->availableToRead());
+    EXPECT_EQ(2, third->availableToRead());
+
+    // reading from one reader does not consume the frames of another.
+    EXPECT_EQ(5, readAndCheck(*first, 5, 0));
+    EXPECT_EQ(8, readAndCheck(*second, kPipeFrames, 4));
+    EXPECT_EQ(7, first->availableToRead());
+    EXPECT_EQ(2, third->flush());
+    EXPECT_EQ(0, third->availableToRead());
+    EXPECT_EQ(2, third->framesRead());
+
+    EXPECT_EQ(3, write(3));
+    EXPECT_EQ(10, readAndCheck(*first, kPipeFrames, 5));
+    EXPECT_EQ(3, readAndCheck(*second, kPipeFrames, 12));
+    EXPECT_EQ(3, readAndCheck(*third, kPipeFrames, 12));
+
+    second.reset();
+    EXPECT_EQ(2u, mPipe.readers());
+}
+
+TEST_F(BroadcastPipeTest, attachFailsBeyondMaxReaders) {
+    std::vector<std::unique_ptr<BroadcastPipeReader>> readers;
+    for (size_t i = 0; i < BroadcastPipe::kMaxReaders; i++) {
+        readers.push_back(attach());
+    }
+    BroadcastPipeReader extra(mPipe);
+    EXPECT_EQ(NO_INIT, extra.initCheck());
+    negotiate(extra);
+    EXPECT_EQ(NO_INIT, extra.availableToRead());
+
+    // a detached slot can be reused.
+    readers.pop_back();
+    BroadcastPipeReader reused(mPipe);
+    EXPECT_EQ(NO_ERROR, reused.initCheck());
+}
+
+TEST_F(BroadcastPipeTest, concurrentWriterAndThrottlingReader) {
+    constexpr int kFrames = 100000;
+    auto reader = attach(true /* throttlesWriter */);
+    std::thread writer([this] {
+        for (int written = 0; written < kFrames; ) {
+            const ssize_t count = write(std::min(5, kFrames - written));
+            if (count == 0) std::this_thread::yield();     // pipe full
+            written += count;
+        }
+    });
+    int16_t expected = 0;   // wraps around like the written sequence
+    int total = 0;
+    while (total < kFrames) {
+        std::vector<int16_t> frames(7);
+        const ssize_t read = reader->read(frames.data(), frames.size());
+        ASSERT_GE(read, 0);
+        if (read == 0) std::this_thread::yield();      // pipe empty
+        for (ssize_t i = 0; i < read; i++) {
+            ASSERT_EQ(expected++, frames[i]);
+        }
+        total += read;
+    }
+    writer.join();
+    EXPECT_EQ(0, reader->overruns());
+}
+
+} // namespace
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include <audio_utils/fifo.h>
+#include <cutils/properties.h>
 #include <json/json.h>
 #include <media/nblog/Merger.h>
 #include <media/nblog/PerformanceAnalysis.h>
@@ -124,7 +125,9 @@ const std::vector<sp<Reader>>& Merger::getReaders() const
 // ---------------------------------------------------------------------------
 
 MergeReader::MergeReader(const void *shared, size_t size, Merger &merger)
-    : Reader(shared, size, "MergeReader"), mReaders(merger.getReaders())
+    : Reader(shared, size, "MergeReader"), mReaders(merger.getReaders()),
+      mMediaMetricsPushPeriodNs(s2ns(property_get_int64("media.nblog.metrics_period_s",
+              ns2s(kPeriodicMediaMetricsPush))))
 {
 }
 
@@ -148,10 +151,12 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
         case EVENT_THREAD_INFO: {
             const thread_info_t info = it.payload<thread_info_t>();
             data.threadInfo = info;
+            data.configureHistograms();
         } break;
         case EVENT_THREAD_PARAMS: {
             const thread_params_t params = it.payload<thread_params_t>();
             data.threadParams = params;
+            data.configureHistograms();
         } break;
         case EVENT_LATENCY: {
             const double latencyMs = it.payload<double>();
@@ -218,7 +223,7 @@ void MergeReader::checkPushToMediaMetrics()
     const nsecs_t now = systemTime();
     for (auto& item : mThreadPerformanceData) {
         ReportPerformance::PerformanceData& data = item.second;
-        if (now - data.start >= kPeriodicMediaMetricsPush) {
+        if (now - data.start >= mMediaMetricsPushPeriodNs) {
             (void)ReportPerformance::sendToMediaMetrics(data);
             data.reset();   // data is persistent per thread
         }
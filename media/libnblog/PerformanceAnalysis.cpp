@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <climits>
+#include <ctype.h>
 #include <deque>
 #include <iomanip>
 #include <math.h>
@@ -37,6 +38,7 @@
 #include <new>
 #include <audio_utils/LogPlot.h>
 #include <audio_utils/roundup.h>
+#include <cutils/properties.h>
 #include <media/nblog/NBLog.h>
 #include <media/nblog/PerformanceAnalysis.h>
 #include <media/nblog/ReportPerformance.h>
@@ -70,11 +72,67 @@ void Histogram::clear()
     mTotalCount = 0;
 }
 
+void Histogram::reconfigure(const Config &c)
+{
+    mBinSize = c.binSize;
+    mNumBins = c.numBins;
+    mLow = c.low;
+    mBins.assign(mNumBins + 2, 0);
+    mTotalCount = 0;
+}
+
+bool Histogram::merge(const Histogram &other)
+{
+    if (config() != other.config()) {
+        return false;
+    }
+    for (size_t i = 0; i < mBins.size(); i++) {
+        mBins[i] += other.mBins[i];
+    }
+    mTotalCount += other.mTotalCount;
+    return true;
+}
+
+double Histogram::percentile(double percent) const
+{
+    if (mTotalCount == 0) {
+        return 0.;
+    }
+    // rank of the data point at the percentile, 1 based
+    const uint64_t rank = std::max((uint64_t)1,
+            (uint64_t)ceil(std::max(0., std::min(100., percent)) / 100. * mTotalCount));
+    uint64_t count = 0;
+    size_t index = 0;
+    for (; index < mBins.size() - 1; index++) {
+        count += mBins[index];
+        if (count >= rank) {
+            break;
+        }
+    }
+    // mBins[0] holds the values below mLow, mBins[i + 1] the values of bin i.
+    return mLow + mBinSize * (static_cast<int>(index) - 1);
+}
+
 uint64_t Histogram::totalCount() const
 {
     return mTotalCount;
 }
 
+/* static */
+bool Histogram::Config::fromString(const std::string &s, Config *config)
+{
+    double binSize, low;
+    unsigned long numBins;
+    char extra;
+    if (config == nullptr
+            || sscanf(s.c_str(), "%lf,%lu,%lf%c", &binSize, &numBins, &low, &extra) != 3
+            || !(binSize > 0.) || numBins == 0) {
+        return false;
+    }
+    *config = {binSize, static_cast<size_t>(numBins), low};
+    return true;
+}
+
 std::string Histogram::toString() const {
     std::stringstream ss;
     static constexpr char kDivider = '|';
@@ -155,6 +213,69 @@ std::string Histogram::asciiArtString(size_t indent) const {
 
 //------------------------------------------------------------------------------
 
+// Returns the configuration from property media.nblog.hist.<thread type>.<name>, if set
+// and valid, otherwise the default.
+static Histogram::Config configFromProperty(const NBLog::thread_info_t &info, const char *name,
+                                            const Histogram::Config &defaultConfig)
+{
+    std::string type = NBLog::threadTypeToString(info.type);
+    std::transform(type.begin(), type.end(), type.begin(),
+            [](unsigned char c) { return tolower(c); });
+    const std::string key = "media.nblog.hist." + type + "." + name;
+    char value[PROPERTY_VALUE_MAX];
+    Histogram::Config config = defaultConfig;
+    if (property_get(key.c_str(), value, nullptr /* default_value */) > 0
+            && !Histogram::Config::fromString(value, &config)) {
+        ALOGW("%s: ignoring invalid %s %s", __func__, key.c_str(), value);
+    }
+    return config;
+}
+
+/* static */
+Histogram::Config PerformanceData::workConfig(const NBLog::thread_info_t &info,
+                                              const NBLog::thread_params_t &params)
+{
+    Histogram::Config config = kWorkConfig;
+    // kWorkConfig is kept for FastMixer, so that its data remains mergeable with the data
+    // sent before the configuration was derived from the buffer period.
+    if (info.type != NBLog::FASTMIXER && params.frameCount > 0 && params.sampleRate > 0) {
+        // kWorkConfig is [0.5, 1.75] times the 4 ms FastMixer period, in 20 bins.
+        const double periodMs = params.frameCount * 1e3 / params.sampleRate;
+        config = {periodMs / 16., kWorkConfig.numBins, periodMs / 2.};
+    }
+    return configFromProperty(info, "work", config);
+}
+
+/* static */
+Histogram::Config PerformanceData::latencyConfig(const NBLog::thread_info_t &info)
+{
+    return configFromProperty(info, "latency", kLatencyConfig);
+}
+
+/* static */
+Histogram::Config PerformanceData::warmupConfig(const NBLog::thread_info_t &info)
+{
+    return configFromProperty(info, "warmup", kWarmupConfig);
+}
+
+void PerformanceData::configureHistograms()
+{
+    const Histogram::Config work = workConfig(threadInfo, threadParams);
+    if (work != workHist.config()) {
+        workHist.reconfigure(work);
+    }
+    const Histogram::Config latency = latencyConfig(threadInfo);
+    if (latency != latencyHist.config()) {
+        latencyHist.reconfigure(latency);
+    }
+    const Histogram::Config warmup = warmupConfig(threadInfo);
+    if (warmup != warmupHist.config()) {
+        warmupHist.reconfigure(warmup);
+    }
+}
+
+//------------------------------------------------------------------------------
+
 // Given an audio processing wakeup timestamp, buckets the time interval
 // since the previous timestamp into a histogram, searches for
 // outliers, analyzes the outlier series for unexpectedly
@@ -162,22 +162,33 @@ bool sendToMediaMetrics(const PerformanceData& data)
     static constexpr char kThreadOverruns[] = "android.media.audiothread.overruns";
     static constexpr char kThreadActive[] = "android.media.audiothread.activeMs";
     static constexpr char kThreadDuration[] = "android.media.audiothread.durationMs";
+    static constexpr char kThreadWorkP50[] = "android.media.audiothread.workMs.p50";
+    static constexpr char kThreadWorkP99[] = "android.media.audiothread.workMs.p99";
+    static constexpr char kThreadLatencyP50[] = "android.media.audiothread.latencyMs.p50";
+    static constexpr char kThreadLatencyP99[] = "android.media.audiothread.latencyMs.p99";
 
-    // Currently, we only allow FastMixer thread data to be sent to Media Metrics.
-    if (data.threadInfo.type != NBLog::FASTMIXER) {
+    // Only threads which identified themselves with EVENT_THREAD_INFO are sent.
+    if (data.threadInfo.type == NBLog::UNKNOWN) {
         return false;
     }
 
     std::unique_ptr<mediametrics::Item> item(mediametrics::Item::create("audiothread"));
 
+    // The serialized histograms include their configuration and can be merged across
+    // devices with the same configuration. The percentiles are estimated on the device
+    // for queries which do not need to merge.
     const Histogram &workHist = data.workHist;
     if (workHist.totalCount() > 0) {
         item->setCString(kThreadWorkHist, workHist.toString().c_str());
+        item->setDouble(kThreadWorkP50, workHist.percentile(50.));
+        item->setDouble(kThreadWorkP99, workHist.percentile(99.));
     }
 
     const Histogram &latencyHist = data.latencyHist;
     if (latencyHist.totalCount() > 0) {
         item->setCString(kThreadLatencyHist, latencyHist.toString().c_str());
+        item->setDouble(kThreadLatencyP50, latencyHist.percentile(50.));
+        item->setDouble(kThreadLatencyP99, latencyHist.percentile(99.));
     }
 
     const Histogram &warmupHist = data.warmupHist;
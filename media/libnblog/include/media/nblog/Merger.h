@@ -103,9 +103,13 @@ private:
     // first parameter is author, i.e. thread index.
     std::map<int, ReportPerformance::PerformanceData> mThreadPerformanceData;
 
-    // how often to push data to Media Metrics
+    // how often to push data to Media Metrics, by default.
     static constexpr nsecs_t kPeriodicMediaMetricsPush = s2ns((nsecs_t)2 * 60 * 60); // 2 hours
 
+    // how often to push data to Media Metrics, property media.nblog.metrics_period_s
+    // overrides the default.
+    const nsecs_t mMediaMetricsPushPeriodNs;
+
     // handle author entry by looking up the author's name and appending it to the body
     // returns number of bytes read from fmtEntry
     void handleAuthor(const AbstractEntry &fmtEntry, String8 *body);
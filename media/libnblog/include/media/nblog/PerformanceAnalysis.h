@@ -44,9 +44,18 @@ namespace ReportPerformance {
 class Histogram {
 public:
     struct Config {
-        const double binSize;   // TODO template type
-        const size_t numBins;
-        const double low;       // TODO template type
+        double binSize;         // TODO template type
+        size_t numBins;
+        double low;             // TODO template type
+
+        bool operator==(const Config &other) const {
+            return binSize == other.binSize && numBins == other.numBins && low == other.low;
+        }
+        bool operator!=(const Config &other) const { return !(*this == other); }
+
+        // Parses "binSize,numBins,low", the fields that follow the version in toString().
+        // Returns false if the string is malformed or binSize or numBins is not positive.
+        static bool fromString(const std::string &s, Config *config);
     };
 
     // Histograms are constructed with fixed configuration numbers. Dynamic configuration based
@@ -87,6 +96,39 @@ public:
      */
     void clear();
 
+    /**
+     * \brief Removes all data points from the histogram and changes its configuration.
+     *
+     * \param c the new configuration.
+     */
+    void reconfigure(const Config &c);
+
+    /**
+     * \brief Returns the configuration of the histogram.
+     */
+    Config config() const { return {mBinSize, mNumBins, mLow}; }
+
+    /**
+     * \brief Adds the data points of another histogram to this histogram.
+     *        Histograms can only be merged if they have the same configuration, which
+     *        is also what allows the serialized histograms of different devices to be
+     *        aggregated by summing bin counts.
+     *
+     * \param other the histogram to merge, it is not modified.
+     * \return true if merged, false if the configurations differ.
+     */
+    bool merge(const Histogram &other);
+
+    /**
+     * \brief Estimates a percentile of the data points, e.g. 50. for the median.
+     *        The estimate is the value of the bin containing the percentile, clamped to
+     *        [low - binSize, low + binSize * numBins] for values outside the range.
+     *
+     * \param percent the percentile, in the range [0, 100].
+     * \return the estimated value, or 0. if the histogram is empty.
+     */
+    double percentile(double percent) const;
+
     /**
      * \brief Returns the total number of data points added to the histogram.
      *
@@ -121,9 +163,9 @@ private:
     // Histogram version number.
     static constexpr int kVersion = 1;
 
-    const double mBinSize;          // Size of each bucket
-    const size_t mNumBins;          // Number of buckets in range (excludes low and high)
-    const double mLow;              // Lower bound of values
+    double mBinSize;                // Size of each bucket
+    size_t mNumBins;                // Number of buckets in range (excludes low and high)
+    double mLow;                    // Lower bound of values
 
     // Data structure to store the actual histogram. Counts of bin values less than mLow
     // are stored in mBins[0]. Bin index i corresponds to mBins[i+1]. Counts of bin values
@@ -152,6 +194,24 @@ struct PerformanceData {
     // bin size and lower/upper limits.
     static constexpr Histogram::Config kWarmupConfig = { 5., 10, 10.};
 
+    // Histogram configurations for a thread. Unless overridden by a property, the work time
+    // histogram of threads other than FastMixer spans the same fraction of the buffer period
+    // as kWorkConfig does for FastMixer, and the other histograms use the defaults above.
+    // The configuration is part of the serialized histogram, so histograms from devices
+    // with identical configurations can be merged.
+    //
+    // The properties are "media.nblog.hist.<thread type>.<work|latency|warmup>", e.g.
+    // media.nblog.hist.fastcapture.work, with a value in the Histogram::Config::fromString()
+    // format.
+    static Histogram::Config workConfig(const NBLog::thread_info_t &info,
+                                        const NBLog::thread_params_t &params);
+    static Histogram::Config latencyConfig(const NBLog::thread_info_t &info);
+    static Histogram::Config warmupConfig(const NBLog::thread_info_t &info);
+
+    // Applies the configurations above for the current threadInfo and threadParams.
+    // Histograms whose configuration changes are cleared.
+    void configureHistograms();
+
     NBLog::thread_info_t threadInfo{};
     NBLog::thread_params_t threadParams{};
 
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "histogram_tests"
+
+#include <gtest/gtest.h>
+#include <media/nblog/PerformanceAnalysis.h>
+
+using android::ReportPerformance::Histogram;
+
+namespace {
+
+TEST(Histogram, percentileEmpty) {
+    const Histogram hist(0.5, 20, 2.);
+    EXPECT_EQ(0., hist.percentile(50.));
+}
+
+TEST(Histogram, percentile) {
+    Histogram hist(1., 10, 0.);
+    // values are rounded to the nearest bin.
+    for (const double value : {1., 2.2, 2.9, 3., 4., 5., 6., 7.4, 8., 9.}) {
+        hist.add(value);
+    }
+    ASSERT_EQ(10u, hist.totalCount());
+    EXPECT_EQ(1., hist.percentile(0.));
+    EXPECT_EQ(1., hist.percentile(10.));
+    EXPECT_EQ(2., hist.percentile(20.));
+    EXPECT_EQ(3., hist.percentile(21.));
+    EXPECT_EQ(3., hist.percentile(40.));
+    EXPECT_EQ(4., hist.percentile(50.));
+    EXPECT_EQ(9., hist.percentile(99.));
+    EXPECT_EQ(9., hist.percentile(100.));
+
+    // out of range percentiles are clamped.
+    EXPECT_EQ(1., hist.percentile(-5.));
+    EXPECT_EQ(9., hist.percentile(150.));
+}
+
+TEST(Histogram, percentileOutOfRange) {
+    Histogram hist(2., 5, 10.);
+    hist.add(3.);       // below low
+    hist.add(14.);
+    hist.add(100.);     // at or above low + binSize * numBins
+    hist.add(20.);
+    EXPECT_EQ(8., hist.percentile(25.));        // low - binSize
+    EXPECT_EQ(14., hist.percentile(50.));
+    EXPECT_EQ(20., hist.percentile(100.));      // low + binSize * numBins
+}
+
+TEST(Histogram, percentileAfterReconfigure) {
+    Histogram hist(1., 10, 0.);
+    hist.add(5.);
+    hist.reconfigure({0.5, 4, 1.});
+    EXPECT_EQ(0., hist.percentile(50.));
+    hist.add(2.);
+    EXPECT_EQ(2., hist.percentile(50.));
+}
+
+TEST(Histogram, merge) {
+    Histogram hist(1., 10, 0.);
+    Histogram other(1., 10, 0.);
+    for (const double value : {1., 2., 2.}) {
+        hist.add(value);
+    }
+    for (const double value : {2., 8., 9., 9., 9.}) {
+        other.add(value);
+    }
+    ASSERT_TRUE(hist.merge(other));
+    EXPECT_EQ(8u, hist.totalCount());
+    EXPECT_EQ(5u, other.totalCount());      // not modified
+    EXPECT_EQ(2., hist.percentile(50.));
+    EXPECT_EQ(9., hist.percentile(75.));
+
+    // the bin counts are summed, as for histograms serialized on different devices.
+    Histogram expected(1., 10, 0.);
+    for (const double value : {1., 2., 2., 2., 8., 9., 9., 9.}) {
+        expected.add(value);
+    }
+    EXPECT_EQ(expected.toString(), hist.toString());
+}
+
+TEST(Histogram, mergeConfigMismatch) {
+    Histogram hist(1., 10, 0.);
+    hist.add(3.);
+    const std::string before = hist.toString();
+    for (const Histogram::Config config : {
+            Histogram::Config{0.5, 10, 0.},     // binSize differs
+            Histogram::Config{1., 11, 0.},      // numBins differs
+            Histogram::Config{1., 10, 1.},      // low differs
+            }) {
+        Histogram other(config);
+        other.add(3.);
+        EXPECT_FALSE(hist.merge(other));
+        EXPECT_EQ(before, hist.toString());
+        EXPECT_EQ(1u, hist.totalCount());
+    }
+}
+
+TEST(HistogramConfig, fromString) {
+    Histogram::Config config{};
+    ASSERT_TRUE(Histogram::Config::fromString("0.5,20,-1.5", &config));
+    EXPECT_EQ(0.5, config.binSize);
+    EXPECT_EQ(20u, config.numBins);
+    EXPECT_EQ(-1.5, config.low);
+
+    // the fields that follow the version in toString().
+    const Histogram hist(config);
+    const std::string s = hist.toString();
+    const size_t begin = s.find(',') + 1;
+    const size_t end = s.find(",{");
+    Histogram::Config parsed{};
+    ASSERT_TRUE(Histogram::Config::fromString(s.substr(begin, end - begin), &parsed));
+    EXPECT_EQ(config, parsed);
+}
+
+TEST(HistogramConfig, fromStringMalformed) {
+    const Histogram::Config initial{1., 2, 3.};
+    for (const char *s : {
+            "",
+            "0.5",
+            "0.5,20",
+            "0.5,20,",
+            "0.5;20;0",
+            "a,20,0",
+            "0.5,20,0,",        // trailing characters
+            "0.5,20,0x",
+            "0,20,0",           // binSize is not positive
+            "-0.5,20,0",
+            "nan,20,0",
+            "0.5,0,0",          // numBins is not positive
+            }) {
+        Histogram::Config config = initial;
+        EXPECT_FALSE(Histogram::Config::fromString(s, &config)) << s;
+        EXPECT_EQ(initial, config) << s;
+    }
+    EXPECT_FALSE(Histogram::Config::fromString("0.5,20,0", nullptr));
+}
+
+} // namespace
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "merger_tests"
+
+#include <stdlib.h>
+
+#include <memory>
+#include <set>
+#include <string>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <media/nblog/Merger.h>
+#include <media/nblog/Reader.h>
+#include <media/nblog/Timeline.h>
+#include <media/nblog/Writer.h>
+#include <utils/String16.h>
+#include <utils/Vector.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kLogSize = 4096;
+
+// The shared memory, writer and reader of one thread, as set up by AudioFlinger and
+// MediaLogService.
+class ThreadLog {
+public:
+    explicit ThreadLog(const char *name)
+        : mShared(calloc(1, NBLog::Timeline::sharedSize(kLogSize)))
+        , mWriter(sp<NBLog::Writer>::make(mShared, kLogSize))
+        , mReader(sp<NBLog::Reader>::make(mShared, kLogSize, name)) {}
+
+    ~ThreadLog() {
+        mWriter.clear();
+        mReader.clear();
+        free(mShared);
+    }
+
+    NBLog::Writer& writer() { return *mWriter; }
+    const sp<NBLog::Reader>& reader() const { return mReader; }
+
+    // Logs what a thread logs when it starts and then runs one cycle.
+    void logThread(audio_io_handle_t id, NBLog::ThreadType type) {
+        NBLog::thread_info_t info;
+        info.id = id;
+        info.type = type;
+        mWriter->log<NBLog::EVENT_THREAD_INFO>(info);
+        NBLog::thread_params_t params;
+        params.frameCount = 240;
+        params.sampleRate = 48000;
+        mWriter->log<NBLog::EVENT_THREAD_PARAMS>(params);
+        mWriter->log<NBLog::EVENT_WORK_TIME>(2000000 /* ns */);
+    }
+
+private:
+    void * const mShared;
+    sp<NBLog::Writer> mWriter;
+    sp<NBLog::Reader> mReader;
+};
+
+// Returns the thread types of the performance data dumped as JSON by the MergeReader.
+std::multiset<std::string> dumpedThreadTypes(NBLog::MergeReader &mergeReader) {
+    TemporaryFile file;
+    Vector<String16> args;
+    args.add(String16("--json"));
+    mergeReader.dump(file.fd, args);
+
+    std::string json;
+    EXPECT_TRUE(base::ReadFileToString(file.path, &json));
+    Json::Value root;
+    const std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    EXPECT_TRUE(reader->parse(json.data(), json.data() + json.size(), &root, nullptr)) << json;
+    std::multiset<std::string> types;
+    for (const Json::Value &thread : root) {
+        types.insert(thread["type"].asString());
+    }
+    return types;
+}
+
+TEST(MergeReader, exportsEveryIdentifiedThreadType) {
+    void * const mergerShared = calloc(1, NBLog::Timeline::sharedSize(kLogSize));
+    {
+        NBLog::Merger merger(mergerShared, kLogSize);
+        NBLog::MergeReader mergeReader(mergerShared, kLogSize, merger);
+
+        ThreadLog fastMixer("FastMixer");
+        ThreadLog fastCapture("FastCapture");
+        merger.addReader(fastMixer.reader());
+        merger.addReader(fastCapture.reader());
+
+        fastMixer.logThread(13, NBLog::FASTMIXER);
+        fastCapture.logThread(21, NBLog::FASTCAPTURE);
+        mergeReader.getAndProcessSnapshot();
+
+        const std::multiset<std::string> expected{"FASTCAPTURE", "FASTMIXER"};
+        EXPECT_EQ(expected, dumpedThreadTypes(mergeReader));
+    }
+    free(mergerShared);
+}
+
+} // namespace
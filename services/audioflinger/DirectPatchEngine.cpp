@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioFlinger::DirectPatchEngine"
+//#define LOG_NDEBUG 0
+#define ATRACE_TAG ATRACE_TAG_AUDIO
+
+#include "DirectPatchEngine.h"
+
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+#include <audio_utils/clock.h>
+#include <media/PatchBuilder.h>
+#include <mediautils/SchedulingPolicyService.h>
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+namespace android {
+
+using base::StringPrintf;
+
+// Same as the FastCapture and FastMixer threads, which the engine replaces on both ends.
+static constexpr int kPriorityDirectPatchEngine = 3;
+
+// Time to wait after a stream error before retrying, so that a failing HAL does not
+// make the thread spin.
+static constexpr useconds_t kErrorSleepUs = 10000;
+
+static audio_port_config mixPortConfig(audio_port_role_t role, audio_module_handle_t module,
+        audio_io_handle_t handle, const audio_config_base_t& config)
+{
+    audio_port_config port{};
+    port.role = role;
+    port.type = AUDIO_PORT_TYPE_MIX;
+    port.config_mask = AUDIO_PORT_CONFIG_SAMPLE_RATE | AUDIO_PORT_CONFIG_CHANNEL_MASK
+            | AUDIO_PORT_CONFIG_FORMAT;
+    port.sample_rate = config.sample_rate;
+    port.channel_mask = config.channel_mask;
+    port.format = config.format;
+    port.ext.mix.hw_module = module;
+    port.ext.mix.handle = handle;
+    if (role == AUDIO_PORT_ROLE_SINK) {
+        port.ext.mix.usecase.source = AUDIO_SOURCE_MIC;
+    } else {
+        port.ext.mix.usecase.stream = AUDIO_STREAM_PATCH;
+    }
+    return port;
+}
+
+static size_t bufferFrameCount(StreamHalInterface* stream, size_t frameSize)
+{
+    size_t bytes = 0;
+    if (stream->getBufferSize(&bytes) != OK || frameSize == 0) return 0;
+    return bytes / frameSize;
+}
+
+/* static */
+sp<DirectPatchEngine> DirectPatchEngine::create(
+        AudioHwDevice* inHwDev, audio_io_handle_t input,
+        AudioHwDevice* outHwDev, audio_io_handle_t output,
+        const struct audio_patch& patch)
+{
+    const audio_port_config& source = patch.sources[0];
+    const audio_port_config& sink = patch.sinks[0];
+
+    // open the sink with the requested properties, or the HAL defaults.
+    audio_config_t outConfig = AUDIO_CONFIG_INITIALIZER;
+    if (sink.config_mask & AUDIO_PORT_CONFIG_SAMPLE_RATE) {
+        outConfig.sample_rate = sink.sample_rate;
+    }
+    if (sink.config_mask & AUDIO_PORT_CONFIG_CHANNEL_MASK) {
+        outConfig.channel_mask = sink.channel_mask;
+    }
+    if (sink.config_mask & AUDIO_PORT_CONFIG_FORMAT) {
+        outConfig.format = sink.format;
+    }
+    const audio_output_flags_t outFlags = sink.config_mask & AUDIO_PORT_CONFIG_FLAGS
+            ? sink.flags.output : AUDIO_OUTPUT_FLAG_NONE;
+    AudioStreamOut* outStream = nullptr;
+    status_t status = outHwDev->openOutputStream(&outStream, output, sink.ext.device.type,
+            outFlags, &outConfig, sink.ext.device.address);
+    if (status != NO_ERROR || outStream == nullptr) {
+        ALOGW("%s: cannot open output for device %#x, status %d",
+                __func__, sink.ext.device.type, status);
+        return nullptr;
+    }
+    std::unique_ptr<AudioStreamOut> outOwner(outStream);
+    const audio_config_base_t outProperties = outStream->getAudioProperties();
+
+    // open the source with the requested properties, or default to the sink properties
+    // so that no conversion is needed.
+    audio_config_t inConfig = AUDIO_CONFIG_INITIALIZER;
+    inConfig.sample_rate = source.config_mask & AUDIO_PORT_CONFIG_SAMPLE_RATE
+            ? source.sample_rate : outProperties.sample_rate;
+    inConfig.channel_mask = source.config_mask & AUDIO_PORT_CONFIG_CHANNEL_MASK
+            ? source.channel_mask
+            : audio_channel_in_mask_from_count(
+                    audio_channel_count_from_out_mask(outProperties.channel_mask));
+    inConfig.format = source.config_mask & AUDIO_PORT_CONFIG_FORMAT
+            ? source.format : outProperties.format;
+    const audio_input_flags_t inFlags = source.config_mask & AUDIO_PORT_CONFIG_FLAGS
+            ? source.flags.input : AUDIO_INPUT_FLAG_NONE;
+    AudioStreamIn* inStream = nullptr;
+    status = inHwDev->openInputStream(&inStream, input, source.ext.device.type, inFlags,
+            &inConfig, source.ext.device.address, AUDIO_SOURCE_MIC,
+            sink.ext.device.type, sink.ext.device.address);
+    if (status != NO_ERROR || inStream == nullptr) {
+        ALOGW("%s: cannot open input for device %#x, status %d",
+                __func__, source.ext.device.type, status);
+        return nullptr;
+    }
+
+    sp<DirectPatchEngine> engine = sp<DirectPatchEngine>::make(
+            inHwDev, input, inStream, outHwDev, output, outOwner.release());
+    status = engine->initialize(patch);
+    if (status != NO_ERROR) {
+        ALOGW("%s: cannot initialize, status %d", __func__, status);
+        return nullptr;
+    }
+    return engine;
+}
+
+DirectPatchEngine::DirectPatchEngine(
+        AudioHwDevice* inHwDev, audio_io_handle_t input, AudioStreamIn* inStream,
+        AudioHwDevice* outHwDev, audio_io_handle_t output, AudioStreamOut* outStream)
+    : Thread(false /* canCallJava */)
+    , mInHwDev(inHwDev)
+    , mInput(input)
+    , mInStream(inStream)
+    , mOutHwDev(outHwDev)
+    , mOutput(output)
+    , mOutStream(outStream)
+{
+}
+
+DirectPatchEngine::~DirectPatchEngine()
+{
+    stop();
+    if (mInHalPatch != AUDIO_PATCH_HANDLE_NONE) {
+        mInHwDev->hwDevice()->releaseAudioPatch(mInHalPatch);
+    }
+    if (mOutHalPatch != AUDIO_PATCH_HANDLE_NONE) {
+        mOutHwDev->hwDevice()->releaseAudioPatch(mOutHalPatch);
+    }
+    mInStream->standby();
+    mOutStream->standby();
+}
+
+status_t DirectPatchEngine::initialize(const struct audio_patch& patch)
+{
+    mInConfig = mInStream->getAudioProperties();
+    mOutConfig = mOutStream->getAudioProperties();
+    if (!audio_is_linear_pcm(mInConfig.format) || !audio_is_linear_pcm(mOutConfig.format)) {
+        return BAD_VALUE;
+    }
+    mInFrameSize = mInStream->getFrameSize();
+    mOutFrameSize = mOutStream->getFrameSize();
+    mInFrameCount = bufferFrameCount(mInStream->stream.get(), mInFrameSize);
+    mOutFrameCount = bufferFrameCount(mOutStream->stream.get(), mOutFrameSize);
+    if (mInFrameCount == 0 || mOutFrameCount == 0) {
+        return NO_INIT;
+    }
+
+    const uint32_t outChannelCount = audio_channel_count_from_out_mask(mOutConfig.channel_mask);
+    const bool matched = mInConfig.sample_rate == mOutConfig.sample_rate
+            && mInConfig.format == mOutConfig.format
+            && audio_channel_count_from_in_mask(mInConfig.channel_mask) == outChannelCount;
+    if (matched) {
+        // read the source straight into the sink buffer
+        mSinkBuffer.reset(new uint8_t[std::max(mInFrameCount, mOutFrameCount) * mOutFrameSize]);
+    } else {
+        mConverter = std::make_unique<RecordBufferConverter>(
+                mInConfig.channel_mask, mInConfig.format, mInConfig.sample_rate,
+                audio_channel_in_mask_from_count(outChannelCount),
+                mOutConfig.format, mOutConfig.sample_rate);
+        if (mConverter->initCheck() != NO_ERROR) {
+            return BAD_VALUE;
+        }
+        mSourceBuffer.reset(new uint8_t[mInFrameCount * mInFrameSize]);
+        mSinkBuffer.reset(new uint8_t[mOutFrameCount * mOutFrameSize]);
+    }
+
+    status_t status = mInHwDev->hwDevice()->createAudioPatch(1, &patch.sources[0], 1,
+            PatchBuilder().addSink(mixPortConfig(AUDIO_PORT_ROLE_SINK,
+                    mInHwDev->handle(), mInput, mInConfig)).patch()->sinks,
+            &mInHalPatch);
+    if (status != NO_ERROR) {
+        mInHalPatch = AUDIO_PATCH_HANDLE_NONE;
+        return status;
+    }
+    status = mOutHwDev->hwDevice()->createAudioPatch(1,
+            PatchBuilder().addSource(mixPortConfig(AUDIO_PORT_ROLE_SOURCE,
+                    mOutHwDev->handle(), mOutput, mOutConfig)).patch()->sources,
+            1, &patch.sinks[0], &mOutHalPatch);
+    if (status != NO_ERROR) {
+        mOutHalPatch = AUDIO_PATCH_HANDLE_NONE;
+        return status;
+    }
+    ALOGV("%s: %s", __func__, toString().c_str());
+    return NO_ERROR;
+}
+
+status_t DirectPatchEngine::start()
+{
+    return run("DirectPatch", ANDROID_PRIORITY_URGENT_AUDIO);
+}
+
+void DirectPatchEngine::stop()
+{
+    requestExitAndWait();
+}
+
+status_t DirectPatchEngine::readyToRun()
+{
+    const status_t status = requestPriority(getpid(), gettid(), kPriorityDirectPatchEngine,
+            false /* isForApp */, true /* asynchronous */);
+    if (status != OK) {
+        ALOGW("%s: cannot request priority, status %d", __func__, status);
+    } else {
+        mInStream->stream->setHalThreadPriority(kPriorityDirectPatchEngine);
+        mOutStream->stream->setHalThreadPriority(kPriorityDirectPatchEngine);
+    }
+    return NO_ERROR;
+}
+
+bool DirectPatchEngine::threadLoop()
+{
+    size_t frames;
+    if (mConverter == nullptr) {
+        frames = readSource();
+    } else {
+        frames = mConverter->convert(mSinkBuffer.get(), &mSourceBufferProvider, mOutFrameCount);
+    }
+    if (frames == 0) {
+        usleep(kErrorSleepUs);
+        return true;
+    }
+    if (!writeSink(frames)) {
+        usleep(kErrorSleepUs);
+        return true;
+    }
+    updateLatency();
+    mCycles.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t DirectPatchEngine::readSource()
+{
+    ATRACE_NAME("read");
+    uint8_t* const buffer = mConverter == nullptr ? mSinkBuffer.get() : mSourceBuffer.get();
+    size_t bytesRead = 0;
+    const status_t status = mInStream->read(buffer, mInFrameCount * mInFrameSize, &bytesRead);
+    if (status != NO_ERROR) {
+        mReadErrors.fetch_add(1, std::memory_order_relaxed);
+        mInStream->standby();
+        return 0;
+    }
+    const size_t frames = bytesRead / mInFrameSize;
+    mFramesRead += frames;
+    return frames;
+}
+
+bool DirectPatchEngine::writeSink(size_t frames)
+{
+    ATRACE_NAME("write");
+    const uint8_t* buffer = mSinkBuffer.get();
+    size_t bytes = frames * mOutFrameSize;
+    while (bytes > 0) {
+        const ssize_t written = mOutStream->write(buffer, bytes);
+        if (written <= 0) {
+            mWriteErrors.fetch_add(1, std::memory_order_relaxed);
+            mOutStream->standby();
+            return false;
+        }
+        buffer += written;
+        bytes -= written;
+        mFramesWritten += written / mOutFrameSize;
+    }
+    return true;
+}
+
+// The last written sink frame was converted from the last consumed source frame.
+// Its latency is its presentation time on the sink timeline minus its capture time
+// on the source timeline, both extrapolated from the latest HAL timestamps.
+void DirectPatchEngine::updateLatency()
+{
+    int64_t capturedFrames, captureTimeNs;
+    uint64_t presentedFrames;
+    struct timespec presentedTime;
+    if (mInStream->getCapturePosition(&capturedFrames, &captureTimeNs) != OK
+            || mOutStream->getPresentationPosition(&presentedFrames, &presentedTime) != OK) {
+        return;
+    }
+    const int64_t consumedFrames = mFramesRead - (int64_t)mSourceAvailable;
+    const double latencyMs =
+            (audio_utils_ns_from_timespec(&presentedTime) - captureTimeNs) * 1e-6
+            + (mFramesWritten - (int64_t)presentedFrames) * 1e3 / mOutConfig.sample_rate
+            - (consumedFrames - capturedFrames) * 1e3 / mInConfig.sample_rate;
+    mLatencyMs.store(latencyMs, std::memory_order_relaxed);
+}
+
+status_t DirectPatchEngine::getLatencyMs(double* latencyMs) const
+{
+    const double latency = mLatencyMs.load(std::memory_order_relaxed);
+    if (latency < 0.) return INVALID_OPERATION;
+    *latencyMs = latency;
+    return OK;
+}
+
+std::string DirectPatchEngine::toString() const
+{
+    return StringPrintf("direct engine: input %d (%u Hz, %#x, %#x, %zu frames)"
+            " => output %d (%u Hz, %#x, %#x, %zu frames)%s"
+            " cycles %lld read errors %lld write errors %lld",
+            mInput, mInConfig.sample_rate, mInConfig.channel_mask, mInConfig.format,
+            mInFrameCount,
+            mOutput, mOutConfig.sample_rate, mOutConfig.channel_mask, mOutConfig.format,
+            mOutFrameCount,
+            mConverter != nullptr ? " converted" : "",
+            (long long)mCycles.load(std::memory_order_relaxed),
+            (long long)mReadErrors.load(std::memory_order_relaxed),
+            (long long)mWriteErrors.load(std::memory_order_relaxed));
+}
+
+status_t DirectPatchEngine::SourceBufferProvider::getNextBuffer(Buffer* buffer)
+{
+    if (mEngine.mSourceAvailable == 0) {
+        mEngine.mSourceOffset = 0;
+        mEngine.mSourceAvailable = mEngine.readSource();
+        if (mEngine.mSourceAvailable == 0) {
+            buffer->frameCount = 0;
+            buffer->raw = nullptr;
+            return NOT_ENOUGH_DATA;
+        }
+    }
+    buffer->frameCount = std::min(buffer->frameCount, mEngine.mSourceAvailable);
+    buffer->raw = mEngine.mSourceBuffer.get() + mEngine.mSourceOffset * mEngine.mInFrameSize;
+    return NO_ERROR;
+}
+
+void DirectPatchEngine::SourceBufferProvider::releaseBuffer(Buffer* buffer)
+{
+    mEngine.mSourceOffset += buffer->frameCount;
+    mEngine.mSourceAvailable -= buffer->frameCount;
+    buffer->frameCount = 0;
+    buffer->raw = nullptr;
+}
+
+}  // namespace android
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <datapath/AudioHwDevice.h>
+#include <datapath/AudioStreamIn.h>
+#include <datapath/AudioStreamOut.h>
+#include <media/AudioBufferProvider.h>
+#include <media/RecordBufferConverter.h>
+#include <utils/RefBase.h>  // avoid transitive dependency
+#include <utils/Thread.h>  // avoid transitive dependency
+
+namespace android {
+
+// DirectPatchEngine is a device to device software patch which does not use a RecordThread,
+// PlaybackThread, PatchRecord and PatchTrack. It opens the source input stream and the sink
+// output stream itself, routes them with HAL patches, and moves the audio from one to the
+// other on a single real-time thread. If the streams do not have the same configuration,
+// format, channel mask and sample rate are converted in a single RecordBufferConverter stage.
+//
+// As there is no thread which could apply legacy routing, the engine requires both
+// HW modules to support audio patches.
+class DirectPatchEngine : public Thread {
+public:
+    // Opens the streams and HAL patches for the first source and sink of patch.
+    // Returns nullptr if this fails, in which case nothing is left open.
+    static sp<DirectPatchEngine> create(
+            AudioHwDevice* inHwDev, audio_io_handle_t input,
+            AudioHwDevice* outHwDev, audio_io_handle_t output,
+            const struct audio_patch& patch);
+
+    ~DirectPatchEngine() override;
+
+    // Starts transferring audio.
+    status_t start();
+    // Stops transferring audio and waits until the transfer thread has exited.
+    // The streams and HAL patches are released by the destructor.
+    void stop();
+
+    // Returns the latency from capture by the source device to presentation by
+    // the sink device, as last measured by the transfer thread.
+    status_t getLatencyMs(double* latencyMs) const;
+
+    std::string toString() const;
+
+private:
+    // Provides the source stream data to the converter.
+    class SourceBufferProvider : public AudioBufferProvider {
+    public:
+        explicit SourceBufferProvider(DirectPatchEngine& engine) : mEngine(engine) {}
+        status_t getNextBuffer(Buffer* buffer) override;
+        void releaseBuffer(Buffer* buffer) override;
+    private:
+        DirectPatchEngine& mEngine;
+    };
+
+    DirectPatchEngine(AudioHwDevice* inHwDev, audio_io_handle_t input, AudioStreamIn* inStream,
+            AudioHwDevice* outHwDev, audio_io_handle_t output, AudioStreamOut* outStream);
+
+    status_t initialize(const struct audio_patch& patch);
+
+    // Thread virtuals
+    status_t readyToRun() override;
+    bool threadLoop() override;
+
+    // Reads one source buffer into mSourceBuffer, returns the number of frames read.
+    size_t readSource();
+    // Writes frames of mSinkBuffer to the sink stream, returns false on error.
+    bool writeSink(size_t frames);
+    void updateLatency();
+
+    AudioHwDevice* const                 mInHwDev;
+    const audio_io_handle_t              mInput;
+    const std::unique_ptr<AudioStreamIn> mInStream;
+    AudioHwDevice* const                 mOutHwDev;
+    const audio_io_handle_t              mOutput;
+    const std::unique_ptr<AudioStreamOut> mOutStream;
+
+    audio_patch_handle_t mInHalPatch = AUDIO_PATCH_HANDLE_NONE;
+    audio_patch_handle_t mOutHalPatch = AUDIO_PATCH_HANDLE_NONE;
+
+    audio_config_base_t mInConfig{};
+    audio_config_base_t mOutConfig{};
+    size_t              mInFrameSize = 0;
+    size_t              mOutFrameSize = 0;
+    size_t              mInFrameCount = 0;     // frames per source read
+    size_t              mOutFrameCount = 0;    // frames per sink write
+
+    // Only used if the streams do not match, otherwise the source is read into mSinkBuffer.
+    std::unique_ptr<RecordBufferConverter> mConverter;
+    SourceBufferProvider                   mSourceBufferProvider{*this};
+    std::unique_ptr<uint8_t[]>             mSourceBuffer;
+    size_t                                 mSourceOffset = 0;     // frames
+    size_t                                 mSourceAvailable = 0;  // frames
+
+    std::unique_ptr<uint8_t[]> mSinkBuffer;
+
+    // Accessed by the transfer thread only.
+    int64_t mFramesRead = 0;
+    int64_t mFramesWritten = 0;
+
+    // Written by the transfer thread, read by dump and getLatencyMs.
+    std::atomic<int64_t> mCycles = 0;
+    std::atomic<int64_t> mReadErrors = 0;
+    std::atomic<int64_t> mWriteErrors = 0;
+    std::atomic<double>  mLatencyMs = -1.;     // negative if unknown
+};
+
+}  // namespace android
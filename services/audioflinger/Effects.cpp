@@ -24,9 +24,13 @@
 #include "Client.h"
 #include "EffectConfiguration.h"
 
+#include <VisualizerAnalysis.h>
 #include <afutils/DumpTryLock.h>
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
+#include <binder/MemoryBase.h>
+#include <binder/MemoryHeapBase.h>
+#include <cutils/properties.h>
 #include <media/AudioCommonTypes.h>
 #include <media/AudioContainers.h>
 #include <media/AudioDeviceTypeAddr.h>
@@ -709,6 +713,7 @@ void EffectModule::process()
     };
 
     if (isProcessEnabled()) {
+        const nsecs_t startNs = systemTime();
         int ret;
         if (isProcessImplemented()) {
             if (auxType) {
@@ -734,6 +739,10 @@ void EffectModule::process()
                         * mInChannelCountRequested * mConfig.inputCfg.buffer.frameCount);
                 inBuffer = mInConversionBuffer;
             }
+            if (mAnalysis != nullptr) {
+                mAnalysis->process(inBuffer->audioBuffer()->f32,
+                        mConfig.inputCfg.buffer.frameCount);
+            }
             if (mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE
                     && mOutChannelCountRequested != outChannelCount) {
                 adjust_selected_channels(
@@ -809,6 +818,16 @@ void EffectModule::process()
                     mConfig.inputCfg.buffer.frameCount * inChannelCount * sizeof(float);
             memset(mConfig.inputCfg.buffer.raw, 0, size);
         }
+
+        // process() is only called by the thread owning the chain: no need for atomic updates.
+        const int64_t processNs = systemTime() - startNs;
+        mProcessCount.store(mProcessCount.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        mProcessTotalNs.store(mProcessTotalNs.load(std::memory_order_relaxed) + processNs,
+                std::memory_order_relaxed);
+        if (processNs > mProcessMaxNs.load(std::memory_order_relaxed)) {
+            mProcessMaxNs.store(processNs, std::memory_order_relaxed);
+        }
     } else if ((mDescriptor.flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_INSERT &&
                 // mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw
                 mConfig.inputCfg.buffer.raw != mConfig.outputCfg.buffer.raw) {
@@ -999,6 +1018,25 @@ status_t EffectModule::configure_l()
                     &buf32,
                     &size,
                     &cmdStatus);
+
+            bool analyzing;
+            {
+                audio_utils::lock_guard _l(mutex());
+                analyzing = mAnalysis != nullptr;
+            }
+            if (analyzing) {
+                // configured before taking the mutex, as process() waits for it, and as
+                // configure() allocates. The replaced analysis is freed after releasing it.
+                auto analysis = std::make_unique<VisualizerAnalysis>();
+                analysis->configure(mConfig.inputCfg.samplingRate,
+                        static_cast<audio_channel_mask_t>(mConfig.inputCfg.channels));
+                audio_utils::lock_guard _l(mutex());
+                if (mAnalysis != nullptr) {
+                    analysis->setRing(static_cast<visualizer_analysis_ring_t*>(
+                            mAnalysisMemory->unsecurePointer()), false /* initialize */);
+                    std::swap(mAnalysis, analysis);
+                }
+            }
         }
     }
 
@@ -1604,6 +1642,84 @@ status_t EffectModule::getConfigs_l(audio_config_base_t* inputCfg, audio_config_
     return NO_ERROR;
 }
 
+status_t EffectModule::acquireAnalysis(sp<IMemory>* memory) {
+    if (memcmp(&mDescriptor.type, SL_IID_VISUALIZATION, sizeof(effect_uuid_t)) != 0) {
+        return INVALID_OPERATION;
+    }
+    // The analysis and its memory are built before taking the mutex, as process() waits for
+    // it, and only installed under it.
+    sp<IMemory> analysisMemory;
+    uint32_t sampleRate;
+    audio_channel_mask_t channelMask;
+    {
+        audio_utils::lock_guard _l(mutex());
+        if (mAnalysisClients > 0) {
+            ++mAnalysisClients;
+            *memory = mAnalysisMemory;
+            return NO_ERROR;
+        }
+        analysisMemory = mAnalysisMemory;
+        sampleRate = mConfig.inputCfg.samplingRate;
+        channelMask = static_cast<audio_channel_mask_t>(mConfig.inputCfg.channels);
+    }
+    const bool newMemory = analysisMemory == nullptr;
+    if (newMemory) {
+        const size_t size = sizeof(visualizer_analysis_ring_t);
+        const auto heap = sp<MemoryHeapBase>::make(
+                size, MemoryHeapBase::READ_ONLY, "EffectModule analysis");
+        if (heap->getHeapID() < 0) {
+            ALOGE("%s cannot allocate %zu bytes", __func__, size);
+            return NO_MEMORY;
+        }
+        analysisMemory = sp<MemoryBase>::make(heap, 0, size);
+    }
+    for (;;) {
+        // declared before the lock, so that an unused analysis is freed after releasing it.
+        auto analysis = std::make_unique<VisualizerAnalysis>();
+        analysis->configure(sampleRate, channelMask);
+        if (newMemory) {
+            // no other thread sees the new memory yet, initialize its ring here.
+            analysis->setRing(
+                    static_cast<visualizer_analysis_ring_t*>(analysisMemory->unsecurePointer()));
+        }
+
+        audio_utils::lock_guard _l(mutex());
+        if (mAnalysisClients > 0) {  // installed by another client meanwhile
+            ++mAnalysisClients;
+            *memory = mAnalysisMemory;
+            return NO_ERROR;
+        }
+        if (sampleRate != mConfig.inputCfg.samplingRate
+                || channelMask != mConfig.inputCfg.channels) {
+            // reconfigured meanwhile, configure again without the mutex.
+            sampleRate = mConfig.inputCfg.samplingRate;
+            channelMask = static_cast<audio_channel_mask_t>(mConfig.inputCfg.channels);
+            continue;
+        }
+        if (mAnalysisMemory == nullptr) {
+            mAnalysisMemory = analysisMemory;
+        }
+        ++mAnalysisClients;
+        if (mAnalysisMemory != analysisMemory || !newMemory) {
+            // the memory of previous clients, which another acquireAnalysis() may also be
+            // about to install.
+            analysis->setRing(
+                    static_cast<visualizer_analysis_ring_t*>(mAnalysisMemory->unsecurePointer()));
+        }
+        mAnalysis = std::move(analysis);
+        *memory = mAnalysisMemory;
+        return NO_ERROR;
+    }
+}
+
+void EffectModule::releaseAnalysis() {
+    std::unique_ptr<VisualizerAnalysis> analysis; // freed after releasing the mutex
+    audio_utils::lock_guard _l(mutex());
+    if (mAnalysisClients > 0 && --mAnalysisClients == 0) {
+        analysis = std::move(mAnalysis);
+    }
+}
+
 status_t EffectModule::sendMetadata_ll(const std::vector<playback_track_metadata_v7_t>& metadata) {
     if (mStatus != NO_ERROR) {
         return mStatus;
@@ -1689,6 +1805,13 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
             dumpInOutBuffer(false /* isInput */, mOutBuffer).c_str(),
             dumpInOutBuffer(false /* isInput */, mOutConversionBuffer).c_str());
 
+    const int64_t processCount = mProcessCount.load(std::memory_order_relaxed);
+    result.appendFormat("\t\t- process: %lld calls, average %.1f us, max %.1f us\n",
+            (long long)processCount,
+            processCount > 0
+                    ? mProcessTotalNs.load(std::memory_order_relaxed) * 1e-3 / processCount : 0.,
+            mProcessMaxNs.load(std::memory_order_relaxed) * 1e-3);
+
     write(fd, result.c_str(), result.length());
 
     if (mEffectInterface != 0) {
@@ -1768,6 +1891,7 @@ BINDER_METHOD_ENTRY(command) \
 BINDER_METHOD_ENTRY(disconnect) \
 BINDER_METHOD_ENTRY(getCblk) \
 BINDER_METHOD_ENTRY(getConfig) \
+BINDER_METHOD_ENTRY(getAnalysisRegion) \
 
 // singleton for Binder Method Statistics for IEffect
 mediautils::MethodStatistics<int>& getIEffectStatistics() {
@@ -1904,6 +2028,10 @@ void EffectHandle::disconnect(bool unpinIfLast)
     {
         sp<IAfEffectBase> effect = mEffect.promote();
         if (effect != 0) {
+            if (mAnalysisMemory != nullptr) {
+                effect->asEffectModule()->releaseAnalysis();
+                mAnalysisMemory.clear();
+            }
             if (effect->disconnectHandle(this, unpinIfLast) > 0) {
                 ALOGW("%s Effect handle %p disconnected after thread destruction",
                     __func__, this);
@@ -1955,6 +2083,29 @@ Status EffectHandle::getConfig(
     RETURN(status);
 }
 
+Status EffectHandle::getAnalysisRegion(
+        media::SharedFileRegion* _region, int32_t* _aidl_return) {
+    audio_utils::lock_guard _l(mutex());
+    sp<IAfEffectBase> effect = mEffect.promote();
+    if (effect == nullptr || mDisconnected) {
+        RETURN(DEAD_OBJECT);
+    }
+    sp<IAfEffectModule> effectModule = effect->asEffectModule();
+    if (effectModule == nullptr) {
+        RETURN(INVALID_OPERATION);
+    }
+    if (mAnalysisMemory == nullptr) {
+        const status_t status = effectModule->acquireAnalysis(&mAnalysisMemory);
+        if (status != NO_ERROR) {
+            RETURN(status);
+        }
+    }
+    if (!convertIMemoryToSharedFileRegion(mAnalysisMemory, _region)) {
+        RETURN(NO_MEMORY);
+    }
+    RETURN(NO_ERROR);
+}
+
 Status EffectHandle::command(int32_t cmdCode,
                        const std::vector<uint8_t>& cmdData,
                        int32_t maxResponseSize,
@@ -2160,7 +2311,8 @@ EffectChain::EffectChain(const sp<IAfThreadBase>& thread,
     : mSessionId(sessionId), mActiveTrackCnt(0), mTrackCnt(0), mTailBufferCount(0),
       mLeftVolume(UINT_MAX), mRightVolume(UINT_MAX),
       mNewLeftVolume(UINT_MAX), mNewRightVolume(UINT_MAX),
-      mEffectCallback(new EffectCallback(wp<EffectChain>(this), thread))
+      mEffectCallback(new EffectCallback(wp<EffectChain>(this), thread)),
+      mInPlaceAllowed(property_get_bool("af.effect.chain_in_place", false /* default_value */))
 {
     mStrategy = thread->getStrategyForStream(AUDIO_STREAM_MUSIC);
     mMaxTailBuffers = ((kProcessTailDurationMs * thread->sampleRate()) / 1000) /
@@ -2276,6 +2428,11 @@ void EffectChain::process_l() {
         for (size_t i = 0; i < size; i++) {
             mEffects[i]->process();
         }
+        if (mInPlace) {
+            // all insert effects processed in place, accumulate their output once.
+            accumulate_float(mOutBuffer->audioBuffer()->f32, mInBuffer->audioBuffer()->f32,
+                    mInPlaceSampleCount);
+        }
         mInBuffer->commit();
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
@@ -2392,10 +2549,57 @@ status_t EffectChain::addEffect_ll(const sp<IAfEffectModule>& effect)
                 __func__, effect.get(), this, idx_insert);
     }
     effect->configure_l();
+    updateInPlace_l();
 
     return NO_ERROR;
 }
 
+// In the fused in-place mode, the last insert effect of a non global session chain
+// processes in place on the chain input buffer like the other insert effects, and
+// process_l() accumulates the chain input buffer onto the chain output buffer in a
+// single pass. Otherwise the last effect accumulates itself, which costs an extra
+// pass for effects processing into a work buffer, converting to int16_t or adjusting
+// channels, and a copy or accumulate in EffectModule::process() while it is idle.
+void EffectChain::updateInPlace_l()
+{
+    if (!mInPlaceAllowed) {
+        return;
+    }
+    mInPlace = false;
+    mInPlaceSampleCount = 0;
+    if (mEffects.isEmpty() || mInBuffer == nullptr || mOutBuffer == nullptr) {
+        return;
+    }
+    const sp<IAfEffectModule> last = mEffects[mEffects.size() - 1];
+    if ((last->desc().flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_AUXILIARY) {
+        return;
+    }
+    const uint32_t channelCount =
+            audio_channel_count_from_out_mask(mEffectCallback->outChannelMask());
+    if (!audio_is_global_session(mSessionId)
+            && mInBuffer->ptr() != mOutBuffer->ptr()
+            && channelCount == audio_channel_count_from_out_mask(
+                    mEffectCallback->inChannelMask(last->id()))) {
+        mInPlace = true;
+        // the haptic generator writes haptic channels beyond the chain channel count.
+        for (size_t i = 0; i < mEffects.size(); i++) {
+            if (mEffects[i]->isHapticGenerator()) {
+                mInPlace = false;
+                break;
+            }
+        }
+    }
+    if (mInPlace) {
+        mInPlaceSampleCount = channelCount * mEffectCallback->frameCount();
+    }
+    const sp<EffectBufferHalInterface>& outBuffer = mInPlace ? mInBuffer : mOutBuffer;
+    if (last->outBuffer() != reinterpret_cast<int16_t*>(outBuffer->ptr())) {
+        last->configure_l();
+        last->setOutBuffer(outBuffer);
+        last->updateAccessMode_l();      // reconfig if needed.
+    }
+}
+
 std::optional<size_t> EffectChain::findVolumeControl_l(size_t from, size_t to) const {
     for (size_t i = std::min(to, mEffects.size()); i > from; i--) {
         if (mEffects[i - 1]->isVolumeControlEnabled_l()) {
@@ -2517,6 +2721,8 @@ size_t EffectChain::removeEffect_l(const sp<IAfEffectModule>& effect,
                 mEffects[0]->updateAccessMode_l();      // reconfig if needed.
             }
 
+            updateInPlace_l();
+
             ALOGV("removeEffect_l() effect %p, removed from chain %p at rank %zu", effect.get(),
                     this, i);
             break;
@@ -2714,6 +2920,9 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
                 (int)outBufferStr.size(), "Out buffer      ");
         result.appendFormat("\t%s   %s   %d\n",
                 inBufferStr.c_str(), outBufferStr.c_str(), mActiveTrackCnt);
+        if (mInPlaceAllowed) {
+            result.appendFormat("\tFused in-place: %s\n", mInPlace ? "yes" : "no");
+        }
         write(fd, result.c_str(), result.size());
 
         for (size_t i = 0; i < numEffects; ++i) {
@@ -3480,6 +3689,9 @@ NO_THREAD_SAFETY_ANALYSIS
             mHalEffect.clear();
             mDevicePort.id = AUDIO_PORT_HANDLE_NONE;
         }
+    } else if (patch.mDirectEngine != nullptr) {
+        // a direct software patch has no thread to host the effect
+        status = INVALID_OPERATION;
     } else if (patch.isSoftware() || patch.thread().promote() != nullptr) {
         sp<IAfThreadBase> thread;
         if (audio_port_config_has_input_direction(port)) {
@@ -24,10 +24,14 @@
 #include <mediautils/Synchronization.h>
 #include <private/media/AudioEffectShared.h>
 
+#include <atomic>
 #include <map>  // avoid transitive dependency
+#include <memory>
 
 namespace android {
 
+class VisualizerAnalysis;
+
 //--- Audio Effect Management
 
 // EffectBase(EffectModule) and EffectChain classes both have their own mutex to protect
@@ -245,6 +249,9 @@ public:
                           bool* isOutput) const final
             REQUIRES(audio_utils::EffectHandle_Mutex) EXCLUDES_EffectBase_Mutex;
 
+    status_t acquireAnalysis(sp<IMemory>* memory) final EXCLUDES_EffectBase_Mutex;
+    void releaseAnalysis() final EXCLUDES_EffectBase_Mutex;
+
     void dump(int fd, const Vector<String16>& args) const final;
 
 private:
@@ -284,6 +291,17 @@ private:
     uint32_t mInChannelCountRequested;
     uint32_t mOutChannelCountRequested;
 
+    // Time spent in process() while processing is enabled, reported by dump().
+    std::atomic<int64_t> mProcessCount = 0;
+    std::atomic<int64_t> mProcessTotalNs = 0;
+    std::atomic<int64_t> mProcessMaxNs = 0;
+
+    // Visualizer analysis, run by process() while mAnalysisClients > 0.
+    // mAnalysisMemory is allocated on first use, and kept for the next clients.
+    std::unique_ptr<VisualizerAnalysis> mAnalysis;
+    sp<IMemory> mAnalysisMemory;
+    int32_t mAnalysisClients = 0;
+
     template <typename MUTEX>
     class AutoLockReentrant {
     public:
@@ -334,6 +352,8 @@ public:
     android::binder::Status getCblk(media::SharedFileRegion* _aidl_return) final;
     android::binder::Status getConfig(media::EffectConfig* _config,
                                       int32_t* _aidl_return) final;
+    android::binder::Status getAnalysisRegion(media::SharedFileRegion* _region,
+                                              int32_t* _aidl_return) final;
 
     const sp<Client>& client() const final { return mClient; }
 
@@ -389,6 +409,7 @@ private:
     sp<IMemory> mCblkMemory;                 // shared memory for control block
     effect_param_cblk_t* mCblk;              // control block for deferred parameter setting via
                                              // shared memory
+    sp<IMemory> mAnalysisMemory;             // Visualizer analysis, if requested by the client
     uint8_t* mBuffer;                        // pointer to parameter area in shared memory
     int mPriority;                           // client application priority to control the effect
     bool mHasControl;                        // true if this handle is controlling the effect
@@ -667,6 +688,9 @@ public:
     std::optional<size_t> findVolumeControl_l(size_t from, size_t to) const
             REQUIRES(audio_utils::EffectChain_Mutex);
 
+    // Selects the output buffer of the last insert effect for the fused in-place mode.
+    void updateInPlace_l() REQUIRES(audio_utils::EffectChain_Mutex);
+
     // mutex protecting effect list
     mutable audio_utils::mutex mMutex{audio_utils::MutexOrder::kEffectChain_Mutex};
              Vector<sp<IAfEffectModule>> mEffects; // list of effect modules
@@ -694,6 +718,11 @@ public:
              const sp<EffectCallback> mEffectCallback;
 
              wp<IAfEffectModule> mVolumeControlEffect;
+
+             // Fused in-place mode, enabled by property af.effect.chain_in_place.
+             const bool mInPlaceAllowed;
+             bool mInPlace = false;           // last insert effect writes to mInBuffer
+             size_t mInPlaceSampleCount = 0;  // samples accumulated onto mOutBuffer
 };
 
 class DeviceEffectProxy : public IAfDeviceEffectProxy, public EffectBase {
@@ -176,6 +176,12 @@ public:
                                   bool* isOutput) const
             REQUIRES(audio_utils::EffectHandle_Mutex) EXCLUDES_EffectBase_Mutex = 0;
 
+    // Starts the analysis of a Visualizer input, if not done yet for another handle, and returns
+    // the read only memory it is published in, see IEffect::getAnalysisRegion().
+    // Each successful call is balanced by releaseAnalysis().
+    virtual status_t acquireAnalysis(sp<IMemory>* memory) EXCLUDES_EffectBase_Mutex = 0;
+    virtual void releaseAnalysis() EXCLUDES_EffectBase_Mutex = 0;
+
     static bool isHapticGenerator(const effect_uuid_t* type);
     virtual bool isHapticGenerator() const = 0;
     static bool isSpatializer(const effect_uuid_t* type);
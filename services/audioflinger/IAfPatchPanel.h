@@ -18,6 +18,7 @@
 
 // The following includes are required because we have class definitions below
 // for EndPoint and Patch, which precludes using a forward declaration only.
+#include "DirectPatchEngine.h"
 #include "IAfThread.h"  // IAfThreadBase IAfMmapThread IAfPlaybackThread IAfRecordThread
 #include "IAfTrack.h"   // IAfPatchRecord IAfPatchTrack
 
@@ -205,6 +206,7 @@ public:
             mRecord = other.mRecord;
             mThread = other.mThread;
             mIsEndpointPatch = other.mIsEndpointPatch;
+            mDirectEngine = other.mDirectEngine;
         }
         Patch(Patch&& other) noexcept { swap(other); }
         Patch& operator=(Patch&& other) noexcept {
@@ -220,6 +222,7 @@ public:
             swap(mRecord, other.mRecord);
             swap(mThread, other.mThread);
             swap(mIsEndpointPatch, other.mIsEndpointPatch);
+            swap(mDirectEngine, other.mDirectEngine);
         }
 
         friend void swap(Patch& a, Patch& b) noexcept { a.swap(b); }
@@ -230,7 +233,8 @@ public:
                 REQUIRES(audio_utils::AudioFlinger_Mutex);
         bool isSoftware() const {
             return mRecord.handle() != AUDIO_PATCH_HANDLE_NONE ||
-                   mPlayback.handle() != AUDIO_PATCH_HANDLE_NONE;
+                   mPlayback.handle() != AUDIO_PATCH_HANDLE_NONE ||
+                   mDirectEngine != nullptr;
         }
 
         void setThread(const sp<IAfThreadBase>& thread) { mThread = thread; }
@@ -256,6 +260,9 @@ public:
 
         wp<IAfThreadBase> mThread;
         bool mIsEndpointPatch;
+        // replaces mPlayback and mRecord for a device to device software patch which
+        // is run without threads and tracks, see PatchPanel::createDirectConnections_l()
+        sp<DirectPatchEngine> mDirectEngine;
     };
 
     /* List connected audio ports and their attributes */
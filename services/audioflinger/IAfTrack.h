@@ -334,6 +334,13 @@ public:
     virtual void setAppMute(bool val) = 0;
     virtual bool isAppMuted() = 0;
 
+    // App volume and mute, updated without the thread mutex and read together.
+    struct AppVolumeState {
+        float volume = 1.0f;
+        bool muted = false;
+    };
+    virtual AppVolumeState appVolumeState() const = 0;
+
     virtual String8 getPackageName() const = 0;
 
     using SourceMetadatas = std::vector<playback_track_metadata_v7_t>;
@@ -428,6 +435,23 @@ public:
     virtual ExtendedAudioBufferProvider* asExtendedAudioBufferProvider() = 0;
     virtual VolumeProvider* asVolumeProvider() = 0;
 
+    // Inputs and results of the last gain computation by MixerThread::prepareTracks_l(),
+    // so that an unchanged track skips it. Used by thread only.
+    struct VolumeInputs {
+        bool valid = false;
+        float volume;                       // master, stream and app volume, 0 if muted
+        float shaperVolume;
+        gain_minifloat_packed_t volumeLR;   // from the control block
+        uint16_t sendLevel;                 // from the control block, clamped
+        float left, right, aux;             // volumes set on the AudioMixer
+
+        bool matches(float v, float vh, gain_minifloat_packed_t vlr, uint16_t send) const {
+            return valid && volume == v && shaperVolume == vh && volumeLR == vlr
+                    && sendLevel == send;
+        }
+    };
+    virtual VolumeInputs& lastVolumeInputs() = 0;
+
     // TODO(b/291317964) split into getter/setter
     virtual FillingStatus& fillingStatus() = 0;
     virtual int8_t& retryCount() = 0;
@@ -23,6 +23,7 @@
 #include "PatchCommandThread.h"
 
 #include <audio_utils/primitives.h>
+#include <cutils/properties.h>
 #include <media/AudioParameter.h>
 #include <media/AudioValidator.h>
 #include <media/DeviceDescriptorBase.h>
@@ -49,7 +50,10 @@ namespace android {
 
 /* static */
 sp<IAfPatchPanel> IAfPatchPanel::create(const sp<IAfPatchPanelCallback>& afPatchPanelCallback) {
-    return sp<PatchPanel>::make(afPatchPanelCallback);
+    // The direct engine is opt-in, as it does not support device effects, and the patch
+    // threads are not available to the policy for other clients.
+    return sp<PatchPanel>::make(afPatchPanelCallback,
+            property_get_bool("af.patch.direct_engine", false /* default_value */));
 }
 
 status_t SoftwarePatch::getLatencyMs_l(double* latencyMs) const {
@@ -223,6 +227,9 @@ status_t PatchPanel::createAudioPatch_l(const struct audio_patch* patch,
                 ((patch->sinks[0].type == AUDIO_PORT_TYPE_DEVICE) &&
                  ((patch->sinks[0].ext.device.hw_module != srcModule) ||
                   !audioHwDevice->supportsAudioPatches()))) {
+                if (createDirectConnections_l(audioHwDevice, &newPatch) == NO_ERROR) {
+                    break;
+                }
                 audio_devices_t outputDevice = patch->sinks[0].ext.device.type;
                 String8 outputDeviceAddress = String8(patch->sinks[0].ext.device.address);
                 if (patch->num_sources == 2) {
@@ -505,6 +512,36 @@ PatchPanel::Patch::~Patch()
             mRecord.handle(), mPlayback.handle());
 }
 
+status_t PatchPanel::createDirectConnections_l(AudioHwDevice* srcHwDevice, Patch* patch)
+{
+    const struct audio_patch& audioPatch = patch->mAudioPatch;
+    if (!mDirectEngineEnabled || audioPatch.num_sources != 1 || audioPatch.num_sinks != 1
+            || audioPatch.sinks[0].type != AUDIO_PORT_TYPE_DEVICE) {
+        return INVALID_OPERATION;
+    }
+    AudioHwDevice* const sinkHwDevice =
+            findAudioHwDeviceByModule_l(audioPatch.sinks[0].ext.device.hw_module);
+    if (sinkHwDevice == nullptr
+            || srcHwDevice->isInsert() || sinkHwDevice->isInsert()
+            || !srcHwDevice->supportsAudioPatches() || !sinkHwDevice->supportsAudioPatches()) {
+        return INVALID_OPERATION;
+    }
+    sp<DirectPatchEngine> engine = DirectPatchEngine::create(
+            srcHwDevice, mAfPatchPanelCallback->nextUniqueId(AUDIO_UNIQUE_ID_USE_INPUT),
+            sinkHwDevice, mAfPatchPanelCallback->nextUniqueId(AUDIO_UNIQUE_ID_USE_OUTPUT),
+            audioPatch);
+    if (engine == nullptr) {
+        ALOGW("%s() falling back to record and playback threads", __func__);
+        return NO_INIT;
+    }
+    const status_t status = engine->start();
+    if (status != NO_ERROR) {
+        return status;
+    }
+    patch->mDirectEngine = std::move(engine);
+    return NO_ERROR;
+}
+
 status_t PatchPanel::Patch::createConnections_l(const sp<IAfPatchPanel>& panel)
 {
     // create patch from source device to record thread input
@@ -673,6 +710,11 @@ void PatchPanel::Patch::clearConnections_l(const sp<IAfPatchPanel>& panel)
 {
     ALOGV("%s() mRecord.handle %d mPlayback.handle %d",
             __func__, mRecord.handle(), mPlayback.handle());
+    if (mDirectEngine != nullptr) {
+        // the engine owns its streams and HAL patches, they are released with it.
+        mDirectEngine->stop();
+        mDirectEngine.clear();
+    }
     mRecord.stopTrack();
     mPlayback.stopTrack();
     mRecord.clearTrackPeer(); // mRecord stop is synchronous. Break PeerProxy sp<> cycle.
@@ -684,6 +726,10 @@ status_t PatchPanel::Patch::getLatencyMs(double* latencyMs) const
 {
     if (!isSoftware()) return INVALID_OPERATION;
 
+    if (mDirectEngine != nullptr) {
+        return mDirectEngine->getLatencyMs(latencyMs);
+    }
+
     auto recordTrack = mRecord.const_track();
     if (recordTrack.get() == nullptr) return INVALID_OPERATION;
 
@@ -758,6 +804,10 @@ String8 PatchPanel::Patch::dump(audio_patch_handle_t myHandle) const
             hasSinkDevice ? mAudioPatch.sinks[0].ext.device.type :
                 (hasSourceDevice ? mAudioPatch.sources[0].ext.device.type : 0));
 
+    if (mDirectEngine != nullptr) {
+        result.appendFormat(" %s", mDirectEngine->toString().c_str());
+    }
+
     // add latency if it exists
     double latencyMs;
     if (getLatencyMs(&latencyMs) == OK) {
@@ -26,8 +26,12 @@ namespace android {
 
 class PatchPanel : public IAfPatchPanel {
 public:
-    explicit PatchPanel(const sp<IAfPatchPanelCallback>& afPatchPanelCallback)
-        : mAfPatchPanelCallback(afPatchPanelCallback) {}
+    // directEngineEnabled allows device to device software patches to use a
+    // DirectPatchEngine instead of record and playback threads,
+    // see createDirectConnections_l().
+    PatchPanel(const sp<IAfPatchPanelCallback>& afPatchPanelCallback, bool directEngineEnabled)
+        : mAfPatchPanelCallback(afPatchPanelCallback)
+        , mDirectEngineEnabled(directEngineEnabled) {}
 
     /* List connected audio ports and their attributes */
     status_t listAudioPorts_l(unsigned int *num_ports,
@@ -89,6 +93,10 @@ private:
             const struct audio_patch *patch)
             REQUIRES(audio_utils::AudioFlinger_Mutex);
     void removeSoftwarePatchFromInsertedModules(audio_patch_handle_t handle);
+    // Creates a DirectPatchEngine for a device to device software patch, if enabled and
+    // supported by both HW modules. Otherwise returns an error and the patch is unchanged.
+    status_t createDirectConnections_l(AudioHwDevice* srcHwDevice, Patch* patch)
+            REQUIRES(audio_utils::AudioFlinger_Mutex);
     /**
      * erase the patch referred by its handle.
      * @param handle of the patch to be erased
@@ -123,6 +131,7 @@ private:
     }
 
     const sp<IAfPatchPanelCallback> mAfPatchPanelCallback;
+    const bool mDirectEngineEnabled;
     std::map<audio_patch_handle_t, Patch> mPatches;
 
     // This map allows going from a thread to "downstream" software patches
@@ -19,6 +19,7 @@
 
 #include "TrackBase.h"
 
+#include <afutils/Seqlock.h>
 #include <android/os/BnExternalVibrationController.h>
 #include <audio_utils/mutex.h>
 #include <audio_utils/LinearMap.h>
@@ -162,9 +163,10 @@ public:
     }
 
     void                setAppVolume(float volume);
-    float               getAppVolume() const { return mAppVolume; }
+    float               getAppVolume() const { return mAppVolumeState.load().volume; }
     void                setAppMute(bool val);
-    bool                isAppMuted() { return mAppMuted; }
+    bool                isAppMuted() { return mAppVolumeState.load().muted; }
+    AppVolumeState      appVolumeState() const final { return mAppVolumeState.load(); }
 
     String8             getPackageName() const { return mPackageName; }
 
@@ -307,6 +309,7 @@ protected:
         return this;
     }
 
+    VolumeInputs& lastVolumeInputs() final { return mLastVolumeInputs; }
     FillingStatus& fillingStatus() final { return mFillingStatus; }
     int8_t& retryCount() final { return mRetryCount; }
     FastTrackUnderruns& fastTrackUnderruns() final { return mObservedUnderruns; }
@@ -392,8 +395,9 @@ private:
                                           // volume
     float               mFinalVolumeRight; // combine master volume, stream type volume and track
                                            // volume
-    float               mAppVolume;  // volume control for separate processes
-    bool                mAppMuted;
+    // volume control for separate processes, set by binder threads
+    afutils::Seqlock<AppVolumeState> mAppVolumeState;
+    VolumeInputs        mLastVolumeInputs;
     sp<AudioTrackServerProxy>  mAudioTrackServerProxy;
     bool                mResumeToStopping; // track was paused in stopping state.
     bool                mFlushHwPending; // track requests for thread flush
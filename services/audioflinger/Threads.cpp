@@ -67,10 +67,10 @@
 #include <media/audiohal/StreamHalInterface.h>
 #include <media/nbaio/AudioStreamInSource.h>
 #include <media/nbaio/AudioStreamOutSink.h>
+#include <media/nbaio/BroadcastPipe.h>
+#include <media/nbaio/BroadcastPipeReader.h>
 #include <media/nbaio/MonoPipe.h>
 #include <media/nbaio/MonoPipeReader.h>
-#include <media/nbaio/Pipe.h>
-#include <media/nbaio/PipeReader.h>
 #include <media/nbaio/SourceAudioBufferProvider.h>
 #include <mediautils/BatteryNotifier.h>
 #include <mediautils/Process.h>
@@ -220,9 +220,16 @@ static const enum {
     FastCapture_Static, // initialize if needed, then use all the time if initialized
 } kUseFastCapture = FastCapture_Static;
 
+// Minimum frames mixed per FastMixer cycle when af.fast_mixer.sub_periods is set
+static const size_t kMinFastMixerSubPeriodFrames = 32;
+
+// How often MixerThread reports the fast mixer cycle telemetry to mediametrics
+static const nsecs_t kFastMixerTelemetryLogIntervalNs = seconds(60);
+
 // Priorities for requestPriority
 static const int kPriorityAudioApp = 2;
 static const int kPriorityFastMixer = 3;
+static const int kPriorityMixerWorker = 2;
 static const int kPriorityFastCapture = 3;
 // Request real-time priority for PlaybackThread in ARC
 static const int kPriorityPlaybackThreadArc = 1;
@@ -2778,24 +2785,31 @@ void PlaybackThread::listAppVolumes(std::set<media::AppVolume> &container)
     }
 }
 
-status_t PlaybackThread::setAppVolume(const String8& packageName, const float value)
+std::vector<sp<IAfTrack>> PlaybackThread::tracksForPackage(const String8& packageName) const
 {
+    std::vector<sp<IAfTrack>> tracks;
     audio_utils::lock_guard _l(mutex());
-    for (sp<IAfTrack> track : mTracks) {
+    for (const sp<IAfTrack>& track : mTracks) {
         if (packageName == track->getPackageName()) {
-            track->setAppVolume(value);
+            tracks.push_back(track);
         }
     }
+    return tracks;
+}
+
+status_t PlaybackThread::setAppVolume(const String8& packageName, const float value)
+{
+    // The app volume is published through the track seqlock, outside of the thread mutex.
+    for (const sp<IAfTrack>& track : tracksForPackage(packageName)) {
+        track->setAppVolume(value);
+    }
     return NO_ERROR;
 }
 
 status_t PlaybackThread::setAppMute(const String8& packageName, const bool value)
 {
-    audio_utils::lock_guard _l(mutex());
-    for (sp<IAfTrack> track : mTracks) {
-        if (packageName == track->getPackageName()) {
-            track->setAppMute(value);
-        }
+    for (const sp<IAfTrack>& track : tracksForPackage(packageName)) {
+        track->setAppMute(value);
     }
     return NO_ERROR;
 }
@@ -3272,6 +3286,21 @@ NO_THREAD_SAFETY_ANALYSIS
     mThreadThrottleEndMs = 0;
     mHalfBufferMs = mNormalFrameCount * 1000 / (2 * mSampleRate);
 
+    // Adaptive write scheduling only pays off if the HAL queues several mixer periods.
+    mWriteScheduler.reset();
+    if (hasMixer() && audio_has_proportional_frames(mFormat)
+            && property_get_bool("af.thread.adaptive_write", false /* default_value */)) {
+        const size_t capacityFrames = (size_t)latency_l() * mSampleRate / 1000;
+        if (capacityFrames >= 3 * mNormalFrameCount) {
+            // target probability of a late wakeup, in parts per million
+            const int64_t underrunPpm = property_get_int64(
+                    "af.thread.adaptive_write.underrun_ppm", 1000 /* default_value */);
+            mWriteScheduler = std::make_unique<audioflinger::AdaptiveWriteScheduler>(
+                    mSampleRate, mNormalFrameCount, capacityFrames,
+                    std::clamp(underrunPpm, (int64_t)1, (int64_t)100000) * 1e-6);
+        }
+    }
+
     // mSinkBuffer is the sink buffer.  Size is always multiple-of-16 frames.
     // Originally this was int16_t[] array, need to remove legacy implications.
     free(mSinkBuffer);
@@ -3984,6 +4013,16 @@ bool PlaybackThread::threadLoop()
 NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 {
     aflog::setThreadWriter(mNBLogWriter.get());
+    {
+        NBLog::thread_info_t info;
+        info.id = mId;
+        info.type = NBLog::MIXER;  // the only playback thread type
+        LOG_THREAD_INFO(info);
+        NBLog::thread_params_t params;
+        params.frameCount = mNormalFrameCount;
+        params.sampleRate = mSampleRate;
+        LOG_THREAD_PARAMS(params);
+    }
 
     if (mType == SPATIALIZER) {
         const pid_t tid = getTid();
@@ -4482,6 +4521,9 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 ssize_t ret = 0;
                 // writePeriodNs is updated >= 0 when ret > 0.
                 int64_t writePeriodNs = -1;
+                // time spent preparing and writing the data, valid when writePeriodNs >= 0.
+                int64_t mixNs = 0;
+                int64_t writeNs = 0;
                 if (mBytesRemaining) {
                     // FIXME rewrite to reduce number of system calls
                     const int64_t lastIoBeginNs = systemTime();
@@ -4496,6 +4538,8 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                         mFramesWritten += frames;
 
                         writePeriodNs = lastIoEndNs - mLastIoEndNs;
+                        mixNs = lastIoBeginNs - mLastIoEndNs;
+                        writeNs = lastIoEndNs - lastIoBeginNs;
                         // process information relating to write time.
                         if (audio_has_proportional_frames(mFormat)) {
                             // we are in a continuous mixing cycle
@@ -4552,7 +4596,49 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 }
                 if ((mType == MIXER || mType == SPATIALIZER) && !mStandby) {
 
-                    if (mThreadThrottle
+                    if (mWriteScheduler != nullptr && !hasFastMixer() && !isSuspended()
+                            && mMixerStatus == MIXER_TRACKS_READY
+                            && writePeriodNs > 0) {
+                        int64_t sleepNs = mWriteScheduler->onWrite(
+                                mLastIoEndNs, mixNs, writeNs, halQueuedFrames(mLastIoEndNs));
+                        mThreadMetrics.logWriteSchedule(
+                                mWriteScheduler->lastWriteWasWakeup(),
+                                mWriteScheduler->lastWriteWasMiss(),
+                                mWriteScheduler->marginFrames() * 1000. / mSampleRate);
+                        const bool wakeupRequested = sleepNs > 0;
+                        if (!wakeupRequested && mThreadThrottle) {
+                            // Back to back writes are still limited to twice the expected
+                            // processing rate, as with the throttle below: tracks with
+                            // minimum size buffers could not refill at the full HAL rate.
+                            // The rate is measured since the last sleep, so the writes
+                            // refilling the HAL after a scheduled sleep are not throttled.
+                            sleepNs = mWriteScheduler->throttleNs(mLastIoEndNs);
+                            if (sleepNs > 0) {
+                                mThreadMetrics.logThrottleMs(
+                                        (double)sleepNs / NANOS_PER_MILLISECOND);
+                                mThreadMetrics.logWriteThrottle();
+                                mThreadThrottleTimeMs += sleepNs / NANOS_PER_MILLISECOND;
+                            }
+                        }
+                        if (sleepNs > 0) {
+                            ATRACE_BEGIN(wakeupRequested ? "adaptive sleep" : "throttle");
+                            {
+                                audio_utils::unique_lock _l(mutex());
+                                // A new track or config event wakes the thread up early.
+                                if (!mSignalPending && mConfigEvents.isEmpty()
+                                        && !exitPending()) {
+                                    mWaitWorkCV.wait_for(_l, std::chrono::nanoseconds(sleepNs));
+                                }
+                            }
+                            ATRACE_END();
+                            mLastIoEndNs = systemTime();
+                            // A throttle sleep leaves room in the HAL, the next write is
+                            // not a wakeup for the scheduler.
+                            if (wakeupRequested) {
+                                mWriteScheduler->onWakeup(mLastIoEndNs);
+                            }
+                        }
+                    } else if (mThreadThrottle
                             && mMixerStatus == MIXER_TRACKS_READY // we are mixing (active tracks)
                             && writePeriodNs > 0) {               // we have write period info
                         // Limit MixerThread data processing to no more than twice the
@@ -4674,6 +4760,17 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
     return false;
 }
 
+int64_t PlaybackThread::halQueuedFrames(int64_t nowNs) const
+{
+    const int64_t kernelTimeNs = mTimestamp.mTimeNs[ExtendedTimestamp::LOCATION_KERNEL];
+    if (kernelTimeNs <= 0 || nowNs < kernelTimeNs) {
+        return -1;
+    }
+    const int64_t presentedFrames = mTimestamp.mPosition[ExtendedTimestamp::LOCATION_KERNEL]
+            + (nowNs - kernelTimeNs) * mSampleRate / NANOS_PER_SECOND;
+    return std::max(mFramesWritten - presentedFrames, (int64_t)0);
+}
+
 void PlaybackThread::collectTimestamps_l()
 {
     if (mStandby) {
@@ -5109,6 +5206,16 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    // Optionally resample independent tracks on this many helper threads.
+    // The threads are created once, and kept by each mixer created afterwards.
+    const int32_t mixerWorkers = property_get_int32("af.mixer.workers", 0 /* default */);
+    if (mixerWorkers > 0) {
+        mMixerWorkerPool = std::make_shared<AudioMixerWorkerPool>(mixerWorkers);
+        for (const pid_t tid : mMixerWorkerPool->getTids()) {
+            sendPrioConfigEvent(getpid(), tid, kPriorityMixerWorker, false /*forApp*/);
+        }
+    }
+    configureAudioMixer();
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -5218,6 +5325,16 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
         state->mOutputSink = mOutputSink.get();
         state->mOutputSinkGen++;
         state->mFrameCount = mFrameCount;
+        // Optionally mix and write in sub-periods of the HAL buffer to reduce the latency
+        // of fast tracks without reducing the HAL buffer size.
+        const int32_t subPeriods = property_get_int32("af.fast_mixer.sub_periods", 1);
+        if (subPeriods > 1 && mFrameCount % subPeriods == 0
+                && mFrameCount / subPeriods >= kMinFastMixerSubPeriodFrames) {
+            state->mSubPeriods = subPeriods;
+        } else if (subPeriods != 1) {
+            ALOGW("%s: ignoring af.fast_mixer.sub_periods %d for frame count %zu",
+                    __func__, subPeriods, mFrameCount);
+        }
         // specify sink channel mask when haptic channel mask present as it can not
         // be calculated directly from channel count
         state->mSinkChannelMask = mHapticChannelMask == AUDIO_CHANNEL_NONE
@@ -5229,6 +5346,10 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
         state->mColdFutexAddr = &mFastMixerFutex;
         state->mColdGen++;
         state->mDumpState = &mFastMixerDumpState;
+        mFastMixerTelemetry = std::make_unique<FastThreadTelemetry>();
+        mFastMixerCycleStats.setPeriodNs((int64_t)(mFrameCount / state->mSubPeriods)
+                * NANOS_PER_SECOND / mSampleRate);
+        state->mTelemetry = mFastMixerTelemetry.get();
         mFastMixerNBLogWriter = afThreadCallback->newWriter_l(kFastMixerLogSize, "FastMixer");
         state->mNBLogWriter = mFastMixerNBLogWriter.get();
         sq->end();
@@ -5275,6 +5396,22 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
     }
 }
 
+// Applies the af.mixer.* tuning properties to mAudioMixer, each time it is created.
+void MixerThread::configureAudioMixer()
+{
+    // Optionally mix all tracks in tiles sized to this many bytes of data cache.
+    const int32_t mixerTileBytes = property_get_int32("af.mixer.tile_bytes", 0 /* default */);
+    if (mixerTileBytes > 0) {
+        mAudioMixer->setTileFrameCount(AudioMixer::tileFrameCountForCache(
+                mChannelCount + mHapticChannelCount, mixerTileBytes));
+        ALOGV("%s: mixer tile frame count %zu",
+                __func__, mAudioMixer->getTileFrameCount());
+    }
+    if (mMixerWorkerPool != nullptr) {
+        mAudioMixer->setWorkerPool(mMixerWorkerPool);
+    }
+}
+
 MixerThread::~MixerThread()
 {
     if (mFastMixer != 0) {
@@ -5376,10 +5513,56 @@ ssize_t MixerThread::threadLoop_write()
         } else {
             sq->end(false /*didModify*/);
         }
+        logFastMixerTelemetry();
     }
     return PlaybackThread::threadLoop_write();
 }
 
+void MixerThread::logFastMixerTelemetry()
+{
+    if (mFastMixerTelemetry == nullptr) {
+        return;
+    }
+    // The ring holds a few seconds of cycles at typical fast mixer periods, and we are
+    // called once per normal mix, so a single drain normally keeps up.
+    FastThreadCycle cycles[64];
+    size_t count, lost;
+    do {
+        count = mFastMixerTelemetry->drain(cycles, std::size(cycles), &lost);
+        mFastMixerCycleStats.add(cycles, count, lost);
+    } while (count == std::size(cycles));
+
+    const nsecs_t now = systemTime();
+    if (mFastMixerTelemetryLogNs == 0) {
+        mFastMixerTelemetryLogNs = now;
+        return;
+    }
+    if (now - mFastMixerTelemetryLogNs < kFastMixerTelemetryLogIntervalNs) {
+        return;
+    }
+    mFastMixerTelemetryLogNs = now;
+    if (mFastMixerCycleStats.cycles() == 0) {
+        return;
+    }
+    mediametrics::LogItem item(mThreadMetrics.getMetricsId());
+    item.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_FASTMIXERTELEMETRY)
+        .set(AMEDIAMETRICS_PROP_FASTCYCLES, mFastMixerCycleStats.cycles())
+        .set(AMEDIAMETRICS_PROP_FASTCYCLESLOST, mFastMixerCycleStats.lost())
+        .set(AMEDIAMETRICS_PROP_FASTUNDERRUNS, mFastMixerCycleStats.underruns())
+        .set(AMEDIAMETRICS_PROP_FASTMAXWALLNS, (int32_t)mFastMixerCycleStats.maxWallNs())
+        .set(AMEDIAMETRICS_PROP_FASTMAXCPUNS, (int32_t)mFastMixerCycleStats.maxCpuNs())
+        .set(AMEDIAMETRICS_PROP_FASTJITTERHISTOGRAM,
+                mFastMixerCycleStats.jitterHistogram().c_str())
+        .set(AMEDIAMETRICS_PROP_FASTCPUHISTOGRAM, mFastMixerCycleStats.loadHistogram().c_str())
+        .record();
+    {
+        // keep the last interval for dumpsys.
+        audio_utils::lock_guard _l(mutex());
+        mFastMixerCycleStatsDump = mFastMixerCycleStats.toString();
+    }
+    mFastMixerCycleStats.reset();
+}
+
 void MixerThread::threadLoop_standby()
 {
     // Idle the fast mixer if it's currently running
@@ -5938,6 +6121,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                 }
                 mAudioMixer->setParameter(trackId, AudioMixer::RESAMPLE, AudioMixer::RESET, NULL);
                 mLeftVolFloat = -1.0;
+                track->lastVolumeInputs().valid = false;
             // FIXME should not make a decision based on mServer
             } else if (cblk->mServer != 0) {
                 // If the track is stopped before the first frame was mixed,
@@ -5946,27 +6130,33 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
             }
 
             // compute volume for this track
-            uint32_t vl, vr;       // in U8.24 integer format
+            uint32_t vl = 0, vr = 0;   // in U8.24 integer format
             float vlf, vrf, vaf;   // in [0.0, 1.0] float format
             // read original volumes with volume control
+            const IAfTrack::AppVolumeState appVolume = track->appVolumeState();
             float v = masterVolume * mStreamTypes[track->streamType()].volume
-                                   * track->getAppVolume();
+                                   * appVolume.volume;
             // Always fetch volumeshaper volume to ensure state is updated.
             const sp<AudioTrackServerProxy> proxy = track->audioTrackServerProxy();
             const float vh = track->getVolumeHandler()->getVolume(
                     track->audioTrackServerProxy()->framesReleased()).first;
 
             if (mStreamTypes[track->streamType()].mute
-                    || track->isPlaybackRestricted() || track->isAppMuted()) {
+                    || track->isPlaybackRestricted() || appVolume.muted) {
                 v = 0;
             }
 
             handleVoipVolume_l(&v);
 
+            // Set when the gain inputs did not change since the last mix of this track, in
+            // which case the AudioMixer already has (or is ramping to) the resulting volumes.
+            bool volumeUnchanged = false;
+            IAfTrack::VolumeInputs& lastVolumeInputs = track->lastVolumeInputs();
             if (track->isPausing()) {
                 vl = vr = 0;
                 vlf = vrf = vaf = 0.;
                 track->setPaused();
+                lastVolumeInputs.valid = false;
             } else {
                 gain_minifloat_packed_t vlr = proxy->getVolumeLR();
                 vlf = float_from_gain(gain_minifloat_unpack_left(vlr));
@@ -5989,51 +6179,66 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                                    vlf == 0.f && vrf == 0.f,
                                    vh == 0.f});
 
-                // now apply the master volume and stream type volume and shaper volume
-                vlf *= v * vh;
-                vrf *= v * vh;
-                // assuming master volume and stream type volume each go up to 1.0,
-                // then derive vl and vr as U8.24 versions for the effect chain
-                const float scaleto8_24 = MAX_GAIN_INT * MAX_GAIN_INT;
-                vl = (uint32_t) (scaleto8_24 * vlf);
-                vr = (uint32_t) (scaleto8_24 * vrf);
-                // vl and vr are now in U8.24 format
                 uint16_t sendLevel = proxy->getSendLevel_U4_12();
                 // send level comes from shared memory and so may be corrupt
                 if (sendLevel > MAX_GAIN_INT) {
                     ALOGV("Track send level out of range: %04X", sendLevel);
                     sendLevel = MAX_GAIN_INT;
                 }
-                // vaf is represented as [0.0, 1.0] float by rescaling sendLevel
-                vaf = v * sendLevel * (1. / MAX_GAIN_INT);
+
+                // A track with an effect chain always recomputes, as the chain may take
+                // over volume control.
+                if (chain == 0 && lastVolumeInputs.matches(v, vh, vlr, sendLevel)) {
+                    volumeUnchanged = true;
+                    vlf = lastVolumeInputs.left;
+                    vrf = lastVolumeInputs.right;
+                    vaf = lastVolumeInputs.aux;
+                } else {
+                    // now apply the master volume and stream type volume and shaper volume
+                    vlf *= v * vh;
+                    vrf *= v * vh;
+                    // assuming master volume and stream type volume each go up to 1.0,
+                    // then derive vl and vr as U8.24 versions for the effect chain
+                    const float scaleto8_24 = MAX_GAIN_INT * MAX_GAIN_INT;
+                    vl = (uint32_t) (scaleto8_24 * vlf);
+                    vr = (uint32_t) (scaleto8_24 * vrf);
+                    // vl and vr are now in U8.24 format
+                    // vaf is represented as [0.0, 1.0] float by rescaling sendLevel
+                    vaf = v * sendLevel * (1. / MAX_GAIN_INT);
+                    lastVolumeInputs = {chain == 0, v, vh, vlr, sendLevel, vlf, vrf, vaf};
+                }
             }
 
-            track->setFinalVolume(vrf, vlf);
+            if (!volumeUnchanged) {
+                track->setFinalVolume(vrf, vlf);
 
-            // Delegate volume control to effect in track effect chain if needed
-            if (chain != 0 && chain->setVolume(&vl, &vr)) {
-                // Do not ramp volume if volume is controlled by effect
-                param = AudioMixer::VOLUME;
-                // Update remaining floating point volume levels
-                vlf = (float)vl / (1 << 24);
-                vrf = (float)vr / (1 << 24);
-                track->setHasVolumeController(true);
-            } else {
-                // force no volume ramp when volume controller was just disabled or removed
-                // from effect chain to avoid volume spike
-                if (track->hasVolumeController()) {
+                // Delegate volume control to effect in track effect chain if needed
+                if (chain != 0 && chain->setVolume(&vl, &vr)) {
+                    // Do not ramp volume if volume is controlled by effect
                     param = AudioMixer::VOLUME;
+                    // Update remaining floating point volume levels
+                    vlf = (float)vl / (1 << 24);
+                    vrf = (float)vr / (1 << 24);
+                    track->setHasVolumeController(true);
+                } else {
+                    // force no volume ramp when volume controller was just disabled or removed
+                    // from effect chain to avoid volume spike
+                    if (track->hasVolumeController()) {
+                        param = AudioMixer::VOLUME;
+                    }
+                    track->setHasVolumeController(false);
                 }
-                track->setHasVolumeController(false);
             }
 
             // XXX: these things DON'T need to be done each time
             mAudioMixer->setBufferProvider(trackId, track->asExtendedAudioBufferProvider());
             mAudioMixer->enable(trackId);
 
-            mAudioMixer->setParameter(trackId, param, AudioMixer::VOLUME0, &vlf);
-            mAudioMixer->setParameter(trackId, param, AudioMixer::VOLUME1, &vrf);
-            mAudioMixer->setParameter(trackId, param, AudioMixer::AUXLEVEL, &vaf);
+            if (!volumeUnchanged) {
+                mAudioMixer->setParameter(trackId, param, AudioMixer::VOLUME0, &vlf);
+                mAudioMixer->setParameter(trackId, param, AudioMixer::VOLUME1, &vrf);
+                mAudioMixer->setParameter(trackId, param, AudioMixer::AUXLEVEL, &vaf);
+            }
             mAudioMixer->setParameter(
                 trackId,
                 AudioMixer::TRACK,
@@ -6212,6 +6417,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                 }
             }
             mAudioMixer->disable(trackId);
+            track->lastVolumeInputs().valid = false;
         }
 
         }   // local variable scope to avoid goto warning
@@ -6460,6 +6666,7 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            configureAudioMixer();
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 const status_t createStatus = mAudioMixer->create(
@@ -6467,6 +6674,7 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
                         track->channelMask(),
                         track->format(),
                         track->sessionId());
+                track->lastVolumeInputs().valid = false;
                 ALOGW_IF(createStatus != NO_ERROR,
                         "%s(): AudioMixer cannot create track(%d)"
                         " mask %#x, format %#x, sessionId %d",
@@ -6486,6 +6694,10 @@ void MixerThread::dumpInternals_l(int fd, const Vector<String16>& args)
     PlaybackThread::dumpInternals_l(fd, args);
     dprintf(fd, "  Thread throttle time (msecs): %u\n", (uint32_t)mThreadThrottleTimeMs);
     dprintf(fd, "  AudioMixer tracks: %s\n", mAudioMixer->trackNames().c_str());
+    if (mAudioMixer->getTileFrameCount() != 0) {
+        dprintf(fd, "  AudioMixer tile frames: %zu %s\n", mAudioMixer->getTileFrameCount(),
+                mAudioMixer->getTileStats().toString().c_str());
+    }
     dprintf(fd, "  Master mono: %s\n", mMasterMono ? "on" : "off");
     dprintf(fd, "  Master balance: %f (%s)\n", mMasterBalance.load(),
             (hasFastMixer() ? std::to_string(mFastMixer->getMasterBalance())
@@ -6500,6 +6712,11 @@ void MixerThread::dumpInternals_l(int fd, const Vector<String16>& args)
         const std::unique_ptr<FastMixerDumpState> copy =
                 std::make_unique<FastMixerDumpState>(mFastMixerDumpState);
         copy->dump(fd);
+        if (!mFastMixerCycleStatsDump.empty()) {
+            dprintf(fd, "  FastMixer cycle stats (last %lld s): %s\n",
+                    (long long)(kFastMixerTelemetryLogIntervalNs / NANOS_PER_SECOND),
+                    mFastMixerCycleStatsDump.c_str());
+        }
 
 #ifdef STATE_QUEUE_DUMP
         // Similar for state queue
@@ -8150,19 +8367,19 @@ RecordThread::RecordThread(const sp<IAfThreadCallback>& afThreadCallback,
         }
         // pipe will be shared directly with fast clients, so clear to avoid leaking old information
         memset(pipeBuffer, 0, pipeSize);
-        Pipe *pipe = new Pipe(pipeFramesP2, format, pipeBuffer);
+        // A BroadcastPipe, so that more readers can follow the capture independently.
+        BroadcastPipe *pipe = new BroadcastPipe(pipeFramesP2, format, pipeBuffer);
         const NBAIO_Format offersFast[1] = {format};
         size_t numCounterOffersFast = 0;
         [[maybe_unused]] ssize_t index2 = pipe->negotiate(offersFast, std::size(offersFast),
                 nullptr /* counterOffers */, numCounterOffersFast);
         ALOG_ASSERT(index2 == 0);
         mPipeSink = pipe;
-        PipeReader *pipeReader = new PipeReader(*pipe);
-        numCounterOffersFast = 0;
-        index2 = pipeReader->negotiate(offersFast, std::size(offersFast),
-                nullptr /* counterOffers */, numCounterOffersFast);
-        ALOG_ASSERT(index2 == 0);
-        mPipeSource = pipeReader;
+        mPipeSource = newFastCaptureReader();
+        ALOG_ASSERT(mPipeSource != nullptr);
+#ifdef TEE_SINK
+        mTeeSource = newFastCaptureReader();
+#endif
         mPipeFramesP2 = pipeFramesP2;
         mPipeMemory = pipeMemory;
 
@@ -8194,6 +8411,11 @@ RecordThread::RecordThread(const sp<IAfThreadCallback>& afThreadCallback,
         sq->end();
         sq->push(FastCaptureStateQueue::BLOCK_UNTIL_PUSHED);
 
+        NBLog::thread_info_t info;
+        info.id = mId;
+        info.type = NBLog::FASTCAPTURE;
+        mFastCaptureNBLogWriter->log<NBLog::EVENT_THREAD_INFO>(info);
+
         // start the fast capture
         mFastCapture->run("FastCapture", ANDROID_PRIORITY_URGENT_AUDIO);
         pid_t tid = mFastCapture->getTid();
@@ -8214,6 +8436,25 @@ failed: ;
     // FIXME mNormalSource
 }
 
+sp<BroadcastPipeReader> RecordThread::newFastCaptureReader(bool throttlesWriter) const
+{
+    if (mPipeSink == nullptr) {
+        return nullptr;
+    }
+    // RecordThread only creates a BroadcastPipe for FastCapture.
+    BroadcastPipe *pipe = static_cast<BroadcastPipe *>(mPipeSink.get());
+    const sp<BroadcastPipeReader> reader = sp<BroadcastPipeReader>::make(*pipe, throttlesWriter);
+    if (reader->initCheck() != NO_ERROR) {
+        return nullptr;
+    }
+    const NBAIO_Format offers[1] = {pipe->format()};
+    size_t numCounterOffers = 0;
+    [[maybe_unused]] const ssize_t index = reader->negotiate(offers, std::size(offers),
+            nullptr /* counterOffers */, numCounterOffers);
+    ALOG_ASSERT(index == 0);
+    return reader;
+}
+
 RecordThread::~RecordThread()
 {
     if (mFastCapture != 0) {
@@ -8255,6 +8496,18 @@ void RecordThread::preExit()
 
 bool RecordThread::threadLoop()
 {
+    aflog::setThreadWriter(mNBLogWriter.get());
+    {
+        NBLog::thread_info_t info;
+        info.id = mId;
+        info.type = NBLog::CAPTURE;
+        LOG_THREAD_INFO(info);
+        NBLog::thread_params_t params;
+        params.frameCount = mFrameCount;
+        params.sampleRate = mSampleRate;
+        LOG_THREAD_PARAMS(params);
+    }
+
     nsecs_t lastWarning = 0;
 
     inputStandBy();
@@ -8649,7 +8902,15 @@ reacquire_wakelock:
         mFramesRead += framesRead;
 
 #ifdef TEE_SINK
-        (void)mTee.write((uint8_t*)mRsmpInBuffer + rear * mFrameSize, framesRead);
+        if (mTeeSource != nullptr) {
+            // the tee has its own reader, so it sees exactly what FastCapture wrote.
+            (void)mTeeSource->readVia([](void *user, const void *buffer, size_t count) {
+                static_cast<NBAIO_Tee *>(user)->write(buffer, count);
+                return (ssize_t)count;
+            }, SIZE_MAX, &mTee);
+        } else {
+            (void)mTee.write((uint8_t*)mRsmpInBuffer + rear * mFrameSize, framesRead);
+        }
 #endif
         // If destination is non-contiguous, we now correct for reading past end of buffer.
         {
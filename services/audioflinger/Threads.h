@@ -33,12 +33,14 @@
 #include <fastpath/FastMixer.h>
 #include <mediautils/Synchronization.h>
 #include <mediautils/ThreadSnapshot.h>
+#include <timing/AdaptiveWriteScheduler.h>
 #include <timing/MonotonicFrameCounter.h>
 #include <utils/Log.h>
 
 namespace android {
 
 class AsyncCallbackThread;
+class BroadcastPipeReader;
 
 class ThreadBase : public virtual IAfThreadBase, public Thread {
 public:
@@ -926,6 +928,9 @@ public:
 
     status_t setAppVolume(const String8& packageName, const float value) final;
     status_t setAppMute(const String8& packageName, const bool muted) final;
+    // Returns the tracks of packageName, so their app volume can be changed without mutex().
+    std::vector<sp<IAfTrack>> tracksForPackage(const String8& packageName) const
+            EXCLUDES_ThreadBase_Mutex;
     void listAppVolumes(std::set<media::AppVolume> &container) final;
 
 protected:
@@ -1220,6 +1225,16 @@ protected:
     // half the buffer size in milliseconds
     uint32_t mHalfBufferMs GUARDED_BY(ThreadBase_ThreadLoop);
 
+    // Paces the HAL writes of mixer threads without a FastMixer when enabled by
+    // af.thread.adaptive_write. The throttle still limits its back to back writes.
+    // Created by readOutputParameters_l().
+    std::unique_ptr<audioflinger::AdaptiveWriteScheduler> mWriteScheduler
+            GUARDED_BY(ThreadBase_ThreadLoop);
+
+    // Frames queued in the HAL at nowNs, extrapolated from the last kernel timestamp,
+    // or -1 if unknown.
+    int64_t halQueuedFrames(int64_t nowNs) const REQUIRES(ThreadBase_ThreadLoop);
+
     void*                           mSinkBuffer;         // frame size aligned sink buffer
 
     // TODO:
@@ -1629,6 +1644,8 @@ protected:
     void threadLoop_standby() override REQUIRES(ThreadBase_ThreadLoop);
     void threadLoop_mix() override REQUIRES(ThreadBase_ThreadLoop);
     void threadLoop_sleepTime() override REQUIRES(ThreadBase_ThreadLoop);
+    // drains the fast mixer cycle telemetry and periodically logs it to mediametrics
+    void logFastMixerTelemetry() REQUIRES(ThreadBase_ThreadLoop);
     uint32_t correctLatency_l(uint32_t latency) const final REQUIRES(mutex());
 
     status_t createAudioPatch_l(
@@ -1637,6 +1654,10 @@ protected:
     status_t releaseAudioPatch_l(const audio_patch_handle_t handle) final REQUIRES(mutex());
 
                 AudioMixer* mAudioMixer;    // normal mixer
+                // applies the af.mixer.* properties to a newly created mAudioMixer
+                void configureAudioMixer();
+                // helper threads of the mixer, from af.mixer.workers, or null
+                std::shared_ptr<AudioMixerWorkerPool> mMixerWorkerPool;
 
             // Support low latency mode by default as unless explicitly indicated by the audio HAL
             // we assume the audio path is compatible with the head tracking latency requirements
@@ -1661,6 +1682,13 @@ private:
 #endif
                 AudioWatchdogDump mAudioWatchdogDump;
 
+                // written by the fast mixer, allocated once when the fast mixer is created
+                std::unique_ptr<FastThreadTelemetry> mFastMixerTelemetry;
+                FastThreadCycleStats mFastMixerCycleStats GUARDED_BY(ThreadBase_ThreadLoop);
+                nsecs_t mFastMixerTelemetryLogNs GUARDED_BY(ThreadBase_ThreadLoop) = 0;
+                // FastThreadCycleStats::toString() of the last logged interval.
+                std::string mFastMixerCycleStatsDump GUARDED_BY(mutex());
+
                 // accessible only within the threadLoop(), no locks required
                 //          mFastMixer->sq()    // for mutating and pushing state
     int32_t mFastMixerFutex GUARDED_BY(ThreadBase_ThreadLoop);  // for cold idle
@@ -1985,6 +2013,13 @@ public:
 
     sp<IMemory> pipeMemory() const final { return mPipeMemory; }
 
+    // Returns a new reader of the FastCapture pipe, which follows the capture from the current
+    // write position independently of the other readers. A throttling reader holds back
+    // FastCapture when it falls behind, see BroadcastPipe.
+    // Returns nullptr if there is no FastCapture, or if too many readers are attached.
+    // The reader must be released before the RecordThread, which owns the pipe.
+    sp<BroadcastPipeReader> newFastCaptureReader(bool throttlesWriter = false) const;
+
     sp<IAfRecordTrack> createRecordTrack_l(
                     const sp<Client>& client,
                     const audio_attributes_t& attr,
@@ -2170,6 +2205,11 @@ private:
             // If a fast capture is present, the non-blocking pipe source read by normal thread,
             // otherwise clear
             sp<NBAIO_Source>                    mPipeSource;
+#ifdef TEE_SINK
+            // If a fast capture is present, a second reader of the pipe feeding mTee,
+            // otherwise clear and mTee is fed from mRsmpInBuffer
+            sp<BroadcastPipeReader>             mTeeSource;
+#endif
             // Depth of pipe from fast capture to normal thread and fast clients, always power of 2
             size_t                              mPipeFramesP2;
             // If a fast capture is present, the Pipe as IMemory, otherwise clear
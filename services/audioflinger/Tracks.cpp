@@ -803,10 +803,6 @@ Track::Track(
         mPackageName = "";
     }
 
-    /* init app volume */
-    mAppMuted = false;
-    mAppVolume = 1.0f;
-
     if (mCblk == NULL) {
         return;
     }
@@ -1573,12 +1569,12 @@ void Track::setFinalVolume(float volumeLeft, float volumeRight)
 
 void Track::setAppVolume(float volume)
 {
-    mAppVolume = volume;
+    mAppVolumeState.modify([volume](AppVolumeState* state) { state->volume = volume; });
 }
 
 void Track::setAppMute(bool val)
 {
-    mAppMuted = val;
+    mAppVolumeState.modify([val](AppVolumeState* state) { state->muted = val; });
 }
 
 void Track::copyMetadataTo(MetadataInserter& backInserter) const
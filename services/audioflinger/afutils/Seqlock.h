@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace android::afutils {
+
+/**
+ * A versioned snapshot of a small trivially copyable value, shared between any number of
+ * writer threads and reader threads without a mutex.
+ *
+ * Writers serialize among themselves by spinning on the sequence, so they must not be
+ * real-time threads. Readers never block a writer, and retry only if a write overlapped
+ * their read. The version is incremented by every write, so that a reader can cheaply
+ * detect that the value changed since a previous load().
+ *
+ * The value is stored as relaxed atomic words, which keeps the concurrent accesses
+ * well defined.
+ */
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    explicit Seqlock(const T& value = {}) { storeWords(value); }
+
+    /** Returns the current value, and its version if version is not nullptr. */
+    T load(uint32_t* version = nullptr) const {
+        T value;
+        uint32_t seq;
+        do {
+            while ((seq = mSeq.load(std::memory_order_acquire)) & 1) {
+                ;  // write in progress
+            }
+            loadWords(&value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (mSeq.load(std::memory_order_relaxed) != seq);
+        if (version != nullptr) *version = seq >> 1;
+        return value;
+    }
+
+    /** Returns the version of the current value. */
+    uint32_t version() const { return mSeq.load(std::memory_order_acquire) >> 1; }
+
+    void store(const T& value) {
+        modify([&value](T* current) { *current = value; });
+    }
+
+    /**
+     * Atomically applies f(T*) to the current value, for updating one field of T
+     * without losing a concurrent update to another field.
+     */
+    template <typename F>
+    void modify(F&& f) {
+        uint32_t seq = mSeq.load(std::memory_order_relaxed);
+        do {
+            while (seq & 1) {
+                seq = mSeq.load(std::memory_order_relaxed);
+            }
+        } while (!mSeq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire));
+        std::atomic_thread_fence(std::memory_order_release);
+        T value;
+        loadWords(&value);
+        f(&value);
+        storeWords(value);
+        mSeq.store(seq + 2, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    void loadWords(T* value) const {
+        uint32_t words[kWords];
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i] = mWords[i].load(std::memory_order_relaxed);
+        }
+        memcpy(value, words, sizeof(T));
+    }
+
+    void storeWords(const T& value) {
+        uint32_t words[kWords] = {};
+        memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) {
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint32_t> mSeq{0};  // odd while a write is in progress
+    std::atomic<uint32_t> mWords[kWords];
+};
+
+}  // namespace android::afutils
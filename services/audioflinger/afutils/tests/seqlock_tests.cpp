@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../Seqlock.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using android::afutils::Seqlock;
+
+namespace {
+
+// Spans several words, so that a read overlapping a write could see a mix of both.
+struct Words {
+    uint64_t a;
+    uint64_t b;
+    uint64_t c;
+    uint64_t d;
+};
+
+Words words(uint64_t value) {
+    return {value, value, value, value};
+}
+
+TEST(seqlock_tests, load_store) {
+    Seqlock<Words> seqlock(words(3));
+    uint32_t version;
+    EXPECT_EQ(3u, seqlock.load(&version).c);
+    EXPECT_EQ(0u, version);
+
+    seqlock.store(words(4));
+    const Words value = seqlock.load(&version);
+    EXPECT_EQ(4u, value.a);
+    EXPECT_EQ(4u, value.d);
+    EXPECT_EQ(1u, version);
+    EXPECT_EQ(1u, seqlock.version());
+}
+
+TEST(seqlock_tests, modify_keeps_other_fields) {
+    Seqlock<Words> seqlock(words(1));
+    seqlock.modify([](Words* value) { value->b = 2; });
+    const Words value = seqlock.load();
+    EXPECT_EQ(1u, value.a);
+    EXPECT_EQ(2u, value.b);
+    EXPECT_EQ(1u, value.c);
+    EXPECT_EQ(1u, seqlock.version());
+}
+
+TEST(seqlock_tests, no_torn_reads) {
+    constexpr uint64_t kWrites = 200000;
+    Seqlock<Words> seqlock(words(0));
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> backwards{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            uint64_t last = 0;
+            uint32_t lastVersion = 0;
+            while (!done.load()) {
+                uint32_t version;
+                const Words value = seqlock.load(&version);
+                if (value.a != value.b || value.a != value.c || value.a != value.d) {
+                    ++torn;
+                }
+                // The version follows the value, as every write stores a larger value.
+                if (value.a < last || version < lastVersion || version != value.a) {
+                    ++backwards;
+                }
+                last = value.a;
+                lastVersion = version;
+            }
+        });
+    }
+    for (uint64_t i = 1; i <= kWrites; ++i) {
+        seqlock.store(words(i));
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+
+    EXPECT_EQ(0u, torn.load());
+    EXPECT_EQ(0u, backwards.load());
+    EXPECT_EQ(kWrites, seqlock.load().a);
+}
+
+TEST(seqlock_tests, concurrent_modify) {
+    constexpr uint64_t kModifies = 100000;
+    Seqlock<Words> seqlock(words(0));
+    std::thread other([&] {
+        for (uint64_t i = 0; i < kModifies; ++i) {
+            seqlock.modify([](Words* value) { ++value->a; });
+        }
+    });
+    for (uint64_t i = 0; i < kModifies; ++i) {
+        seqlock.modify([](Words* value) { ++value->b; });
+    }
+    other.join();
+
+    const Words value = seqlock.load();
+    EXPECT_EQ(kModifies, value.a);
+    EXPECT_EQ(kModifies, value.b);
+    EXPECT_EQ(2 * kModifies, seqlock.version());
+}
+
+TEST(seqlock_tests, load_retries_while_write_in_progress) {
+    Seqlock<Words> seqlock(words(1));
+    std::atomic<bool> writing{false};
+    std::atomic<bool> readerStarted{false};
+    std::atomic<bool> readerDone{false};
+    Words read{};
+
+    std::thread writer([&] {
+        seqlock.modify([&](Words* value) {
+            // The sequence is odd here, until modify() returns.
+            writing = true;
+            while (!readerStarted.load()) {
+                std::this_thread::yield();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            EXPECT_FALSE(readerDone.load());
+            *value = words(2);
+        });
+    });
+    while (!writing.load()) {
+        std::this_thread::yield();
+    }
+    std::thread reader([&] {
+        readerStarted = true;
+        read = seqlock.load();
+        readerDone = true;
+    });
+    writer.join();
+    reader.join();
+
+    // The reader started during the write, so it must not see the old value.
+    EXPECT_EQ(2u, read.a);
+    EXPECT_EQ(2u, read.d);
+}
+
+}  // namespace
@@ -129,6 +129,26 @@ public:
         mUnderrunFrames += frames;
     }
 
+    // Called for each HAL write scheduled by an AdaptiveWriteScheduler.
+    void logWriteSchedule(bool wakeup, bool miss, double marginMs) {
+        std::lock_guard l(mLock);
+        ++mScheduledWrites;
+        if (wakeup) {
+            ++mScheduledWakeups;
+            mScheduleMarginMs.add(marginMs);
+        }
+        if (miss) {
+            ++mScheduleMisses;
+        }
+    }
+
+    // Called for each throttle sleep between HAL writes scheduled by an
+    // AdaptiveWriteScheduler, which is a wakeup as well.
+    void logWriteThrottle() {
+        std::lock_guard l(mLock);
+        ++mScheduledWakeups;
+    }
+
     const std::string& getMetricsId() const {
         return mMetricsId;
     }
@@ -164,6 +184,14 @@ private:
                 item.set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)mUnderrunCount)
                     .set(AMEDIAMETRICS_PROP_UNDERRUNFRAMES, (int64_t)mUnderrunFrames);
             }
+            if (mScheduledWrites > 0) {
+                item.set(AMEDIAMETRICS_PROP_WRITES, mScheduledWrites)
+                    .set(AMEDIAMETRICS_PROP_WAKEUPS, mScheduledWakeups)
+                    .set(AMEDIAMETRICS_PROP_SCHEDULEMISSES, mScheduleMisses);
+                if (mScheduleMarginMs.getN() > 0) {
+                    item.set(AMEDIAMETRICS_PROP_SCHEDULEMARGINMS, mScheduleMarginMs.getMean());
+                }
+            }
             item.record();
         }
     }
@@ -181,6 +209,11 @@ private:
         mLastUnderrun = false;
         mUnderrunCount = 0;
         mUnderrunFrames = 0;
+
+        mScheduledWrites = 0;
+        mScheduledWakeups = 0;
+        mScheduleMisses = 0;
+        mScheduleMarginMs.reset();
     }
 
     const std::string mMetricsId;
@@ -206,6 +239,12 @@ private:
     bool              mLastUnderrun GUARDED_BY(mLock) = false; // checks consecutive underruns
     int64_t           mUnderrunCount GUARDED_BY(mLock) = 0;    // number of consecutive underruns
     int64_t           mUnderrunFrames GUARDED_BY(mLock) = 0;   // total estimated frames underrun
+
+    // adaptive write scheduling decisions
+    int64_t           mScheduledWrites GUARDED_BY(mLock) = 0;  // writes made by the scheduler
+    int64_t           mScheduledWakeups GUARDED_BY(mLock) = 0; // sleeps or blocking writes
+    int64_t           mScheduleMisses GUARDED_BY(mLock) = 0;   // wakeups finding the HAL drained
+    audio_utils::Statistics<double> mScheduleMarginMs GUARDED_BY(mLock);
 };
 
 } // namespace android
@@ -195,7 +195,8 @@ void FastMixer::onStateChange()
     const FastMixerState * const current = (const FastMixerState *) mCurrent;
     const FastMixerState * const previous = (const FastMixerState *) mPrevious;
     FastMixerDumpState * const dumpState = (FastMixerDumpState *) mDumpState;
-    const size_t frameCount = current->mFrameCount;
+    // in sub-period mode each cycle mixes and writes only a fraction of the sink period.
+    const size_t frameCount = current->mFrameCount / current->mSubPeriods;
 
     // update boottime offset, in case it has changed
     mTimestamp.mTimebaseOffset[ExtendedTimestamp::TIMEBASE_BOOTTIME] =
@@ -233,7 +234,9 @@ void FastMixer::onStateChange()
         dumpState->mSampleRate = mSampleRate;
     }
 
-    if ((!Format_isEqual(mFormat, previousFormat)) || (frameCount != previous->mFrameCount)) {
+    mSinkFrameCount = current->mFrameCount;
+    if ((!Format_isEqual(mFormat, previousFormat))
+            || (frameCount != previous->mFrameCount / previous->mSubPeriods)) {
         // FIXME to avoid priority inversion, don't delete here
         delete mMixer;
         mMixer = nullptr;
@@ -348,7 +351,8 @@ void FastMixer::onWork()
 #endif
     }
     const FastMixerState::Command command = mCommand;
-    const size_t frameCount = current->mFrameCount;
+    const size_t frameCount = current->mFrameCount / current->mSubPeriods;
+    mActiveMask = 0;
 
     if ((command & FastMixerState::MIX) && (mMixer != nullptr) && mIsWarm) {
         ALOG_ASSERT(mMixerBuffer != nullptr);
@@ -356,6 +360,9 @@ void FastMixer::onWork()
         // AudioMixer::mState.enabledTracks is undefined if mState.hook == process__validate,
         // so we keep a side copy of enabledTracks
         bool anyEnabledTracks = false;
+        unsigned enabledTrackMask = 0;  // for telemetry
+        int fullTrack = -1;             // a track with at least frameCount frames ready
+        gain_minifloat_packed_t fullTrackVlr = GAIN_MINIFLOAT_PACKED_UNITY;
 
         // for each track, update volume and check for underrun
         unsigned currentTrackMask = current->mTrackMask;
@@ -383,8 +390,9 @@ void FastMixer::onWork()
             fastTrack->mBufferProvider->onTimestamp(perTrackTimestamp);
 
             const int name = i;
+            gain_minifloat_packed_t vlr = GAIN_MINIFLOAT_PACKED_UNITY;
             if (fastTrack->mVolumeProvider != nullptr) {
-                const gain_minifloat_packed_t vlr = fastTrack->mVolumeProvider->getVolumeLR();
+                vlr = fastTrack->mVolumeProvider->getVolumeLR();
                 float vlf = float_from_gain(gain_minifloat_unpack_left(vlr));
                 float vrf = float_from_gain(gain_minifloat_unpack_right(vlr));
 
@@ -417,19 +425,31 @@ void FastMixer::onWork()
                     underruns.mBitFields.mMostRecent = UNDERRUN_PARTIAL;
                     mMixer->enable(name);
                     anyEnabledTracks = true;
+                    enabledTrackMask |= 1 << i;
                 }
             } else {
                 underruns.mBitFields.mFull++;
                 underruns.mBitFields.mMostRecent = UNDERRUN_FULL;
                 mMixer->enable(name);
                 anyEnabledTracks = true;
+                enabledTrackMask |= 1 << i;
+                fullTrack = i;
+                fullTrackVlr = vlr;
             }
             ftDump->mUnderruns = underruns;
             ftDump->mFramesReady = framesReady;
             ftDump->mFramesWritten = trackFramesWritten;
         }
+        mActiveMask = enabledTrackMask;
 
-        if (anyEnabledTracks) {
+        const bool singleFullTrack = fullTrack >= 0 && enabledTrackMask == 1u << fullTrack;
+        if (!singleFullTrack) {
+            mPassthroughTrack = -1;
+        }
+        if (singleFullTrack && (command & FastMixerState::WRITE) && mOutputSink != nullptr
+                && preparePassthrough(fullTrack, fullTrackVlr, frameCount)) {
+            // the mixer is bypassed this cycle
+        } else if (anyEnabledTracks) {
             // process() is CPU-bound
             mMixer->process();
             mMixerBufferState = MIXED;
@@ -443,33 +463,12 @@ void FastMixer::onWork()
     //bool didFullWrite = false;    // dumpsys could display a count of partial writes
     if ((command & FastMixerState::WRITE)
             && (mOutputSink != nullptr) && (mMixerBuffer != nullptr)) {
-        if (mMixerBufferState == UNDEFINED) {
-            memset(mMixerBuffer, 0, mMixerBufferSize);
-            mMixerBufferState = ZEROED;
-        }
-
-        if (mMasterMono.load()) {  // memory_order_seq_cst
-            mono_blend(mMixerBuffer, mMixerBufferFormat, Format_channelCount(mFormat), frameCount,
-                    true /*limit*/);
-        }
-
-        // Balance must take effect after mono conversion.
-        // mBalance detects zero balance within the class for speed (not needed here).
-        mBalance.setBalance(mMasterBalance.load());
-        mBalance.process((float *)mMixerBuffer, frameCount);
-
         // prepare the buffer used to write to sink
-        void *buffer = mSinkBuffer != nullptr ? mSinkBuffer : mMixerBuffer;
-        if (mFormat.mFormat != mMixerBufferFormat) { // sink format not the same as mixer format
-            memcpy_by_audio_format(buffer, mFormat.mFormat, mMixerBuffer, mMixerBufferFormat,
-                    frameCount * Format_channelCount(mFormat));
-        }
-        if (mSinkChannelMask & AUDIO_CHANNEL_HAPTIC_ALL) {
-            // When there are haptic channels, the sample data is partially interleaved.
-            // Make the sample data fully interleaved here.
-            adjust_channels_non_destructive(buffer, mAudioChannelCount, buffer, mSinkChannelCount,
-                    audio_bytes_per_sample(mFormat.mFormat),
-                    frameCount * audio_bytes_per_frame(mAudioChannelCount, mFormat.mFormat));
+        void *buffer;
+        if (mPassthroughBuffer.raw != nullptr) {
+            buffer = mPassthroughBuffer.raw;    // already in sink format
+        } else {
+            buffer = prepareSinkBuffer(frameCount);
         }
         // if non-nullptr, then duplicate write() to this non-blocking sink
 #ifdef TEE_SINK
@@ -493,6 +492,12 @@ void FastMixer::onWork()
             dumpState->mWriteErrors++;
         }
         mAttemptedWrite = true;
+        if (mPassthroughBuffer.raw != nullptr) {
+            // like the mixer, consume the whole period even if the sink took less
+            current->mFastTracks[mPassthroughTrack].mBufferProvider->releaseBuffer(
+                    &mPassthroughBuffer);
+            mPassthroughBuffer.raw = nullptr;
+        }
         // FIXME count # of writes blocked excessively, CPU usage, etc. for dump
 
         if (mIsWarm) {
@@ -529,6 +534,9 @@ void FastMixer::onWork()
             if (status == NO_ERROR) {
                 mTimestamp.mTimeNs[ExtendedTimestamp::LOCATION_SERVER] =
                         mTimestamp.mTimeNs[ExtendedTimestamp::LOCATION_KERNEL];
+                if (frameCount < mSinkFrameCount) {
+                    paceSubPeriod(frameCount);
+                }
             } else {
                 // fetch server time if we can't get timestamp
                 mTimestamp.mTimeNs[ExtendedTimestamp::LOCATION_SERVER] =
@@ -542,4 +550,108 @@ void FastMixer::onWork()
     }
 }
 
+bool FastMixer::preparePassthrough(int index, gain_minifloat_packed_t vlr, size_t frameCount)
+{
+    const FastMixerState * const current = (const FastMixerState *) mCurrent;
+    const FastTrack * const fastTrack = &current->mFastTracks[index];
+
+    // The mixer ramps a volume change over one period, so only bypass it once the
+    // volume has been stable for a cycle.
+    const bool volumeSettled = index == mPassthroughTrack && vlr == mPassthroughVlr;
+    mPassthroughTrack = index;
+    mPassthroughVlr = vlr;
+    const bool unity = vlr == GAIN_MINIFLOAT_PACKED_UNITY;
+    if (!volumeSettled
+            || fastTrack->mFormat != mFormat.mFormat
+            || fastTrack->mChannelMask != mSinkChannelMask  // also excludes haptic channels
+            || fastTrack->mHapticPlaybackEnabled
+            || mMasterMono.load() || mMasterBalance.load() != 0.f
+            // a constant volume is only applied here to float stereo
+            || (!unity && (mFormat.mFormat != mMixerBufferFormat
+                    || mSinkChannelCount != FCC_2))) {
+        return false;
+    }
+
+    ExtendedAudioBufferProvider * const provider = fastTrack->mBufferProvider;
+    mPassthroughBuffer.frameCount = frameCount;
+    if (provider->getNextBuffer(&mPassthroughBuffer) != NO_ERROR) {
+        mPassthroughBuffer.raw = nullptr;
+        return false;
+    }
+    if (mPassthroughBuffer.frameCount < frameCount) {
+        // the period wraps around the end of the track buffer, let the mixer handle it
+        mPassthroughBuffer.frameCount = 0;
+        provider->releaseBuffer(&mPassthroughBuffer);
+        mPassthroughBuffer.raw = nullptr;
+        return false;
+    }
+
+    if (unity) {
+        // mPassthroughBuffer is written directly to the sink and released after the write.
+        mMixerBufferState = UNDEFINED;
+        return true;
+    }
+    const float vl = float_from_gain(gain_minifloat_unpack_left(vlr));
+    const float vr = float_from_gain(gain_minifloat_unpack_right(vlr));
+    const float *in = (const float *) mPassthroughBuffer.raw;
+    float *out = (float *) mMixerBuffer;
+    for (size_t i = 0; i < frameCount; ++i) {
+        *out++ = *in++ * vl;
+        *out++ = *in++ * vr;
+    }
+    provider->releaseBuffer(&mPassthroughBuffer);
+    mPassthroughBuffer.raw = nullptr;
+    mMixerBufferState = MIXED;
+    return true;
+}
+
+void *FastMixer::prepareSinkBuffer(size_t frameCount)
+{
+    if (mMixerBufferState == UNDEFINED) {
+        memset(mMixerBuffer, 0, mMixerBufferSize);
+        mMixerBufferState = ZEROED;
+    }
+
+    if (mMasterMono.load()) {  // memory_order_seq_cst
+        mono_blend(mMixerBuffer, mMixerBufferFormat, Format_channelCount(mFormat), frameCount,
+                true /*limit*/);
+    }
+
+    // Balance must take effect after mono conversion.
+    // mBalance detects zero balance within the class for speed (not needed here).
+    mBalance.setBalance(mMasterBalance.load());
+    mBalance.process((float *)mMixerBuffer, frameCount);
+
+    void *buffer = mSinkBuffer != nullptr ? mSinkBuffer : mMixerBuffer;
+    if (mFormat.mFormat != mMixerBufferFormat) { // sink format not the same as mixer format
+        memcpy_by_audio_format(buffer, mFormat.mFormat, mMixerBuffer, mMixerBufferFormat,
+                frameCount * Format_channelCount(mFormat));
+    }
+    if (mSinkChannelMask & AUDIO_CHANNEL_HAPTIC_ALL) {
+        // When there are haptic channels, the sample data is partially interleaved.
+        // Make the sample data fully interleaved here.
+        adjust_channels_non_destructive(buffer, mAudioChannelCount, buffer, mSinkChannelCount,
+                audio_bytes_per_sample(mFormat.mFormat),
+                frameCount * audio_bytes_per_frame(mAudioChannelCount, mFormat.mFormat));
+    }
+    return buffer;
+}
+
+void FastMixer::paceSubPeriod(size_t frameCount)
+{
+    // Extrapolate the sink read position from the last kernel timestamp.
+    const int64_t nowNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    const int64_t sinceNs = nowNs - mTimestamp.mTimeNs[ExtendedTimestamp::LOCATION_KERNEL];
+    const int64_t presented = mTimestamp.mPosition[ExtendedTimestamp::LOCATION_KERNEL]
+            + (sinceNs > 0 ? sinceNs * mSampleRate / 1000000000LL : 0);
+    const int64_t queued = mTotalNativeFramesWritten - presented;
+
+    // Keep one sink period plus the sub-period being mixed queued. Writing further ahead
+    // only adds latency; a blocking sink would otherwise let us fill its whole buffer.
+    const int64_t excess = queued - (int64_t)(mSinkFrameCount + frameCount);
+    if (excess > 0) {
+        mPaceNs = excess * 1000000000LL / mSampleRate;
+    }
+}
+
 }   // namespace android
@@ -65,6 +65,19 @@ private:
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
 
+    // If the single active track index can bypass the mixer this cycle, either obtains
+    // its buffer into mPassthroughBuffer for writing to the sink as is (unity volume),
+    // or applies its volume into mMixerBuffer, and returns true.
+    bool preparePassthrough(int index, gain_minifloat_packed_t vlr, size_t frameCount);
+
+    // applies master mono, balance, format and haptic channel layout to mMixerBuffer,
+    // and returns the buffer to write to the sink.
+    void *prepareSinkBuffer(size_t frameCount);
+
+    // in sub-period mode, sets mPaceNs so that the sink does not queue more than
+    // one sink period ahead of its read position. Requires a valid mTimestamp.
+    void paceSubPeriod(size_t frameCount);
+
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
 
@@ -91,6 +104,8 @@ private:
     enum {UNDEFINED, MIXED, ZEROED} mMixerBufferState = UNDEFINED;
     NBAIO_Format    mFormat{Format_Invalid};
     unsigned        mSampleRate = 0;
+    size_t          mSinkFrameCount = 0;    // frames per sink period, a multiple of the
+                                            // frames mixed per cycle in sub-period mode
     int             mFastTracksGen = 0;
     FastMixerDumpState mDummyFastMixerDumpState;
     int64_t         mTotalNativeFramesWritten = 0;  // copied to dumpState->mFramesWritten
@@ -101,6 +116,11 @@ private:
 
     audio_utils::Balance mBalance;
 
+    // single track passthrough, see preparePassthrough()
+    int             mPassthroughTrack = -1;    // index of the single active track, or -1
+    gain_minifloat_packed_t mPassthroughVlr = GAIN_MINIFLOAT_PACKED_UNITY; // its last volume
+    AudioBufferProvider::Buffer mPassthroughBuffer; // raw is non-null from mix until write
+
     // accessed without lock between multiple threads.
     std::atomic_bool mMasterMono{};
     std::atomic<float> mMasterBalance{};
@@ -81,6 +81,9 @@ struct FastMixerState : FastThreadState {
     NBAIO_Sink* mOutputSink = nullptr; // HAL output device, must already be negotiated
     int         mOutputSinkGen = 0; // increment when mOutputSink is assigned
     size_t      mFrameCount = 0;    // number of frames per fast mix buffer
+    uint32_t    mSubPeriods = 1;    // if > 1, mix and write mFrameCount / mSubPeriods frames
+                                    // per cycle, paced by the sink timestamp; must divide
+                                    // mFrameCount
     audio_channel_mask_t mSinkChannelMask; // If not AUDIO_CHANNEL_NONE, specifies sink channel
                                            // mask when it cannot be directly calculated from
                                            // channel count
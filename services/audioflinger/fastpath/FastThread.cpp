@@ -20,6 +20,7 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <audio_utils/clock.h>
@@ -81,6 +82,7 @@ bool FastThread::threadLoop()
 
             // As soon as possible of learning of a new dump area, start using it
             mDumpState = next->mDumpState != nullptr ? next->mDumpState : mDummyDumpState;
+            mTelemetry = next->mTelemetry;
             NBLog::Writer * const writer = next->mNBLogWriter != nullptr ?
                     next->mNBLogWriter : mDummyNBLogWriter.get();
             aflog::setThreadWriter(writer);
@@ -225,8 +227,10 @@ bool FastThread::threadLoop()
                     }
                 }
                 mSleepNs = -1;
+                [[maybe_unused]] bool underrun = false;   // for telemetry
                 if (mIsWarm) {
                     if (sec > 0 || nsec > mUnderrunNs) {
+                        underrun = true;
                         ATRACE_NAME("underrun");   // NOLINT(misc-const-correctness)
                         // FIXME only log occasionally
                         ALOGV("underrun: time since last cycle %d.%03ld sec",
@@ -254,7 +258,14 @@ bool FastThread::threadLoop()
                     } else {
                         mIgnoreNextOverrun = false;
                     }
+                    if (mPaceNs > 0) {
+                        // Capping the delay at one period would only hold the sink queue
+                        // level, never drain it; 1.5 periods drains half a period per cycle
+                        // while keeping the cycle below mUnderrunNs.
+                        mSleepNs = std::max(mSleepNs, std::min(mPaceNs, mPeriodNs * 3 / 2));
+                    }
                 }
+                mPaceNs = 0;
 #ifdef FAST_THREAD_STATISTICS
                 if (mIsWarm) {
                     // advance the FIFO queue bounds
@@ -313,6 +324,9 @@ bool FastThread::threadLoop()
                     mDumpState->mBounds = mBounds;
                     ATRACE_INT(mCycleMs, monotonicNs / 1000000);
                     ATRACE_INT(mLoadUs, loadNs / 1000);
+                    if (mTelemetry != nullptr) {
+                        mTelemetry->push({monotonicNs, loadNs, mActiveMask, underrun});
+                    }
                 }
 #endif
             } else {
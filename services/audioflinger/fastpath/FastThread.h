@@ -22,6 +22,7 @@
 #endif
 #include <utils/Thread.h>
 #include "FastThreadState.h"
+#include "FastThreadTelemetry.h"
 
 namespace android {
 
@@ -62,8 +63,12 @@ protected:
     int64_t         mWarmupNsMin = 0;  // warmup complete when write cycle is greater
                                        //  than or equal to this value
     int64_t         mWarmupNsMax = INT64_MAX;  // and less than or equal to this value
+    int64_t         mPaceNs = 0;       // if > 0, set by onWork() to delay the next cycle
+                                       // at least this long, e.g. until the sink drains
     FastThreadDumpState* mDummyDumpState = nullptr;
     FastThreadDumpState* mDumpState = nullptr;
+    FastThreadTelemetry* mTelemetry = nullptr;  // optional, receives a record per warm cycle
+    uint32_t        mActiveMask = 0;   // set by onWork() to the tracks serviced in the cycle
     bool            mIgnoreNextOverrun = true; // used to ignore initial overrun
                                                //  and first after an underrun
 #ifdef FAST_THREAD_STATISTICS
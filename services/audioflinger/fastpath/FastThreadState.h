@@ -24,6 +24,7 @@
 namespace android {
 
 struct FastThreadDumpState;
+class FastThreadTelemetry;
 
 // Represents a single state of a FastThread
 struct FastThreadState {
@@ -43,6 +44,7 @@ struct FastThreadState {
     // This might be a one-time configuration rather than per-state
     FastThreadDumpState* mDumpState = nullptr; // if non-NULL, then update dump state periodically
     NBLog::Writer* mNBLogWriter = nullptr; // non-blocking logger
+    FastThreadTelemetry* mTelemetry = nullptr; // if non-NULL, then push per-cycle timing
 
     // returns NULL if command belongs to a subclass
     static const char *commandToString(Command command);
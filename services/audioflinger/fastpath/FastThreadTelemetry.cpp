@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FastThreadTelemetry"
+//#define LOG_NDEBUG 0
+
+#include "FastThreadTelemetry.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include <audio_utils/roundup.h>
+
+namespace android {
+
+FastThreadTelemetry::FastThreadTelemetry(uint32_t capacity)
+    : mBuffer(new FastThreadCycle[roundup(capacity)])
+    , mFifo(roundup(capacity), sizeof(FastThreadCycle), mBuffer.get(),
+            false /*throttlesWriter*/)
+    , mWriter(mFifo)
+    , mReader(mFifo, false /*throttlesWriter*/, false /*flush*/)
+{
+}
+
+size_t FastThreadTelemetry::drain(FastThreadCycle* cycles, size_t count, size_t* lost)
+{
+    size_t totalLost = 0;
+    for (;;) {
+        size_t lostNow = 0;
+        const ssize_t actual = mReader.read(cycles, count, nullptr /*timeout*/, &lostNow);
+        totalLost += lostNow;
+        if (actual != -EOVERFLOW) {
+            *lost = totalLost;
+            return actual > 0 ? actual : 0;
+        }
+        // the reader was resynchronized to the oldest valid record, try again
+    }
+}
+
+void FastThreadCycleStats::add(const FastThreadCycle* cycles, size_t count, size_t lost)
+{
+    mLost += lost;
+    for (size_t i = 0; i < count; ++i) {
+        const FastThreadCycle& cycle = cycles[i];
+        ++mCycles;
+        if (cycle.mUnderrun) {
+            ++mUnderruns;
+        }
+        mSumWallNs += cycle.mWallNs;
+        mSumCpuNs += cycle.mCpuNs;
+        mMaxWallNs = std::max(mMaxWallNs, cycle.mWallNs);
+        mMaxCpuNs = std::max(mMaxCpuNs, cycle.mCpuNs);
+        mMaxActiveTracks = std::max(mMaxActiveTracks,
+                (uint32_t)__builtin_popcount(cycle.mActiveMask));
+
+        const int64_t jitterUs = std::abs((int64_t)cycle.mWallNs - mPeriodNs) / 1000;
+        mJitter[std::upper_bound(std::begin(kJitterBoundsUs), std::end(kJitterBoundsUs),
+                jitterUs) - std::begin(kJitterBoundsUs)]++;
+        if (mPeriodNs > 0) {
+            const size_t bucket = (int64_t)cycle.mCpuNs * 10 / mPeriodNs;
+            mLoad[std::min(bucket, kLoadBuckets - 1)]++;
+        }
+    }
+}
+
+void FastThreadCycleStats::reset()
+{
+    *this = FastThreadCycleStats(mPeriodNs);
+}
+
+template <size_t N>
+static std::string histogramToString(const int64_t (&buckets)[N])
+{
+    std::stringstream ss;
+    for (size_t i = 0; i < N; ++i) {
+        if (i > 0) ss << "|";
+        ss << buckets[i];
+    }
+    return ss.str();
+}
+
+std::string FastThreadCycleStats::jitterHistogram() const
+{
+    return histogramToString(mJitter);
+}
+
+std::string FastThreadCycleStats::loadHistogram() const
+{
+    return histogramToString(mLoad);
+}
+
+std::string FastThreadCycleStats::toString() const
+{
+    std::stringstream ss;
+    ss << "cycles: " << mCycles << " lost: " << mLost << " underruns: " << mUnderruns;
+    if (mCycles > 0) {
+        ss << " wall ms mean: " << mSumWallNs * 1e-6 / mCycles
+                << " max: " << mMaxWallNs * 1e-6
+                << " cpu ms mean: " << mSumCpuNs * 1e-6 / mCycles
+                << " max: " << mMaxCpuNs * 1e-6
+                << " max active tracks: " << mMaxActiveTracks;
+    }
+    ss << "\n  jitter us (<=";
+    for (uint32_t bound : kJitterBoundsUs) {
+        ss << " " << bound;
+    }
+    ss << " >): " << jitterHistogram() << "\n  load 10% buckets: " << loadHistogram();
+    return ss.str();
+}
+
+}  // namespace android
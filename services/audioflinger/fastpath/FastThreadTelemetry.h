@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iterator>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+#include <audio_utils/fifo.h>
+
+namespace android {
+
+// Timing of one fast thread cycle, as measured at the top of the following cycle.
+struct FastThreadCycle {
+    uint32_t mWallNs;       // delta of CLOCK_MONOTONIC since the previous cycle
+    uint32_t mCpuNs;        // delta of CLOCK_THREAD_CPUTIME_ID since the previous cycle
+    uint32_t mActiveMask;   // fast tracks that were mixed in the cycle
+    uint32_t mUnderrun;     // non-zero if the cycle was late enough to be counted as underrun
+};
+
+// FastThreadTelemetry is a lock-free single producer, single consumer ring of
+// FastThreadCycle records. The fast thread is the only producer; it never blocks and
+// overwrites the oldest records if the reader falls behind. The reader learns about
+// overwritten records through the lost count of drain().
+//
+// Unlike the mMonotonicNs / mLoadNs arrays of FastThreadDumpState, every record is
+// delivered exactly once (or reported lost), so a reader can aggregate them continuously.
+class FastThreadTelemetry {
+public:
+    static constexpr uint32_t kDefaultCapacity = 1024;   // cycles, rounded up to a power of 2
+
+    explicit FastThreadTelemetry(uint32_t capacity = kDefaultCapacity);
+
+    FastThreadTelemetry(const FastThreadTelemetry&) = delete;
+    FastThreadTelemetry& operator=(const FastThreadTelemetry&) = delete;
+
+    // Called by the fast thread only. Wait-free.
+    void push(const FastThreadCycle& cycle) { mWriter.write(&cycle, 1); }
+
+    // Called by the single reader only. Copies up to count of the oldest available
+    // records into cycles and returns the number copied. *lost is set to the number of
+    // records overwritten by the producer since the previous call.
+    size_t drain(FastThreadCycle* cycles, size_t count, size_t* lost);
+
+private:
+    const std::unique_ptr<FastThreadCycle[]> mBuffer;
+    audio_utils_fifo        mFifo;
+    audio_utils_fifo_writer mWriter;
+    audio_utils_fifo_reader mReader;
+};
+
+// FastThreadCycleStats aggregates drained cycles into fixed-bucket histograms,
+// which can be merged across devices by summing bucket counts.
+// Not thread-safe; intended for the non-RT reader of a FastThreadTelemetry.
+class FastThreadCycleStats {
+public:
+    // Upper bounds in microseconds of the |wall time - period| jitter buckets.
+    // A final bucket counts cycles with larger jitter.
+    static constexpr uint32_t kJitterBoundsUs[] = {50, 100, 200, 500, 1000, 2000, 5000};
+    static constexpr size_t kJitterBuckets = std::size(kJitterBoundsUs) + 1;
+    // CPU load as a fraction of the period in 10% buckets, the last one is >= 100%.
+    static constexpr size_t kLoadBuckets = 11;
+
+    explicit FastThreadCycleStats(int64_t periodNs = 0) : mPeriodNs(periodNs) {}
+
+    void setPeriodNs(int64_t periodNs) { mPeriodNs = periodNs; }
+
+    void add(const FastThreadCycle* cycles, size_t count, size_t lost);
+    void reset();
+
+    int64_t cycles() const { return mCycles; }
+    int64_t lost() const { return mLost; }
+    int64_t underruns() const { return mUnderruns; }
+    uint32_t maxWallNs() const { return mMaxWallNs; }
+    uint32_t maxCpuNs() const { return mMaxCpuNs; }
+
+    // Bucket counts separated by '|', suitable for mediametrics.
+    std::string jitterHistogram() const;
+    std::string loadHistogram() const;
+
+    std::string toString() const;
+
+private:
+    int64_t  mPeriodNs;
+    int64_t  mCycles = 0;
+    int64_t  mLost = 0;
+    int64_t  mUnderruns = 0;
+    int64_t  mSumWallNs = 0;
+    int64_t  mSumCpuNs = 0;
+    uint32_t mMaxWallNs = 0;
+    uint32_t mMaxCpuNs = 0;
+    uint32_t mMaxActiveTracks = 0;
+    int64_t  mJitter[kJitterBuckets]{};
+    int64_t  mLoad[kLoadBuckets]{};
+};
+
+}  // namespace android
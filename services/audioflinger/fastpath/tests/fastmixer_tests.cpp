@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FastMixer_tests"
+
+#include "FastMixer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <audio_utils/minifloat.h>
+#include <gtest/gtest.h>
+#include <media/nbaio/NBAIO.h>
+#include <utils/Timers.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kFrameCount = 256;                 // sink period
+constexpr size_t kTrackFrames = kFrameCount * 16;   // a whole number of periods
+
+// Sample value of both channels of a track frame; never zero, so silence is told apart.
+float sampleAt(int64_t frame) {
+    return 0.5f * (frame % kTrackFrames + 1) / (kTrackFrames + 1);
+}
+
+// A sink that never blocks and plays at kSampleRate from its first write, stalling when
+// empty. It records each write for inspection after the mixer has exited.
+class TestSink : public NBAIO_Sink {
+public:
+    struct Write {
+        const void* buffer;
+        size_t frameCount;
+        int64_t timeNs;
+        int64_t queued;             // frames written but not yet presented before the write
+        std::vector<float> samples; // interleaved stereo, float sinks only
+    };
+
+    explicit TestSink(audio_format_t format)
+        : NBAIO_Sink(Format_from_SR_C(kSampleRate, FCC_2, format)), mSampleFormat(format) {
+        mNegotiated = true;
+        mWrites.reserve(4096);
+    }
+
+    ssize_t write(const void* buffer, size_t count) override {
+        const int64_t nowNs = systemTime(SYSTEM_TIME_MONOTONIC);
+        Write record{buffer, count, nowNs, mFramesWritten - present(nowNs), {}};
+        if (mSampleFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            const float* samples = static_cast<const float*>(buffer);
+            record.samples.assign(samples, samples + count * FCC_2);
+        }
+        mWrites.push_back(std::move(record));
+        mFramesWritten += count;
+        return count;
+    }
+
+    status_t getTimestamp(ExtendedTimestamp& timestamp) override {
+        const int64_t nowNs = systemTime(SYSTEM_TIME_MONOTONIC);
+        timestamp.mPosition[ExtendedTimestamp::LOCATION_KERNEL] = present(nowNs);
+        timestamp.mTimeNs[ExtendedTimestamp::LOCATION_KERNEL] = nowNs;
+        return NO_ERROR;
+    }
+
+    const std::vector<Write>& writes() const { return mWrites; }
+
+private:
+    // advances and returns the read position
+    int64_t present(int64_t nowNs) {
+        if (mLastNs > 0) {
+            mPresented = std::min((double)mFramesWritten,
+                    mPresented + (nowNs - mLastNs) * 1e-9 * kSampleRate);
+        }
+        mLastNs = nowNs;
+        return (int64_t)mPresented;
+    }
+
+    const audio_format_t mSampleFormat;
+    std::vector<Write> mWrites;
+    double mPresented = 0;
+    int64_t mLastNs = 0;
+};
+
+// A float stereo track with its whole buffer always ready, holding sampleAt() for each frame.
+class TestTrack : public ExtendedAudioBufferProvider, public VolumeProvider {
+public:
+    explicit TestTrack(float volume = 1.f)
+        : mBuffer(kTrackFrames * FCC_2),
+          mVolume(gain_minifloat_pack(gain_from_float(volume), gain_from_float(volume))) {
+        for (size_t i = 0; i < kTrackFrames; ++i) {
+            mBuffer[i * FCC_2] = mBuffer[i * FCC_2 + 1] = sampleAt(i);
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const size_t offset = mReleased % kTrackFrames;
+        buffer->frameCount = std::min(buffer->frameCount, kTrackFrames - offset);
+        buffer->raw = &mBuffer[offset * FCC_2];
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mReleased += buffer->frameCount;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+    size_t framesReady() const override { return kTrackFrames; }
+    int64_t framesReleased() const override { return mReleased; }
+    gain_minifloat_packed_t getVolumeLR() const override { return mVolume; }
+
+    bool contains(const void* buffer) const {
+        return buffer >= mBuffer.data() && buffer < mBuffer.data() + mBuffer.size();
+    }
+
+private:
+    std::vector<float> mBuffer;
+    const gain_minifloat_packed_t mVolume;
+    int64_t mReleased = 0;
+};
+
+// Mixes the tracks to the sink for the duration, kFrameCount / subPeriods frames per cycle,
+// then exits the mixer.
+void mix(TestSink* sink, const std::vector<TestTrack*>& tracks, uint32_t subPeriods,
+        std::chrono::milliseconds duration) {
+    const sp<FastMixer> mixer = sp<FastMixer>::make(AUDIO_IO_HANDLE_NONE);
+    FastMixerStateQueue* sq = mixer->sq();
+    FastMixerState* state = sq->begin();
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        FastTrack* fastTrack = &state->mFastTracks[i];
+        fastTrack->mBufferProvider = tracks[i];
+        fastTrack->mVolumeProvider = tracks[i];
+        fastTrack->mChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+        fastTrack->mFormat = AUDIO_FORMAT_PCM_FLOAT;
+        fastTrack->mGeneration++;
+        state->mTrackMask |= 1 << i;
+    }
+    state->mFastTracksGen++;
+    state->mOutputSink = sink;
+    state->mOutputSinkGen++;
+    state->mFrameCount = kFrameCount;
+    state->mSubPeriods = subPeriods;
+    state->mSinkChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+    state->mCommand = FastMixerState::MIX_WRITE;
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+    mixer->run("FastMixer", PRIORITY_URGENT_AUDIO);
+
+    std::this_thread::sleep_for(duration);
+
+    state = sq->begin();
+    state->mCommand = FastMixerState::EXIT;
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+    mixer->join();
+}
+
+struct TrackOutput {
+    size_t frames = 0;      // track frames found in the sink, after the warmup silence
+    size_t mismatches = 0;  // samples that are not the next track frame times the gain
+};
+
+// Checks that the sink played the track frames in order, multiplied by gain.
+TrackOutput checkTrackOutput(const TestSink& sink, float gain) {
+    TrackOutput output;
+    for (const auto& write : sink.writes()) {
+        for (size_t i = 0; i < write.frameCount; ++i) {
+            const float* frame = &write.samples[i * FCC_2];
+            if (output.frames == 0 && frame[0] == 0.f) {
+                continue;
+            }
+            const float expected = gain * sampleAt(output.frames++);
+            for (size_t c = 0; c < FCC_2; ++c) {
+                if (std::abs(frame[c] - expected) > 1e-6f) {
+                    output.mismatches++;
+                }
+            }
+        }
+    }
+    return output;
+}
+
+TEST(FastMixer, writesWholePeriod) {
+    const auto sink = sp<TestSink>::make(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack track;
+    mix(sink.get(), {&track}, 1 /* subPeriods */, std::chrono::milliseconds(100));
+
+    ASSERT_FALSE(sink->writes().empty());
+    for (const auto& write : sink->writes()) {
+        EXPECT_EQ(kFrameCount, write.frameCount);
+    }
+    const TrackOutput output = checkTrackOutput(*sink, 1.f);
+    EXPECT_GT(output.frames, kFrameCount);
+    EXPECT_EQ(0u, output.mismatches);
+}
+
+TEST(FastMixer, subPeriodsWriteFractionOfPeriod) {
+    constexpr uint32_t kSubPeriods = 4;
+    const auto sink = sp<TestSink>::make(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack track;
+    mix(sink.get(), {&track}, kSubPeriods, std::chrono::milliseconds(100));
+
+    ASSERT_FALSE(sink->writes().empty());
+    for (const auto& write : sink->writes()) {
+        EXPECT_EQ(kFrameCount / kSubPeriods, write.frameCount);
+    }
+    const TrackOutput output = checkTrackOutput(*sink, 1.f);
+    EXPECT_GT(output.frames, kFrameCount);
+    EXPECT_EQ(0u, output.mismatches);
+}
+
+TEST(FastMixer, subPeriodsPacedToOnePeriodAhead) {
+    constexpr uint32_t kSubPeriods = 4;
+    constexpr size_t kSubPeriodFrames = kFrameCount / kSubPeriods;
+    const auto sink = sp<TestSink>::make(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack track;
+    mix(sink.get(), {&track}, kSubPeriods, std::chrono::milliseconds(400));
+
+    // Without pacing the overrun protection alone writes 5% faster than real time, and
+    // warmup writes back to back; the queue must settle at a period plus a sub-period.
+    const auto& writes = sink->writes();
+    ASSERT_FALSE(writes.empty());
+    const int64_t settledNs = writes.front().timeNs + 200000000;   // 200 ms
+    size_t settledWrites = 0;
+    for (const auto& write : writes) {
+        if (write.timeNs < settledNs) {
+            continue;
+        }
+        ++settledWrites;
+        EXPECT_LE(write.queued, (int64_t)(kFrameCount + 2 * kSubPeriodFrames));
+    }
+    EXPECT_GT(settledWrites, 0u);
+}
+
+// Returns the number of writes that handed the sink the track buffer itself.
+size_t countPassthroughWrites(const TestSink& sink, const TestTrack& track) {
+    return std::count_if(sink.writes().begin(), sink.writes().end(),
+            [&](const TestSink::Write& write) { return track.contains(write.buffer); });
+}
+
+TEST(FastMixer, singleTrackBypassesMixer) {
+    for (const uint32_t subPeriods : {1u, 4u}) {
+        SCOPED_TRACE(testing::Message() << "subPeriods " << subPeriods);
+        const auto sink = sp<TestSink>::make(AUDIO_FORMAT_PCM_FLOAT);
+        TestTrack track;
+        mix(sink.get(), {&track}, subPeriods, std::chrono::milliseconds(100));
+
+        // The first mixed cycle goes through the mixer while the volume settles,
+        // every cycle after it writes the track buffer to the sink.
+        const auto& writes = sink->writes();
+        const auto first = std::find_if(writes.begin(), writes.end(),
+                [&](const TestSink::Write& write) { return track.contains(write.buffer); });
+        ASSERT_NE(writes.end(), first);
+        for (auto write = first; write != writes.end(); ++write) {
+            EXPECT_TRUE(track.contains(write->buffer));
+            EXPECT_EQ(kFrameCount / subPeriods, write->frameCount);
+        }
+        const TrackOutput output = checkTrackOutput(*sink, 1.f);
+        EXPECT_GT(output.frames, kFrameCount);
+        EXPECT_EQ(0u, output.mismatches);
+    }
+}
+
+TEST(FastMixer, twoTracksAreMixed) {
+    const auto sink = sp<TestSink>::make(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack track0;
+    TestTrack track1;
+    mix(sink.get(), {&track0, &track1}, 1 /* subPeriods */, std::chrono::milliseconds(100));
+
+    EXPECT_EQ(0u, countPassthroughWrites(*sink, track0));
+    EXPECT_EQ(0u, countPassthroughWrites(*sink, track1));
+    const TrackOutput output = checkTrackOutput(*sink, 2.f);
+    EXPECT_GT(output.frames, kFrameCount);
+    EXPECT_EQ(0u, output.mismatches);
+}
+
+TEST(FastMixer, singleTrackVolumeIsApplied) {
+    const auto sink = sp<TestSink>::make(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack track(0.5f /* volume */);
+    mix(sink.get(), {&track}, 1 /* subPeriods */, std::chrono::milliseconds(100));
+
+    // the volume is applied into the mixer buffer, never in place in the track
+    EXPECT_EQ(0u, countPassthroughWrites(*sink, track));
+    const TrackOutput output = checkTrackOutput(*sink, 0.5f);
+    EXPECT_GT(output.frames, kFrameCount);
+    EXPECT_EQ(0u, output.mismatches);
+}
+
+TEST(FastMixer, sinkFormatMismatchIsMixed) {
+    const auto sink = sp<TestSink>::make(AUDIO_FORMAT_PCM_16_BIT);
+    TestTrack track;
+    mix(sink.get(), {&track}, 1 /* subPeriods */, std::chrono::milliseconds(100));
+
+    ASSERT_FALSE(sink->writes().empty());
+    EXPECT_EQ(0u, countPassthroughWrites(*sink, track));
+    EXPECT_GT(track.framesReleased(), (int64_t)kFrameCount);
+}
+
+}  // namespace
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FastThreadTelemetry_tests"
+
+#include "FastThreadTelemetry.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace android;
+
+namespace {
+
+constexpr int64_t kPeriodNs = 1'000'000;
+
+FastThreadCycle makeCycle(uint32_t index) {
+    return {index, index, 0 /*activeMask*/, 0 /*underrun*/};
+}
+
+TEST(FastThreadTelemetry, drainEmpty) {
+    FastThreadTelemetry telemetry(8);
+    FastThreadCycle cycles[8];
+    size_t lost = 1;
+    EXPECT_EQ(0u, telemetry.drain(cycles, std::size(cycles), &lost));
+    EXPECT_EQ(0u, lost);
+}
+
+TEST(FastThreadTelemetry, drainInOrder) {
+    FastThreadTelemetry telemetry(16);
+    for (uint32_t i = 0; i < 10; ++i) {
+        telemetry.push(makeCycle(i));
+    }
+    FastThreadCycle cycles[4];
+    size_t lost = 1;
+    uint32_t expected = 0;
+    size_t count;
+    while ((count = telemetry.drain(cycles, std::size(cycles), &lost)) > 0) {
+        EXPECT_EQ(0u, lost);
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(expected++, cycles[i].mWallNs);
+        }
+    }
+    EXPECT_EQ(10u, expected);
+
+    // each record is delivered once.
+    telemetry.push(makeCycle(10));
+    ASSERT_EQ(1u, telemetry.drain(cycles, std::size(cycles), &lost));
+    EXPECT_EQ(10u, cycles[0].mWallNs);
+}
+
+// The producer never blocks, a reader that falls behind gets the newest records and the
+// number of records it missed.
+TEST(FastThreadTelemetry, overflowReportsLost) {
+    constexpr uint32_t kCapacity = 8;
+    constexpr uint32_t kPushed = 3 * kCapacity + 3;
+    FastThreadTelemetry telemetry(kCapacity);
+    for (uint32_t i = 0; i < kPushed; ++i) {
+        telemetry.push(makeCycle(i));
+    }
+    FastThreadCycle cycles[kPushed];
+    size_t lost = 0;
+    const size_t count = telemetry.drain(cycles, std::size(cycles), &lost);
+    ASSERT_GT(count, 0u);
+    EXPECT_LE(count, kCapacity);
+    EXPECT_EQ(kPushed, count + lost);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(lost + i, cycles[i].mWallNs);
+    }
+
+    // the reader is resynchronized.
+    telemetry.push(makeCycle(kPushed));
+    ASSERT_EQ(1u, telemetry.drain(cycles, std::size(cycles), &lost));
+    EXPECT_EQ(0u, lost);
+    EXPECT_EQ(kPushed, cycles[0].mWallNs);
+}
+
+TEST(FastThreadTelemetry, concurrentProducer) {
+    constexpr uint32_t kPushed = 100'000;
+    FastThreadTelemetry telemetry(64);
+    std::atomic_bool done = false;
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < kPushed; ++i) {
+            telemetry.push(makeCycle(i));
+        }
+        done = true;
+    });
+
+    FastThreadCycle cycles[16];
+    size_t received = 0;
+    size_t totalLost = 0;
+    int64_t previous = -1;
+    for (;;) {
+        const bool finished = done;
+        size_t lost;
+        const size_t count = telemetry.drain(cycles, std::size(cycles), &lost);
+        totalLost += lost;
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_GT((int64_t)cycles[i].mWallNs, previous);
+            previous = cycles[i].mWallNs;
+        }
+        received += count;
+        if (finished && count == 0) break;
+    }
+    producer.join();
+    EXPECT_EQ(kPushed, received + totalLost);
+    EXPECT_EQ(kPushed - 1, previous);
+}
+
+TEST(FastThreadCycleStats, counts) {
+    FastThreadCycleStats stats(kPeriodNs);
+    const FastThreadCycle cycles[] = {
+        {1'000'000, 200'000, 0x1, 0},
+        {1'500'000, 700'000, 0x7, 1},
+        {  900'000, 300'000, 0x3, 0},
+    };
+    stats.add(cycles, std::size(cycles), 5 /*lost*/);
+    EXPECT_EQ(3, stats.cycles());
+    EXPECT_EQ(5, stats.lost());
+    EXPECT_EQ(1, stats.underruns());
+    EXPECT_EQ(1'500'000u, stats.maxWallNs());
+    EXPECT_EQ(700'000u, stats.maxCpuNs());
+
+    stats.add(cycles, 1, 2 /*lost*/);
+    EXPECT_EQ(4, stats.cycles());
+    EXPECT_EQ(7, stats.lost());
+}
+
+TEST(FastThreadCycleStats, jitterHistogram) {
+    FastThreadCycleStats stats(kPeriodNs);
+    const FastThreadCycle cycles[] = {
+        {kPeriodNs, 0, 0, 0},                 // <= 50 us
+        {kPeriodNs - 30'000, 0, 0, 0},        // <= 50 us, early is jitter too
+        {kPeriodNs + 75'000, 0, 0, 0},        // <= 100 us
+        {kPeriodNs + 150'000, 0, 0, 0},       // <= 200 us
+        {kPeriodNs + 4'000'000, 0, 0, 0},     // <= 5000 us
+        {kPeriodNs + 10'000'000, 0, 0, 0},    // > 5000 us
+    };
+    stats.add(cycles, std::size(cycles), 0 /*lost*/);
+    EXPECT_EQ("2|1|1|0|0|0|1|1", stats.jitterHistogram());
+}
+
+TEST(FastThreadCycleStats, loadHistogram) {
+    FastThreadCycleStats stats(kPeriodNs);
+    const FastThreadCycle cycles[] = {
+        {kPeriodNs, 50'000, 0, 0},       // 5%
+        {kPeriodNs, 250'000, 0, 0},      // 25%
+        {kPeriodNs, 290'000, 0, 0},      // 29%
+        {kPeriodNs, 999'999, 0, 0},      // 99%
+        {kPeriodNs, 1'000'000, 0, 0},    // 100%
+        {kPeriodNs, 3'000'000, 0, 0},    // 300%
+    };
+    stats.add(cycles, std::size(cycles), 0 /*lost*/);
+    EXPECT_EQ("1|0|2|0|0|0|0|0|0|1|2", stats.loadHistogram());
+
+    // without a period, the load is unknown.
+    FastThreadCycleStats noPeriod;
+    noPeriod.add(cycles, std::size(cycles), 0 /*lost*/);
+    EXPECT_EQ("0|0|0|0|0|0|0|0|0|0|0", noPeriod.loadHistogram());
+    EXPECT_EQ(6, noPeriod.cycles());
+}
+
+TEST(FastThreadCycleStats, resetKeepsPeriod) {
+    FastThreadCycleStats stats(kPeriodNs);
+    const FastThreadCycle cycle = {kPeriodNs + 150'000, 500'000, 0x3, 1};
+    stats.add(&cycle, 1, 3 /*lost*/);
+    stats.reset();
+    EXPECT_EQ(0, stats.cycles());
+    EXPECT_EQ(0, stats.lost());
+    EXPECT_EQ(0, stats.underruns());
+    EXPECT_EQ(0u, stats.maxWallNs());
+    EXPECT_EQ(0u, stats.maxCpuNs());
+    EXPECT_EQ("0|0|0|0|0|0|0|0", stats.jitterHistogram());
+
+    stats.add(&cycle, 1, 0 /*lost*/);
+    EXPECT_EQ("0|0|1|0|0|0|0|0", stats.jitterHistogram());
+    EXPECT_EQ("0|0|0|0|0|1|0|0|0|0|0", stats.loadHistogram());
+}
+
+TEST(FastThreadCycleStats, toString) {
+    FastThreadCycleStats stats(kPeriodNs);
+    EXPECT_EQ(std::string::npos, stats.toString().find("mean"));
+
+    const FastThreadCycle cycles[] = {
+        {1'000'000, 200'000, 0x1, 0},
+        {3'000'000, 600'000, 0x13, 1},
+    };
+    stats.add(cycles, std::size(cycles), 4 /*lost*/);
+    const std::string s = stats.toString();
+    EXPECT_NE(std::string::npos, s.find("cycles: 2 lost: 4 underruns: 1")) << s;
+    EXPECT_NE(std::string::npos, s.find("wall ms mean: 2 max: 3")) << s;
+    EXPECT_NE(std::string::npos, s.find("cpu ms mean: 0.4 max: 0.6")) << s;
+    EXPECT_NE(std::string::npos, s.find("max active tracks: 3")) << s;
+    EXPECT_NE(std::string::npos, s.find(stats.jitterHistogram())) << s;
+    EXPECT_NE(std::string::npos, s.find(stats.loadHistogram())) << s;
+}
+
+} // namespace
@@ -0,0 +1,629 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "DirectPatchEngine_tests"
+
+#include <DirectPatchEngine.h>
+#include <PatchCommandThread.h>
+#include <PatchPanel.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <audio_utils/mutex.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <media/PatchBuilder.h>
+#include <media/audiohal/StreamHalInterface.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace {
+
+using media::audio::common::AudioMMapPolicyInfo;
+using media::audio::common::AudioMMapPolicyType;
+using media::audio::common::AudioMode;
+using media::audio::common::AudioPort;
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::Return;
+
+constexpr audio_module_handle_t kSourceModule = 1;
+constexpr audio_module_handle_t kSinkModule = 2;
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kHalFrameCount = 240;  // 5 ms at kSampleRate
+constexpr auto kTransferTimeout = std::chrono::seconds(2);
+
+class FakeDeviceHal;
+
+// Stream HAL methods common to input and output streams. The stream reports the
+// configuration it was opened with and paces transfers to a HAL buffer per millisecond.
+template <typename T>
+class FakeStreamHal : public T {
+public:
+    FakeStreamHal(const sp<FakeDeviceHal>& device, const audio_config_base_t& config,
+            uint32_t channelCount);
+    ~FakeStreamHal() override;
+
+    status_t getBufferSize(size_t* size) override {
+        *size = kHalFrameCount * mFrameSize;
+        return OK;
+    }
+    status_t getAudioProperties(audio_config_base_t* configBase) override {
+        *configBase = mConfig;
+        return OK;
+    }
+    status_t setParameters(const String8&) override { return OK; }
+    status_t getParameters(const String8&, String8*) override { return INVALID_OPERATION; }
+    status_t getFrameSize(size_t* size) override {
+        *size = mFrameSize;
+        return OK;
+    }
+    status_t addEffect(sp<EffectHalInterface>) override { return INVALID_OPERATION; }
+    status_t removeEffect(sp<EffectHalInterface>) override { return INVALID_OPERATION; }
+    status_t standby() override;
+    status_t dump(int, const Vector<String16>&) override { return OK; }
+    status_t start() override { return INVALID_OPERATION; }
+    status_t stop() override { return INVALID_OPERATION; }
+    status_t createMmapBuffer(int32_t, struct audio_mmap_buffer_info*) override {
+        return INVALID_OPERATION;
+    }
+    status_t getMmapPosition(struct audio_mmap_position*) override { return INVALID_OPERATION; }
+    status_t setHalThreadPriority(int) override { return OK; }
+    status_t legacyCreateAudioPatch(const struct audio_port_config&,
+            std::optional<audio_source_t>, audio_devices_t) override {
+        return INVALID_OPERATION;
+    }
+    status_t legacyReleaseAudioPatch() override { return INVALID_OPERATION; }
+
+protected:
+    // Waits for the HAL buffer period and accounts for the transferred bytes.
+    size_t transfer(size_t bytes);
+
+    const sp<FakeDeviceHal> mDevice;
+    const audio_config_base_t mConfig;
+    const size_t mFrameSize;
+    std::atomic<int64_t> mFrames = 0;
+};
+
+class FakeStreamInHal : public FakeStreamHal<StreamInHalInterface> {
+public:
+    using FakeStreamHal::FakeStreamHal;
+
+    status_t setGain(float) override { return OK; }
+    status_t read(void* buffer, size_t bytes, size_t* read) override {
+        memset(buffer, 0, bytes);
+        *read = transfer(bytes);
+        return OK;
+    }
+    status_t getInputFramesLost(uint32_t* framesLost) override {
+        *framesLost = 0;
+        return OK;
+    }
+    status_t getCapturePosition(int64_t* frames, int64_t* time) override {
+        *frames = mFrames;
+        *time = systemTime(SYSTEM_TIME_MONOTONIC);
+        return OK;
+    }
+    status_t getActiveMicrophones(std::vector<media::MicrophoneInfoFw>*) override {
+        return INVALID_OPERATION;
+    }
+    status_t setPreferredMicrophoneDirection(audio_microphone_direction_t) override {
+        return INVALID_OPERATION;
+    }
+    status_t setPreferredMicrophoneFieldDimension(float) override { return INVALID_OPERATION; }
+    status_t updateSinkMetadata(const SinkMetadata&) override { return OK; }
+};
+
+class FakeStreamOutHal : public FakeStreamHal<StreamOutHalInterface> {
+public:
+    using FakeStreamHal::FakeStreamHal;
+
+    status_t getLatency(uint32_t* latency) override {
+        *latency = 0;
+        return OK;
+    }
+    status_t setVolume(float, float) override { return OK; }
+    status_t selectPresentation(int, int) override { return INVALID_OPERATION; }
+    status_t write(const void*, size_t bytes, size_t* written) override {
+        *written = transfer(bytes);
+        return OK;
+    }
+    status_t getRenderPosition(uint32_t* dspFrames) override {
+        *dspFrames = mFrames;
+        return OK;
+    }
+    status_t getNextWriteTimestamp(int64_t*) override { return INVALID_OPERATION; }
+    status_t setCallback(wp<StreamOutHalInterfaceCallback>) override { return INVALID_OPERATION; }
+    status_t supportsPauseAndResume(bool* supportsPause, bool* supportsResume) override {
+        *supportsPause = *supportsResume = false;
+        return OK;
+    }
+    status_t pause() override { return INVALID_OPERATION; }
+    status_t resume() override { return INVALID_OPERATION; }
+    status_t supportsDrain(bool* supportsDrain) override {
+        *supportsDrain = false;
+        return OK;
+    }
+    status_t drain(bool) override { return INVALID_OPERATION; }
+    status_t flush() override { return OK; }
+    status_t getPresentationPosition(uint64_t* frames, struct timespec* timestamp) override {
+        *frames = mFrames;
+        const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        timestamp->tv_sec = now / 1000000000;
+        timestamp->tv_nsec = now % 1000000000;
+        return OK;
+    }
+    status_t updateSourceMetadata(const SourceMetadata&) override { return OK; }
+    status_t getDualMonoMode(audio_dual_mono_mode_t*) override { return INVALID_OPERATION; }
+    status_t setDualMonoMode(audio_dual_mono_mode_t) override { return INVALID_OPERATION; }
+    status_t getAudioDescriptionMixLevel(float*) override { return INVALID_OPERATION; }
+    status_t setAudioDescriptionMixLevel(float) override { return INVALID_OPERATION; }
+    status_t getPlaybackRateParameters(audio_playback_rate_t*) override {
+        return INVALID_OPERATION;
+    }
+    status_t setPlaybackRateParameters(const audio_playback_rate_t&) override {
+        return INVALID_OPERATION;
+    }
+    status_t setEventCallback(const sp<StreamOutHalInterfaceEventCallback>&) override {
+        return INVALID_OPERATION;
+    }
+    status_t setLatencyMode(audio_latency_mode_t) override { return INVALID_OPERATION; }
+    status_t getRecommendedLatencyModes(std::vector<audio_latency_mode_t>*) override {
+        return INVALID_OPERATION;
+    }
+    status_t setLatencyModeCallback(
+            const sp<StreamOutHalInterfaceLatencyModeCallback>&) override {
+        return INVALID_OPERATION;
+    }
+    status_t exit() override { return OK; }
+};
+
+// A HW module which opens fake streams with the requested configuration, or with a
+// 48 kHz stereo 16 bit default, and keeps track of its open streams and HAL patches.
+class FakeDeviceHal : public DeviceHalInterface {
+public:
+    status_t getAudioPorts(std::vector<AudioPort>*) override { return INVALID_OPERATION; }
+    status_t getAudioRoutes(std::vector<media::AudioRoute>*) override {
+        return INVALID_OPERATION;
+    }
+    status_t getSupportedModes(std::vector<AudioMode>*) override { return INVALID_OPERATION; }
+    status_t getSupportedDevices(uint32_t*) override { return INVALID_OPERATION; }
+    status_t initCheck() override { return OK; }
+    status_t setVoiceVolume(float) override { return INVALID_OPERATION; }
+    status_t setMasterVolume(float) override { return INVALID_OPERATION; }
+    status_t getMasterVolume(float*) override { return INVALID_OPERATION; }
+    status_t setMode(audio_mode_t) override { return INVALID_OPERATION; }
+    status_t setMicMute(bool) override { return INVALID_OPERATION; }
+    status_t getMicMute(bool*) override { return INVALID_OPERATION; }
+    status_t setMasterMute(bool) override { return INVALID_OPERATION; }
+    status_t getMasterMute(bool*) override { return INVALID_OPERATION; }
+    status_t setParameters(const String8&) override { return OK; }
+    status_t getParameters(const String8&, String8*) override { return INVALID_OPERATION; }
+    status_t getInputBufferSize(struct audio_config*, size_t*) override {
+        return INVALID_OPERATION;
+    }
+
+    status_t openOutputStream(audio_io_handle_t, audio_devices_t, audio_output_flags_t,
+            struct audio_config* config, const char*,
+            sp<StreamOutHalInterface>* outStream) override {
+        if (mOpenStatus != OK) return mOpenStatus;
+        applyDefaults(config, AUDIO_CHANNEL_OUT_STEREO);
+        *outStream = sp<FakeStreamOutHal>::make(sp<FakeDeviceHal>::fromExisting(this),
+                baseConfig(*config), audio_channel_count_from_out_mask(config->channel_mask));
+        return OK;
+    }
+
+    status_t openInputStream(audio_io_handle_t, audio_devices_t, struct audio_config* config,
+            audio_input_flags_t, const char*, audio_source_t, audio_devices_t, const char*,
+            sp<StreamInHalInterface>* inStream) override {
+        if (mOpenStatus != OK) return mOpenStatus;
+        applyDefaults(config, AUDIO_CHANNEL_IN_STEREO);
+        *inStream = sp<FakeStreamInHal>::make(sp<FakeDeviceHal>::fromExisting(this),
+                baseConfig(*config), audio_channel_count_from_in_mask(config->channel_mask));
+        return OK;
+    }
+
+    status_t supportsAudioPatches(bool* supportsPatches) override {
+        *supportsPatches = true;
+        return OK;
+    }
+
+    status_t createAudioPatch(unsigned int, const struct audio_port_config*,
+            unsigned int, const struct audio_port_config*, audio_patch_handle_t* patch) override {
+        if (mCreatePatchStatus != OK) return mCreatePatchStatus;
+        std::lock_guard _l(mMutex);
+        *patch = ++mLastPatch;
+        mPatches.insert(*patch);
+        return OK;
+    }
+
+    status_t releaseAudioPatch(audio_patch_handle_t patch) override {
+        std::lock_guard _l(mMutex);
+        return mPatches.erase(patch) == 1 ? OK : BAD_VALUE;
+    }
+
+    status_t getAudioPort(struct audio_port*) override { return INVALID_OPERATION; }
+    status_t getAudioPort(struct audio_port_v7*) override { return INVALID_OPERATION; }
+    status_t setAudioPortConfig(const struct audio_port_config*) override {
+        return INVALID_OPERATION;
+    }
+    status_t getMicrophones(std::vector<audio_microphone_characteristic_t>*) override {
+        return INVALID_OPERATION;
+    }
+    status_t addDeviceEffect(const struct audio_port_config*, sp<EffectHalInterface>) override {
+        return INVALID_OPERATION;
+    }
+    status_t removeDeviceEffect(
+            const struct audio_port_config*, sp<EffectHalInterface>) override {
+        return INVALID_OPERATION;
+    }
+    status_t getMmapPolicyInfos(
+            AudioMMapPolicyType, std::vector<AudioMMapPolicyInfo>*) override {
+        return INVALID_OPERATION;
+    }
+    int32_t getAAudioMixerBurstCount() override { return 0; }
+    int32_t getAAudioHardwareBurstMinUsec() override { return 0; }
+    status_t supportsBluetoothVariableLatency(bool* supports) override {
+        *supports = false;
+        return OK;
+    }
+    status_t setConnectedState(const struct audio_port_v7*, bool) override {
+        return INVALID_OPERATION;
+    }
+    status_t setSimulateDeviceConnections(bool) override { return INVALID_OPERATION; }
+    error::Result<audio_hw_sync_t> getHwAvSync() override {
+        return base::unexpected(INVALID_OPERATION);
+    }
+    status_t dump(int, const Vector<String16>&) override { return OK; }
+    status_t getSoundDoseInterface(const std::string&, ::ndk::SpAIBinder*) override {
+        return INVALID_OPERATION;
+    }
+    status_t prepareToDisconnectExternalDevice(const struct audio_port_v7*) override {
+        return INVALID_OPERATION;
+    }
+    status_t getAudioMixPort(const struct audio_port_v7*, struct audio_port_v7*) override {
+        return INVALID_OPERATION;
+    }
+
+    // Makes openOutputStream and openInputStream fail with status.
+    void refuseStreams(status_t status) { mOpenStatus = status; }
+    // Makes createAudioPatch fail with status.
+    void refusePatches(status_t status) { mCreatePatchStatus = status; }
+
+    size_t patchCount() const {
+        std::lock_guard _l(mMutex);
+        return mPatches.size();
+    }
+    int openedStreamCount() const { return mOpenedStreamCount; }
+    int streamCount() const { return mStreamCount; }
+    int standbyCount() const { return mStandbyCount; }
+    int64_t frames() const { return mFrames; }
+
+    // Called by the fake streams.
+    void onStreamOpened() {
+        ++mOpenedStreamCount;
+        ++mStreamCount;
+    }
+    void onStreamClosed() { --mStreamCount; }
+    void onStandby() { ++mStandbyCount; }
+    void onTransfer(size_t frames) { mFrames += frames; }
+
+private:
+    static void applyDefaults(struct audio_config* config, audio_channel_mask_t channelMask) {
+        if (config->sample_rate == 0) config->sample_rate = kSampleRate;
+        if (config->channel_mask == AUDIO_CHANNEL_NONE) config->channel_mask = channelMask;
+        if (config->format == AUDIO_FORMAT_DEFAULT) config->format = AUDIO_FORMAT_PCM_16_BIT;
+    }
+    static audio_config_base_t baseConfig(const struct audio_config& config) {
+        return {config.sample_rate, config.channel_mask, config.format};
+    }
+
+    std::atomic<status_t> mOpenStatus = OK;
+    std::atomic<status_t> mCreatePatchStatus = OK;
+    std::atomic<int> mOpenedStreamCount = 0;
+    std::atomic<int> mStreamCount = 0;
+    std::atomic<int> mStandbyCount = 0;
+    std::atomic<int64_t> mFrames = 0;
+    mutable std::mutex mMutex;
+    audio_patch_handle_t mLastPatch = AUDIO_PATCH_HANDLE_NONE;
+    std::set<audio_patch_handle_t> mPatches;
+};
+
+template <typename T>
+FakeStreamHal<T>::FakeStreamHal(const sp<FakeDeviceHal>& device,
+        const audio_config_base_t& config, uint32_t channelCount)
+    : mDevice(device)
+    , mConfig(config)
+    , mFrameSize(audio_has_proportional_frames(config.format)
+            ? audio_bytes_per_frame(channelCount, config.format) : sizeof(uint8_t))
+{
+    mDevice->onStreamOpened();
+}
+
+template <typename T>
+FakeStreamHal<T>::~FakeStreamHal()
+{
+    mDevice->onStreamClosed();
+}
+
+template <typename T>
+status_t FakeStreamHal<T>::standby()
+{
+    mDevice->onStandby();
+    return OK;
+}
+
+template <typename T>
+size_t FakeStreamHal<T>::transfer(size_t bytes)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    mFrames += bytes / mFrameSize;
+    mDevice->onTransfer(bytes / mFrameSize);
+    return bytes;
+}
+
+class MockPatchPanelCallback : public IAfPatchPanelCallback {
+public:
+    MOCK_METHOD(void, closeThreadInternal_l, (const sp<IAfPlaybackThread>&), (override));
+    MOCK_METHOD(void, closeThreadInternal_l, (const sp<IAfRecordThread>&), (override));
+    MOCK_METHOD(IAfPlaybackThread*, primaryPlaybackThread_l, (), (const, override));
+    MOCK_METHOD(IAfPlaybackThread*, checkPlaybackThread_l, (audio_io_handle_t),
+            (const, override));
+    MOCK_METHOD(IAfRecordThread*, checkRecordThread_l, (audio_io_handle_t), (const, override));
+    MOCK_METHOD(IAfMmapThread*, checkMmapThread_l, (audio_io_handle_t), (const, override));
+    MOCK_METHOD(sp<IAfThreadBase>, openInput_l,
+            (audio_module_handle_t, audio_io_handle_t*, audio_config_t*, audio_devices_t,
+                    const char*, audio_source_t, audio_input_flags_t, audio_devices_t,
+                    const String8&), (override));
+    MOCK_METHOD(sp<IAfThreadBase>, openOutput_l,
+            (audio_module_handle_t, audio_io_handle_t*, audio_config_t*, audio_config_base_t*,
+                    audio_devices_t, const String8&, audio_output_flags_t), (override));
+    MOCK_METHOD(void, updateDownStreamPatches_l,
+            (const struct audio_patch*, const std::set<audio_io_handle_t>&), (override));
+    MOCK_METHOD(void, updateOutDevicesForRecordThreads_l, (const DeviceDescriptorBaseVector&),
+            (override));
+
+    audio_utils::mutex& mutex() const override
+            RETURN_CAPABILITY(audio_utils::AudioFlinger_Mutex) { return mMutex; }
+    const DefaultKeyedVector<audio_module_handle_t, AudioHwDevice*>&
+            getAudioHwDevs_l() const override { return mAudioHwDevs; }
+    audio_unique_id_t nextUniqueId(audio_unique_id_use_t) override { return ++mLastUniqueId; }
+    const sp<PatchCommandThread>& getPatchCommandThread() override {
+        return mPatchCommandThread;
+    }
+
+    DefaultKeyedVector<audio_module_handle_t, AudioHwDevice*> mAudioHwDevs{nullptr};
+
+private:
+    mutable audio_utils::mutex mMutex{audio_utils::MutexOrder::kAudioFlinger_Mutex};
+    std::atomic<audio_unique_id_t> mLastUniqueId = AUDIO_UNIQUE_ID_ALLOCATE;
+    const sp<PatchCommandThread> mPatchCommandThread = sp<PatchCommandThread>::make();
+};
+
+// Waits until condition is true, returns false on timeout.
+template <typename C>
+bool waitFor(C condition) {
+    const auto deadline = std::chrono::steady_clock::now() + kTransferTimeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// A builtin mic of the source module patched to the speaker of the sink module.
+struct audio_patch devicePatch() {
+    audio_port_config source{};
+    source.role = AUDIO_PORT_ROLE_SOURCE;
+    source.type = AUDIO_PORT_TYPE_DEVICE;
+    source.ext.device.hw_module = kSourceModule;
+    source.ext.device.type = AUDIO_DEVICE_IN_BUILTIN_MIC;
+    audio_port_config sink{};
+    sink.role = AUDIO_PORT_ROLE_SINK;
+    sink.type = AUDIO_PORT_TYPE_DEVICE;
+    sink.ext.device.hw_module = kSinkModule;
+    sink.ext.device.type = AUDIO_DEVICE_OUT_SPEAKER;
+    return *PatchBuilder().addSource(source).addSink(sink).patch();
+}
+
+class DirectPatchEngineTest : public ::testing::Test {
+protected:
+    sp<DirectPatchEngine> createEngine() {
+        return DirectPatchEngine::create(&mSourceHwDev, kInput, &mSinkHwDev, kOutput, mPatch);
+    }
+
+    // Expects that nothing is left open on either HW module.
+    void expectReleased() const {
+        EXPECT_EQ(0, mSourceHal->streamCount());
+        EXPECT_EQ(0u, mSourceHal->patchCount());
+        EXPECT_EQ(0, mSinkHal->streamCount());
+        EXPECT_EQ(0u, mSinkHal->patchCount());
+    }
+
+    static constexpr audio_io_handle_t kInput = 10;
+    static constexpr audio_io_handle_t kOutput = 11;
+
+    const sp<FakeDeviceHal> mSourceHal = sp<FakeDeviceHal>::make();
+    const sp<FakeDeviceHal> mSinkHal = sp<FakeDeviceHal>::make();
+    AudioHwDevice mSourceHwDev{kSourceModule, "source", mSourceHal, AudioHwDevice::Flags{}};
+    AudioHwDevice mSinkHwDev{kSinkModule, "sink", mSinkHal, AudioHwDevice::Flags{}};
+    struct audio_patch mPatch = devicePatch();
+};
+
+TEST_F(DirectPatchEngineTest, createOpensStreamsAndPatches) {
+    sp<DirectPatchEngine> engine = createEngine();
+    ASSERT_NE(nullptr, engine.get());
+    EXPECT_EQ(1, mSourceHal->streamCount());
+    EXPECT_EQ(1u, mSourceHal->patchCount());
+    EXPECT_EQ(1, mSinkHal->streamCount());
+    EXPECT_EQ(1u, mSinkHal->patchCount());
+    // the source defaults to the sink configuration
+    EXPECT_THAT(engine->toString(), Not(HasSubstr("converted")));
+
+    engine.clear();
+    expectReleased();
+    EXPECT_GT(mSourceHal->standbyCount(), 0);
+    EXPECT_GT(mSinkHal->standbyCount(), 0);
+}
+
+TEST_F(DirectPatchEngineTest, startTransfersAndStopHalts) {
+    sp<DirectPatchEngine> engine = createEngine();
+    ASSERT_NE(nullptr, engine.get());
+    double latencyMs;
+    EXPECT_EQ(INVALID_OPERATION, engine->getLatencyMs(&latencyMs));
+
+    ASSERT_EQ(NO_ERROR, engine->start());
+    EXPECT_TRUE(waitFor([&] { return mSinkHal->frames() >= 10 * (int64_t)kHalFrameCount; }));
+    EXPECT_EQ(OK, engine->getLatencyMs(&latencyMs));
+    EXPECT_GE(latencyMs, 0.);
+
+    engine->stop();
+    const int64_t frames = mSinkHal->frames();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(frames, mSinkHal->frames());
+    EXPECT_LE(frames, mSourceHal->frames());
+
+    engine.clear();
+    expectReleased();
+}
+
+TEST_F(DirectPatchEngineTest, convertsMismatchedSource) {
+    mPatch.sources[0].config_mask |= AUDIO_PORT_CONFIG_SAMPLE_RATE;
+    mPatch.sources[0].sample_rate = 44100;
+    sp<DirectPatchEngine> engine = createEngine();
+    ASSERT_NE(nullptr, engine.get());
+    EXPECT_THAT(engine->toString(), HasSubstr("converted"));
+
+    ASSERT_EQ(NO_ERROR, engine->start());
+    EXPECT_TRUE(waitFor([&] { return mSinkHal->frames() >= 10 * (int64_t)kHalFrameCount; }));
+    engine->stop();
+
+    engine.clear();
+    expectReleased();
+}
+
+TEST_F(DirectPatchEngineTest, createFailsWhenOutputRefused) {
+    mSinkHal->refuseStreams(INVALID_OPERATION);
+    EXPECT_EQ(nullptr, createEngine().get());
+    EXPECT_EQ(0, mSourceHal->openedStreamCount());
+    expectReleased();
+}
+
+TEST_F(DirectPatchEngineTest, createFailsWhenInputRefused) {
+    mSourceHal->refuseStreams(INVALID_OPERATION);
+    EXPECT_EQ(nullptr, createEngine().get());
+    EXPECT_EQ(1, mSinkHal->openedStreamCount());
+    expectReleased();
+}
+
+TEST_F(DirectPatchEngineTest, createFailsWhenSourcePatchRefused) {
+    mSourceHal->refusePatches(INVALID_OPERATION);
+    EXPECT_EQ(nullptr, createEngine().get());
+    expectReleased();
+}
+
+TEST_F(DirectPatchEngineTest, createFailsWhenSinkPatchRefused) {
+    mSinkHal->refusePatches(INVALID_OPERATION);
+    EXPECT_EQ(nullptr, createEngine().get());
+    // the source HAL patch was created, and is released with the engine
+    expectReleased();
+}
+
+TEST_F(DirectPatchEngineTest, createFailsForCompressedSink) {
+    mPatch.sinks[0].config_mask |= AUDIO_PORT_CONFIG_FORMAT;
+    mPatch.sinks[0].format = AUDIO_FORMAT_AC3;
+    EXPECT_EQ(nullptr, createEngine().get());
+    expectReleased();
+}
+
+class PatchPanelDirectEngineTest : public DirectPatchEngineTest {
+protected:
+    void SetUp() override {
+        mCallback->mAudioHwDevs.add(kSourceModule, &mSourceHwDev);
+        mCallback->mAudioHwDevs.add(kSinkModule, &mSinkHwDev);
+    }
+
+    const sp<MockPatchPanelCallback> mCallback = sp<MockPatchPanelCallback>::make();
+};
+
+TEST_F(PatchPanelDirectEngineTest, createAndReleaseDirectPatch) {
+    const sp<PatchPanel> panel = sp<PatchPanel>::make(mCallback, true /* directEngineEnabled */);
+    EXPECT_CALL(*mCallback, openOutput_l).Times(0);
+    EXPECT_CALL(*mCallback, openInput_l).Times(0);
+
+    audio_patch_handle_t handle = AUDIO_PATCH_HANDLE_NONE;
+    {
+        audio_utils::lock_guard _l(mCallback->mutex());
+        ASSERT_EQ(NO_ERROR, panel->createAudioPatch_l(&mPatch, &handle));
+        const auto& patches = panel->patches_l();
+        ASSERT_EQ(1u, patches.count(handle));
+        EXPECT_TRUE(patches.at(handle).isSoftware());
+        EXPECT_NE(nullptr, patches.at(handle).mDirectEngine.get());
+    }
+    EXPECT_EQ(1, mSourceHal->streamCount());
+    EXPECT_EQ(1, mSinkHal->streamCount());
+    EXPECT_TRUE(waitFor([&] { return mSinkHal->frames() > 0; }));
+
+    {
+        audio_utils::lock_guard _l(mCallback->mutex());
+        double latencyMs;
+        EXPECT_TRUE(waitFor([&] { return panel->getLatencyMs_l(handle, &latencyMs) == OK; }));
+        EXPECT_EQ(NO_ERROR, panel->releaseAudioPatch_l(handle));
+        EXPECT_TRUE(panel->patches_l().empty());
+    }
+    expectReleased();
+}
+
+TEST_F(PatchPanelDirectEngineTest, fallsBackToThreadsWhenHalRefusesPatch) {
+    mSinkHal->refusePatches(INVALID_OPERATION);
+    const sp<PatchPanel> panel = sp<PatchPanel>::make(mCallback, true /* directEngineEnabled */);
+    // the patch threads are not available in this test, so the fallback fails to open them
+    EXPECT_CALL(*mCallback, openOutput_l(kSinkModule, _, _, _, AUDIO_DEVICE_OUT_SPEAKER, _, _))
+            .WillOnce(Return(nullptr));
+
+    audio_patch_handle_t handle = AUDIO_PATCH_HANDLE_NONE;
+    {
+        audio_utils::lock_guard _l(mCallback->mutex());
+        EXPECT_EQ(NO_MEMORY, panel->createAudioPatch_l(&mPatch, &handle));
+        EXPECT_TRUE(panel->patches_l().empty());
+    }
+    EXPECT_EQ(1, mSourceHal->openedStreamCount());
+    expectReleased();
+}
+
+TEST_F(PatchPanelDirectEngineTest, usesThreadsWhenDisabled) {
+    const sp<PatchPanel> panel = sp<PatchPanel>::make(mCallback, false /* directEngineEnabled */);
+    EXPECT_CALL(*mCallback, openOutput_l(kSinkModule, _, _, _, AUDIO_DEVICE_OUT_SPEAKER, _, _))
+            .WillOnce(Return(nullptr));
+
+    audio_patch_handle_t handle = AUDIO_PATCH_HANDLE_NONE;
+    {
+        audio_utils::lock_guard _l(mCallback->mutex());
+        EXPECT_EQ(NO_MEMORY, panel->createAudioPatch_l(&mPatch, &handle));
+    }
+    EXPECT_EQ(0, mSourceHal->openedStreamCount());
+    EXPECT_EQ(0, mSinkHal->openedStreamCount());
+}
+
+}  // namespace
+}  // namespace android
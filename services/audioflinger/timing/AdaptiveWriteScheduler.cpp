@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "AdaptiveWriteScheduler"
+
+#include <algorithm>
+#include <cmath>
+
+#include <utils/Log.h>
+#include "AdaptiveWriteScheduler.h"
+
+namespace android::audioflinger {
+
+namespace {
+
+constexpr double kNanosPerSecond = 1e9;
+
+// Weight of a new cost sample in the running mean and variance.
+constexpr double kCostAlpha = 1. / 16;
+
+// Margin gain after a miss, and its relaxation per wakeup without a miss.
+constexpr double kMissGain = 1.5;
+constexpr double kMaxMarginGain = 8.;
+constexpr double kGainDecay = 0.98;
+
+// Sleeps shorter than this are not worth a wakeup, the HAL write blocks instead.
+constexpr int64_t kMinSleepNs = 2'000'000;
+
+// A write longer than this fraction of a period is considered blocked by the HAL.
+constexpr double kBlockedWriteFraction = 0.5;
+
+} // namespace
+
+AdaptiveWriteScheduler::AdaptiveWriteScheduler(uint32_t sampleRate, size_t periodFrames,
+        size_t capacityFrames, double underrunProbability)
+    : mSampleRate(sampleRate)
+    , mPeriodFrames(periodFrames)
+    , mCapacityFrames(std::max(capacityFrames, periodFrames))
+    , mZScore(zScoreForProbability(underrunProbability))
+{
+}
+
+// static
+double AdaptiveWriteScheduler::zScoreForProbability(double p) {
+    // Abramowitz and Stegun 26.2.23, absolute error below 4.5e-4.
+    p = std::clamp(p, 1e-9, 0.5);
+    const double t = std::sqrt(-2. * std::log(p));
+    return t - (2.515517 + 0.802853 * t + 0.010328 * t * t)
+            / (1. + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+}
+
+void AdaptiveWriteScheduler::addCost(int64_t costNs) {
+    if (!mHasCost) {
+        mCostMeanNs = costNs;
+        mCostVarianceNs2 = 0.;
+        mHasCost = true;
+        return;
+    }
+    const double delta = costNs - mCostMeanNs;
+    mCostMeanNs += kCostAlpha * delta;
+    mCostVarianceNs2 = (1. - kCostAlpha) * (mCostVarianceNs2 + kCostAlpha * delta * delta);
+}
+
+int64_t AdaptiveWriteScheduler::marginFrames() const {
+    const double marginNs = mMarginGain
+            * (mCostMeanNs + mZScore * std::sqrt(mCostVarianceNs2));
+    // Always keep at least one period queued when waking up.
+    return std::max((int64_t)mPeriodFrames,
+            (int64_t)std::ceil(marginNs * mSampleRate / kNanosPerSecond));
+}
+
+void AdaptiveWriteScheduler::onWakeup(int64_t nowNs) {
+    if (mWakeupDeadlineNs >= 0) {
+        mOversleepNs = std::max(nowNs - mWakeupDeadlineNs, (int64_t)0);
+        mWakeupDeadlineNs = -1;
+    }
+    mAfterWakeup = true;
+}
+
+int64_t AdaptiveWriteScheduler::onWrite(
+        int64_t nowNs, int64_t mixNs, int64_t writeNs, int64_t queuedFrames) {
+    const int64_t periodNs = (int64_t)mPeriodFrames * kNanosPerSecond / mSampleRate;
+    const bool blocked = writeNs > kBlockedWriteFraction * periodNs;
+
+    mLastWriteWasMiss = false;
+    mLastWriteWasWakeup = blocked;
+    const bool afterWakeup = mAfterWakeup;
+    if (mAfterWakeup) {
+        // The cost to predict is what elapses between the requested wakeup time
+        // and the end of the first write.
+        addCost(mOversleepNs + std::max(mixNs, (int64_t)0) + (blocked ? 0 : writeNs));
+        if (queuedFrames >= 0 && queuedFrames < 2 * (int64_t)mPeriodFrames) {
+            // Less than a period was left when the write completed: a near underrun.
+            mLastWriteWasMiss = true;
+            mMarginGain = std::min(mMarginGain * kMissGain, kMaxMarginGain);
+            ALOGV("%s: miss, queued %lld frames, margin gain %.2f",
+                    __func__, (long long)queuedFrames, mMarginGain);
+        } else {
+            mMarginGain = std::max(mMarginGain * kGainDecay, 1.);
+        }
+        mAfterWakeup = false;
+        mOversleepNs = 0;
+    } else if (!blocked) {
+        addCost(std::max(mixNs, (int64_t)0) + writeNs);
+    }
+
+    // A write that starts more than a period after the previous one, and not after
+    // a wakeup, resumes writing (e.g. after standby): the throttle window restarts.
+    if (mThrottleStartNs < 0 || (!afterWakeup && mixNs > periodNs)) {
+        mThrottleStartNs = nowNs;
+        mThrottleFrames = 0;
+    } else {
+        mThrottleFrames += mPeriodFrames;
+    }
+
+    if (queuedFrames < 0) {
+        return 0;  // no timestamp, let the HAL write pace the thread
+    }
+    if (blocked) {
+        // The HAL was full, which bounds its capacity.
+        mCapacityFrames = std::clamp((size_t)queuedFrames, mPeriodFrames, mCapacityFrames);
+    }
+    if ((int64_t)mCapacityFrames - queuedFrames >= (int64_t)mPeriodFrames) {
+        return 0;  // another period fits without blocking
+    }
+    const int64_t wakeupFrames = std::min(marginFrames(),
+            (int64_t)(mCapacityFrames - mPeriodFrames));
+    const int64_t sleepNs = (queuedFrames - wakeupFrames) * kNanosPerSecond / mSampleRate;
+    if (sleepNs < kMinSleepNs) {
+        return 0;
+    }
+    mWakeupDeadlineNs = nowNs + sleepNs;
+    mLastWriteWasWakeup = true;
+    mThrottleStartNs = nowNs;
+    mThrottleFrames = 0;
+    return sleepNs;
+}
+
+int64_t AdaptiveWriteScheduler::throttleNs(int64_t nowNs) {
+    if (mThrottleStartNs < 0) {
+        return 0;
+    }
+    const int64_t sleepNs = mThrottleFrames * kNanosPerSecond / (2 * mSampleRate)
+            - (nowNs - mThrottleStartNs);
+    // Shorter throttles accumulate until they are worth a sleep.
+    if (sleepNs < kMinSleepNs) {
+        return 0;
+    }
+    mThrottleStartNs = nowNs;
+    mThrottleFrames = 0;
+    return sleepNs;
+}
+
+} // namespace android::audioflinger
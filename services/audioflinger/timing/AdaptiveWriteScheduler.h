@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace android::audioflinger {
+
+/**
+ * AdaptiveWriteScheduler
+ *
+ * Chooses when a mixer thread writing to a blocking HAL stream wakes up, and how many
+ * mixer periods it writes back to back once awake.
+ *
+ * Without it, the thread wakes up once per period, when the HAL write unblocks.
+ * The scheduler instead sleeps while the HAL has more frames queued than a safety margin,
+ * then writes periods back to back until the HAL is full, which reduces wakeups when
+ * the HAL buffers several periods (deep buffer outputs).
+ *
+ * The margin is the predicted time from wakeup to the end of the next write: the mean
+ * plus a number of standard deviations of the measured wakeup latency and mix cost,
+ * where the number is derived from the target underrun probability under a normal model.
+ * It is scaled up after each wakeup which found the HAL nearly drained,
+ * and relaxes back slowly, closing the loop on the prediction.
+ *
+ * This class is not thread safe.
+ */
+class AdaptiveWriteScheduler {
+public:
+    /**
+     * \param sampleRate          sink sample rate.
+     * \param periodFrames        frames written per HAL write.
+     * \param capacityFrames      frames the HAL can queue, refined when a write blocks.
+     * \param underrunProbability target probability that a wakeup is late, in (0, 0.5).
+     */
+    AdaptiveWriteScheduler(uint32_t sampleRate, size_t periodFrames, size_t capacityFrames,
+            double underrunProbability);
+
+    /**
+     * Called after each HAL write, returns the time to sleep before mixing the next
+     * period, or 0 to mix it immediately.
+     *
+     * \param nowNs         time at the end of the write.
+     * \param mixNs         time spent preparing the period since the previous write or wakeup.
+     * \param writeNs       time spent in the HAL write.
+     * \param queuedFrames  frames queued in the HAL after the write, estimated from the
+     *                      kernel timestamp, or negative if unknown.
+     */
+    int64_t onWrite(int64_t nowNs, int64_t mixNs, int64_t writeNs, int64_t queuedFrames);
+
+    /** Called when the thread wakes up from a sleep returned by onWrite(). */
+    void onWakeup(int64_t nowNs);
+
+    /**
+     * Called after onWrite() returned 0 when the thread throttles its writes.
+     * Returns the time to sleep so that the periods written since the last sleep,
+     * or since the thread resumed writing, are not consumed faster than twice real time,
+     * or 0 if they are not. The elapsed time includes the last sleep, so a burst that
+     * refills the HAL after a sleep of about its duration is not throttled.
+     *
+     * \param nowNs  time at the end of the write.
+     */
+    int64_t throttleNs(int64_t nowNs);
+
+    /** The current margin in frames. */
+    [[nodiscard]] int64_t marginFrames() const;
+
+    /** The HAL capacity in frames, as refined by blocked writes. */
+    [[nodiscard]] size_t capacityFrames() const { return mCapacityFrames; }
+
+    /** True if the last onWrite() started a wakeup, either by sleeping or by blocking. */
+    [[nodiscard]] bool lastWriteWasWakeup() const { return mLastWriteWasWakeup; }
+
+    /** True if the HAL was found with less than a period queued after the last wakeup. */
+    [[nodiscard]] bool lastWriteWasMiss() const { return mLastWriteWasMiss; }
+
+    /** Returns the z-score for the one sided tail probability p, for 0 < p < 0.5. */
+    static double zScoreForProbability(double p);
+
+private:
+    void addCost(int64_t costNs);
+
+    const uint32_t mSampleRate;
+    const size_t   mPeriodFrames;
+    size_t         mCapacityFrames;
+    const double   mZScore;
+
+    // Exponentially weighted mean and variance of the wakeup to write completion cost.
+    double         mCostMeanNs = 0.;
+    double         mCostVarianceNs2 = 0.;
+    bool           mHasCost = false;
+
+    // Scale applied to the predicted margin, raised by misses.
+    double         mMarginGain = 1.;
+
+    // Throttle window: starts at the last sleep, or when writing resumed after a gap.
+    int64_t        mThrottleStartNs = -1;   // -1 until the first write
+    int64_t        mThrottleFrames = 0;     // frames written since mThrottleStartNs
+
+    int64_t        mWakeupDeadlineNs = -1;  // requested end of the current sleep, -1 if none
+    int64_t        mOversleepNs = 0;        // latency of the last wakeup
+    bool           mAfterWakeup = false;    // next write is the first one after a wakeup
+    bool           mLastWriteWasWakeup = false;
+    bool           mLastWriteWasMiss = false;
+};
+
+} // namespace android::audioflinger
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "adaptivewritescheduler_tests"
+
+#include "../AdaptiveWriteScheduler.h"
+
+#include <gtest/gtest.h>
+
+using namespace android::audioflinger;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kPeriodFrames = 960;            // 20 ms
+constexpr size_t kCapacityFrames = 8 * kPeriodFrames;
+constexpr int64_t kPeriodNs = 20'000'000;
+constexpr int64_t kMixNs = 1'000'000;
+
+TEST(AdaptiveWriteSchedulerTest, ZScore) {
+    EXPECT_NEAR(1.645, AdaptiveWriteScheduler::zScoreForProbability(0.05), 1e-3);
+    EXPECT_NEAR(2.326, AdaptiveWriteScheduler::zScoreForProbability(0.01), 1e-3);
+    EXPECT_NEAR(3.090, AdaptiveWriteScheduler::zScoreForProbability(0.001), 1e-3);
+}
+
+TEST(AdaptiveWriteSchedulerTest, UnknownQueueDoesNotSleep) {
+    AdaptiveWriteScheduler scheduler(kSampleRate, kPeriodFrames, kCapacityFrames, 1e-3);
+    EXPECT_EQ(0, scheduler.onWrite(0, kMixNs, 100'000, -1 /* queuedFrames */));
+}
+
+TEST(AdaptiveWriteSchedulerTest, FillsThenSleepsToMargin) {
+    AdaptiveWriteScheduler scheduler(kSampleRate, kPeriodFrames, kCapacityFrames, 1e-3);
+    int64_t now = 0;
+    int64_t queued = 0;
+    int writes = 0;
+    int64_t sleepNs = 0;
+    // Periods are written back to back while they fit in the HAL.
+    while ((sleepNs = scheduler.onWrite(now, kMixNs, 100'000, queued += kPeriodFrames)) == 0) {
+        ++writes;
+        now += kMixNs;
+        ASSERT_LT(writes, 16);
+    }
+    EXPECT_EQ(kCapacityFrames / kPeriodFrames, (size_t)writes + 1);
+    EXPECT_TRUE(scheduler.lastWriteWasWakeup());
+
+    // The thread sleeps until only the margin is left, which is much more than a period.
+    const int64_t margin = scheduler.marginFrames();
+    EXPECT_GE(margin, (int64_t)kPeriodFrames);
+    EXPECT_LT(margin, (int64_t)(kCapacityFrames - kPeriodFrames));
+    EXPECT_NEAR((double)(queued - margin) * 1e9 / kSampleRate, (double)sleepNs, 1e3);
+    EXPECT_GT(sleepNs, 4 * kPeriodNs);
+}
+
+TEST(AdaptiveWriteSchedulerTest, MissRaisesMargin) {
+    AdaptiveWriteScheduler scheduler(kSampleRate, kPeriodFrames, kCapacityFrames, 1e-3);
+    const int64_t sleepNs = scheduler.onWrite(0, kMixNs, 100'000, kCapacityFrames);
+    ASSERT_GT(sleepNs, 0);
+    const int64_t margin = scheduler.marginFrames();
+
+    // Wake up late enough that the HAL had almost drained.
+    const int64_t now = sleepNs + 50'000'000;
+    scheduler.onWakeup(now);
+    (void)scheduler.onWrite(now + kMixNs, kMixNs, 100'000, kPeriodFrames);
+    EXPECT_TRUE(scheduler.lastWriteWasMiss());
+    EXPECT_GT(scheduler.marginFrames(), margin);
+}
+
+TEST(AdaptiveWriteSchedulerTest, BlockedWriteBoundsCapacity) {
+    AdaptiveWriteScheduler scheduler(kSampleRate, kPeriodFrames, kCapacityFrames, 1e-3);
+    // The HAL blocks with 4 periods queued, less than the capacity derived from latency.
+    (void)scheduler.onWrite(0, kMixNs, kPeriodNs, 4 * kPeriodFrames);
+    EXPECT_EQ(4 * kPeriodFrames, scheduler.capacityFrames());
+}
+
+TEST(AdaptiveWriteSchedulerTest, BackToBackWritesAreThrottled) {
+    AdaptiveWriteScheduler scheduler(kSampleRate, kPeriodFrames, kCapacityFrames, 1e-3);
+    // No timestamp: the scheduler never sleeps, the throttle paces the writes.
+    int64_t now = 0;
+    EXPECT_EQ(0, scheduler.onWrite(now, kPeriodNs * 100 /* mixNs */, 100'000, -1));
+    EXPECT_EQ(0, scheduler.throttleNs(now));
+
+    // The second write a millisecond later would run at 20 times real time.
+    now += kMixNs;
+    EXPECT_EQ(0, scheduler.onWrite(now, kMixNs, 100'000, -1));
+    const int64_t throttleNs = scheduler.throttleNs(now);
+    EXPECT_EQ(kPeriodNs / 2 - kMixNs, throttleNs);
+
+    // After the throttle, writes at twice real time are not throttled further.
+    for (int i = 0; i < 10; ++i) {
+        now += kPeriodNs / 2;
+        EXPECT_EQ(0, scheduler.onWrite(now, kMixNs, 100'000, -1));
+        EXPECT_EQ(0, scheduler.throttleNs(now));
+    }
+}
+
+TEST(AdaptiveWriteSchedulerTest, RefillAfterSleepIsNotThrottled) {
+    AdaptiveWriteScheduler scheduler(kSampleRate, kPeriodFrames, kCapacityFrames, 1e-3);
+    int64_t now = 0;
+    int64_t queued = kCapacityFrames;
+    int64_t sleepNs = scheduler.onWrite(now, kMixNs, 100'000, queued);
+    ASSERT_GT(sleepNs, 4 * kPeriodNs);
+
+    // Wake up on time and refill the periods played during the sleep, back to back.
+    now += sleepNs;
+    queued -= sleepNs * kSampleRate / 1'000'000'000;
+    scheduler.onWakeup(now);
+    int writes = 0;
+    do {
+        now += kMixNs;
+        sleepNs = scheduler.onWrite(now, kMixNs, 100'000, queued += kPeriodFrames);
+        if (sleepNs == 0) {
+            EXPECT_EQ(0, scheduler.throttleNs(now)) << "write " << writes;
+        }
+        ASSERT_LT(++writes, 16);
+    } while (sleepNs == 0);
+    EXPECT_GT(writes, 2);
+}
+
+TEST(AdaptiveWriteSchedulerTest, ResumeRestartsThrottle) {
+    AdaptiveWriteScheduler scheduler(kSampleRate, kPeriodFrames, kCapacityFrames, 1e-3);
+    int64_t now = 0;
+    for (int i = 0; i < 4; ++i) {
+        now += kPeriodNs;
+        (void)scheduler.onWrite(now, kMixNs, 100'000, -1);
+        EXPECT_EQ(0, scheduler.throttleNs(now));
+    }
+
+    // Writing resumes a second later (e.g. after standby): the idle time is no credit.
+    now += 1'000'000'000;
+    (void)scheduler.onWrite(now, 1'000'000'000 /* mixNs */, 100'000, -1);
+    EXPECT_EQ(0, scheduler.throttleNs(now));
+    now += kMixNs;
+    (void)scheduler.onWrite(now, kMixNs, 100'000, -1);
+    EXPECT_EQ(kPeriodNs / 2 - kMixNs, scheduler.throttleNs(now));
+}
+
+} // namespace
@@ -20,7 +20,9 @@
 
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
+#include <algorithm>
 #include <cstring>
+#include <audio_utils/primitives.h>
 #include <utils/Trace.h>
 
 #include "AAudioMixer.h"
@@ -33,12 +35,17 @@ using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
 
+// Typical maximum number of shared streams, to avoid allocating in the mixer loop.
+static constexpr size_t kInitialSourceCapacity = 32;
+
 void AAudioMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst) {
     mSamplesPerFrame = samplesPerFrame;
     mFramesPerBurst = framesPerBurst;
     int32_t samplesPerBuffer = samplesPerFrame * framesPerBurst;
     mOutputBuffer = std::make_unique<float[]>(samplesPerBuffer);
     mBufferSizeInBytes = samplesPerBuffer * sizeof(float);
+    mSources.clear();
+    mSources.reserve(kInitialSourceCapacity);
 }
 
 void AAudioMixer::clear() {
@@ -106,13 +113,164 @@ int32_t AAudioMixer::mix(
 }
 
 void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
+    accumulate_float(destination, source, numFrames * mSamplesPerFrame);
+}
+
+int32_t AAudioMixer::addStream(
+        int streamIndex, const std::shared_ptr<FifoBuffer>& fifo, bool allowUnderflow) {
+    WrappingBuffer wrappingBuffer;
+    fifo_frames_t fullFrames = fifo->getFullDataAvailable(&wrappingBuffer);
+#if AAUDIO_MIXER_ATRACE_ENABLED
+    if (ATRACE_ENABLED()) {
+        char rdyText[] = "aaMixRdy#";
+        char letter = 'A' + (streamIndex % 26);
+        rdyText[sizeof(rdyText) - 2] = letter;
+        ATRACE_INT(rdyText, fullFrames);
+    }
+#else /* MIXER_ATRACE_ENABLED */
+    (void) streamIndex;
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+
+    // Same policy as mix().
+    fifo_frames_t framesDesired = mFramesPerBurst;
+    if (!allowUnderflow && fullFrames < framesDesired) {
+        framesDesired = fullFrames;
+    }
+
+    Source &source = mSources.emplace_back();
+    source.fifo = fifo;
+    source.framesToAdvance = framesDesired;
+    int32_t framesLeft = framesDesired;
+    for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+        const int32_t framesFromPart = std::max(0,
+                std::min(framesLeft, wrappingBuffer.numFrames[partIndex]));
+        source.parts[partIndex] = static_cast<const float *>(wrappingBuffer.data[partIndex]);
+        source.partSamples[partIndex] = framesFromPart * mSamplesPerFrame;
+        framesLeft -= framesFromPart;
+    }
+    return framesDesired - framesLeft; // framesRead
+}
+
+const float *AAudioMixer::Source::contiguous(int32_t start, int32_t numSamples) const {
+    const int32_t end = start + numSamples;
+    if (end <= partSamples[0]) {
+        return parts[0] + start;
+    }
+    if (start >= partSamples[0] && end <= partSamples[0] + partSamples[1]) {
+        return parts[1] + (start - partSamples[0]);
+    }
+    return nullptr;
+}
+
+// Sum NUM_INPUTS inputs into destination, adding to its content if ACCUMULATE.
+// The loop over samples is vectorized by the compiler.
+template <int NUM_INPUTS, bool ACCUMULATE>
+static void sumInputs(float *destination, const float * const *inputs, int32_t numSamples) {
+    for (int32_t i = 0; i < numSamples; i++) {
+        float sum = ACCUMULATE ? destination[i] : 0.0f;
+        for (int input = 0; input < NUM_INPUTS; input++) {
+            sum += inputs[input][i];
+        }
+        destination[i] = sum;
     }
 }
 
+template <bool ACCUMULATE>
+static void sumInputs(float *destination, const float * const *inputs, int numInputs,
+                      int32_t numSamples) {
+    switch (numInputs) {
+        case 0:
+            if (!ACCUMULATE) {
+                memset(destination, 0, numSamples * sizeof(float));
+            }
+            break;
+        case 1:
+            sumInputs<1, ACCUMULATE>(destination, inputs, numSamples);
+            break;
+        case 2:
+            sumInputs<2, ACCUMULATE>(destination, inputs, numSamples);
+            break;
+        case 3:
+            sumInputs<3, ACCUMULATE>(destination, inputs, numSamples);
+            break;
+        default:
+            sumInputs<4, ACCUMULATE>(destination, inputs, numSamples);
+            break;
+    }
+}
+
+void AAudioMixer::mixStreams() {
+    static_assert(kMaxStreamsPerPass == 4, "update sumInputs()");
+#if AAUDIO_MIXER_ATRACE_ENABLED
+    ATRACE_BEGIN("aaMix");
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+
+    const int32_t numSamples = mFramesPerBurst * mSamplesPerFrame;
+    for (int32_t start = 0; start < numSamples; start += kSamplesPerBlock) {
+        const int32_t blockSamples = std::min(kSamplesPerBlock, numSamples - start);
+        float *destination = &mOutputBuffer[start];
+
+        // Sum the sources that are contiguous in this block, several per pass.
+        // The first pass overwrites the block, so clear() is not needed.
+        const float *inputs[kMaxStreamsPerPass];
+        int numInputs = 0;
+        bool written = false;
+        bool hasPartial = false;
+        for (const Source &source : mSources) {
+            const float *input = source.contiguous(start, blockSamples);
+            if (input == nullptr) {
+                hasPartial = true;
+                continue;
+            }
+            inputs[numInputs++] = input;
+            if (numInputs == kMaxStreamsPerPass) {
+                if (written) {
+                    sumInputs<true>(destination, inputs, numInputs, blockSamples);
+                } else {
+                    sumInputs<false>(destination, inputs, numInputs, blockSamples);
+                    written = true;
+                }
+                numInputs = 0;
+            }
+        }
+        if (written) {
+            sumInputs<true>(destination, inputs, numInputs, blockSamples);
+        } else {
+            sumInputs<false>(destination, inputs, numInputs, blockSamples);
+        }
+
+        // Add the sources which wrap or underflow within this block.
+        if (hasPartial) {
+            const int32_t end = start + blockSamples;
+            for (const Source &source : mSources) {
+                if (source.contiguous(start, blockSamples) != nullptr) {
+                    continue;
+                }
+                int32_t partStart = 0;
+                for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+                    const int32_t partEnd = partStart + source.partSamples[partIndex];
+                    const int32_t from = std::max(start, partStart);
+                    const int32_t to = std::min(end, partEnd);
+                    if (from < to) {
+                        accumulate_float(&mOutputBuffer[from],
+                                source.parts[partIndex] + (from - partStart), to - from);
+                    }
+                    partStart = partEnd;
+                }
+            }
+        }
+    }
+
+    for (const Source &source : mSources) {
+        source.fifo->advanceReadIndex(source.framesToAdvance);
+    }
+    mSources.clear();
+
+#if AAUDIO_MIXER_ATRACE_ENABLED
+    ATRACE_END();
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+}
+
 float *AAudioMixer::getOutputBuffer() {
     return mOutputBuffer.get();
 }
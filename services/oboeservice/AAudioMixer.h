@@ -18,6 +18,7 @@
 #define AAUDIO_AAUDIO_MIXER_H
 
 #include <stdint.h>
+#include <vector>
 
 #include <aaudio/AAudio.h>
 #include <fifo/FifoBuffer.h>
@@ -41,6 +42,29 @@ public:
                 const std::shared_ptr<android::FifoBuffer>& fifo,
                 bool allowUnderflow);
 
+    /**
+     * Queue a burst from this FIFO for mixStreams().
+     * The data is read, and the read index advanced, by mixStreams(),
+     * so the memory of the FIFO must remain valid until then.
+     *
+     * @param streamIndex for marking stream variables in systrace
+     * @param fifo to read from
+     * @param allowUnderflow if true then allow mixer to advance read index past the write index
+     * @return frames that will be read from this stream
+     */
+    int32_t addStream(int streamIndex,
+                      const std::shared_ptr<android::FifoBuffer>& fifo,
+                      bool allowUnderflow);
+
+    /**
+     * Replace the output buffer with the sum of the streams queued by addStream(),
+     * then advance their read indices and clear the queue.
+     *
+     * The output is processed in blocks that stay in the cache, and several streams
+     * are summed in each pass over a block.
+     */
+    void mixStreams();
+
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
@@ -48,6 +72,25 @@ public:
 private:
     void mixPart(float *destination, float *source, int32_t numFrames);
 
+    // Output samples per block in mixStreams().
+    static constexpr int32_t kSamplesPerBlock = 512;
+    // Streams summed in one pass over a block.
+    static constexpr int32_t kMaxStreamsPerPass = 4;
+
+    // A burst queued by addStream(), in one or two parts.
+    struct Source {
+        std::shared_ptr<android::FifoBuffer> fifo;
+        const float *parts[android::WrappingBuffer::SIZE];
+        int32_t partSamples[android::WrappingBuffer::SIZE];
+        int32_t framesToAdvance;
+
+        // Returns the samples [start, start + numSamples) if they are all in one part,
+        // otherwise nullptr.
+        const float *contiguous(int32_t start, int32_t numSamples) const;
+    };
+
+    std::vector<Source> mSources;
+
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
     int32_t  mFramesPerBurst = 0;
@@ -55,6 +55,9 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
     ALOGD("callbackLoop() entering");
     aaudio_result_t result = AAUDIO_OK;
     int64_t timeoutNanos = getStreamInternal()->calculateReasonableTimeout();
+    // The blocking read() is already paced by the timing model of the MMAP stream,
+    // so we just tell the clients when to expect the next burst.
+    const int64_t burstPeriodNanos = getBurstPeriodNanos();
 
     // result might be a frame count
     while (mCallbackEnabled.load() && getStreamInternal()->isActive() && (result >= 0)) {
@@ -83,7 +86,8 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
                             static_cast<AAudioServiceStreamShared *>(clientStream.get());
                     streamShared->writeDataIfRoom(mmapFramesRead,
                                                   mDistributionBuffer.get(),
-                                                  getFramesPerBurst());
+                                                  getFramesPerBurst(),
+                                                  burstPeriodNanos);
                 }
             }
         }
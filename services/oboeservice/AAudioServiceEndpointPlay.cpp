@@ -31,6 +31,8 @@
 #include <vector>
 
 #include "core/AudioStreamBuilder.h"
+#include "utility/AAudioUtilities.h"
+#include "utility/AudioClock.h"
 #include "AAudioServiceEndpoint.h"
 #include "AAudioServiceStreamShared.h"
 #include "AAudioServiceEndpointPlay.h"
@@ -42,6 +44,9 @@ using namespace aaudio;   // TODO just import names needed
 
 #define BURSTS_PER_BUFFER_DEFAULT   2
 
+// Avoid allocations in the mixer loop for up to this many streams.
+static constexpr size_t kTypicalMixedStreams = 32;
+
 AAudioServiceEndpointPlay::AAudioServiceEndpointPlay(AAudioService& audioService)
         : AAudioServiceEndpointShared(
                 new AudioStreamInternalPlay(audioService.asAAudioServiceInterface(), true)) {}
@@ -51,6 +56,7 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     if (result == AAUDIO_OK) {
         mMixer.allocate(getStreamInternal()->getSamplesPerFrame(),
                         getStreamInternal()->getFramesPerBurst());
+        mMixedStreams.reserve(kTypicalMixedStreams);
 
         int32_t burstsPerBuffer = AudioSystem::getAAudioMixerBurstCount();
         if (burstsPerBuffer == 0) {
@@ -59,6 +65,14 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
         }
         int32_t desiredBufferSize = burstsPerBuffer * getStreamInternal()->getFramesPerBurst();
         getStreamInternal()->setBufferSize(desiredBufferSize);
+
+        // A burst can be mixed as soon as there is room for it in the MMAP buffer,
+        // which is this long before the DSP needs it.
+        const int64_t maxLeadNanos = AAUDIO_NANOS_PER_SECOND
+                * (getStreamInternal()->getBufferSize() - getFramesPerBurst())
+                / getSampleRate();
+        mJustInTimeEnabled = AAudioProperty_isJustInTimeMixerEnabled() && maxLeadNanos > 0;
+        mWakeupScheduler.configure(maxLeadNanos);
     }
     return result;
 }
@@ -68,19 +82,32 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
     aaudio_result_t result = AAUDIO_OK;
     int64_t timeoutNanos = getStreamInternal()->calculateReasonableTimeout();
+    const int64_t burstPeriodNanos = getBurstPeriodNanos();
+    mWakeupScheduler.reset();
 
     // result might be a frame count
     while (mCallbackEnabled.load() && getStreamInternal()->isActive() && (result >= 0)) {
-        // Mix data from each active stream.
-        mMixer.clear();
+        int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
+
+        // Rather than mixing as soon as there is room in the MMAP buffer, wait until
+        // just before the DSP needs the data so that the clients have more time to write it.
+        int64_t deadlineTime = 0;
+        int64_t wakeTime = 0;
+        if (mJustInTimeEnabled) {
+            // This is 0 until the stream has received enough timestamps.
+            deadlineTime = getStreamInternal()->predictPositionTime(mmapFramesWritten);
+            if (deadlineTime > 0) {
+                wakeTime = mWakeupScheduler.calculateWakeTime(deadlineTime);
+                AudioClock::sleepUntilNanoTime(wakeTime);
+            }
+        }
 
+        // Mix data from each active stream.
         { // brackets are for lock_guard
             int index = 0;
-            int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
             std::lock_guard <std::mutex> lock(mLockStreams);
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -107,12 +134,13 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
 
                         // Determine offset between framePosition in client's stream
                         // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
+                        int64_t clientFramesRead = fifo->getReadCounter();
                         // These two indices refer to the same frame.
                         int64_t positionOffset = mmapFramesWritten - clientFramesRead;
                         streamShared->setTimestampPositionOffset(positionOffset);
 
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
+                        // The data is read by mixStreams() below, once all streams are queued.
+                        int32_t framesMixed = mMixer.addStream(index, fifo, allowUnderflow);
 
                         if (streamShared->isFlowing()) {
                             // Consider it an underflow if we got less than a burst
@@ -126,19 +154,36 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                             // Mark beginning of data flow after a start.
                             streamShared->setFlowing(true);
                         }
-                        clientFramesRead = fifo->getReadCounter();
+                        mMixedStreams.push_back({streamShared, std::move(audioDataQueue)});
                     }
                 }
 
+                index++; // just used for labelling tracks in systrace
+            }
+
+            // Sum all the queued streams in one pass over the output buffer,
+            // which also clears it when there are none.
+            mMixer.mixStreams();
+
+            const int64_t transferTime = AudioClock::getNanoseconds();
+            for (const MixedStream& mixed : mMixedStreams) {
+                int64_t clientFramesRead =
+                        mixed.audioDataQueue->getFifoBuffer()->getReadCounter();
                 if (clientFramesRead > 0) {
                     // This timestamp represents the completion of data being read out of the
                     // client buffer. It is sent to the client and used in the timing model
                     // to decide when the client has room to write more data.
-                    Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
-                    streamShared->markTransferTime(timestamp);
+                    Timestamp timestamp(clientFramesRead, transferTime);
+                    mixed.stream->markTransferTime(timestamp);
                 }
+                // Let the client wake up just after we read the next burst.
+                mixed.audioDataQueue->setServiceSchedule(transferTime + burstPeriodNanos,
+                                                         burstPeriodNanos);
+            }
+            mMixedStreams.clear();
 
-                index++; // just used for labelling tracks in systrace
+            if (deadlineTime > 0) {
+                mWakeupScheduler.onBurstDone(wakeTime, transferTime, deadlineTime);
             }
         }
 
@@ -156,7 +201,8 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
         }
     }
 
-    ALOGD("%s() exiting, enabled = %d, state = %d, result = %d <<<<<<<<<<<<< MIXER",
-          __func__, mCallbackEnabled.load(), getStreamInternal()->getState(), result);
+    ALOGD("%s() exiting, enabled = %d, state = %d, result = %d, missed %d <<<<<<<<<<<<< MIXER",
+          __func__, mCallbackEnabled.load(), getStreamInternal()->getState(), result,
+          mWakeupScheduler.getMissCount());
     return nullptr; // TODO review
 }
@@ -29,6 +29,7 @@
 #include "AAudioServiceStreamMMAP.h"
 #include "AAudioMixer.h"
 #include "AAudioService.h"
+#include "EndpointWakeupScheduler.h"
 
 namespace aaudio {
 
@@ -44,8 +45,18 @@ public:
     void *callbackLoop() override;
 
 private:
+    // A stream queued in the mixer during one pass of callbackLoop().
+    struct MixedStream {
+        android::sp<AAudioServiceStreamShared> stream;
+        // Keeps the shared memory mapped until the mixer has read it.
+        std::shared_ptr<SharedRingBuffer>      audioDataQueue;
+    };
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
+    bool                     mJustInTimeEnabled = false;
     AAudioMixer              mMixer;    //
+    std::vector<MixedStream> mMixedStreams; // only used by callbackLoop()
+    EndpointWakeupScheduler  mWakeupScheduler; // only used by callbackLoop()
 };
 
 } /* namespace aaudio */
@@ -70,6 +70,11 @@ protected:
 
     void                     handleDisconnectRegisteredStreamsAsync();
 
+    // Time between the transfers done by callbackLoop().
+    int64_t getBurstPeriodNanos() const {
+        return AAUDIO_NANOS_PER_SECOND * getFramesPerBurst() / getSampleRate();
+    }
+
     // An MMAP stream that is shared by multiple clients.
     android::sp<AudioStreamInternal> mStreamInternal;
 
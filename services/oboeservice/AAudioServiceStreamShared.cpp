@@ -221,7 +221,8 @@ aaudio_result_t AAudioServiceStreamShared::getAudioDataDescription_l(
     }
     // Gather information on the data queue.
     mAudioDataQueue->fillParcelable(parcelable,
-                                    parcelable->mDownDataQueueParcelable);
+                                    parcelable->mDownDataQueueParcelable,
+                                    &parcelable->mEndpointScheduleParcelable);
     parcelable->mDownDataQueueParcelable.setFramesPerBurst(getFramesPerBurst());
     return AAUDIO_OK;
 }
@@ -268,7 +269,8 @@ aaudio_result_t AAudioServiceStreamShared::getHardwareTimestamp_l(int64_t *posit
 }
 
 void AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
-                                                const void *buffer, int32_t numFrames) {
+                                                const void *buffer, int32_t numFrames,
+                                                int64_t servicePeriod) {
     int64_t clientFramesWritten = 0;
 
     // Lock the AudioFifo to protect against close.
@@ -290,6 +292,9 @@ void AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
             fifo->write(buffer, numFrames);
         }
         clientFramesWritten = fifo->getWriteCounter();
+        // Expect to write the next burst one period after this one.
+        mAudioDataQueue->setServiceSchedule(AudioClock::getNanoseconds() + servicePeriod,
+                                            servicePeriod);
     }
 
     if (clientFramesWritten > 0) {
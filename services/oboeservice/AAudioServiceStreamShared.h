@@ -53,7 +53,13 @@ public:
     aaudio_result_t open(const aaudio::AAudioStreamRequest &request) override
             EXCLUDES(mUpMessageQueueLock);
 
-    void writeDataIfRoom(int64_t mmapFramesRead, const void *buffer, int32_t numFrames);
+    /**
+     * Write a burst to the client's data queue and publish when the next one is expected.
+     *
+     * @param servicePeriod nanoseconds between calls
+     */
+    void writeDataIfRoom(int64_t mmapFramesRead, const void *buffer, int32_t numFrames,
+                         int64_t servicePeriod);
 
     /**
      * This must only be called under getAudioDataQueueLock().
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <math.h>
+
+#include "EndpointWakeupScheduler.h"
+
+using namespace aaudio;
+
+void EndpointWakeupScheduler::configure(int64_t maxLeadNanos) {
+    mMaxLeadNanos = std::max(maxLeadNanos, (int64_t) 0);
+    mMeanWorkNanos = 0.0;
+    mVarianceWorkNanos = 0.0;
+    reset();
+}
+
+void EndpointWakeupScheduler::reset() {
+    // Start with the conventional schedule until we have measured the work.
+    mBackoffNanos = mMaxLeadNanos;
+    mMissCount = 0;
+    updateLead();
+}
+
+void EndpointWakeupScheduler::onBurstDone(int64_t wakeTimeNanos, int64_t doneTimeNanos,
+                                          int64_t deadlineNanos) {
+    // This includes the wakeup latency as well as the time to produce the burst.
+    const double workNanos = (double) std::max(doneTimeNanos - wakeTimeNanos, (int64_t) 0);
+    const double error = workNanos - mMeanWorkNanos;
+    mMeanWorkNanos += error / (1 << kMeasurementShift);
+    mVarianceWorkNanos += ((error * error) - mVarianceWorkNanos) / (1 << kMeasurementShift);
+
+    if (doneTimeNanos > deadlineNanos) {
+        // We were too late so fall back to producing the data as early as possible.
+        mMissCount++;
+        mBackoffNanos = mMaxLeadNanos;
+    } else {
+        mBackoffNanos -= mBackoffNanos >> kBackoffDecayShift;
+    }
+    updateLead();
+}
+
+void EndpointWakeupScheduler::updateLead() {
+    const int64_t workLead = (int64_t) (mMeanWorkNanos
+            + (kDeviationsAllowed * sqrt(mVarianceWorkNanos)));
+    const int64_t lead = workLead + kSafetyMarginNanos + mBackoffNanos;
+    // Never wake up earlier than we could write.
+    mLeadNanos = std::min(std::max(lead, kMinLeadNanos), mMaxLeadNanos);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAUDIO_ENDPOINT_WAKEUP_SCHEDULER_H
+#define AAUDIO_ENDPOINT_WAKEUP_SCHEDULER_H
+
+#include <stdint.h>
+
+namespace aaudio {
+
+/**
+ * Schedule the wakeup of a shared endpoint thread so that it produces each burst
+ * shortly before the DSP needs it, rather than as soon as there is room in the MMAP buffer.
+ *
+ * The deadline for each burst is predicted by the timing model of the MMAP stream.
+ * The thread wakes up ahead of the deadline by a lead time that covers the measured
+ * wakeup latency plus the time taken to produce the burst. The lead time backs off to the
+ * maximum when a deadline is missed and then slowly recovers.
+ *
+ * Note that this object is not thread safe. Only call it from a single thread.
+ */
+class EndpointWakeupScheduler {
+public:
+    /**
+     * Set the maximum lead time and restart the schedule.
+     *
+     * @param maxLeadNanos the earliest before its deadline that a burst can be produced
+     *                     without blocking
+     */
+    void configure(int64_t maxLeadNanos);
+
+    /**
+     * Restart the schedule at the maximum lead time, e.g. when the stream is started.
+     */
+    void reset();
+
+    /**
+     * @param deadlineNanos predicted time when the DSP will need the next burst
+     * @return time to wake up and start producing the burst
+     */
+    int64_t calculateWakeTime(int64_t deadlineNanos) const {
+        return deadlineNanos - mLeadNanos;
+    }
+
+    /**
+     * Update the lead time after producing a burst.
+     *
+     * @param wakeTimeNanos value that was returned by calculateWakeTime()
+     * @param doneTimeNanos time when the burst was produced
+     * @param deadlineNanos value that was passed to calculateWakeTime()
+     */
+    void onBurstDone(int64_t wakeTimeNanos, int64_t doneTimeNanos, int64_t deadlineNanos);
+
+    int64_t getLeadNanos() const {
+        return mLeadNanos;
+    }
+
+    int32_t getMissCount() const {
+        return mMissCount;
+    }
+
+private:
+    void updateLead();
+
+    // Weight of a new measurement in the running mean and variance, as a shift.
+    static constexpr int     kMeasurementShift = 4;
+    // The backoff after a miss decays by 1/2^kBackoffDecayShift per burst.
+    static constexpr int     kBackoffDecayShift = 5;
+    // Number of standard deviations of the measured work time to allow for.
+    static constexpr int64_t kDeviationsAllowed = 4;
+    static constexpr int64_t kSafetyMarginNanos = 300 * 1000;
+    static constexpr int64_t kMinLeadNanos = 500 * 1000;
+
+    int64_t mMaxLeadNanos = 0;
+    int64_t mLeadNanos = 0;
+    int64_t mBackoffNanos = 0;
+    double  mMeanWorkNanos = 0.0;
+    double  mVarianceWorkNanos = 0.0;
+    int32_t mMissCount = 0;
+};
+
+} /* namespace aaudio */
+
+#endif /* AAUDIO_ENDPOINT_WAKEUP_SCHEDULER_H */
@@ -20,6 +20,7 @@
 
 #include <iomanip>
 #include <iostream>
+#include <new>
 #include <sys/mman.h>
 
 #include "binding/RingBufferParcelable.h"
@@ -33,6 +34,7 @@ using namespace aaudio;
 SharedRingBuffer::~SharedRingBuffer()
 {
     mFifoBuffer.reset(); // uses mSharedMemory
+    mSchedule = nullptr;
     if (mSharedMemory != nullptr) {
         munmap(mSharedMemory, mSharedMemorySizeInBytes);
         mSharedMemory = nullptr;
@@ -43,9 +45,13 @@ aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
                                          fifo_frames_t   capacityInFrames) {
     mCapacityInFrames = capacityInFrames;
 
-    // Create shared memory large enough to hold the data and the read and write counters.
+    // Create shared memory large enough to hold the data, the read and write counters
+    // and the schedule.
     mDataMemorySizeInBytes = bytesPerFrame * capacityInFrames;
-    mSharedMemorySizeInBytes = mDataMemorySizeInBytes + (2 * (sizeof(fifo_counter_t)));
+    const int32_t dataEnd = SHARED_RINGBUFFER_DATA_OFFSET + mDataMemorySizeInBytes;
+    constexpr int32_t alignment = SHARED_RINGBUFFER_SCHEDULE_ALIGNMENT;
+    mScheduleOffsetInBytes = (dataEnd + alignment - 1) & ~(alignment - 1);
+    mSharedMemorySizeInBytes = mScheduleOffsetInBytes + (int32_t) sizeof(EndpointSchedule);
     mFileDescriptor.reset(ashmem_create_region("AAudioSharedRingBuffer", mSharedMemorySizeInBytes));
     if (mFileDescriptor.get() == -1) {
         ALOGE("allocate() ashmem_create_region() failed %d", errno);
@@ -77,6 +83,7 @@ aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
     auto readCounterAddress = (fifo_counter_t *) &mSharedMemory[SHARED_RINGBUFFER_READ_OFFSET];
     auto writeCounterAddress = (fifo_counter_t *) &mSharedMemory[SHARED_RINGBUFFER_WRITE_OFFSET];
     uint8_t *dataAddress = &mSharedMemory[SHARED_RINGBUFFER_DATA_OFFSET];
+    mSchedule = new (&mSharedMemory[mScheduleOffsetInBytes]) EndpointSchedule();
 
     mFifoBuffer = std::make_shared<FifoBufferIndirect>(bytesPerFrame, capacityInFrames,
                                  readCounterAddress, writeCounterAddress, dataAddress);
@@ -84,7 +91,8 @@ aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
 }
 
 void SharedRingBuffer::fillParcelable(AudioEndpointParcelable* endpointParcelable,
-                    RingBufferParcelable &ringBufferParcelable) {
+                    RingBufferParcelable &ringBufferParcelable,
+                    SharedRegionParcelable *scheduleParcelable) {
     int fdIndex = endpointParcelable->addFileDescriptor(mFileDescriptor, mSharedMemorySizeInBytes);
     ringBufferParcelable.setupMemory(fdIndex,
                                      SHARED_RINGBUFFER_DATA_OFFSET,
@@ -95,6 +103,10 @@ void SharedRingBuffer::fillParcelable(AudioEndpointParcelable* endpointParcelabl
     ringBufferParcelable.setBytesPerFrame(mFifoBuffer->getBytesPerFrame());
     ringBufferParcelable.setFramesPerBurst(1);
     ringBufferParcelable.setCapacityInFrames(mCapacityInFrames);
+    if (scheduleParcelable != nullptr) {
+        scheduleParcelable->setup({fdIndex, mScheduleOffsetInBytes,
+                                   (int32_t) sizeof(EndpointSchedule)});
+    }
 }
 
 double SharedRingBuffer::getFractionalFullness() const {
@@ -33,6 +33,8 @@ namespace aaudio {
 #define SHARED_RINGBUFFER_READ_OFFSET   0
 #define SHARED_RINGBUFFER_WRITE_OFFSET  sizeof(fifo_counter_t)
 #define SHARED_RINGBUFFER_DATA_OFFSET   (SHARED_RINGBUFFER_WRITE_OFFSET + sizeof(fifo_counter_t))
+// The EndpointSchedule follows the data, aligned for its atomics.
+#define SHARED_RINGBUFFER_SCHEDULE_ALIGNMENT  alignof(EndpointSchedule)
 
 /**
  * Atomic FIFO that uses shared memory.
@@ -45,8 +47,12 @@ public:
 
     aaudio_result_t allocate(android::fifo_frames_t bytesPerFrame, android::fifo_frames_t capacityInFrames);
 
+    /**
+     * @param scheduleParcelable if not null, set to the region of the EndpointSchedule
+     */
     void fillParcelable(AudioEndpointParcelable* endpointParcelable,
-                        RingBufferParcelable &ringBufferParcelable);
+                        RingBufferParcelable &ringBufferParcelable,
+                        SharedRegionParcelable *scheduleParcelable = nullptr);
 
     /**
      * Return available frames as a fraction of the capacity.
@@ -61,6 +67,14 @@ public:
         return mFifoBuffer;
     }
 
+    /**
+     * Publish when the service will next transfer data to or from this buffer.
+     * Only call this from the thread that does the transfers.
+     */
+    void setServiceSchedule(int64_t nextServiceTime, int64_t servicePeriod) {
+        mSchedule->write(nextServiceTime, servicePeriod);
+    }
+
 private:
     android::base::unique_fd  mFileDescriptor;
     std::shared_ptr<android::FifoBufferIndirect>  mFifoBuffer;
@@ -68,6 +82,8 @@ private:
     int32_t                   mSharedMemorySizeInBytes = 0;
     // size of memory used for data vs counters
     int32_t                   mDataMemorySizeInBytes = 0;
+    int32_t                   mScheduleOffsetInBytes = 0;
+    EndpointSchedule         *mSchedule = nullptr; // in mSharedMemory
     android::fifo_frames_t    mCapacityInFrames = 0;
 };
 
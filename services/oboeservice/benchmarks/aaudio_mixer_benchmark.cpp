@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the AAudioMixer of a shared MMAP playback endpoint, for 1 to 32 streams
+// of 48 kHz stereo with 96 frame bursts.
+//
+// Each benchmark takes (streamCount, blocked), where blocked selects
+// addStream() and mixStreams() instead of clear() and mix() per stream.
+// The FIFOs are 3 bursts, so that some of the bursts wrap around the end of a FIFO.
+// An item is one output frame.
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+
+static constexpr int32_t kChannelCount = 2;
+static constexpr int32_t kFramesPerBurst = 96;
+static constexpr int32_t kBurstsPerFifo = 3;
+
+static void BM_AAudioMixer(benchmark::State& state) {
+    const int32_t streamCount = state.range(0);
+    const bool blocked = state.range(1) != 0;
+
+    AAudioMixer mixer;
+    mixer.allocate(kChannelCount, kFramesPerBurst);
+
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dis(-0.1f, 0.1f);
+    constexpr int32_t kFifoFrames = kFramesPerBurst * kBurstsPerFifo;
+    std::vector<float> data(kFifoFrames * kChannelCount);
+    std::generate(data.begin(), data.end(), [&] { return dis(gen); });
+
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    for (int32_t i = 0; i < streamCount; i++) {
+        auto fifo = std::make_shared<FifoBufferAllocated>(
+                kChannelCount * sizeof(float), kFifoFrames);
+        fifo->write(data.data(), kFifoFrames);
+        // Offset the streams so that they do not all wrap in the same burst.
+        const int32_t offset = (i * kFramesPerBurst / 2) % kFifoFrames;
+        fifo->setReadCounter(offset);
+        fifos.push_back(std::move(fifo));
+    }
+
+    for (auto _ : state) {
+        // The client writes a burst, without touching the data.
+        for (const auto& fifo : fifos) {
+            fifo->setWriteCounter(fifo->getReadCounter() + kFramesPerBurst);
+        }
+
+        if (blocked) {
+            for (int32_t i = 0; i < streamCount; i++) {
+                mixer.addStream(i, fifos[i], true /* allowUnderflow */);
+            }
+            mixer.mixStreams();
+        } else {
+            mixer.clear();
+            for (int32_t i = 0; i < streamCount; i++) {
+                mixer.mix(i, fifos[i], true /* allowUnderflow */);
+            }
+        }
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+static void AAudioMixerArgs(benchmark::internal::Benchmark *b) {
+    for (int64_t streamCount : {1, 2, 4, 8, 16, 32}) {
+        for (int64_t blocked : {0, 1}) {
+            b->Args({streamCount, blocked});
+        }
+    }
+}
+
+BENCHMARK(BM_AAudioMixer)->Apply(AAudioMixerArgs);
+
+BENCHMARK_MAIN();
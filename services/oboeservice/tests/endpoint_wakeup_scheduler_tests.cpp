@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include <gtest/gtest.h>
+
+#include "EndpointWakeupScheduler.h"
+
+using namespace aaudio;
+
+namespace {
+
+constexpr int64_t kMaxLeadNanos = 8'000'000;
+constexpr int64_t kBurstNanos = 2'000'000;
+// As in EndpointWakeupScheduler.
+constexpr int64_t kSafetyMarginNanos = 300'000;
+constexpr int64_t kMinLeadNanos = 500'000;
+
+class EndpointWakeupSchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mScheduler.configure(kMaxLeadNanos);
+    }
+
+    // Produce a burst that takes workNanos after the scheduled wakeup, and returns the lead.
+    int64_t runBurst(int64_t workNanos) {
+        mDeadlineNanos += kBurstNanos;
+        const int64_t wakeTime = mScheduler.calculateWakeTime(mDeadlineNanos);
+        EXPECT_EQ(mDeadlineNanos - mScheduler.getLeadNanos(), wakeTime);
+        mScheduler.onBurstDone(wakeTime, wakeTime + workNanos, mDeadlineNanos);
+        return mScheduler.getLeadNanos();
+    }
+
+    // Run until the backoff has decayed.
+    void converge(int64_t workNanos) {
+        for (int i = 0; i < 1000; i++) {
+            runBurst(workNanos);
+        }
+    }
+
+    EndpointWakeupScheduler mScheduler;
+    int64_t mDeadlineNanos = 1'000'000'000;
+};
+
+TEST_F(EndpointWakeupSchedulerTest, startsAtMaxLead) {
+    EXPECT_EQ(kMaxLeadNanos, mScheduler.getLeadNanos());
+    EXPECT_EQ(0, mScheduler.getMissCount());
+}
+
+TEST_F(EndpointWakeupSchedulerTest, leadConvergesToWork) {
+    constexpr int64_t kWorkNanos = 1'000'000;
+    converge(kWorkNanos);
+    EXPECT_NEAR(kWorkNanos + kSafetyMarginNanos, mScheduler.getLeadNanos(), 1000);
+    EXPECT_EQ(0, mScheduler.getMissCount());
+}
+
+// The lead allows for four standard deviations of the work.
+TEST_F(EndpointWakeupSchedulerTest, leadCoversDeviation) {
+    constexpr int64_t kWorkNanos = 1'000'000;
+    constexpr int64_t kDeviationNanos = 200'000;
+    for (int i = 0; i < 2000; i++) {
+        runBurst(kWorkNanos + ((i & 1) ? kDeviationNanos : -kDeviationNanos));
+    }
+    // The running mean and variance lag the alternating samples a little.
+    EXPECT_NEAR(kWorkNanos + 4 * kDeviationNanos + kSafetyMarginNanos,
+                mScheduler.getLeadNanos(), 50'000);
+    EXPECT_EQ(0, mScheduler.getMissCount());
+}
+
+TEST_F(EndpointWakeupSchedulerTest, missBacksOffToMaxLead) {
+    constexpr int64_t kWorkNanos = 1'000'000;
+    converge(kWorkNanos);
+    const int64_t convergedLead = mScheduler.getLeadNanos();
+    ASSERT_LT(convergedLead, kMaxLeadNanos);
+
+    // Done after the deadline.
+    runBurst(convergedLead + 1);
+    EXPECT_EQ(1, mScheduler.getMissCount());
+    EXPECT_EQ(kMaxLeadNanos, mScheduler.getLeadNanos());
+}
+
+// After a miss, the backoff decays by 1/32 per burst back to the converged lead.
+TEST_F(EndpointWakeupSchedulerTest, backoffDecays) {
+    constexpr int64_t kWorkNanos = 1'000'000;
+    converge(kWorkNanos);
+    const int64_t convergedLead = mScheduler.getLeadNanos();
+    mDeadlineNanos += kBurstNanos;
+    const int64_t wakeTime = mScheduler.calculateWakeTime(mDeadlineNanos);
+    // A late wakeup which does not disturb the measured work much.
+    mScheduler.onBurstDone(wakeTime, mDeadlineNanos + 1, mDeadlineNanos);
+    ASSERT_EQ(1, mScheduler.getMissCount());
+
+    int64_t previousLead = mScheduler.getLeadNanos();
+    for (int burst = 1; burst <= 200; burst++) {
+        const int64_t lead = runBurst(kWorkNanos);
+        EXPECT_LE(lead, previousLead) << "burst " << burst;
+        previousLead = lead;
+        const double backoff = kMaxLeadNanos * pow(31. / 32., burst);
+        if (burst == 32 || burst == 64 || burst == 128) {
+            EXPECT_NEAR(convergedLead + backoff, lead, 0.05 * backoff) << "burst " << burst;
+        }
+    }
+    converge(kWorkNanos);
+    EXPECT_NEAR(convergedLead, mScheduler.getLeadNanos(), 1000);
+    EXPECT_EQ(1, mScheduler.getMissCount());
+}
+
+TEST_F(EndpointWakeupSchedulerTest, clampedToMinLead) {
+    converge(0);
+    EXPECT_EQ(kMinLeadNanos, mScheduler.getLeadNanos());
+}
+
+TEST_F(EndpointWakeupSchedulerTest, clampedToMaxLead) {
+    // Work that takes longer than the buffer never wakes up earlier than a write can start.
+    converge(2 * kMaxLeadNanos);
+    EXPECT_EQ(kMaxLeadNanos, mScheduler.getLeadNanos());
+}
+
+TEST_F(EndpointWakeupSchedulerTest, maxLeadBelowMinLead) {
+    mScheduler.configure(kMinLeadNanos / 2);
+    converge(0);
+    EXPECT_EQ(kMinLeadNanos / 2, mScheduler.getLeadNanos());
+
+    mScheduler.configure(-1);
+    EXPECT_EQ(0, mScheduler.getLeadNanos());
+}
+
+// A restart goes back to the maximum lead, but keeps the measured work.
+TEST_F(EndpointWakeupSchedulerTest, resetRestartsAtMaxLead) {
+    constexpr int64_t kWorkNanos = 1'000'000;
+    converge(kWorkNanos);
+    const int64_t convergedLead = mScheduler.getLeadNanos();
+    runBurst(convergedLead + 1);
+    ASSERT_EQ(1, mScheduler.getMissCount());
+
+    mScheduler.reset();
+    EXPECT_EQ(kMaxLeadNanos, mScheduler.getLeadNanos());
+    EXPECT_EQ(0, mScheduler.getMissCount());
+    converge(kWorkNanos);
+    EXPECT_NEAR(convergedLead, mScheduler.getLeadNanos(), 1000);
+}
+
+} // namespace